@@ -15,6 +15,7 @@
 #include "DriveEnumeratorImpl.h"
 #include "ExitCode.h"
 #include "FileSystemWatcher.h"
+#include "FolderSizeCache.h"
 #include "LanguageHelper.h"
 #include "MainRebarStorage.h"
 #include "MainResource.h"
@@ -47,6 +48,7 @@ App::App(const CommandLine::Settings *commandLineSettings) :
 	m_themeManager(&m_darkModeManager, &m_darkModeColorProvider),
 	m_cachedIcons(std::make_shared<CachedIcons>(MAX_CACHED_ICONS)),
 	m_iconFetcher(std::make_shared<AsyncIconFetcher>(&m_runtime, m_cachedIcons)),
+	m_folderSizeCache(std::make_shared<FolderSizeCache>(MAX_CACHED_FOLDER_SIZES)),
 	m_colorRuleModel(ColorRuleModelFactory::Create()),
 	m_resourceInstance(GetModuleHandle(nullptr)),
 	m_processManager(&m_browserList),
@@ -405,6 +407,11 @@ std::shared_ptr<AsyncIconFetcher> App::GetIconFetcher()
 	return m_iconFetcher;
 }
 
+std::shared_ptr<FolderSizeCache> App::GetFolderSizeCache()
+{
+	return m_folderSizeCache;
+}
+
 BrowserList *App::GetBrowserList()
 {
 	return &m_browserList;
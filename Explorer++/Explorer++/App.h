@@ -42,6 +42,7 @@
 class AsyncIconFetcher;
 class CachedIcons;
 class ColorRuleModel;
+class FolderSizeCache;
 class ResourceLoader;
 struct WindowStorageData;
 
@@ -67,6 +68,7 @@ public:
 	DirectoryWatcherFactory *GetDirectoryWatcherFactory();
 	CachedIcons *GetCachedIcons();
 	std::shared_ptr<AsyncIconFetcher> GetIconFetcher();
+	std::shared_ptr<FolderSizeCache> GetFolderSizeCache();
 	BrowserList *GetBrowserList();
 	ModelessDialogList *GetModelessDialogList();
 	BookmarkTree *GetBookmarkTree();
@@ -94,6 +96,9 @@ private:
 	// various components in the application.
 	static constexpr int MAX_CACHED_ICONS = 1000;
 
+	// The maximum number of folders whose sizes will be cached.
+	static constexpr size_t MAX_CACHED_FOLDER_SIZES = 100000;
+
 	static constexpr int MIN_COM_STA_THREADPOOL_SIZE = 5;
 
 	void OnBrowserRemoved();
@@ -128,6 +133,7 @@ private:
 	ThemeManager m_themeManager;
 	std::shared_ptr<CachedIcons> m_cachedIcons;
 	std::shared_ptr<AsyncIconFetcher> m_iconFetcher;
+	std::shared_ptr<FolderSizeCache> m_folderSizeCache;
 	BrowserList m_browserList;
 	ModelessDialogList m_modelessDialogList;
 	BookmarkTree m_bookmarkTree;
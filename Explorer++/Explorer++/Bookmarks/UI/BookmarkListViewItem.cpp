@@ -63,7 +63,7 @@ std::wstring BookmarkListViewItem::FormatDate(const FILETIME &date) const
 {
 	wchar_t formattedDate[256];
 	auto res = CreateFileTimeString(&date, formattedDate, std::size(formattedDate),
-		m_config->globalFolderSettings.showFriendlyDates);
+		m_config->globalFolderSettings.showFriendlyDates.get());
 
 	if (!res)
 	{
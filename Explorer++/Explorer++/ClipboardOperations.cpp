@@ -22,6 +22,8 @@ enum class LinkType
 	SymLink
 };
 
+constexpr size_t PASTED_ITEMS_BATCH_SIZE = 256;
+
 void CreateSymLink(const std::filesystem::path &sourceFilePath,
 	const std::filesystem::path &destinationFilePath, std::error_code &error)
 {
@@ -42,18 +44,26 @@ void CreateSymLink(const std::filesystem::path &sourceFilePath,
 	}
 }
 
-ClipboardOperations::PastedItems PasteLinksOfType(ClipboardStore *clipboardStore,
-	const std::wstring &destination, LinkType linkType)
+bool IsInsufficientPrivilegeError(const std::error_code &error)
+{
+	return error == std::error_code(ERROR_PRIVILEGE_NOT_HELD, std::system_category());
+}
+
+// Invokes the callback with each batch of results. If a symlink can't be created because this
+// process has insufficient privileges, it's assumed that none of the symlinks can be created, so
+// the operation is abandoned (without the failed item being reported) and false is returned.
+bool PasteLinksOfType(ClipboardStore *clipboardStore, const std::wstring &destination,
+	LinkType linkType, ClipboardOperations::PastedItemsCallback pastedItemsCallback)
 {
 	Clipboard clipboard(clipboardStore);
 	auto paths = clipboard.ReadHDropData();
 
 	if (!paths)
 	{
-		return {};
+		return true;
 	}
 
-	ClipboardOperations::PastedItems pastedItems;
+	ClipboardOperations::PastedItems batch;
 
 	for (const auto &path : *paths)
 	{
@@ -78,23 +88,26 @@ ClipboardOperations::PastedItems PasteLinksOfType(ClipboardStore *clipboardStore
 			CHECK(false);
 		}
 
-		pastedItems.emplace_back(destinationFilePath, error);
-	}
+		if (linkType == LinkType::SymLink && IsInsufficientPrivilegeError(error))
+		{
+			return false;
+		}
 
-	return pastedItems;
-}
+		batch.emplace_back(destinationFilePath, error);
 
-ClipboardOperations::PastedItems PasteSymLinksViaElevatedProcess(const std::wstring &destination)
-{
-	auto clientLauncher = [&destination]
+		if (batch.size() == PASTED_ITEMS_BATCH_SIZE)
+		{
+			pastedItemsCallback(batch);
+			batch.clear();
+		}
+	}
+
+	if (!batch.empty())
 	{
-		std::wstring parameters =
-			std::format(L"{} \"{}\"", CommandLine::PASTE_SYMLINKS_ARGUMENT, destination);
-		return LaunchCurrentProcess(nullptr, parameters, LaunchProcessFlags::Elevated);
-	};
+		pastedItemsCallback(batch);
+	}
 
-	PasteSymLinksServer server;
-	return server.LaunchClientAndWaitForResponse(clientLauncher, 10s);
+	return true;
 }
 
 }
@@ -109,34 +122,40 @@ bool CanPasteLinkInDirectory(const ClipboardStore *clipboardStore, PCIDLIST_ABSO
 
 PastedItems PasteHardLinks(ClipboardStore *clipboardStore, const std::wstring &destination)
 {
-	return PasteLinksOfType(clipboardStore, destination, LinkType::HardLink);
+	PastedItems pastedItems;
+	PasteLinksOfType(clipboardStore, destination, LinkType::HardLink,
+		[&pastedItems](const PastedItems &batch)
+		{ pastedItems.insert(pastedItems.end(), batch.begin(), batch.end()); });
+	return pastedItems;
 }
 
-PastedItems PasteSymLinks(ClipboardStore *clipboardStore, const std::wstring &destination)
+bool PasteSymLinks(ClipboardStore *clipboardStore, const std::wstring &destination,
+	PastedItemsCallback pastedItemsCallback)
 {
-	auto pastedItems = PasteLinksOfType(clipboardStore, destination, LinkType::SymLink);
-
-	auto itr = std::find_if(pastedItems.begin(), pastedItems.end(),
-		[](const auto &pastedItem)
-		{
-			return pastedItem.error
-				== std::error_code(ERROR_PRIVILEGE_NOT_HELD, std::system_category());
-		});
+	// If none of the symlink operations failed because of insufficient privileges, it indicates
+	// that either this process is elevated, or developer mode is enabled. In either case, there's
+	// no need to retry the operations in an elevated process.
+	// Note that this doesn't necessarily indicate that any of the symlink operations actually
+	// succeeded, only that they didn't fail because symlink creation is blocked.
+	// Otherwise, all of the symlink operations will fail for that reason, so the caller needs to
+	// retry the operation in an elevated process.
+	return PasteLinksOfType(clipboardStore, destination, LinkType::SymLink, pastedItemsCallback);
+}
 
-	if (itr == pastedItems.end())
+void PasteSymLinksViaElevatedProcess(const std::wstring &destination,
+	PastedItemsCallback pastedItemsCallback)
+{
+	auto clientLauncher = [&destination]
 	{
-		// If none of the symlink operations failed because of insufficient privileges, it indicates
-		// that either this process is elevated, or developer mode is enabled. In either case,
-		// there's no need to retry the operations in an elevated process.
-		// Note that this doesn't necessarily indicate that any of the symlink operations actually
-		// succeeded, only that they didn't fail because symlink creation is blocked.
-		return pastedItems;
-	}
+		std::wstring parameters =
+			std::format(L"{} \"{}\"", CommandLine::PASTE_SYMLINKS_ARGUMENT, destination);
+		return LaunchCurrentProcess(nullptr, parameters, LaunchProcessFlags::Elevated);
+	};
 
-	// If at least one symlink operation failed due to insufficient privileges, it's assumed they
-	// all failed for that reason. In which case, the operation needs to be retried in an elevated
-	// process.
-	return PasteSymLinksViaElevatedProcess(destination);
+	// The client may take some time to start (e.g. if the user has to respond to a UAC prompt).
+	// Once it's running, it's expected to send results regularly.
+	PasteSymLinksServer server;
+	server.LaunchClientAndWaitForResponse(clientLauncher, 60s, 10s, pastedItemsCallback);
 }
 
 }
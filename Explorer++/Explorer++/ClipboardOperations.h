@@ -5,6 +5,7 @@
 #pragma once
 
 #include <shtypes.h>
+#include <functional>
 #include <string>
 #include <system_error>
 #include <vector>
@@ -48,6 +49,9 @@ struct PastedItem
 
 using PastedItems = std::vector<PastedItem>;
 
+// Invoked with each batch of pasted items, once the batch has been completed.
+using PastedItemsCallback = std::function<void(const PastedItems &pastedItems)>;
+
 bool CanPasteLinkInDirectory(const ClipboardStore *clipboardStore, PCIDLIST_ABSOLUTE pidl);
 
 // There are two types of paste operations used within the application:
@@ -58,6 +62,19 @@ bool CanPasteLinkInDirectory(const ClipboardStore *clipboardStore, PCIDLIST_ABSO
 //
 // These functions allow for the second type of paste operation to be performed.
 PastedItems PasteHardLinks(ClipboardStore *clipboardStore, const std::wstring &destination);
-PastedItems PasteSymLinks(ClipboardStore *clipboardStore, const std::wstring &destination);
+
+// Creating symlinks may require the operation to be retried in an elevated process, which can
+// take some time when there are a large number of items. So, rather than returning the results
+// once everything has finished, the callback is invoked with each batch of results as it arrives.
+// Returns false if the symlinks couldn't be created because this process has insufficient
+// privileges, in which case the operation should be retried via PasteSymLinksViaElevatedProcess().
+bool PasteSymLinks(ClipboardStore *clipboardStore, const std::wstring &destination,
+	PastedItemsCallback pastedItemsCallback);
+
+// Launches an elevated copy of the application to create the symlinks and waits for it to finish.
+// The client may have to wait for the user to respond to a UAC prompt, so this can block for some
+// time and shouldn't be called on the UI thread. The callback is invoked on the calling thread.
+void PasteSymLinksViaElevatedProcess(const std::wstring &destination,
+	PastedItemsCallback pastedItemsCallback);
 
 }
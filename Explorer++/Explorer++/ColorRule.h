@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "../Helper/WildcardPattern.h"
+
 class ColorRule
 {
 public:
@@ -17,6 +19,7 @@ public:
 	std::wstring GetFilterPattern() const;
 	void SetFilterPattern(const std::wstring &filterPattern);
 	bool GetFilterPatternCaseInsensitive() const;
+	const WildcardPattern &GetCompiledFilterPattern() const;
 	void SetFilterPatternCaseInsensitive(bool caseInsensitive);
 	DWORD GetFilterAttributes() const;
 	void SetFilterAttributes(DWORD attributes);
@@ -29,6 +32,7 @@ private:
 	std::wstring m_description;
 	std::wstring m_filterPattern;
 	bool m_filterPatternCaseInsensitive;
+	WildcardPattern m_compiledFilterPattern;
 	DWORD m_filterAttributes;
 	COLORREF m_color;
 
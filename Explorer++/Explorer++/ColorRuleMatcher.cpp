@@ -0,0 +1,49 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ColorRuleMatcher.h"
+#include "ColorRuleModel.h"
+
+ColorRuleMatcher::ColorRuleMatcher(const ColorRuleModel *model)
+{
+	for (const auto &colorRule : model->GetItems())
+	{
+		CompiledRule compiledRule;
+
+		if (!colorRule->GetFilterPattern().empty())
+		{
+			compiledRule.pattern = colorRule->GetCompiledFilterPattern();
+		}
+
+		compiledRule.attributes = colorRule->GetFilterAttributes();
+		compiledRule.color = colorRule->GetColor();
+
+		m_rules.push_back(std::move(compiledRule));
+	}
+}
+
+std::optional<COLORREF> ColorRuleMatcher::GetColor(std::wstring_view name,
+	std::optional<DWORD> attributes) const
+{
+	for (const auto &rule : m_rules)
+	{
+		if (rule.attributes != 0
+			&& (!attributes || !WI_IsAnyFlagSet(*attributes, rule.attributes)))
+		{
+			continue;
+		}
+
+		// The attribute check is cheap, so it's performed first. The pattern check can then be
+		// skipped for any rules that don't apply based on attributes alone.
+		if (rule.pattern && !rule.pattern->Matches(name))
+		{
+			continue;
+		}
+
+		return rule.color;
+	}
+
+	return std::nullopt;
+}
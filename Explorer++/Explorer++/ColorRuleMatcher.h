@@ -0,0 +1,36 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "../Helper/WildcardPattern.h"
+#include <optional>
+#include <string_view>
+#include <vector>
+
+class ColorRuleModel;
+
+// Determines which color rule (if any) applies to an item. The rules are copied out of the model
+// when the matcher is constructed, so a new matcher needs to be built whenever the rules change.
+class ColorRuleMatcher
+{
+public:
+	explicit ColorRuleMatcher(const ColorRuleModel *model);
+
+	// Returns the color from the first matching rule. If the item's attributes aren't known,
+	// rules that filter on attributes will never match.
+	std::optional<COLORREF> GetColor(std::wstring_view name,
+		std::optional<DWORD> attributes) const;
+
+private:
+	struct CompiledRule
+	{
+		// This will be empty if the rule doesn't filter on the item name.
+		std::optional<WildcardPattern> pattern;
+		DWORD attributes;
+		COLORREF color;
+	};
+
+	std::vector<CompiledRule> m_rules;
+};
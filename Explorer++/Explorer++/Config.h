@@ -113,6 +113,11 @@ struct Config
 	ValueWrapper<COLORREF> displayWindowTextColor = DisplayWindowDefaults::TEXT_COLOR;
 	ValueWrapper<LOGFONT> displayWindowFont = DisplayWindowDefaults::FONT;
 
+	// Thumbnails
+	// The maximum amount of memory, in MB, that each tab will use to hold the thumbnails it
+	// displays.
+	UINT thumbnailMemoryLimitMB = 128;
+
 	// These are settings that are shared between all tabs. It's not
 	// possible to adjust them on a per-tab basis.
 	GlobalFolderSettings globalFolderSettings;
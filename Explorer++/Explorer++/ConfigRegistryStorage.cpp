@@ -102,6 +102,8 @@ void LoadFromKey(HKEY settingsKey, Config &config)
 		config.globalFolderSettings.forceSize);
 	RegistrySettings::Read32BitValueFromRegistry(settingsKey, L"ShowTaskbarThumbnails",
 		config.showTaskbarThumbnails);
+	RegistrySettings::Read32BitValueFromRegistry(settingsKey, L"ThumbnailMemoryLimitMB",
+		config.thumbnailMemoryLimitMB);
 	RegistrySettings::Read32BitValueFromRegistry(settingsKey, L"SynchronizeTreeview",
 		config.synchronizeTreeview);
 	RegistrySettings::Read32BitValueFromRegistry(settingsKey, L"TVAutoExpandSelected",
@@ -247,7 +249,7 @@ void SaveToKey(HKEY settingsKey, const Config &config)
 	RegistrySettings::SaveDword(settingsKey, L"ShowFullTitlePath", config.showFullTitlePath.get());
 	RegistrySettings::SaveDword(settingsKey, L"AlwaysOpenNewTab", config.alwaysOpenNewTab);
 	RegistrySettings::SaveDword(settingsKey, L"ShowFriendlyDates",
-		config.globalFolderSettings.showFriendlyDates);
+		config.globalFolderSettings.showFriendlyDates.get());
 	RegistrySettings::SaveDword(settingsKey, L"ShowDisplayWindow", config.showDisplayWindow.get());
 	RegistrySettings::SaveDword(settingsKey, L"ShowFolderSizes",
 		config.globalFolderSettings.showFolderSizes);
@@ -323,6 +325,8 @@ void SaveToKey(HKEY settingsKey, const Config &config)
 		config.globalFolderSettings.hideLinkExtension);
 	RegistrySettings::SaveDword(settingsKey, L"ShowTaskbarThumbnails",
 		config.showTaskbarThumbnails);
+	RegistrySettings::SaveDword(settingsKey, L"ThumbnailMemoryLimitMB",
+		config.thumbnailMemoryLimitMB);
 	RegistrySettings::SaveDword(settingsKey, L"SynchronizeTreeview",
 		config.synchronizeTreeview.get());
 	RegistrySettings::SaveDword(settingsKey, L"TVAutoExpandSelected",
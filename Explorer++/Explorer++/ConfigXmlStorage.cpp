@@ -215,6 +215,7 @@ void LoadFromNode(IXMLDOMNode *settingsNode, Config &config)
 		config.globalFolderSettings.sizeDisplayFormat);
 	GetBetterEnumSetting(settingsNode, L"StartupMode", config.startupMode);
 	GetBoolSetting(settingsNode, L"SynchronizeTreeview", config.synchronizeTreeview);
+	GetIntSetting(settingsNode, L"ThumbnailMemoryLimitMB", config.thumbnailMemoryLimitMB);
 	GetBoolSetting(settingsNode, L"TVAutoExpandSelected", config.treeViewAutoExpandSelected);
 	GetBoolSetting(settingsNode, L"UseFullRowSelect", config.useFullRowSelect);
 	GetBoolSetting(settingsNode, L"TreeViewDelayEnabled", config.treeViewDelayEnabled);
@@ -408,7 +409,7 @@ void SaveToNode(IXMLDOMDocument *xmlDocument, IXMLDOMElement *settingsNode, cons
 		XMLSettings::EncodeBoolValue(config.globalFolderSettings.showFolderSizes));
 	XMLSettings::WriteStandardSetting(xmlDocument, settingsNode, SETTING_NODE_NAME,
 		L"ShowFriendlyDates",
-		XMLSettings::EncodeBoolValue(config.globalFolderSettings.showFriendlyDates));
+		XMLSettings::EncodeBoolValue(config.globalFolderSettings.showFriendlyDates.get()));
 	XMLSettings::WriteStandardSetting(xmlDocument, settingsNode, SETTING_NODE_NAME,
 		L"ShowFullTitlePath", XMLSettings::EncodeBoolValue(config.showFullTitlePath.get()));
 	XMLSettings::WriteStandardSetting(xmlDocument, settingsNode, SETTING_NODE_NAME,
@@ -445,6 +446,8 @@ void SaveToNode(IXMLDOMDocument *xmlDocument, IXMLDOMElement *settingsNode, cons
 		XMLSettings::EncodeIntValue(config.startupMode));
 	XMLSettings::WriteStandardSetting(xmlDocument, settingsNode, SETTING_NODE_NAME,
 		L"SynchronizeTreeview", XMLSettings::EncodeBoolValue(config.synchronizeTreeview.get()));
+	XMLSettings::WriteStandardSetting(xmlDocument, settingsNode, SETTING_NODE_NAME,
+		L"ThumbnailMemoryLimitMB", XMLSettings::EncodeIntValue(config.thumbnailMemoryLimitMB));
 	XMLSettings::WriteStandardSetting(xmlDocument, settingsNode, SETTING_NODE_NAME,
 		L"TVAutoExpandSelected", XMLSettings::EncodeBoolValue(config.treeViewAutoExpandSelected));
 	XMLSettings::WriteStandardSetting(xmlDocument, settingsNode, SETTING_NODE_NAME,
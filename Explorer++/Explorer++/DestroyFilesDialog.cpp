@@ -7,10 +7,25 @@
 #include "App.h"
 #include "MainResource.h"
 #include "ResourceLoader.h"
+#include "TransferProgressHelper.h"
 #include "../Helper/Helper.h"
 #include "../Helper/RegistrySettings.h"
+#include "../Helper/SecureDelete.h"
 #include "../Helper/StringHelper.h"
+#include "../Helper/WindowHelper.h"
 #include "../Helper/XMLSettings.h"
+#include <fmt/format.h>
+#include <fmt/xchar.h>
+#include <algorithm>
+
+namespace NDestroyFilesDialog
+{
+const int WM_APP_DESTROYPROGRESS = WM_APP + 1;
+const int WM_APP_DESTROYFINISHED = WM_APP + 2;
+
+// The maximum number of failed paths that will be listed when reporting an error.
+const size_t MAX_FAILED_PATHS_SHOWN = 10;
+}
 
 const TCHAR DestroyFilesDialogPersistentSettings::SETTINGS_KEY[] = _T("DestroyFiles");
 
@@ -166,7 +181,23 @@ INT_PTR DestroyFilesDialog::OnCommand(WPARAM wParam, LPARAM lParam)
 
 INT_PTR DestroyFilesDialog::OnClose()
 {
-	EndDialog(m_hDlg, 0);
+	OnCancel();
+	return 0;
+}
+
+INT_PTR DestroyFilesDialog::OnPrivateMessage(UINT uMsg, WPARAM wParam, LPARAM lParam)
+{
+	switch (uMsg)
+	{
+	case NDestroyFilesDialog::WM_APP_DESTROYPROGRESS:
+		OnDestroyProgress(static_cast<int>(wParam), static_cast<std::uint64_t>(lParam));
+		break;
+
+	case NDestroyFilesDialog::WM_APP_DESTROYFINISHED:
+		OnDestroyFinished();
+		break;
+	}
+
 	return 0;
 }
 
@@ -209,6 +240,16 @@ void DestroyFilesDialog::OnOk()
 
 void DestroyFilesDialog::OnCancel()
 {
+	if (m_destroyingFiles)
+	{
+		// Any file that's currently being overwritten will be finished and deleted, since
+		// stopping part way through would leave it partially overwritten (i.e. neither intact,
+		// nor destroyed). Files that haven't been started yet will be left alone. The dialog
+		// will be closed once the background thread has stopped.
+		m_stopSource.request_stop();
+		return;
+	}
+
 	EndDialog(m_hDlg, 0);
 }
 
@@ -225,10 +266,72 @@ void DestroyFilesDialog::OnConfirmDestroy()
 		overwriteMethod = FileOperations::OverwriteMethod::ThreePass;
 	}
 
-	/* TODO: Perform in background thread. */
-	for (const auto &strFullFilename : m_FullFilenameList)
+	m_destroyingFiles = true;
+	m_title = GetWindowString(m_hDlg);
+
+	EnableWindow(GetDlgItem(m_hDlg, IDOK), FALSE);
+	EnableWindow(GetDlgItem(m_hDlg, IDC_DESTROYFILES_RADIO_ONEPASS), FALSE);
+	EnableWindow(GetDlgItem(m_hDlg, IDC_DESTROYFILES_RADIO_THREEPASS), FALSE);
+
+	std::vector<std::wstring> paths(m_FullFilenameList.begin(), m_FullFilenameList.end());
+
+	m_destroyThread = std::jthread(
+		[hDlg = m_hDlg, paths = std::move(paths), overwriteMethod,
+			stopToken = m_stopSource.get_token(), failedPaths = &m_failedPaths]
+		{
+			auto result = DeleteFilesSecurely(paths, overwriteMethod, stopToken,
+				[hDlg](const SecureDeleteProgress &progress)
+				{
+					TransferProgressHelper::PostProgressMessage(hDlg,
+						NDestroyFilesDialog::WM_APP_DESTROYPROGRESS, progress.bytesWritten,
+						progress.totalBytes, 100, progress.bytesPerSecond);
+				});
+
+			// The dialog won't be destroyed until this thread has been joined, so it's safe to
+			// write to the member here.
+			*failedPaths = std::move(result.failedPaths);
+
+			PostMessage(hDlg, NDestroyFilesDialog::WM_APP_DESTROYFINISHED, 0, 0);
+		});
+}
+
+void DestroyFilesDialog::OnDestroyProgress(int percentage, std::uint64_t bytesPerSecond)
+{
+	if (!m_destroyingFiles)
+	{
+		return;
+	}
+
+	// There's no status text in this dialog, so progress is shown in the title bar.
+	auto title = TransferProgressHelper::FormatStatus(m_resourceLoader, m_title, percentage,
+		bytesPerSecond);
+	SetWindowText(m_hDlg, title.c_str());
+}
+
+void DestroyFilesDialog::OnDestroyFinished()
+{
+	m_destroyingFiles = false;
+
+	if (!m_failedPaths.empty())
 	{
-		DeleteFileSecurely(strFullFilename, overwriteMethod);
+		std::wstring failedPathsText;
+		size_t numPathsShown =
+			std::min(m_failedPaths.size(), NDestroyFilesDialog::MAX_FAILED_PATHS_SHOWN);
+
+		for (size_t i = 0; i < numPathsShown; i++)
+		{
+			failedPathsText += m_failedPaths[i] + L"\n";
+		}
+
+		if (m_failedPaths.size() > NDestroyFilesDialog::MAX_FAILED_PATHS_SHOWN)
+		{
+			failedPathsText += L"...\n";
+		}
+
+		std::wstring message =
+			fmt::format(fmt::runtime(m_resourceLoader->LoadString(IDS_DESTROY_FILES_FAILED)),
+				fmt::arg(L"num_files", m_failedPaths.size()), fmt::arg(L"files", failedPathsText));
+		MessageBox(m_hDlg, message.c_str(), App::APP_NAME, MB_ICONWARNING | MB_OK);
 	}
 
 	EndDialog(m_hDlg, 1);
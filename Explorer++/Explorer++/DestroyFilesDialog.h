@@ -9,6 +9,11 @@
 #include "../Helper/FileOperations.h"
 #include "../Helper/ResizableDialogHelper.h"
 #include <wil/resource.h>
+#include <cstdint>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
 
 class DestroyFilesDialog;
 
@@ -49,6 +54,8 @@ protected:
 	INT_PTR OnCommand(WPARAM wParam, LPARAM lParam) override;
 	INT_PTR OnClose() override;
 
+	INT_PTR OnPrivateMessage(UINT uMsg, WPARAM wParam, LPARAM lParam) override;
+
 private:
 	DestroyFilesDialog(const ResourceLoader *resourceLoader, HWND hParent,
 		const std::list<std::wstring> &FullFilenameList, BOOL bShowFriendlyDates);
@@ -60,6 +67,8 @@ private:
 	void OnOk();
 	void OnCancel();
 	void OnConfirmDestroy();
+	void OnDestroyProgress(int percentage, std::uint64_t bytesPerSecond);
+	void OnDestroyFinished();
 
 	std::list<std::wstring> m_FullFilenameList;
 
@@ -68,4 +77,13 @@ private:
 	DestroyFilesDialogPersistentSettings *m_pdfdps;
 
 	BOOL m_bShowFriendlyDates;
+
+	bool m_destroyingFiles = false;
+	std::wstring m_title;
+	std::stop_source m_stopSource;
+
+	// Set by the background thread before it posts WM_APP_DESTROYFINISHED. This is declared
+	// before the thread, so that it outlives it.
+	std::vector<std::wstring> m_failedPaths;
+	std::jthread m_destroyThread;
 };
@@ -129,7 +129,7 @@ void Explorerplusplus::UpdateDisplayWindowForOneFile(const Tab &tab)
 				TCHAR szCalculating[64];
 				DWORD threadId;
 
-				pfs = (FolderSize_t *) malloc(sizeof(FolderSize_t));
+				pfs = new (std::nothrow) FolderSize_t();
 
 				if (pfs != nullptr)
 				{
@@ -158,6 +158,7 @@ void Explorerplusplus::UpdateDisplayWindowForOneFile(const Tab &tab)
 						displayWindowFolderSize.iTabId =
 							GetActivePane()->GetTabContainer()->GetSelectedTab().GetId();
 						displayWindowFolderSize.bValid = TRUE;
+						pfs->stopToken = displayWindowFolderSize.stopSource.get_token();
 						m_DWFolderSizes.push_back(displayWindowFolderSize);
 
 						HANDLE hThread = CreateThread(nullptr, 0, Thread_CalculateFolderSize,
@@ -168,7 +169,7 @@ void Explorerplusplus::UpdateDisplayWindowForOneFile(const Tab &tab)
 					}
 					else
 					{
-						free(pfs);
+						delete pfs;
 					}
 				}
 			}
@@ -181,7 +182,7 @@ void Explorerplusplus::UpdateDisplayWindowForOneFile(const Tab &tab)
 			}
 
 			CreateFileTimeString(&wfd.ftLastWriteTime, szFileDate, std::size(szFileDate),
-				m_config->globalFolderSettings.showFriendlyDates);
+				m_config->globalFolderSettings.showFriendlyDates.get());
 
 			LoadString(m_app->GetResourceInstance(), IDS_GENERAL_DATEMODIFIED, szDateModified,
 				std::size(szDateModified));
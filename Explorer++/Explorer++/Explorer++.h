@@ -32,6 +32,7 @@
 #include <concurrencpp/concurrencpp.h>
 #include <wil/resource.h>
 #include <optional>
+#include <stop_token>
 
 /* Sent when a folder size calculation has finished. */
 #define WM_APP_FOLDERSIZECOMPLETED WM_APP + 3
@@ -156,6 +157,7 @@ private:
 		int uId;
 		int iTabId;
 		BOOL bValid;
+		std::stop_source stopSource;
 	};
 
 	struct FolderSizeExtraInfo
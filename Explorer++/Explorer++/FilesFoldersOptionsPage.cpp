@@ -121,7 +121,7 @@ void FilesFoldersOptionsPage::InitializeControls()
 		CheckDlgButton(GetDialog(), IDC_SETTINGS_CHECK_CONTAINER_FILES, BST_CHECKED);
 	}
 
-	if (m_config->globalFolderSettings.showFriendlyDates)
+	if (m_config->globalFolderSettings.showFriendlyDates.get())
 	{
 		CheckDlgButton(GetDialog(), IDC_SETTINGS_CHECK_FRIENDLYDATES, BST_CHECKED);
 	}
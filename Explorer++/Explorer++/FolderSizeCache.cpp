@@ -0,0 +1,317 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "FolderSizeCache.h"
+#include <algorithm>
+#include <functional>
+
+FolderSizeCache::WatchedTree::WatchedTree(FolderSizeCache *cache, std::wstring normalizedPath) :
+	m_cache(cache),
+	m_normalizedPath(std::move(normalizedPath))
+{
+}
+
+FolderSizeCache::WatchedTree::~WatchedTree()
+{
+	m_cache->UnregisterWatchedTree(m_normalizedPath);
+}
+
+FolderSizeCache::FolderSizeCache(size_t maxEntries) : m_maxEntries(maxEntries)
+{
+}
+
+std::unique_ptr<FolderSizeCache::WatchedTree> FolderSizeCache::RegisterWatchedTree(
+	const std::wstring &path)
+{
+	auto normalizedPath = NormalizePath(path);
+
+	std::scoped_lock lock(m_mutex);
+
+	auto &watchedRoot = m_watchedRoots[normalizedPath];
+
+	if (watchedRoot.numRegistrations == 0)
+	{
+		watchedRoot.generation = ++m_currentGeneration;
+	}
+
+	watchedRoot.numRegistrations++;
+
+	return std::make_unique<WatchedTree>(this, std::move(normalizedPath));
+}
+
+void FolderSizeCache::UnregisterWatchedTree(const std::wstring &normalizedPath)
+{
+	std::scoped_lock lock(m_mutex);
+
+	auto itr = m_watchedRoots.find(normalizedPath);
+	CHECK(itr != m_watchedRoots.end());
+
+	itr->second.numRegistrations--;
+
+	if (itr->second.numRegistrations > 0)
+	{
+		return;
+	}
+
+	m_watchedRoots.erase(itr);
+
+	// Changes within the tree will no longer be reported, so any entries that aren't also within
+	// another watched tree can no longer be relied on.
+	std::erase_if(m_entries,
+		[this, &normalizedPath](const auto &entry)
+		{
+			return IsSameOrWithin(entry.first, normalizedPath)
+				&& !IsWatched(entry.first, m_currentGeneration);
+		});
+}
+
+std::optional<FolderInfo> FolderSizeCache::MaybeGet(const std::wstring &path,
+	const FILETIME &lastWriteTime) const
+{
+	auto normalizedPath = NormalizePath(path);
+
+	std::scoped_lock lock(m_mutex);
+	auto itr = m_entries.find(normalizedPath);
+
+	if (itr == m_entries.end() || !AreFileTimesEqual(itr->second.lastWriteTime, lastWriteTime))
+	{
+		return std::nullopt;
+	}
+
+	return itr->second.folderInfo;
+}
+
+void FolderSizeCache::Set(const std::wstring &path, const FILETIME &lastWriteTime,
+	const FolderInfo &folderInfo)
+{
+	auto normalizedPath = NormalizePath(path);
+
+	std::scoped_lock lock(m_mutex);
+
+	if (!IsWatched(normalizedPath, m_currentGeneration))
+	{
+		return;
+	}
+
+	SetInternal(std::move(normalizedPath), { lastWriteTime, folderInfo });
+}
+
+FolderInfo FolderSizeCache::GetOrCalculate(const std::wstring &path, const FILETIME &lastWriteTime,
+	std::stop_token stopToken)
+{
+	auto existingInfo = MaybeGet(path, lastWriteTime);
+
+	if (existingInfo)
+	{
+		return *existingInfo;
+	}
+
+	auto normalizedPath = NormalizePath(path);
+
+	std::unique_lock lock(m_mutex);
+	auto calculation = m_calculations.insert(m_calculations.end(),
+		Calculation{ .normalizedPath = normalizedPath, .startGeneration = m_currentGeneration });
+	lock.unlock();
+
+	auto folderInfo = GetFolderInfo(path, stopToken, nullptr,
+		std::bind_front(&FolderSizeCache::MaybeGet, this),
+		std::bind_front(&FolderSizeCache::OnSubfolderCalculated, this, std::cref(*calculation)));
+
+	lock.lock();
+
+	if (!stopToken.stop_requested())
+	{
+		MaybeSetFromCalculation(*calculation, std::move(normalizedPath),
+			{ lastWriteTime, folderInfo });
+	}
+
+	m_calculations.erase(calculation);
+
+	return folderInfo;
+}
+
+void FolderSizeCache::OnSubfolderCalculated(const Calculation &calculation,
+	const std::wstring &path, const FILETIME &lastWriteTime, const FolderInfo &folderInfo)
+{
+	auto normalizedPath = NormalizePath(path);
+
+	std::scoped_lock lock(m_mutex);
+	MaybeSetFromCalculation(calculation, std::move(normalizedPath), { lastWriteTime, folderInfo });
+}
+
+void FolderSizeCache::MaybeSetFromCalculation(const Calculation &calculation,
+	std::wstring normalizedPath, const Entry &entry)
+{
+	// If something within the folder was changed while the folder was being scanned, the totals
+	// may already be out of date. Changes elsewhere in the tree don't affect the folder.
+	bool invalidated = std::ranges::any_of(calculation.invalidations,
+		[&normalizedPath](const auto &invalidation)
+		{ return DoesInvalidationAffectPath(invalidation, normalizedPath); });
+
+	if (invalidated || !IsWatched(normalizedPath, calculation.startGeneration))
+	{
+		return;
+	}
+
+	SetInternal(std::move(normalizedPath), entry);
+}
+
+void FolderSizeCache::InvalidatePath(const std::wstring &path, bool includeSubtree)
+{
+	auto normalizedPath = NormalizePath(path);
+
+	std::scoped_lock lock(m_mutex);
+
+	Invalidation invalidation = { normalizedPath, includeSubtree };
+
+	for (auto &calculation : m_calculations)
+	{
+		// Any folder affected by the invalidation is either an ancestor of the item, or (if
+		// includeSubtree is set) within it. So, if the root of the calculation isn't affected,
+		// none of the folders within the calculation will be either.
+		if (DoesInvalidationAffectPath(invalidation, calculation.normalizedPath))
+		{
+			calculation.invalidations.push_back(invalidation);
+		}
+	}
+
+	if (includeSubtree)
+	{
+		auto prefix = normalizedPath + L"\\";
+
+		std::erase_if(m_entries,
+			[&prefix](const auto &entry) { return entry.first.starts_with(prefix); });
+	}
+
+	// The item itself and every folder above it will have a different total.
+	auto currentPath = normalizedPath;
+
+	while (!currentPath.empty())
+	{
+		m_entries.erase(currentPath);
+
+		auto separatorPosition = currentPath.find_last_of(L'\\');
+
+		if (separatorPosition == std::wstring::npos)
+		{
+			break;
+		}
+
+		currentPath.resize(separatorPosition);
+	}
+}
+
+void FolderSizeCache::Clear()
+{
+	std::scoped_lock lock(m_mutex);
+
+	m_entries.clear();
+
+	for (auto &calculation : m_calculations)
+	{
+		calculation.invalidations.push_back({ calculation.normalizedPath, true });
+	}
+}
+
+size_t FolderSizeCache::GetNumEntries() const
+{
+	std::scoped_lock lock(m_mutex);
+	return m_entries.size();
+}
+
+bool FolderSizeCache::IsWatched(const std::wstring &normalizedPath,
+	std::uint64_t maxGeneration) const
+{
+	auto currentPath = normalizedPath;
+
+	while (!currentPath.empty())
+	{
+		auto itr = m_watchedRoots.find(currentPath);
+
+		if (itr != m_watchedRoots.end() && itr->second.generation <= maxGeneration)
+		{
+			return true;
+		}
+
+		auto separatorPosition = currentPath.find_last_of(L'\\');
+
+		if (separatorPosition == std::wstring::npos)
+		{
+			break;
+		}
+
+		currentPath.resize(separatorPosition);
+	}
+
+	return false;
+}
+
+void FolderSizeCache::SetInternal(std::wstring normalizedPath, const Entry &entry)
+{
+	if (m_entries.size() >= m_maxEntries && !m_entries.contains(normalizedPath))
+	{
+		// The cache is only bounded to prevent it from growing indefinitely, so there's no
+		// particular preference as to which entry is removed.
+		m_entries.erase(m_entries.begin());
+	}
+
+	m_entries.insert_or_assign(std::move(normalizedPath), entry);
+}
+
+std::wstring FolderSizeCache::NormalizePath(const std::wstring &path)
+{
+	// Paths are compared case-insensitively and without any trailing separator, so that the path
+	// passed in when the size of a folder is displayed matches the path that's generated when the
+	// folder is found during the scan of its parent.
+	std::wstring normalizedPath = path;
+
+	while (normalizedPath.ends_with(L'\\'))
+	{
+		normalizedPath.pop_back();
+	}
+
+	if (normalizedPath.empty())
+	{
+		return normalizedPath;
+	}
+
+	std::wstring upperCasePath(normalizedPath.size(), '\0');
+	int res = LCMapStringEx(LOCALE_NAME_INVARIANT, LCMAP_UPPERCASE, normalizedPath.c_str(),
+		static_cast<int>(normalizedPath.size()), upperCasePath.data(),
+		static_cast<int>(upperCasePath.size()), nullptr, nullptr, 0);
+
+	if (res == 0)
+	{
+		DCHECK(false);
+		return normalizedPath;
+	}
+
+	upperCasePath.resize(res);
+
+	return upperCasePath;
+}
+
+bool FolderSizeCache::AreFileTimesEqual(const FILETIME &fileTime1, const FILETIME &fileTime2)
+{
+	return CompareFileTime(&fileTime1, &fileTime2) == 0;
+}
+
+bool FolderSizeCache::IsSameOrWithin(const std::wstring &normalizedPath,
+	const std::wstring &normalizedAncestorPath)
+{
+	return normalizedPath.starts_with(normalizedAncestorPath)
+		&& (normalizedPath.size() == normalizedAncestorPath.size()
+			|| normalizedPath[normalizedAncestorPath.size()] == L'\\');
+}
+
+bool FolderSizeCache::DoesInvalidationAffectPath(const Invalidation &invalidation,
+	const std::wstring &normalizedPath)
+{
+	// The total for a folder changes if an item within it changes. Additionally, if the contents of
+	// an entire subtree are unknown, the totals for the folders within that subtree are unknown.
+	return IsSameOrWithin(invalidation.normalizedPath, normalizedPath)
+		|| (invalidation.includeSubtree
+			&& IsSameOrWithin(normalizedPath, invalidation.normalizedPath));
+}
@@ -0,0 +1,131 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "../Helper/FolderSize.h"
+#include <boost/core/noncopyable.hpp>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Caches the total size of folders, keyed by path. Calculating the size of a folder requires the
+// entire tree below the folder to be scanned, so without this cache, that would happen every time
+// the size of a folder was displayed. When a folder is scanned, the totals for each of its
+// subfolders are cached as well, and cached totals are reused when a parent folder is later
+// scanned.
+//
+// The last write time of a folder only changes when items directly within the folder change, so it
+// can't be used to detect changes further down the tree. Therefore, entries are only held for
+// folders within a tree that's being watched for changes. Callers register each watched tree via
+// RegisterWatchedTree() and report the changes within it via InvalidatePath(). Once a tree is no
+// longer watched, the entries within it are removed.
+//
+// This class can be used from multiple threads.
+class FolderSizeCache : private boost::noncopyable
+{
+public:
+	// Represents a registered tree. The tree remains registered until this object is destroyed.
+	class WatchedTree : private boost::noncopyable
+	{
+	public:
+		WatchedTree(FolderSizeCache *cache, std::wstring normalizedPath);
+		~WatchedTree();
+
+	private:
+		FolderSizeCache *const m_cache;
+		const std::wstring m_normalizedPath;
+	};
+
+	explicit FolderSizeCache(size_t maxEntries);
+
+	// Should be called once the specified folder is being recursively watched for changes. Note
+	// that the returned object must not outlive the cache.
+	[[nodiscard]] std::unique_ptr<WatchedTree> RegisterWatchedTree(const std::wstring &path);
+
+	std::optional<FolderInfo> MaybeGet(const std::wstring &path,
+		const FILETIME &lastWriteTime) const;
+
+	// The entry will only be stored if the folder is within a watched tree.
+	void Set(const std::wstring &path, const FILETIME &lastWriteTime, const FolderInfo &folderInfo);
+
+	// Returns the cached totals for the folder, if available. Otherwise, the folder will be scanned
+	// and the result cached, along with the totals for each of its subfolders. If a stop is
+	// requested during the scan, the partial totals will be returned, but not cached.
+	FolderInfo GetOrCalculate(const std::wstring &path, const FILETIME &lastWriteTime,
+		std::stop_token stopToken = {});
+
+	// Should be called when the item at the specified path has been added, removed or modified. The
+	// entry for each folder that contains the item will be removed. If the item itself is a folder
+	// and its contents may have changed (e.g. because it was renamed or removed), includeSubtree
+	// should be set, so that the entries for any of its subfolders are also removed.
+	void InvalidatePath(const std::wstring &path, bool includeSubtree);
+
+	void Clear();
+	size_t GetNumEntries() const;
+
+private:
+	struct Entry
+	{
+		FILETIME lastWriteTime;
+		FolderInfo folderInfo;
+	};
+
+	struct WatchedRoot
+	{
+		int numRegistrations = 0;
+
+		// The value of m_currentGeneration at the point the tree was first registered.
+		std::uint64_t generation = 0;
+	};
+
+	struct Invalidation
+	{
+		std::wstring normalizedPath;
+		bool includeSubtree;
+	};
+
+	// Tracks a scan that's in progress, along with the invalidations that affect the tree being
+	// scanned. The results for a folder are only discarded if an invalidation affects that
+	// folder.
+	struct Calculation
+	{
+		std::wstring normalizedPath;
+		std::uint64_t startGeneration;
+		std::vector<Invalidation> invalidations;
+	};
+
+	static std::wstring NormalizePath(const std::wstring &path);
+	static bool AreFileTimesEqual(const FILETIME &fileTime1, const FILETIME &fileTime2);
+	static bool IsSameOrWithin(const std::wstring &normalizedPath,
+		const std::wstring &normalizedAncestorPath);
+	static bool DoesInvalidationAffectPath(const Invalidation &invalidation,
+		const std::wstring &normalizedPath);
+
+	void UnregisterWatchedTree(const std::wstring &normalizedPath);
+	bool IsWatched(const std::wstring &normalizedPath, std::uint64_t maxGeneration) const;
+	void OnSubfolderCalculated(const Calculation &calculation, const std::wstring &path,
+		const FILETIME &lastWriteTime, const FolderInfo &folderInfo);
+	void MaybeSetFromCalculation(const Calculation &calculation, std::wstring normalizedPath,
+		const Entry &entry);
+	void SetInternal(std::wstring normalizedPath, const Entry &entry);
+
+	const size_t m_maxEntries;
+	mutable std::mutex m_mutex;
+	std::unordered_map<std::wstring, Entry> m_entries;
+	std::unordered_map<std::wstring, WatchedRoot> m_watchedRoots;
+
+	// Incremented every time a tree is registered. A scan that started before a tree was
+	// registered may have missed changes made before the tree was being watched, so the results
+	// from the scan won't be cached within that tree.
+	std::uint64_t m_currentGeneration = 0;
+
+	std::list<Calculation> m_calculations;
+};
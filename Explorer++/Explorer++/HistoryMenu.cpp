@@ -5,26 +5,95 @@
 #include "stdafx.h"
 #include "HistoryMenu.h"
 #include "HistoryModel.h"
+#include "MenuView.h"
 
 HistoryMenu::HistoryMenu(MenuView *menuView, const AcceleratorManager *acceleratorManager,
 	HistoryModel *historyModel, BrowserWindow *browserWindow, ShellIconLoader *shellIconLoader,
 	UINT startId, UINT endId) :
-	ShellItemsMenu(menuView, acceleratorManager, GetHistoryItems(historyModel), browserWindow,
-		shellIconLoader, startId, endId),
+	ShellItemsMenu(menuView, acceleratorManager, {}, browserWindow, shellIconLoader, startId,
+		endId),
 	m_historyModel(historyModel)
 {
-	m_connections.push_back(m_historyModel->AddHistoryChangedObserver(
-		std::bind_front(&HistoryMenu::OnHistoryChanged, this)));
+	const auto &historyItems = m_historyModel->GetHistoryItems();
+	m_pendingItems.insert(historyItems.begin(), historyItems.end());
+
+	m_connections.push_back(m_historyModel->AddHistoryItemAddedObserver(
+		std::bind_front(&HistoryMenu::OnHistoryItemAdded, this)));
+	m_connections.push_back(m_historyModel->AddHistoryItemMovedObserver(
+		std::bind_front(&HistoryMenu::OnHistoryItemMoved, this)));
+	m_connections.push_back(m_historyModel->AddHistoryItemEvictedObserver(
+		std::bind_front(&HistoryMenu::OnHistoryItemEvicted, this)));
+	m_connections.push_back(
+		m_menuView->AddMenuWillShowObserver(std::bind_front(&HistoryMenu::OnMenuWillShow, this)));
+}
+
+void HistoryMenu::OnHistoryItemAdded(const PidlAbsolute &pidl)
+{
+	m_pendingItems.insert(pidl);
+}
+
+void HistoryMenu::OnHistoryItemMoved(const PidlAbsolute &pidl)
+{
+	auto itr = m_itemIds.find(pidl);
+
+	if (itr == m_itemIds.end())
+	{
+		// The item hasn't been added to the menu yet. Its position will be determined when it is.
+		return;
+	}
+
+	MoveItem(itr->second, 0);
 }
 
-void HistoryMenu::OnHistoryChanged()
+void HistoryMenu::OnHistoryItemEvicted(const PidlAbsolute &pidl)
 {
-	RebuildMenu(GetHistoryItems(m_historyModel));
+	if (m_pendingItems.erase(pidl) > 0)
+	{
+		return;
+	}
+
+	auto itr = m_itemIds.find(pidl);
+
+	if (itr == m_itemIds.end())
+	{
+		return;
+	}
+
+	RemoveItem(itr->second);
+	m_itemIds.erase(itr);
 }
 
-std::vector<PidlAbsolute> HistoryMenu::GetHistoryItems(const HistoryModel *historyModel)
+void HistoryMenu::OnMenuWillShow()
 {
-	const auto &history = historyModel->GetHistoryItems();
-	std::vector<PidlAbsolute> historyVector({ history.begin(), history.end() });
-	return historyVector;
+	// The items in the menu are in the same order as the items in the model, with the exception
+	// that pending items are missing. So, walking through the model and inserting each pending item
+	// at its position in the model will result in the pending items being placed correctly.
+	int position = 0;
+
+	for (const auto &pidl : m_historyModel->GetHistoryItems())
+	{
+		if (m_pendingItems.empty())
+		{
+			break;
+		}
+
+		auto itr = m_pendingItems.find(pidl);
+
+		if (itr != m_pendingItems.end())
+		{
+			auto id = InsertItem(position, pidl);
+
+			if (!id)
+			{
+				// There's no room left in the menu. The remaining items will stay pending, until
+				// existing items are evicted.
+				break;
+			}
+
+			m_itemIds.insert({ pidl, *id });
+			m_pendingItems.erase(itr);
+		}
+
+		position++;
+	}
 }
@@ -5,10 +5,20 @@
 #pragma once
 
 #include "ShellItemsMenu.h"
+#include "../Helper/Pidl.h"
+#include <boost/container_hash/hash.hpp>
+#include <boost/signals2.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class HistoryModel;
 
 // Displays the set of global history entries.
+//
+// The menu is updated incrementally as the history changes. Retrieving the name and path of an
+// item is relatively expensive, though, so new items are only added to the menu once it's about to
+// be shown.
 class HistoryMenu : public ShellItemsMenu
 {
 public:
@@ -17,9 +27,19 @@ public:
 		UINT startId = DEFAULT_START_ID, UINT endId = DEFAULT_END_ID);
 
 private:
-	void OnHistoryChanged();
-	static std::vector<PidlAbsolute> GetHistoryItems(const HistoryModel *historyModel);
+	void OnHistoryItemAdded(const PidlAbsolute &pidl);
+	void OnHistoryItemMoved(const PidlAbsolute &pidl);
+	void OnHistoryItemEvicted(const PidlAbsolute &pidl);
+	void OnMenuWillShow();
 
 	HistoryModel *const m_historyModel;
+
+	// The history items currently shown in the menu, mapped to their menu item IDs. The items in
+	// the menu always appear in the same order as they do in the model.
+	std::unordered_map<PidlAbsolute, UINT, boost::hash<PidlAbsolute>> m_itemIds;
+
+	// History items that haven't been added to the menu yet.
+	std::unordered_set<PidlAbsolute, boost::hash<PidlAbsolute>> m_pendingItems;
+
 	std::vector<boost::signals2::scoped_connection> m_connections;
 };
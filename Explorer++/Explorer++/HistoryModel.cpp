@@ -6,25 +6,57 @@
 #include "HistoryModel.h"
 #include "../Helper/ShellHelper.h"
 
+HistoryModel::HistoryModel(size_t maxItems) : m_maxItems(maxItems)
+{
+	CHECK_GT(maxItems, 0u);
+}
+
 void HistoryModel::AddHistoryItem(const PidlAbsolute &pidl)
 {
-	if (!m_historyItems.empty() && (pidl == m_historyItems.front()))
+	auto [itr, inserted] = m_historyItems.push_front(pidl);
+
+	if (!inserted)
 	{
-		// This item is the same as the most recent history item.
+		if (itr == m_historyItems.begin())
+		{
+			// This item is the same as the most recent history item.
+			return;
+		}
+
+		m_historyItems.relocate(m_historyItems.begin(), itr);
+		m_historyItemMovedSignal(*itr);
 		return;
 	}
 
-	m_historyItems.push_front(pidl);
-	m_historyChangedSignal();
+	m_historyItemAddedSignal(*itr);
+
+	if (m_historyItems.size() > m_maxItems)
+	{
+		PidlAbsolute evictedItem = m_historyItems.back();
+		m_historyItems.pop_back();
+		m_historyItemEvictedSignal(evictedItem);
+	}
+}
+
+const HistoryModel::ByRecencyIndex &HistoryModel::GetHistoryItems() const
+{
+	return m_historyItems.get<ByRecency>();
+}
+
+boost::signals2::connection HistoryModel::AddHistoryItemAddedObserver(
+	const HistoryItemAddedSignal::slot_type &observer)
+{
+	return m_historyItemAddedSignal.connect(observer);
 }
 
-const std::deque<PidlAbsolute> &HistoryModel::GetHistoryItems() const
+boost::signals2::connection HistoryModel::AddHistoryItemMovedObserver(
+	const HistoryItemMovedSignal::slot_type &observer)
 {
-	return m_historyItems;
+	return m_historyItemMovedSignal.connect(observer);
 }
 
-boost::signals2::connection HistoryModel::AddHistoryChangedObserver(
-	const HistoryChangedSignal::slot_type &observer)
+boost::signals2::connection HistoryModel::AddHistoryItemEvictedObserver(
+	const HistoryItemEvictedSignal::slot_type &observer)
 {
-	return m_historyChangedSignal.connect(observer);
+	return m_historyItemEvictedSignal.connect(observer);
 }
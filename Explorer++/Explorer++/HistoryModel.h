@@ -5,24 +5,74 @@
 #pragma once
 
 #include "../Helper/Pidl.h"
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index_container.hpp>
 #include <boost/signals2.hpp>
-#include <deque>
 
-// Stores global history (i.e. the history of navigations across all tabs).
+// Stores global history (i.e. the history of navigations across all tabs). Each location is only
+// stored once, with a repeat visit moving the location back to the front. Once the maximum number
+// of items has been reached, the least recently visited location is evicted.
 class HistoryModel
 {
 public:
-	using HistoryChangedSignal = boost::signals2::signal<void()>;
+	// Signaled when an item is added to the front of the history.
+	using HistoryItemAddedSignal = boost::signals2::signal<void(const PidlAbsolute &pidl)>;
+
+	// Signaled when an existing item is moved to the front of the history.
+	using HistoryItemMovedSignal = boost::signals2::signal<void(const PidlAbsolute &pidl)>;
+
+	// Signaled when the least recently visited item is removed, to make room for a new item.
+	using HistoryItemEvictedSignal = boost::signals2::signal<void(const PidlAbsolute &pidl)>;
+
+	struct ByRecency
+	{
+	};
+
+	struct ByLocation
+	{
+	};
+
+	// clang-format off
+	using HistoryItems = boost::multi_index_container<PidlAbsolute,
+		boost::multi_index::indexed_by<
+			// An index of items, with the most recently visited items first.
+			boost::multi_index::sequenced<
+				boost::multi_index::tag<ByRecency>
+			>,
+
+			// A non-sorted index of items, based on the pidl.
+			boost::multi_index::hashed_unique<
+				boost::multi_index::tag<ByLocation>,
+				boost::multi_index::identity<PidlAbsolute>
+			>
+		>
+	>;
+	// clang-format on
+
+	using ByRecencyIndex = HistoryItems::index<ByRecency>::type;
+
+	static constexpr size_t DEFAULT_MAX_ITEMS = 1000;
+
+	explicit HistoryModel(size_t maxItems = DEFAULT_MAX_ITEMS);
 
 	void AddHistoryItem(const PidlAbsolute &pidl);
 
 	// Returns the set of history items, with more recent items appearing first.
-	const std::deque<PidlAbsolute> &GetHistoryItems() const;
+	const ByRecencyIndex &GetHistoryItems() const;
 
-	boost::signals2::connection AddHistoryChangedObserver(
-		const HistoryChangedSignal::slot_type &observer);
+	boost::signals2::connection AddHistoryItemAddedObserver(
+		const HistoryItemAddedSignal::slot_type &observer);
+	boost::signals2::connection AddHistoryItemMovedObserver(
+		const HistoryItemMovedSignal::slot_type &observer);
+	boost::signals2::connection AddHistoryItemEvictedObserver(
+		const HistoryItemEvictedSignal::slot_type &observer);
 
 private:
-	std::deque<PidlAbsolute> m_historyItems;
-	HistoryChangedSignal m_historyChangedSignal;
+	const size_t m_maxItems;
+	HistoryItems m_historyItems;
+	HistoryItemAddedSignal m_historyItemAddedSignal;
+	HistoryItemMovedSignal m_historyItemMovedSignal;
+	HistoryItemEvictedSignal m_historyItemEvictedSignal;
 };
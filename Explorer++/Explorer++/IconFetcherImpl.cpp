@@ -4,14 +4,15 @@
 
 #include "stdafx.h"
 #include "IconFetcherImpl.h"
+#include "TaskScheduler.h"
 #include "../Helper/CachedIcons.h"
 #include "../Helper/WindowSubclass.h"
 
-IconFetcherImpl::IconFetcherImpl(HWND hwnd, CachedIcons *cachedIcons) :
+IconFetcherImpl::IconFetcherImpl(HWND hwnd, CachedIcons *cachedIcons,
+	TaskScheduler *taskScheduler) :
 	m_hwnd(hwnd),
 	m_cachedIcons(cachedIcons),
-	m_iconThreadPool(1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED),
-		CoUninitialize),
+	m_iconTaskQueue(taskScheduler->CreateQueue()),
 	m_iconResultIDCounter(0)
 {
 	FAIL_FAST_IF_FAILED(GetDefaultFileIconIndex(m_defaultFileIconIndex));
@@ -23,7 +24,7 @@ IconFetcherImpl::IconFetcherImpl(HWND hwnd, CachedIcons *cachedIcons) :
 
 IconFetcherImpl::~IconFetcherImpl()
 {
-	m_iconThreadPool.clear_queue();
+	m_iconTaskQueue->Clear();
 }
 
 LRESULT IconFetcherImpl::OwnerWindowSubclass(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -43,11 +44,9 @@ void IconFetcherImpl::QueueIconTask(std::wstring_view path, Callback callback)
 {
 	int iconResultID = m_iconResultIDCounter++;
 
-	auto iconResult = m_iconThreadPool.push(
-		[this, iconResultID, copiedPath = std::wstring(path)](int id) -> std::optional<IconResult>
+	auto iconResult = m_iconTaskQueue->Push(
+		[this, iconResultID, copiedPath = std::wstring(path)]() -> std::optional<IconResult>
 		{
-			UNREFERENCED_PARAMETER(id);
-
 			// SHGetFileInfo will fail for non-filesystem paths that are passed in
 			// as strings. For example, attempting to retrieve the icon for the
 			// recycle bin will fail if you pass the parsing path (i.e.
@@ -87,17 +86,26 @@ void IconFetcherImpl::QueueIconTask(std::wstring_view path, Callback callback)
 }
 
 void IconFetcherImpl::QueueIconTask(PCIDLIST_ABSOLUTE pidl, Callback callback)
+{
+	QueueIconTaskInternal(pidl, std::nullopt, callback);
+}
+
+void IconFetcherImpl::QueueIconTask(PCIDLIST_ABSOLUTE pidl, int taskId, Callback callback)
+{
+	QueueIconTaskInternal(pidl, taskId, callback);
+}
+
+void IconFetcherImpl::QueueIconTaskInternal(PCIDLIST_ABSOLUTE pidl, std::optional<int> taskId,
+	Callback callback)
 {
 	int iconResultID = m_iconResultIDCounter++;
 
 	BasicItemInfo basicItemInfo;
 	basicItemInfo.pidl.reset(ILCloneFull(pidl));
 
-	auto iconResult = m_iconThreadPool.push(
-		[this, iconResultID, basicItemInfo](int id) -> std::optional<IconResult>
+	auto iconResult = m_iconTaskQueue->Push(
+		[this, iconResultID, basicItemInfo]() -> std::optional<IconResult>
 		{
-			UNREFERENCED_PARAMETER(id);
-
 			// It's important that pidl is updated. Otherwise, the icon that's retrieved may be the
 			// original icon.
 			PidlAbsolute updatedPidl;
@@ -136,7 +144,8 @@ void IconFetcherImpl::QueueIconTask(PCIDLIST_ABSOLUTE pidl, Callback callback)
 			PostMessage(m_hwnd, WM_APP_ICON_RESULT_READY, iconResultID, 0);
 
 			return result;
-		});
+		},
+		taskId);
 
 	FutureResult futureResult;
 	futureResult.callback = callback;
@@ -144,6 +153,21 @@ void IconFetcherImpl::QueueIconTask(PCIDLIST_ABSOLUTE pidl, Callback callback)
 	m_iconResults.insert({ iconResultID, std::move(futureResult) });
 }
 
+void IconFetcherImpl::PrioritizeTasks(const std::unordered_set<int> &taskIds)
+{
+	m_iconTaskQueue->Prioritize(taskIds);
+}
+
+void IconFetcherImpl::SetTaskPriority(TaskPriority priority)
+{
+	m_iconTaskQueue->SetPriority(priority);
+}
+
+TaskCounters IconFetcherImpl::GetTaskCounters() const
+{
+	return m_iconTaskQueue->GetCounters();
+}
+
 std::optional<ShellIconInfo> IconFetcherImpl::FindIconAsync(PCIDLIST_ABSOLUTE pidl)
 {
 	// Must use SHGFI_ICON here, rather than SHGFO_SYSICONINDEX, or else
@@ -190,7 +214,7 @@ void IconFetcherImpl::ProcessIconResult(int iconResultId)
 
 void IconFetcherImpl::ClearQueue()
 {
-	m_iconThreadPool.clear_queue();
+	m_iconTaskQueue->Clear();
 	m_iconResults.clear();
 }
 
@@ -6,17 +6,22 @@
 
 #include "IconFetcher.h"
 #include "../Helper/ShellHelper.h"
-#include "../ThirdParty/CTPL/cpl_stl.h"
 #include <future>
+#include <optional>
 #include <unordered_map>
+#include <unordered_set>
 
 class CachedIcons;
+struct TaskCounters;
+enum class TaskPriority;
+class TaskQueue;
+class TaskScheduler;
 class WindowSubclass;
 
 class IconFetcherImpl : public IconFetcher
 {
 public:
-	IconFetcherImpl(HWND hwnd, CachedIcons *cachedIcons);
+	IconFetcherImpl(HWND hwnd, CachedIcons *cachedIcons, TaskScheduler *taskScheduler);
 	~IconFetcherImpl();
 
 	void QueueIconTask(std::wstring_view path, Callback callback) override;
@@ -26,6 +31,14 @@ public:
 		DefaultIconType defaultIconType) const override;
 	std::optional<int> GetCachedIconIndex(const std::wstring &itemPath) const override;
 
+	// Queues a task that's associated with the specified ID. That allows the task to be moved
+	// ahead of other queued tasks (see PrioritizeTasks()).
+	void QueueIconTask(PCIDLIST_ABSOLUTE pidl, int taskId, Callback callback);
+	void PrioritizeTasks(const std::unordered_set<int> &taskIds);
+	void SetTaskPriority(TaskPriority priority);
+
+	TaskCounters GetTaskCounters() const;
+
 private:
 	// This is the end of the range that starts at WM_APP. This class subclasses the window that's
 	// passed to the constructor, so it's not possible to tell what other WM_APP messages are in
@@ -60,6 +73,9 @@ private:
 
 	LRESULT OwnerWindowSubclass(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
+	void QueueIconTaskInternal(PCIDLIST_ABSOLUTE pidl, std::optional<int> taskId,
+		Callback callback);
+
 	static std::optional<ShellIconInfo> FindIconAsync(PCIDLIST_ABSOLUTE pidl);
 	void ProcessIconResult(int iconResultId);
 
@@ -69,7 +85,7 @@ private:
 	int m_defaultFileIconIndex;
 	int m_defaultFolderIconIndex;
 
-	ctpl::thread_pool m_iconThreadPool;
+	const std::unique_ptr<TaskQueue> m_iconTaskQueue;
 	std::unordered_map<int, FutureResult> m_iconResults;
 	int m_iconResultIDCounter;
 	std::function<void(int data)> m_callback;
@@ -40,7 +40,7 @@ void Explorerplusplus::OnDestroyFiles()
 	}
 
 	auto *destroyFilesDialog = DestroyFilesDialog::Create(m_app->GetResourceLoader(), m_hContainer,
-		fullFilenameList, m_config->globalFolderSettings.showFriendlyDates);
+		fullFilenameList, m_config->globalFolderSettings.showFriendlyDates.get());
 	destroyFilesDialog->ShowModalDialog();
 }
 
@@ -21,6 +21,14 @@ MenuView::~MenuView()
 void MenuView::AppendItem(UINT id, const std::wstring &text,
 	std::unique_ptr<const IconModel> iconModel, const std::wstring &helpText,
 	const std::optional<std::wstring> &acceleratorText)
+{
+	InsertItem(GetMenuItemCount(GetMenu()), id, text, std::move(iconModel), helpText,
+		acceleratorText);
+}
+
+void MenuView::InsertItem(int position, UINT id, const std::wstring &text,
+	std::unique_ptr<const IconModel> iconModel, const std::wstring &helpText,
+	const std::optional<std::wstring> &acceleratorText)
 {
 	// The value 0 shouldn't be used as an item ID. That's because a call like TrackPopupMenu() will
 	// use a return value of 0 to indicate the menu was canceled, or an error occurred.
@@ -39,7 +47,7 @@ void MenuView::AppendItem(UINT id, const std::wstring &text,
 	menuItemInfo.wID = id;
 	menuItemInfo.dwTypeData = finalText.data();
 
-	auto res = InsertMenuItem(GetMenu(), GetMenuItemCount(GetMenu()), true, &menuItemInfo);
+	auto res = InsertMenuItem(GetMenu(), position, true, &menuItemInfo);
 	CHECK(res);
 
 	auto [itr, didInsert] = m_idToItemMap.try_emplace(id, std::move(iconModel), helpText);
@@ -53,6 +61,40 @@ void MenuView::AppendItem(UINT id, const std::wstring &text,
 	{
 		SetItemImage(id);
 	}
+	else
+	{
+		m_idsAwaitingImages.insert(id);
+	}
+}
+
+void MenuView::MoveItem(UINT id, int newPosition)
+{
+	const auto *item = GetItem(id);
+	auto text = MenuHelper::GetMenuItemString(GetMenu(), id, false);
+
+	auto res = DeleteMenu(GetMenu(), id, MF_BYCOMMAND);
+	CHECK(res);
+
+	// The item details are retained, so there's no need to regenerate the text or image.
+	MENUITEMINFO menuItemInfo = {};
+	menuItemInfo.cbSize = sizeof(menuItemInfo);
+	menuItemInfo.fMask = MIIM_ID | MIIM_STRING | MIIM_BITMAP;
+	menuItemInfo.wID = id;
+	menuItemInfo.dwTypeData = text.data();
+	menuItemInfo.hbmpItem = item->bitmap.get();
+	res = InsertMenuItem(GetMenu(), newPosition, true, &menuItemInfo);
+	CHECK(res);
+}
+
+void MenuView::RemoveItem(UINT id)
+{
+	auto res = DeleteMenu(GetMenu(), id, MF_BYCOMMAND);
+	CHECK(res);
+
+	auto numErased = m_idToItemMap.erase(id);
+	CHECK_EQ(numErased, 1u);
+
+	m_idsAwaitingImages.erase(id);
 }
 
 void MenuView::SetItemImage(UINT id)
@@ -67,10 +109,11 @@ void MenuView::SetItemImage(UINT id)
 	auto bitmap = item->iconModel->GetBitmap(GetCurrentDpi(),
 		[id, self = m_weakPtrFactory.GetWeakPtr()](wil::unique_hbitmap updatedBitmap)
 		{
-			if (!self)
+			if (!self || !self->m_idToItemMap.contains(id))
 			{
-				// The updated image can be returned after the menu has been closed or cleared. In
-				// either case, there's nothing that needs to be done.
+				// The updated image can be returned after the menu has been closed or cleared, or
+				// after the item has been removed. In each case, there's nothing that needs to be
+				// done.
 				return;
 			}
 
@@ -125,6 +168,7 @@ void MenuView::ClearMenu()
 	}
 
 	m_idToItemMap.clear();
+	m_idsAwaitingImages.clear();
 	m_lastRenderedImageDpi.reset();
 	m_weakPtrFactory.InvalidateWeakPtrs();
 }
@@ -138,6 +182,8 @@ void MenuView::OnMenuWillShowForDpi(UINT dpi)
 {
 	DCHECK(!m_currentDpi);
 
+	m_menuWillShowSignal();
+
 	m_currentDpi = dpi;
 
 	MaybeAddImagesToMenu();
@@ -168,8 +214,14 @@ void MenuView::MaybeAddImagesToMenu()
 {
 	if (GetCurrentDpi() == m_lastRenderedImageDpi)
 	{
-		// The DPI hasn't changed since the images were last added, so there's nothing that needs to
-		// be done.
+		// The DPI hasn't changed since the images were last added, so only the images for items
+		// added since then need to be set.
+		for (UINT id : m_idsAwaitingImages)
+		{
+			SetItemImage(id);
+		}
+
+		m_idsAwaitingImages.clear();
 		return;
 	}
 
@@ -178,6 +230,7 @@ void MenuView::MaybeAddImagesToMenu()
 		SetItemImage(id);
 	}
 
+	m_idsAwaitingImages.clear();
 	m_lastRenderedImageDpi = GetCurrentDpi();
 }
 
@@ -244,3 +297,9 @@ boost::signals2::connection MenuView::AddViewDestroyedObserver(
 {
 	return m_viewDestroyedSignal.connect(observer);
 }
+
+boost::signals2::connection MenuView::AddMenuWillShowObserver(
+	const MenuWillShowSignal::slot_type &observer)
+{
+	return m_menuWillShowSignal.connect(observer);
+}
@@ -11,6 +11,7 @@
 #include <memory>
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
 
 class MenuHelpTextHost;
 
@@ -22,6 +23,7 @@ public:
 	using ItemMiddleClickedSignal =
 		boost::signals2::signal<void(UINT menuItemId, bool isCtrlKeyDown, bool isShiftKeyDown)>;
 	using ViewDestroyedSignal = boost::signals2::signal<void()>;
+	using MenuWillShowSignal = boost::signals2::signal<void()>;
 
 	MenuView(MenuHelpTextHost *menuHelpTextHost);
 	virtual ~MenuView();
@@ -29,6 +31,11 @@ public:
 	void AppendItem(UINT id, const std::wstring &text,
 		std::unique_ptr<const IconModel> iconModel = {}, const std::wstring &helpText = L"",
 		const std::optional<std::wstring> &acceleratorText = std::nullopt);
+	void InsertItem(int position, UINT id, const std::wstring &text,
+		std::unique_ptr<const IconModel> iconModel = {}, const std::wstring &helpText = L"",
+		const std::optional<std::wstring> &acceleratorText = std::nullopt);
+	void MoveItem(UINT id, int newPosition);
+	void RemoveItem(UINT id);
 	void AppendSeparator();
 	void EnableItem(UINT id, bool enable);
 	void CheckItem(UINT id, bool check);
@@ -47,6 +54,11 @@ public:
 	boost::signals2::connection AddViewDestroyedObserver(
 		const ViewDestroyedSignal::slot_type &observer);
 
+	// Signaled just before the menu is shown. This allows the menu to be updated at the last
+	// moment, which can be useful if building the menu items is expensive.
+	boost::signals2::connection AddMenuWillShowObserver(
+		const MenuWillShowSignal::slot_type &observer);
+
 protected:
 	virtual HMENU GetMenu() const = 0;
 
@@ -82,6 +94,10 @@ private:
 
 	std::unordered_map<UINT, Item> m_idToItemMap;
 
+	// Items that were added while the menu wasn't being shown and that haven't yet had their
+	// images added.
+	std::unordered_set<UINT> m_idsAwaitingImages;
+
 	// This will only be set whilst the menu is being shown.
 	std::optional<UINT> m_currentDpi;
 
@@ -96,6 +112,7 @@ private:
 	ItemSelectedSignal m_itemSelectedSignal;
 	ItemMiddleClickedSignal m_itemMiddleClickedSignal;
 	ViewDestroyedSignal m_viewDestroyedSignal;
+	MenuWillShowSignal m_menuWillShowSignal;
 
 	WeakPtrFactory<MenuView> m_weakPtrFactory{ this };
 };
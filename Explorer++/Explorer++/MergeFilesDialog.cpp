@@ -7,6 +7,8 @@
 #include "App.h"
 #include "MainResource.h"
 #include "ResourceLoader.h"
+#include "TransferProgressHelper.h"
+#include "../Helper/FileConcatenation.h"
 #include "../Helper/FileOperations.h"
 #include "../Helper/Helper.h"
 #include "../Helper/ListViewHelper.h"
@@ -19,10 +21,12 @@
 
 namespace NMergeFilesDialog
 {
-const int WM_APP_SETTOTALMERGECOUNT = WM_APP + 1;
-const int WM_APP_SETCURRENTMERGECOUNT = WM_APP + 2;
-const int WM_APP_MERGINGFINISHED = WM_APP + 3;
-const int WM_APP_OUTPUTFILEINVALID = WM_APP + 4;
+const int WM_APP_SETPROGRESS = WM_APP + 1;
+const int WM_APP_MERGINGFINISHED = WM_APP + 2;
+const int WM_APP_OUTPUTFILEINVALID = WM_APP + 3;
+
+// The progress bar tracks the number of bytes copied, scaled to this range.
+const int PROGRESS_BAR_RANGE = 1000;
 
 DWORD WINAPI MergeFilesThread(LPVOID pParam);
 }
@@ -258,20 +262,14 @@ INT_PTR MergeFilesDialog::OnClose()
 
 INT_PTR MergeFilesDialog::OnPrivateMessage(UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
-	UNREFERENCED_PARAMETER(lParam);
-
 	switch (uMsg)
 	{
-	case NMergeFilesDialog::WM_APP_SETTOTALMERGECOUNT:
-		SendDlgItemMessage(m_hDlg, IDC_MERGE_PROGRESS, PBM_SETRANGE32, 0, wParam);
-		break;
-
-	case NMergeFilesDialog::WM_APP_SETCURRENTMERGECOUNT:
-		SendDlgItemMessage(m_hDlg, IDC_MERGE_PROGRESS, PBM_SETPOS, wParam, 0);
+	case NMergeFilesDialog::WM_APP_SETPROGRESS:
+		OnMergeProgress(static_cast<int>(wParam), static_cast<std::uint64_t>(lParam));
 		break;
 
 	case NMergeFilesDialog::WM_APP_MERGINGFINISHED:
-		OnFinished();
+		OnFinished(static_cast<bool>(wParam));
 		break;
 
 	case NMergeFilesDialog::WM_APP_OUTPUTFILEINVALID:
@@ -287,6 +285,7 @@ INT_PTR MergeFilesDialog::OnPrivateMessage(UINT uMsg, WPARAM wParam, LPARAM lPar
 		m_bMergingFiles = false;
 		m_bStopMerging = false;
 
+		SetWindowText(m_hDlg, m_title.c_str());
 		SetDlgItemText(m_hDlg, IDOK, m_szOk);
 	}
 	break;
@@ -318,8 +317,12 @@ void MergeFilesDialog::OnOk()
 
 		m_pMergeFiles = new MergeFiles(m_hDlg, outputFileName, m_filePaths);
 
+		SendDlgItemMessage(m_hDlg, IDC_MERGE_PROGRESS, PBM_SETRANGE32, 0,
+			NMergeFilesDialog::PROGRESS_BAR_RANGE);
 		SendDlgItemMessage(m_hDlg, IDC_MERGE_PROGRESS, PBM_SETPOS, 0, 0);
 
+		m_title = GetWindowString(m_hDlg);
+
 		GetDlgItemText(m_hDlg, IDOK, m_szOk, static_cast<int>(std::size(m_szOk)));
 
 		auto cancelText = m_resourceLoader->LoadString(IDS_CANCEL);
@@ -418,22 +421,52 @@ void MergeFilesDialog::OnMove(bool bUp)
 	}
 }
 
-void MergeFilesDialog::OnFinished()
+void MergeFilesDialog::OnFinished(bool succeeded)
 {
 	assert(m_pMergeFiles != nullptr);
 
 	m_pMergeFiles->Release();
 	m_pMergeFiles = nullptr;
 
+	bool stopped = m_bStopMerging;
+
 	m_bMergingFiles = false;
 	m_bStopMerging = false;
 
-	/* Set the progress bar position to the end. */
-	int iHighLimit =
-		static_cast<int>(SendDlgItemMessage(m_hDlg, IDC_MERGE_PROGRESS, PBM_GETRANGE, FALSE, 0));
-	SendDlgItemMessage(m_hDlg, IDC_MERGE_PROGRESS, PBM_SETPOS, iHighLimit, 0);
+	int position = 0;
 
+	if (succeeded)
+	{
+		/* Set the progress bar position to the end. */
+		position = static_cast<int>(
+			SendDlgItemMessage(m_hDlg, IDC_MERGE_PROGRESS, PBM_GETRANGE, FALSE, 0));
+	}
+
+	SendDlgItemMessage(m_hDlg, IDC_MERGE_PROGRESS, PBM_SETPOS, position, 0);
+
+	SetWindowText(m_hDlg, m_title.c_str());
 	SetDlgItemText(m_hDlg, IDOK, m_szOk);
+
+	// If the user stopped the merge, there's no need to report that it didn't complete.
+	if (!succeeded && !stopped)
+	{
+		auto errorMessage = m_resourceLoader->LoadString(IDS_MERGE_FILES_FAILED);
+		MessageBox(m_hDlg, errorMessage.c_str(), App::APP_NAME, MB_ICONWARNING | MB_OK);
+	}
+}
+
+void MergeFilesDialog::OnMergeProgress(int position, std::uint64_t bytesPerSecond)
+{
+	if (!m_bMergingFiles)
+	{
+		return;
+	}
+
+	SendDlgItemMessage(m_hDlg, IDC_MERGE_PROGRESS, PBM_SETPOS, position, 0);
+
+	// There's no status text in this dialog, so the transfer rate is shown in the title bar.
+	auto title = TransferProgressHelper::FormatStatus(m_resourceLoader, m_title, bytesPerSecond);
+	SetWindowText(m_hDlg, title.c_str());
 }
 
 DWORD WINAPI NMergeFilesDialog::MergeFilesThread(LPVOID pParam)
@@ -452,87 +485,46 @@ MergeFiles::MergeFiles(HWND hDlg, const std::wstring &strOutputFilename,
 	m_hDlg = hDlg;
 	m_strOutputFilename = strOutputFilename;
 	m_filePaths = filePaths;
-
-	m_bstopMerging = false;
-
-	InitializeCriticalSection(&m_csStop);
-}
-
-MergeFiles::~MergeFiles()
-{
-	DeleteCriticalSection(&m_csStop);
 }
 
 void MergeFiles::StartMerging()
 {
-	LARGE_INTEGER lMergeFileSize;
-	int nFilesMerged = 1;
-	bool bStop = false;
-
-	HANDLE hOutputFile = CreateFile(m_strOutputFilename.c_str(), GENERIC_WRITE, 0, nullptr,
-		CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+	wil::unique_hfile outputFile(CreateFile(m_strOutputFilename.c_str(), GENERIC_WRITE, 0,
+		nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr));
 
-	if (hOutputFile == INVALID_HANDLE_VALUE)
+	if (!outputFile)
 	{
 		PostMessage(m_hDlg, NMergeFilesDialog::WM_APP_OUTPUTFILEINVALID, 0, 0);
 		return;
 	}
 
-	PostMessage(m_hDlg, NMergeFilesDialog::WM_APP_SETTOTALMERGECOUNT,
-		static_cast<WPARAM>(m_filePaths.size()), 0);
-
-	for (const auto &strFullFilename : m_filePaths)
-	{
-		if (bStop)
-		{
-			break;
-		}
-
-		HANDLE hInputFile = CreateFile(strFullFilename.c_str(), GENERIC_READ, FILE_SHARE_READ,
-			nullptr, OPEN_EXISTING, 0, nullptr);
-
-		if (hInputFile != INVALID_HANDLE_VALUE)
-		{
-			GetFileSizeEx(hInputFile, &lMergeFileSize);
-
-			if (lMergeFileSize.QuadPart != 0)
-			{
-				auto buffer = std::make_unique<char[]>(lMergeFileSize.LowPart);
-
-				DWORD dwNumberOfBytesRead;
-				ReadFile(hInputFile, reinterpret_cast<LPVOID>(buffer.get()),
-					static_cast<DWORD>(lMergeFileSize.LowPart), &dwNumberOfBytesRead, nullptr);
-
-				DWORD dwNumberOfBytesWritten;
-				WriteFile(hOutputFile, reinterpret_cast<LPCVOID>(buffer.get()), dwNumberOfBytesRead,
-					&dwNumberOfBytesWritten, nullptr);
-			}
-
-			CloseHandle(hInputFile);
-
-			PostMessage(m_hDlg, NMergeFilesDialog::WM_APP_SETCURRENTMERGECOUNT, nFilesMerged, 0);
+	PipelinedFileCopier copier(m_stopSource.get_token(),
+		std::bind_front(&MergeFiles::OnProgress, this));
+	bool succeeded = ConcatenateFiles(m_filePaths, outputFile.get(), copier,
+		[this](std::uint64_t totalSize) { m_totalSize = totalSize; });
 
-			nFilesMerged++;
+	outputFile.reset();
 
-			EnterCriticalSection(&m_csStop);
-			if (m_bstopMerging)
-			{
-				bStop = true;
-			}
-			LeaveCriticalSection(&m_csStop);
-		}
+	if (!succeeded)
+	{
+		// The output file was created above, so it can be safely removed. Leaving it in place
+		// would make it look like the files had been merged.
+		DeleteFile(m_strOutputFilename.c_str());
 	}
 
-	CloseHandle(hOutputFile);
+	SendMessage(m_hDlg, NMergeFilesDialog::WM_APP_MERGINGFINISHED, succeeded, 0);
+}
 
-	SendMessage(m_hDlg, NMergeFilesDialog::WM_APP_MERGINGFINISHED, 0, 0);
+void MergeFiles::OnProgress(const PipelinedFileCopier::Progress &progress)
+{
+	TransferProgressHelper::PostProgressMessage(m_hDlg, NMergeFilesDialog::WM_APP_SETPROGRESS,
+		progress.bytesCopied, m_totalSize, NMergeFilesDialog::PROGRESS_BAR_RANGE,
+		progress.bytesPerSecond);
 }
 
 void MergeFiles::StopMerging()
 {
-	EnterCriticalSection(&m_csStop);
-	m_bstopMerging = true;
-	LeaveCriticalSection(&m_csStop);
+	m_stopSource.request_stop();
 }
 
 MergeFilesDialogPersistentSettings::MergeFilesDialogPersistentSettings() :
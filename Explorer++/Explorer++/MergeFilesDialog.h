@@ -6,8 +6,11 @@
 
 #include "BaseDialog.h"
 #include "../Helper/DialogSettings.h"
+#include "../Helper/PipelinedFileCopier.h"
 #include "../Helper/ReferenceCount.h"
 #include "../Helper/ResizableDialogHelper.h"
+#include <cstdint>
+#include <stop_token>
 #include <string>
 #include <vector>
 
@@ -34,19 +37,20 @@ class MergeFiles : public ReferenceCount
 public:
 	MergeFiles(HWND hDlg, const std::wstring &strOutputFilename,
 		const std::vector<std::wstring> &filePaths);
-	~MergeFiles();
 
 	void StartMerging();
 	void StopMerging();
 
 private:
+	void OnProgress(const PipelinedFileCopier::Progress &progress);
+
 	HWND m_hDlg;
 
 	std::wstring m_strOutputFilename;
 	std::vector<std::wstring> m_filePaths;
+	std::uint64_t m_totalSize = 0;
 
-	CRITICAL_SECTION m_csStop;
-	bool m_bstopMerging;
+	std::stop_source m_stopSource;
 };
 
 class MergeFilesDialog : public BaseDialog
@@ -78,7 +82,8 @@ private:
 	void OnCancel();
 	void OnChangeOutputDirectory();
 	void OnMove(bool bUp);
-	void OnFinished();
+	void OnFinished(bool succeeded);
+	void OnMergeProgress(int position, std::uint64_t bytesPerSecond);
 
 	std::wstring m_strOutputDirectory;
 	std::vector<std::wstring> m_filePaths;
@@ -88,6 +93,7 @@ private:
 	bool m_bMergingFiles;
 	bool m_bStopMerging;
 	TCHAR m_szOk[32];
+	std::wstring m_title;
 
 	MergeFilesDialogPersistentSettings *m_persistentSettings;
 };
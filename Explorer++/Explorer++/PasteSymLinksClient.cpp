@@ -4,42 +4,133 @@
 
 #include "stdafx.h"
 #include "PasteSymLinksClient.h"
+#include <boost/interprocess/sync/scoped_lock.hpp>
 #include <cereal/archives/binary.hpp>
 
-void PasteSymLinksClient::NotifyServerOfResult(const ClipboardOperations::PastedItems &pastedItems)
+PasteSymLinksClient::PasteSymLinksClient()
 {
 	try
 	{
-		Segment segment(boost::interprocess::open_only, SHARED_MEMORY_NAME);
+		m_segment.emplace(boost::interprocess::open_only, SHARED_MEMORY_NAME);
+	}
+	catch (const boost::interprocess::interprocess_exception &e)
+	{
+		// If this exception is thrown, it indicates that the shared memory isn't present (i.e. the
+		// server is gone).
+		LOG(ERROR) << e.what();
+		return;
+	}
 
-		auto [sharedData, length] = segment.find<SharedData>(SHARED_DATA_NAME);
+	auto [sharedData, length] = m_segment->find<SharedData>(SHARED_DATA_NAME);
 
-		if (!sharedData || length != 1)
-		{
-			DCHECK(false);
-			return;
-		}
+	if (!sharedData || length != 1)
+	{
+		DCHECK(false);
+		return;
+	}
 
-		std::stringstream stringstream;
-		cereal::BinaryOutputArchive outputArchive(stringstream);
+	m_sharedData = sharedData;
 
-		outputArchive(pastedItems);
+	boost::interprocess::scoped_lock lock(m_sharedData->mutex);
+	m_sharedData->clientConnected = true;
+	m_sharedData->chunkWrittenCondition.notify_all();
+}
 
-		sharedData->serializedResultData = stringstream.view();
+PasteSymLinksClient::~PasteSymLinksClient()
+{
+	FinishStream();
+}
 
-		boost::interprocess::scoped_lock lock(sharedData->resultMutex);
-		sharedData->resultCondition.notify_all();
+bool PasteSymLinksClient::NotifyServerOfResult(
+	const ClipboardOperations::PastedItems &pastedItems)
+{
+	if (!m_sharedData || m_finished)
+	{
+		return false;
 	}
-	catch (const boost::interprocess::interprocess_exception &e)
+
+	for (size_t i = 0; i < pastedItems.size(); i += RESULTS_PER_MESSAGE)
 	{
-		// If this exception is thrown, it indicates that the shared memory isn't present (i.e. the
-		// server is gone).
-		LOG(ERROR) << e.what();
+		size_t batchEnd = std::min(i + RESULTS_PER_MESSAGE, pastedItems.size());
+		ClipboardOperations::PastedItems batch(pastedItems.begin() + i,
+			pastedItems.begin() + batchEnd);
+
+		std::stringstream stringstream;
+
+		{
+			cereal::BinaryOutputArchive outputArchive(stringstream);
+			outputArchive(batch);
+		}
+
+		if (!WriteMessage(stringstream.view()))
+		{
+			// There's no point sending any further results.
+			m_finished = true;
+			return false;
+		}
 	}
-	catch (const boost::container::length_error &e)
+
+	return true;
+}
+
+void PasteSymLinksClient::FinishStream()
+{
+	if (!m_sharedData || m_finished)
 	{
-		// If this exception is thrown, it indicates that the shared memory isn't large enough to
-		// hold the serialized string.
-		LOG(ERROR) << e.what();
+		return;
+	}
+
+	boost::interprocess::scoped_lock lock(m_sharedData->mutex);
+	m_sharedData->streamFinished = true;
+	m_sharedData->chunkWrittenCondition.notify_all();
+
+	m_finished = true;
+}
+
+bool PasteSymLinksClient::WriteMessage(std::string_view message)
+{
+	do
+	{
+		auto data = message.substr(0, CHUNK_DATA_SIZE);
+		message.remove_prefix(data.size());
+
+		if (!WriteChunk(data, message.empty()))
+		{
+			return false;
+		}
+	} while (!message.empty());
+
+	return true;
+}
+
+bool PasteSymLinksClient::WriteChunk(std::string_view data, bool endOfMessage)
+{
+	DCHECK_LE(data.size(), CHUNK_DATA_SIZE);
+
+	boost::interprocess::scoped_lock lock(m_sharedData->mutex);
+
+	bool chunkFree = m_sharedData->chunkReadCondition.wait_for(lock, CLIENT_WRITE_TIMEOUT,
+		[this]
+		{
+			return m_sharedData->serverFinished
+				|| m_sharedData->writeSequenceNumber - m_sharedData->readSequenceNumber
+				< NUM_CHUNKS;
+		});
+
+	if (!chunkFree || m_sharedData->serverFinished)
+	{
+		LOG(ERROR) << "Server stopped reading results";
+		return false;
 	}
+
+	auto &chunk = m_sharedData->chunks[m_sharedData->writeSequenceNumber % NUM_CHUNKS];
+	chunk.sequenceNumber = m_sharedData->writeSequenceNumber;
+	chunk.size = static_cast<uint32_t>(data.size());
+	chunk.endOfMessage = endOfMessage;
+	std::copy(data.begin(), data.end(), chunk.data);
+
+	m_sharedData->writeSequenceNumber++;
+	m_sharedData->chunkWrittenCondition.notify_all();
+
+	return true;
 }
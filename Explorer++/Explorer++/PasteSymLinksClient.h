@@ -6,9 +6,33 @@
 
 #include "ClipboardOperations.h"
 #include "PasteSymLinksServerClientBase.h"
+#include <boost/core/noncopyable.hpp>
+#include <optional>
+#include <string_view>
 
-class PasteSymLinksClient : public PasteSymLinksServerClientBase
+class PasteSymLinksClient : public PasteSymLinksServerClientBase, private boost::noncopyable
 {
 public:
-	void NotifyServerOfResult(const ClipboardOperations::PastedItems &pastedItems);
+	// Connects to the server, which allows it to start waiting for results. If the server isn't
+	// present, the methods below will do nothing.
+	PasteSymLinksClient();
+
+	// Finishes the stream, if that hasn't already been done.
+	~PasteSymLinksClient();
+
+	// Sends a set of results to the server. This can be called multiple times, as results become
+	// available, with the server being able to process each set as soon as it's received.
+	// Returns false if the server is no longer reading results.
+	bool NotifyServerOfResult(const ClipboardOperations::PastedItems &pastedItems);
+
+	// Indicates to the server that all results have been sent.
+	void FinishStream();
+
+private:
+	bool WriteMessage(std::string_view message);
+	bool WriteChunk(std::string_view data, bool endOfMessage);
+
+	std::optional<Segment> m_segment;
+	SharedData *m_sharedData = nullptr;
+	bool m_finished = false;
 };
@@ -7,7 +7,8 @@
 #include <boost/interprocess/sync/scoped_lock.hpp>
 
 ClipboardOperations::PastedItems PasteSymLinksServer::LaunchClientAndWaitForResponse(
-	std::function<bool()> clientLauncher, std::chrono::milliseconds responseTimeout)
+	std::function<bool()> clientLauncher, std::chrono::milliseconds clientStartTimeout,
+	std::chrono::milliseconds responseTimeout, ResultsReceivedCallback resultsReceivedCallback)
 {
 	try
 	{
@@ -15,29 +16,99 @@ ClipboardOperations::PastedItems PasteSymLinksServer::LaunchClientAndWaitForResp
 		// explicit removal, since it will be destroyed once all handles are closed.
 		Segment segment(boost::interprocess::create_only, SHARED_MEMORY_NAME, SHARED_MEMORY_SIZE);
 
-		const CharAllocator allocator(segment.get_segment_manager());
-		auto *sharedData = segment.construct<SharedData>(SHARED_DATA_NAME)(allocator);
-
-		boost::interprocess::scoped_lock lock(sharedData->resultMutex);
+		auto *sharedData = segment.construct<SharedData>(SHARED_DATA_NAME)();
 
+		// The lock isn't held while the client is being launched, since that can take some time
+		// and the client needs to acquire the lock to signal that it has connected. If the client
+		// connects before the wait below starts, the predicate will still observe that.
 		if (!clientLauncher())
 		{
 			return {};
 		}
 
-		auto waitResult = sharedData->resultCondition.wait_for(lock, responseTimeout);
+		boost::interprocess::scoped_lock lock(sharedData->mutex);
+
+		bool clientConnected = sharedData->chunkWrittenCondition.wait_for(lock,
+			clientStartTimeout, [sharedData] { return sharedData->clientConnected; });
 
-		if (waitResult == boost::interprocess::cv_status::timeout)
+		if (!clientConnected)
 		{
+			LOG(WARNING) << "Timed out waiting for client to start";
+
+			sharedData->serverFinished = true;
+			sharedData->chunkReadCondition.notify_all();
+
 			return {};
 		}
 
-		std::stringstream stringstream;
-		stringstream << sharedData->serializedResultData;
-		cereal::BinaryInputArchive inputArchive(stringstream);
-
 		ClipboardOperations::PastedItems pastedItems;
-		inputArchive(pastedItems);
+		std::string message;
+
+		while (true)
+		{
+			bool chunkAvailable = sharedData->chunkWrittenCondition.wait_for(lock, responseTimeout,
+				[sharedData]
+				{
+					return sharedData->readSequenceNumber != sharedData->writeSequenceNumber
+						|| sharedData->streamFinished;
+				});
+
+			if (!chunkAvailable)
+			{
+				LOG_IF(WARNING, !pastedItems.empty())
+					<< "Timed out after receiving " << pastedItems.size() << " results";
+				break;
+			}
+
+			if (sharedData->readSequenceNumber == sharedData->writeSequenceNumber)
+			{
+				// All chunks have been read and the client has finished writing.
+				LOG_IF(WARNING, !message.empty()) << "Stream finished with an incomplete message";
+				break;
+			}
+
+			const auto &chunk = sharedData->chunks[sharedData->readSequenceNumber % NUM_CHUNKS];
+
+			if (chunk.sequenceNumber != sharedData->readSequenceNumber
+				|| chunk.size > CHUNK_DATA_SIZE)
+			{
+				LOG(ERROR) << "Received invalid chunk (expected sequence number "
+						   << sharedData->readSequenceNumber << ", found "
+						   << chunk.sequenceNumber << ")";
+				break;
+			}
+
+			message.append(chunk.data, chunk.size);
+			bool endOfMessage = chunk.endOfMessage;
+
+			sharedData->readSequenceNumber++;
+			sharedData->chunkReadCondition.notify_all();
+
+			if (!endOfMessage)
+			{
+				continue;
+			}
+
+			// The chunk has already been copied out, so the client can continue writing while
+			// the message is being processed.
+			lock.unlock();
+
+			auto results = DeserializeMessage(message);
+			message.clear();
+
+			if (resultsReceivedCallback)
+			{
+				resultsReceivedCallback(results);
+			}
+
+			pastedItems.insert(pastedItems.end(), std::make_move_iterator(results.begin()),
+				std::make_move_iterator(results.end()));
+
+			lock.lock();
+		}
+
+		sharedData->serverFinished = true;
+		sharedData->chunkReadCondition.notify_all();
 
 		return pastedItems;
 	}
@@ -49,3 +120,23 @@ ClipboardOperations::PastedItems PasteSymLinksServer::LaunchClientAndWaitForResp
 		return {};
 	}
 }
+
+ClipboardOperations::PastedItems PasteSymLinksServer::DeserializeMessage(
+	const std::string &message)
+{
+	try
+	{
+		std::stringstream stringstream(message);
+		cereal::BinaryInputArchive inputArchive(stringstream);
+
+		ClipboardOperations::PastedItems pastedItems;
+		inputArchive(pastedItems);
+
+		return pastedItems;
+	}
+	catch (const cereal::Exception &e)
+	{
+		LOG(ERROR) << e.what();
+		return {};
+	}
+}
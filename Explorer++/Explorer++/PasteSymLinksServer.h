@@ -8,10 +8,27 @@
 #include "PasteSymLinksServerClientBase.h"
 #include <chrono>
 #include <functional>
+#include <string>
 
 class PasteSymLinksServer : public PasteSymLinksServerClientBase
 {
 public:
+	// Invoked with each batch of results, as it arrives.
+	using ResultsReceivedCallback =
+		std::function<void(const ClipboardOperations::PastedItems &results)>;
+
+	// Returns all of the results received. The client has up to clientStartTimeout to start and
+	// connect. After that, responseTimeout applies to the time between chunks, rather than to the
+	// transfer as a whole, so a large number of results can be received, provided the client
+	// continues to make progress. If the client stops sending results before the stream has
+	// finished, the results received up to that point will be returned.
+	// This blocks until the transfer has finished, with the callback being invoked on the calling
+	// thread, so it shouldn't be called on the UI thread.
 	ClipboardOperations::PastedItems LaunchClientAndWaitForResponse(
-		std::function<bool()> clientLauncher, std::chrono::milliseconds responseTimeout);
+		std::function<bool()> clientLauncher, std::chrono::milliseconds clientStartTimeout,
+		std::chrono::milliseconds responseTimeout,
+		ResultsReceivedCallback resultsReceivedCallback = nullptr);
+
+private:
+	static ClipboardOperations::PastedItems DeserializeMessage(const std::string &message);
 };
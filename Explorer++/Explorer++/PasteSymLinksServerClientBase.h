@@ -4,37 +4,80 @@
 
 #pragma once
 
-#include <boost/interprocess/containers/string.hpp>
 #include <boost/interprocess/managed_windows_shared_memory.hpp>
 #include <boost/interprocess/sync/interprocess_condition.hpp>
 #include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <chrono>
+#include <cstdint>
 
+// The results are streamed from the client to the server through a ring buffer of fixed-size
+// chunks in shared memory. The client serializes the results in batches (each batch being a single
+// message) and splits each message across as many chunks as necessary. That means the amount of
+// data that can be transferred isn't limited by the size of the shared memory segment and the
+// server can process each batch as soon as it arrives.
 class PasteSymLinksServerClientBase
 {
 public:
 	static constexpr size_t SHARED_MEMORY_SIZE = 64 * 1024;
+	static constexpr size_t NUM_CHUNKS = 8;
+	static constexpr size_t CHUNK_DATA_SIZE = 4 * 1024;
+	static constexpr size_t RESULTS_PER_MESSAGE = 256;
 
 	virtual ~PasteSymLinksServerClientBase() = default;
 
 protected:
 	using Segment = boost::interprocess::managed_windows_shared_memory;
-	using Manager = Segment::segment_manager;
-	template <typename T>
-	using Allocator = boost::interprocess::allocator<T, Manager>;
-	using CharAllocator = Allocator<char>;
-	using String = boost::interprocess::basic_string<char, std::char_traits<char>, CharAllocator>;
+
+	struct Chunk
+	{
+		// Chunks are numbered consecutively, starting at 0. This allows the server to verify that
+		// no chunk has been skipped or overwritten before it was read.
+		uint64_t sequenceNumber = 0;
+
+		uint32_t size = 0;
+
+		// Set on the last chunk of each message.
+		bool endOfMessage = false;
+
+		char data[CHUNK_DATA_SIZE];
+	};
 
 	struct SharedData
 	{
-		boost::interprocess::interprocess_mutex resultMutex;
-		boost::interprocess::interprocess_condition resultCondition;
-		String serializedResultData;
+		boost::interprocess::interprocess_mutex mutex;
+
+		// Signaled by the client when a chunk has been written, or the stream has finished.
+		boost::interprocess::interprocess_condition chunkWrittenCondition;
 
-		SharedData(const CharAllocator &allocator) : serializedResultData(allocator)
-		{
-		}
+		// Signaled by the server when a chunk has been read (freeing up its slot), or the server
+		// has stopped reading.
+		boost::interprocess::interprocess_condition chunkReadCondition;
+
+		Chunk chunks[NUM_CHUNKS];
+
+		// The sequence numbers of the next chunk to be written and read. The chunk with a
+		// particular sequence number is stored at index (sequenceNumber % NUM_CHUNKS).
+		uint64_t writeSequenceNumber = 0;
+		uint64_t readSequenceNumber = 0;
+
+		// Set by the client once it has started and opened the shared memory segment.
+		bool clientConnected = false;
+
+		// Set by the client once all results have been written.
+		bool streamFinished = false;
+
+		// Set by the server once it has stopped reading (e.g. because it timed out). This allows
+		// the client to stop writing, rather than waiting for space that will never be freed.
+		bool serverFinished = false;
 	};
 
+	// The segment also contains the bookkeeping data of the segment manager, so there needs to be
+	// some space left over.
+	static_assert(sizeof(SharedData) + 4 * 1024 <= SHARED_MEMORY_SIZE);
+
+	// The maximum amount of time the client will wait for a free chunk.
+	static constexpr std::chrono::seconds CLIENT_WRITE_TIMEOUT = std::chrono::seconds(10);
+
 	static constexpr char SHARED_MEMORY_NAME[] = "Explorer++PasteSymLinksSharedMemory";
 	static constexpr char SHARED_DATA_NAME[] = "SharedData";
 };
@@ -4,6 +4,7 @@
 
 #include "stdafx.h"
 #include "Runtime.h"
+#include "TaskScheduler.h"
 #include <chrono>
 
 using namespace std::chrono_literals;
@@ -14,6 +15,7 @@ Runtime::Runtime(std::shared_ptr<concurrencpp::executor> uiThreadExecutor,
 	m_comStaExecutor(comStaExecutor),
 	m_inlineExecutor(std::make_shared<concurrencpp::inline_executor>()),
 	m_timerQueue(std::make_shared<concurrencpp::timer_queue>(120s)),
+	m_taskScheduler(std::make_unique<TaskScheduler>(m_comStaExecutor)),
 	m_uiThreadId(UniqueThreadId::GetForCurrentThread())
 {
 }
@@ -46,6 +48,11 @@ std::shared_ptr<concurrencpp::timer_queue> Runtime::GetTimerQueue() const
 	return m_timerQueue;
 }
 
+TaskScheduler *Runtime::GetTaskScheduler() const
+{
+	return m_taskScheduler.get();
+}
+
 bool Runtime::IsUiThread() const
 {
 	return UniqueThreadId::GetForCurrentThread() == m_uiThreadId;
@@ -9,6 +9,8 @@
 #include <concurrencpp/concurrencpp.h>
 #include <memory>
 
+class TaskScheduler;
+
 class Runtime : private boost::noncopyable
 {
 public:
@@ -21,6 +23,11 @@ public:
 	std::shared_ptr<concurrencpp::executor> GetComStaExecutor() const;
 	std::shared_ptr<concurrencpp::inline_executor> GetInlineExecutor() const;
 	std::shared_ptr<concurrencpp::timer_queue> GetTimerQueue() const;
+
+	// Background tasks that aren't tied to a coroutine (e.g. retrieving column text) should be run
+	// through this scheduler, so that they share the COM STA threads.
+	TaskScheduler *GetTaskScheduler() const;
+
 	bool IsUiThread() const;
 
 private:
@@ -28,5 +35,6 @@ private:
 	const std::shared_ptr<concurrencpp::executor> m_comStaExecutor;
 	const std::shared_ptr<concurrencpp::inline_executor> m_inlineExecutor;
 	const std::shared_ptr<concurrencpp::timer_queue> m_timerQueue;
+	const std::unique_ptr<TaskScheduler> m_taskScheduler;
 	const UniqueThreadId m_uiThreadId;
 };
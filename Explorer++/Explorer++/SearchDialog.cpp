@@ -21,18 +21,19 @@
 #include "../Helper/Helper.h"
 #include "../Helper/RegistrySettings.h"
 #include "../Helper/ShellHelper.h"
+#include "../Helper/ScopedRedrawDisabler.h"
 #include "../Helper/ShellItemContextMenu.h"
 #include "../Helper/WindowHelper.h"
 #include "../Helper/XMLSettings.h"
 #include <algorithm>
+#include <functional>
 #include <regex>
 
 namespace NSearchDialog
 {
 
-const int WM_APP_SEARCHITEMFOUND = WM_APP + 1;
+const int WM_APP_SEARCHPROGRESS = WM_APP + 1;
 const int WM_APP_SEARCHFINISHED = WM_APP + 2;
-const int WM_APP_SEARCHCHANGEDDIRECTORY = WM_APP + 3;
 const int WM_APP_REGULAREXPRESSIONINVALID = WM_APP + 4;
 
 int CALLBACK SortResultsStub(LPARAM lParam1, LPARAM lParam2, LPARAM lParamSort);
@@ -319,8 +320,14 @@ void SearchDialog::StartSearching()
 		dwAttributes |= FILE_ATTRIBUTE_SYSTEM;
 	}
 
-	m_pSearch = new Search(m_hDlg, szBaseDirectory, szSearchPattern, dwAttributes,
-		bUseRegularExpressions, bCaseInsensitive, bSearchSubFolders);
+	FileSearchOptions options;
+	options.pattern = szSearchPattern;
+	options.useRegularExpressions = bUseRegularExpressions;
+	options.caseInsensitive = bCaseInsensitive;
+	options.searchSubfolders = bSearchSubFolders;
+	options.attributes = dwAttributes;
+
+	m_pSearch = new Search(m_hDlg, szBaseDirectory, options);
 	m_pSearch->AddRef();
 
 	/* Save the search directory and search pattern (only if they are not
@@ -688,34 +695,28 @@ INT_PTR SearchDialog::OnPrivateMessage(UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
 	switch (uMsg)
 	{
-	/* We won't actually process the item here. Instead, we'll
-	add it onto the list of current items, which will be processed
-	in batch. This is done to stop this message from blocking the
-	main GUI (also see http://www.flounder.com/iocompletion.htm). */
-	case NSearchDialog::WM_APP_SEARCHITEMFOUND:
-	{
-		m_AwaitingSearchItems.push_back(reinterpret_cast<PIDLIST_ABSOLUTE>(wParam));
-
-		if (m_bSetSearchTimer)
-		{
-			SetTimer(m_hDlg, SEARCH_PROCESSITEMS_TIMER_ID, SEARCH_PROCESSITEMS_TIMER_ELAPSED,
-				nullptr);
-
-			m_bSetSearchTimer = FALSE;
-		}
-	}
-	break;
+	case NSearchDialog::WM_APP_SEARCHPROGRESS:
+		ProcessSearchProgress();
+		break;
 
 	case NSearchDialog::WM_APP_SEARCHFINISHED:
 	{
+		// The final progress update may not have been processed yet.
+		ProcessSearchProgress();
+
 		TCHAR szStatus[512];
 
 		if (!m_bStopSearching)
 		{
-			int iFoldersFound = LOWORD(lParam);
-			int iFilesFound = HIWORD(lParam);
-
-			auto messageTemplate = m_resourceLoader->LoadString(IDS_SEARCH_FINISHED_MESSAGE);
+			int iFoldersFound = static_cast<int>(wParam);
+			int iFilesFound = static_cast<int>(lParam);
+
+			// If the regular expression couldn't be evaluated against some of the items, those
+			// items won't have been included in the results, which the user should be aware of.
+			auto messageTemplate = m_resourceLoader->LoadString(
+				m_pSearch->GetSummary().regexMatchFailed
+					? IDS_SEARCH_FINISHED_WITH_REGULAR_EXPRESSION_ERRORS_MESSAGE
+					: IDS_SEARCH_FINISHED_MESSAGE);
 			StringCchPrintf(szStatus, std::size(szStatus), messageTemplate.c_str(), iFoldersFound,
 				iFilesFound);
 			SetDlgItemText(m_hDlg, IDC_STATIC_STATUS, szStatus);
@@ -737,19 +738,6 @@ INT_PTR SearchDialog::OnPrivateMessage(UINT uMsg, WPARAM wParam, LPARAM lParam)
 	}
 	break;
 
-	case NSearchDialog::WM_APP_SEARCHCHANGEDDIRECTORY:
-	{
-		TCHAR szStatus[512];
-		TCHAR *pszDirectory = nullptr;
-
-		pszDirectory = reinterpret_cast<TCHAR *>(wParam);
-
-		auto messageTemplate = m_resourceLoader->LoadString(IDS_SEARCHING);
-		StringCchPrintf(szStatus, std::size(szStatus), messageTemplate.c_str(), pszDirectory);
-		SetDlgItemText(m_hDlg, IDC_STATIC_STATUS, szStatus);
-	}
-	break;
-
 	case NSearchDialog::WM_APP_REGULAREXPRESSIONINVALID:
 	{
 		/* The link/status controls are in the same position, and
@@ -778,6 +766,47 @@ INT_PTR SearchDialog::OnPrivateMessage(UINT uMsg, WPARAM wParam, LPARAM lParam)
 	return 0;
 }
 
+void SearchDialog::ProcessSearchProgress()
+{
+	if (m_pSearch == nullptr)
+	{
+		// The search this message was sent for has already finished.
+		return;
+	}
+
+	auto progress = m_pSearch->TakeProgress();
+
+	if (!progress.currentDirectory.empty() && !m_bStopSearching)
+	{
+		TCHAR szStatus[512];
+		auto messageTemplate = m_resourceLoader->LoadString(IDS_SEARCHING);
+		StringCchPrintf(szStatus, std::size(szStatus), messageTemplate.c_str(),
+			progress.currentDirectory.c_str());
+		SetDlgItemText(m_hDlg, IDC_STATIC_STATUS, szStatus);
+	}
+
+	if (progress.results.empty())
+	{
+		return;
+	}
+
+	/* We won't actually process the items here. Instead, we'll
+	add them onto the list of current items, which will be processed
+	in batch. This is done to stop this message from blocking the
+	main GUI (also see http://www.flounder.com/iocompletion.htm). */
+	for (auto &result : progress.results)
+	{
+		m_AwaitingSearchItems.push_back(std::move(result.path));
+	}
+
+	if (m_bSetSearchTimer)
+	{
+		SetTimer(m_hDlg, SEARCH_PROCESSITEMS_TIMER_ID, SEARCH_PROCESSITEMS_TIMER_ELAPSED, nullptr);
+
+		m_bSetSearchTimer = FALSE;
+	}
+}
+
 INT_PTR SearchDialog::OnTimer(int iTimerID)
 {
 	if (iTimerID != SEARCH_PROCESSITEMS_TIMER_ID)
@@ -785,6 +814,11 @@ INT_PTR SearchDialog::OnTimer(int iTimerID)
 		return 1;
 	}
 
+	if (m_AwaitingSearchItems.empty())
+	{
+		return 0;
+	}
+
 	HWND hListView = GetDlgItem(m_hDlg, IDC_LISTVIEW_SEARCHRESULTS);
 	int nListViewItems = ListView_GetItemCount(hListView);
 
@@ -794,25 +828,27 @@ INT_PTR SearchDialog::OnTimer(int iTimerID)
 
 	auto itr = m_AwaitingSearchItems.begin();
 
+	ScopedRedrawDisabler redrawDisabler(hListView);
+
 	while (i < nItems)
 	{
 		LVITEM lvItem;
 		SHFILEINFO shfi;
 		int iIndex;
 
-		PIDLIST_ABSOLUTE pidl = *itr;
-
-		std::wstring fullFileName;
-		GetDisplayName(pidl, SHGDN_FORPARSING, fullFileName);
+		const std::wstring &fullFileName = *itr;
 
-		TCHAR directory[MAX_PATH];
-		StringCchCopy(directory, std::size(directory), fullFileName.c_str());
-		PathRemoveFileSpec(directory);
+		auto separatorPosition = fullFileName.find_last_of(L'\\');
+		std::wstring directory = fullFileName.substr(0, separatorPosition);
+		std::wstring fileName = fullFileName.substr(separatorPosition + 1);
 
-		std::wstring fileName;
-		GetDisplayName(pidl, SHGDN_INFOLDER | SHGDN_FORPARSING, fileName);
+		// If the directory is the root of a drive (e.g. "C:"), the separator needs to be retained.
+		if (directory.ends_with(L':'))
+		{
+			directory += L'\\';
+		}
 
-		SHGetFileInfo((LPCWSTR) pidl, 0, &shfi, sizeof(shfi), SHGFI_PIDL | SHGFI_SYSICONINDEX);
+		SHGetFileInfo(fullFileName.c_str(), 0, &shfi, sizeof(shfi), SHGFI_SYSICONINDEX);
 
 		m_SearchItemsMapInternal.insert(
 			std::unordered_map<int, std::wstring>::value_type(m_iInternalIndex, fullFileName));
@@ -825,9 +861,7 @@ INT_PTR SearchDialog::OnTimer(int iTimerID)
 		lvItem.lParam = m_iInternalIndex++;
 		iIndex = ListView_InsertItem(hListView, &lvItem);
 
-		ListView_SetItemText(hListView, iIndex, 1, directory);
-
-		CoTaskMemFree(pidl);
+		ListView_SetItemText(hListView, iIndex, 1, directory.data());
 
 		itr = m_AwaitingSearchItems.erase(itr);
 
@@ -856,206 +890,72 @@ DWORD WINAPI NSearchDialog::SearchThread(LPVOID pParam)
 	return 0;
 }
 
-Search::Search(HWND hDlg, TCHAR *szBaseDirectory, TCHAR *szPattern, DWORD dwAttributes,
-	BOOL bUseRegularExpressions, BOOL bCaseInsensitive, BOOL bSearchSubFolders)
+Search::Search(HWND hDlg, const std::wstring &baseDirectory, const FileSearchOptions &options) :
+	m_hDlg(hDlg),
+	m_baseDirectory(baseDirectory),
+	m_options(options)
 {
-	m_hDlg = hDlg;
-	m_dwAttributes = dwAttributes;
-	m_bUseRegularExpressions = bUseRegularExpressions;
-	m_bCaseInsensitive = bCaseInsensitive;
-	m_bSearchSubFolders = bSearchSubFolders;
-
-	StringCchCopy(m_szBaseDirectory, std::size(m_szBaseDirectory), szBaseDirectory);
-	StringCchCopy(m_szSearchPattern, std::size(m_szSearchPattern), szPattern);
-
-	InitializeCriticalSection(&m_csStop);
-	m_bStopSearching = FALSE;
-}
-
-Search::~Search()
-{
-	DeleteCriticalSection(&m_csStop);
 }
 
 void Search::StartSearching()
 {
-	m_iFoldersFound = 0;
-	m_iFilesFound = 0;
-
-	if (lstrlen(m_szSearchPattern) != 0 && m_bUseRegularExpressions)
+	try
 	{
-		try
-		{
-			if (m_bCaseInsensitive)
-			{
-				m_rxPattern.assign(m_szSearchPattern, std::regex_constants::icase);
-			}
-			else
-			{
-				m_rxPattern.assign(m_szSearchPattern);
-			}
-		}
-		catch (std::exception)
-		{
-			SendMessage(m_hDlg, NSearchDialog::WM_APP_REGULAREXPRESSIONINVALID, 0, 0);
-
-			return;
-		}
+		m_summary = SearchFiles(m_baseDirectory, m_options, m_stopSource.get_token(),
+			std::bind_front(&Search::OnProgress, this));
 	}
+	catch (const std::regex_error &)
+	{
+		SendMessage(m_hDlg, NSearchDialog::WM_APP_REGULAREXPRESSIONINVALID, 0, 0);
 
-	SearchDirectory(m_szBaseDirectory);
+		Release();
+		return;
+	}
 
-	SendMessage(m_hDlg, NSearchDialog::WM_APP_SEARCHFINISHED, 0,
-		MAKELPARAM(m_iFoldersFound, m_iFilesFound));
+	SendMessage(m_hDlg, NSearchDialog::WM_APP_SEARCHFINISHED, m_summary.numFoldersFound,
+		m_summary.numFilesFound);
 
 	Release();
 }
 
-void Search::SearchDirectory(const TCHAR *szDirectory)
+void Search::OnProgress(FileSearchProgress &&progress)
 {
-	SendMessage(m_hDlg, NSearchDialog::WM_APP_SEARCHCHANGEDDIRECTORY,
-		reinterpret_cast<WPARAM>(szDirectory), 0);
-
-	std::list<std::wstring> subFolderList;
+	std::unique_lock lock(m_progressMutex);
 
-	SearchDirectoryInternal(szDirectory, &subFolderList);
+	m_pendingProgress.results.insert(m_pendingProgress.results.end(),
+		std::make_move_iterator(progress.results.begin()),
+		std::make_move_iterator(progress.results.end()));
+	m_pendingProgress.currentDirectory = std::move(progress.currentDirectory);
 
-	bool bStop = false;
+	bool notificationRequired = !m_progressNotificationPending;
+	m_progressNotificationPending = true;
+	lock.unlock();
 
-	EnterCriticalSection(&m_csStop);
-	if (m_bStopSearching)
+	if (notificationRequired)
 	{
-		bStop = true;
-	}
-	LeaveCriticalSection(&m_csStop);
-
-	if (bStop)
-	{
-		return;
-	}
-
-	if (m_bSearchSubFolders)
-	{
-		for (const auto &strSubFolder : subFolderList)
-		{
-			SearchDirectory(strSubFolder.c_str());
-		}
+		PostMessage(m_hDlg, NSearchDialog::WM_APP_SEARCHPROGRESS, 0, 0);
 	}
 }
 
-/* Can't recurse, as it would overflow the stack. */
-void Search::SearchDirectoryInternal(const TCHAR *szSearchDirectory,
-	std::list<std::wstring> *pSubFolderList)
+const FileSearchSummary &Search::GetSummary() const
 {
-	assert(szSearchDirectory != nullptr);
-	assert(pSubFolderList != nullptr);
-
-	WIN32_FIND_DATA wfd;
-	TCHAR szSearchTerm[MAX_PATH];
-
-	PathCombine(szSearchTerm, szSearchDirectory, _T("*"));
-
-	HANDLE hFindFile = FindFirstFile(szSearchTerm, &wfd);
-
-	if (hFindFile != INVALID_HANDLE_VALUE)
-	{
-		bool bStop = false;
-
-		while (FindNextFile(hFindFile, &wfd) != 0 && !bStop)
-		{
-			if (lstrcmpi(wfd.cFileName, _T(".")) != 0 && lstrcmpi(wfd.cFileName, _T("..")) != 0)
-			{
-				BOOL bMatchFileName = FALSE;
-				BOOL bMatchAttributes = FALSE;
-
-				/* Only match against the filename if it's not empty. */
-				if (lstrlen(m_szSearchPattern) != 0)
-				{
-					if (m_bUseRegularExpressions)
-					{
-						if (std::regex_match(wfd.cFileName, m_rxPattern))
-						{
-							bMatchFileName = TRUE;
-						}
-					}
-					else
-					{
-						if (CheckWildcardMatch(m_szSearchPattern, wfd.cFileName,
-								!m_bCaseInsensitive))
-						{
-							bMatchFileName = TRUE;
-						}
-					}
-				}
-				else
-				{
-					/* No filename constraint, so all filenames match. */
-					bMatchFileName = TRUE;
-				}
-
-				if (m_dwAttributes != 0)
-				{
-					if ((wfd.dwFileAttributes & m_dwAttributes) == m_dwAttributes)
-					{
-						bMatchAttributes = TRUE;
-					}
-				}
-				else
-				{
-					bMatchAttributes = TRUE;
-				}
-
-				BOOL bItemMatch = bMatchFileName && bMatchAttributes;
-
-				if (bItemMatch)
-				{
-					if ((wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-						== FILE_ATTRIBUTE_DIRECTORY)
-					{
-						m_iFoldersFound++;
-					}
-					else
-					{
-						m_iFilesFound++;
-					}
-
-					TCHAR szFullFileName[MAX_PATH];
-					PathCombine(szFullFileName, szSearchDirectory, wfd.cFileName);
-
-					unique_pidl_absolute pidl;
-					SHParseDisplayName(szFullFileName, nullptr, wil::out_param(pidl), 0, nullptr);
-
-					PostMessage(m_hDlg, NSearchDialog::WM_APP_SEARCHITEMFOUND,
-						reinterpret_cast<WPARAM>(ILCloneFull(pidl.get())), 0);
-				}
-
-				if ((wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY)
-				{
-					TCHAR szSubFolder[MAX_PATH];
-
-					PathCombine(szSubFolder, szSearchDirectory, wfd.cFileName);
+	return m_summary;
+}
 
-					pSubFolderList->push_back(szSubFolder);
-				}
-			}
+FileSearchProgress Search::TakeProgress()
+{
+	std::scoped_lock lock(m_progressMutex);
 
-			EnterCriticalSection(&m_csStop);
-			if (m_bStopSearching)
-			{
-				bStop = true;
-			}
-			LeaveCriticalSection(&m_csStop);
-		}
+	FileSearchProgress progress = std::move(m_pendingProgress);
+	m_pendingProgress = {};
+	m_progressNotificationPending = false;
 
-		FindClose(hFindFile);
-	}
+	return progress;
 }
 
 void Search::StopSearching()
 {
-	EnterCriticalSection(&m_csStop);
-	m_bStopSearching = TRUE;
-	LeaveCriticalSection(&m_csStop);
+	m_stopSource.request_stop();
 }
 
 void SearchDialog::SaveState()
@@ -6,12 +6,14 @@
 
 #include "BaseDialog.h"
 #include "../Helper/DialogSettings.h"
+#include "../Helper/FileSearch.h"
 #include "../Helper/ReferenceCount.h"
 #include <boost/circular_buffer.hpp>
 #include <MsXml2.h>
 #include <objbase.h>
 #include <list>
-#include <regex>
+#include <mutex>
+#include <stop_token>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -101,34 +103,33 @@ private:
 class Search : public ReferenceCount
 {
 public:
-	Search(HWND hDlg, TCHAR *szBaseDirectory, TCHAR *szPattern, DWORD dwAttributes,
-		BOOL bUseRegularExpressions, BOOL bCaseInsensitive, BOOL bSearchSubFolders);
-	~Search();
+	Search(HWND hDlg, const std::wstring &baseDirectory, const FileSearchOptions &options);
 
 	void StartSearching();
 	void StopSearching();
 
-private:
-	void SearchDirectory(const TCHAR *szDirectory);
-	void SearchDirectoryInternal(const TCHAR *szSearchDirectory,
-		std::list<std::wstring> *pSubFolderList);
+	// Returns the results (and most recent directory) found since this method was last called.
+	FileSearchProgress TakeProgress();
 
-	HWND m_hDlg;
+	// This is only valid once the search has finished.
+	const FileSearchSummary &GetSummary() const;
 
-	TCHAR m_szBaseDirectory[MAX_PATH];
-	TCHAR m_szSearchPattern[MAX_PATH + 2];
-	DWORD m_dwAttributes;
-	BOOL m_bUseRegularExpressions;
-	BOOL m_bCaseInsensitive;
-	BOOL m_bSearchSubFolders;
+private:
+	void OnProgress(FileSearchProgress &&progress);
 
-	std::wregex m_rxPattern;
+	const HWND m_hDlg;
+	const std::wstring m_baseDirectory;
+	const FileSearchOptions m_options;
 
-	CRITICAL_SECTION m_csStop;
-	BOOL m_bStopSearching;
+	std::stop_source m_stopSource;
+	FileSearchSummary m_summary = {};
 
-	int m_iFoldersFound;
-	int m_iFilesFound;
+	// Progress updates are added here by the search thread and taken by the dialog. A message is
+	// only posted to the dialog when the first update is added, so the dialog receives at most one
+	// message for each batch of results it takes.
+	std::mutex m_progressMutex;
+	FileSearchProgress m_pendingProgress;
+	bool m_progressNotificationPending = false;
 };
 
 class SearchDialog : public BaseDialog
@@ -156,7 +157,7 @@ protected:
 private:
 	static const int SEARCH_PROCESSITEMS_TIMER_ID = 0;
 	static const int SEARCH_PROCESSITEMS_TIMER_ELAPSED = 50;
-	static const int SEARCH_MAX_ITEMS_BATCH_PROCESS = 100;
+	static const int SEARCH_MAX_ITEMS_BATCH_PROCESS = 1000;
 
 	SearchDialog(const ResourceLoader *resourceLoader, HWND hParent,
 		std::wstring_view searchDirectory, BrowserList *browserList);
@@ -169,6 +170,7 @@ private:
 	void OnSearch();
 	void StartSearching();
 	void StopSearching();
+	void ProcessSearchProgress();
 	void SaveEntry(int comboBoxId, boost::circular_buffer<std::wstring> &buffer);
 	void UpdateListViewHeader();
 
@@ -182,7 +184,7 @@ private:
 	Search *m_pSearch = nullptr;
 
 	/* Listview item information. */
-	std::list<PIDLIST_ABSOLUTE> m_AwaitingSearchItems;
+	std::list<std::wstring> m_AwaitingSearchItems;
 	std::unordered_map<int, std::wstring> m_SearchItemsMapInternal;
 	int m_iInternalIndex;
 	int m_iPreviousSelectedColumn;
@@ -10,25 +10,40 @@
 #include "DocumentServiceProvider.h"
 #include "FeatureList.h"
 #include "HistoryEntry.h"
-#include "IconFetcher.h"
+#include "IconFetcherImpl.h"
 #include "ItemData.h"
 #include "MainResource.h"
 #include "NavigationRequest.h"
+#include "RemainingNavigationItems.h"
 #include "RuntimeHelper.h"
 #include "ShellEnumeratorImpl.h"
 #include "ShellNavigationController.h"
 #include "ShellView.h"
+#include "TaskScheduler.h"
 #include "ViewModes.h"
 #include "WebBrowserApp.h"
 #include "../Helper/ListViewHelper.h"
 #include "../Helper/ScopedRedrawDisabler.h"
 #include "../Helper/ShellHelper.h"
+#include "../Helper/StringHelper.h"
 #include "../Helper/WinRTBaseWrapper.h"
 #include "../Helper/WindowHelper.h"
 #include <wil/com.h>
-#include <propkey.h>
-#include <propvarutil.h>
+#include <format>
+#include <algorithm>
 #include <list>
+#include <span>
+
+namespace
+{
+
+std::string FormatTaskCounters(const TaskCounters &counters)
+{
+	return std::format("{} queued, {} executed, {} discarded", counters.numTasksQueued,
+		counters.numTasksExecuted, counters.numTasksDiscarded);
+}
+
+}
 
 void ShellBrowserImpl::OnNavigationStarted(const NavigationRequest *request)
 {
@@ -54,6 +69,7 @@ void ShellBrowserImpl::ChangeFolders(const PidlAbsolute &directory)
 	m_directoryState.pidlDirectory = directory;
 	m_directoryState.directory = GetDisplayNameWithFallback(directory.Raw(), SHGDN_FORPARSING);
 	m_directoryState.virtualFolder = isVirtualFolder;
+	m_directoryState.itemInfoContext = GetItemInfoContext(directory.Raw());
 	m_uniqueFolderId++;
 
 	SetActiveColumnSet();
@@ -80,16 +96,22 @@ void ShellBrowserImpl::PrepareToChangeFolders()
 
 void ShellBrowserImpl::ClearPendingResults()
 {
-	m_columnThreadPool.clear_queue();
-	m_columnResults.clear();
+	ClearColumnTasks();
 
 	m_iconFetcher->ClearQueue();
 
-	m_thumbnailThreadPool.clear_queue();
+	m_thumbnailTaskQueue->Clear();
 	m_thumbnailResults.clear();
 
-	m_infoTipsThreadPool.clear_queue();
+	m_infoTipTaskQueue->Clear();
 	m_infoTipResults.clear();
+
+	ClearGroupTasks();
+
+	DLOG(INFO) << std::format("Column tasks: {}; icon tasks: {}; thumbnail tasks: {}",
+		FormatTaskCounters(m_columnTaskQueue->GetCounters()),
+		FormatTaskCounters(m_iconFetcher->GetTaskCounters()),
+		FormatTaskCounters(m_thumbnailTaskQueue->GetCounters()));
 }
 
 void ShellBrowserImpl::StoreCurrentlySelectedItems()
@@ -106,9 +128,18 @@ void ShellBrowserImpl::ResetFolderState()
 
 	ListView_RemoveAllGroups(m_listView);
 
+	DLOG(INFO) << std::format("Performed {} item row lookups ({} row map rebuilds) in {}",
+		m_directoryState.numItemRowLookups, m_directoryState.numItemRowMapRebuilds,
+		wstrToUtf8Str(m_directoryState.directory));
+	LogThumbnailSlotUsage();
+
+	StopEnumeratingRemainingNavigationItems();
+
 	m_directoryState = DirectoryState();
 
 	m_itemInfoMap.clear();
+	m_parsingNameIndex.Clear();
+	m_columnTextCache.Clear();
 }
 
 void ShellBrowserImpl::NotifyShellOfNavigation(PCIDLIST_ABSOLUTE pidl)
@@ -264,8 +295,7 @@ std::optional<int> ShellBrowserImpl::AddItemInternal(IShellFolder *shellFolder,
 
 int ShellBrowserImpl::AddItemInternal(int itemIndex, const ItemInfo_t &itemInfo, BOOL setPosition)
 {
-	int itemId = GenerateUniqueItemId();
-	m_itemInfoMap.insert({ itemId, itemInfo });
+	int itemId = StoreItem(itemInfo);
 
 	AwaitingAdd_t awaitingAdd;
 
@@ -288,155 +318,20 @@ int ShellBrowserImpl::AddItemInternal(int itemIndex, const ItemInfo_t &itemInfo,
 	return itemId;
 }
 
-std::optional<ShellBrowserImpl::ItemInfo_t> ShellBrowserImpl::GetItemInformation(
-	IShellFolder *shellFolder, PCIDLIST_ABSOLUTE pidlDirectory, PCITEMID_CHILD pidlChild)
+int ShellBrowserImpl::StoreItem(const ItemInfo_t &itemInfo)
 {
-	ItemInfo_t itemInfo;
-
-	itemInfo.pidlComplete = PidlAbsolute(ILCombine(pidlDirectory, pidlChild), Pidl::takeOwnership);
-	itemInfo.pridl = pidlChild;
-
-	std::wstring parsingName;
-	HRESULT hr = GetDisplayName(shellFolder, pidlChild, SHGDN_FORPARSING, parsingName);
-
-	if (FAILED(hr))
-	{
-		return std::nullopt;
-	}
-
-	itemInfo.parsingName = parsingName;
-
-	ULONG attributes = SFGAO_FOLDER | SFGAO_FILESYSTEM;
-	PCITEMID_CHILD items[] = { pidlChild };
-	hr = shellFolder->GetAttributesOf(1, items, &attributes);
-
-	if (FAILED(hr))
-	{
-		return std::nullopt;
-	}
-
-	SHGDNF displayNameFlags = SHGDN_INFOLDER;
-
-	unique_pidl_absolute recycleBinPidl;
-	hr = SHGetKnownFolderIDList(FOLDERID_RecycleBinFolder, KF_FLAG_DEFAULT, nullptr,
-		wil::out_param(recycleBinPidl));
-
-	bool isRecycleBin = SUCCEEDED(hr) && ArePidlsEquivalent(pidlDirectory, recycleBinPidl.get());
-
-	// SHGDN_INFOLDER | SHGDN_FORPARSING is used to ensure that the name retrieved for a filesystem
-	// file contains an extension, even if extensions are hidden in Windows Explorer. When using
-	// SHGDN_INFOLDER by itself, the resulting name won't contain an extension if extensions are
-	// hidden in Windows Explorer.
-	// Note that the recycle bin is excluded here, as the parsing names for the items are completely
-	// different to their regular display names.
-	if (!isRecycleBin && WI_IsFlagSet(attributes, SFGAO_FILESYSTEM)
-		&& WI_IsFlagClear(attributes, SFGAO_FOLDER))
-	{
-		WI_SetFlag(displayNameFlags, SHGDN_FORPARSING);
-	}
-
-	std::wstring displayName;
-	hr = GetDisplayName(shellFolder, pidlChild, displayNameFlags, displayName);
-
-	if (FAILED(hr))
-	{
-		return std::nullopt;
-	}
-
-	itemInfo.displayName = displayName;
-
-	std::wstring editingName;
-	hr = GetDisplayName(shellFolder, pidlChild, SHGDN_INFOLDER | SHGDN_FOREDITING, editingName);
-
-	if (FAILED(hr))
-	{
-		return std::nullopt;
-	}
-
-	itemInfo.editingName = editingName;
-
-	if (PathIsRoot(parsingName.c_str()))
-	{
-		itemInfo.bDrive = TRUE;
-		StringCchCopy(itemInfo.szDrive, std::size(itemInfo.szDrive), parsingName.c_str());
-	}
-	else
-	{
-		itemInfo.bDrive = FALSE;
-	}
-
-	WIN32_FIND_DATA wfd;
-	hr = SHGetDataFromIDList(shellFolder, pidlChild, SHGDFIL_FINDDATA, &wfd, sizeof(wfd));
-
-	if (FAILED(hr))
-	{
-		hr = ExtractFindDataUsingPropertyStore(shellFolder, pidlChild, wfd);
-	}
-
-	if (SUCCEEDED(hr))
-	{
-		itemInfo.wfd = wfd;
-		itemInfo.isFindDataValid = true;
-	}
-	else
-	{
-		StringCchCopy(itemInfo.wfd.cFileName, std::size(itemInfo.wfd.cFileName),
-			displayName.c_str());
-
-		if (WI_IsFlagSet(attributes, SFGAO_FOLDER))
-		{
-			WI_SetFlag(itemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY);
-		}
-	}
+	int itemId = GenerateUniqueItemId();
+	m_itemInfoMap.insert({ itemId, itemInfo });
+	m_parsingNameIndex.AddItem(itemInfo.parsingName, itemId);
 
-	return itemInfo;
+	return itemId;
 }
 
-HRESULT ShellBrowserImpl::ExtractFindDataUsingPropertyStore(IShellFolder *shellFolder,
-	PCITEMID_CHILD pidlChild, WIN32_FIND_DATA &output)
+std::optional<ItemInfo_t> ShellBrowserImpl::GetItemInformation(IShellFolder *shellFolder,
+	PCIDLIST_ABSOLUTE pidlDirectory, PCITEMID_CHILD pidlChild) const
 {
-	wil::com_ptr_nothrow<IPropertyStoreFactory> factory;
-	HRESULT hr = shellFolder->BindToObject(pidlChild, nullptr, IID_PPV_ARGS(&factory));
-
-	if (FAILED(hr))
-	{
-		return hr;
-	}
-
-	wil::com_ptr_nothrow<IPropertyStore> store;
-	PROPERTYKEY keys[] = { PKEY_FindData };
-	hr = factory->GetPropertyStoreForKeys(keys, std::size(keys), GPS_FASTPROPERTIESONLY,
-		IID_PPV_ARGS(&store));
-
-	if (FAILED(hr))
-	{
-		return hr;
-	}
-
-	wil::unique_prop_variant findDataProp;
-	hr = store->GetValue(PKEY_FindData, &findDataProp);
-
-	if (FAILED(hr))
-	{
-		return hr;
-	}
-
-	if (PropVariantGetElementCount(findDataProp) != sizeof(WIN32_FIND_DATA))
-	{
-		return hr;
-	}
-
-	WIN32_FIND_DATA wfd;
-	hr = PropVariantToBuffer(findDataProp, &wfd, sizeof(wfd));
-
-	if (FAILED(hr))
-	{
-		return hr;
-	}
-
-	output = wfd;
-
-	return hr;
+	return ::GetItemInformation(shellFolder, pidlDirectory, pidlChild,
+		m_directoryState.itemInfoContext);
 }
 
 void ShellBrowserImpl::OnNavigationWillCommit(const NavigationRequest *request)
@@ -463,16 +358,17 @@ void ShellBrowserImpl::OnNavigationComitted(const NavigationRequest *request)
 	StartDirectoryMonitoring();
 
 	AddNavigationItems(request, request->GetItems());
+	ReceiveRemainingNavigationItems(request->GetRemainingItems());
 
 	SetNavigationState(NavigationState::Committed);
 }
 
 void ShellBrowserImpl::AddNavigationItems(const NavigationRequest *request,
-	const std::vector<PidlChild> &itemPidls)
+	const std::vector<ItemInfo_t> &items)
 {
-	auto items = GetItemInformationFromPidls(request, itemPidls);
-
-	for (auto &item : items)
+	// In a large folder, this is only the first set of items. The rest are added in chunks as
+	// they're enumerated, giving the UI thread the chance to process other messages in between.
+	for (const auto &item : items)
 	{
 		AddItemInternal(-1, item, FALSE);
 	}
@@ -492,6 +388,7 @@ void ShellBrowserImpl::AddNavigationItems(const NavigationRequest *request,
 	auto *currentEntry = m_navigationController->GetCurrentEntry();
 	DCHECK(currentEntry->GetPidl() == request->GetNavigateParams().pidl);
 
+	// Any items that haven't been added yet will be selected once they're inserted.
 	SelectItems(currentEntry->GetSelectedItems());
 
 	if (request->GetNavigateParams().navigationType == NavigationType::Up)
@@ -500,32 +397,97 @@ void ShellBrowserImpl::AddNavigationItems(const NavigationRequest *request,
 	}
 }
 
-std::vector<ShellBrowserImpl::ItemInfo_t> ShellBrowserImpl::GetItemInformationFromPidls(
-	const NavigationRequest *request, const std::vector<PidlChild> &itemPidls)
+void ShellBrowserImpl::ReceiveRemainingNavigationItems(
+	std::shared_ptr<RemainingNavigationItems> remainingNavigationItems)
 {
-	wil::com_ptr_nothrow<IShellFolder> shellFolder;
-	HRESULT hr = SHBindToObject(nullptr, request->GetNavigateParams().pidl.Raw(), nullptr,
-		IID_PPV_ARGS(&shellFolder));
+	m_directoryState.remainingNavigationItems = remainingNavigationItems;
 
-	if (FAILED(hr))
+	// The weak pointer will be invalidated if the folder changes, so the items here will always be
+	// for the current folder.
+	auto weakSelf = m_weakPtrFactory.GetWeakPtr();
+
+	remainingNavigationItems->SetCallbacks(
+		[weakSelf](std::vector<ItemInfo_t> items)
+		{
+			if (weakSelf)
+			{
+				weakSelf->AddNavigationItemsChunk(items);
+			}
+		},
+		[weakSelf]
+		{
+			if (weakSelf)
+			{
+				weakSelf->OnRemainingNavigationItemsFinished();
+			}
+		});
+}
+
+void ShellBrowserImpl::AddNavigationItemsChunk(std::span<const ItemInfo_t> items)
+{
+	std::vector<int> internalIndexes;
+	internalIndexes.reserve(items.size());
+
+	for (const auto &item : items)
+	{
+		// Change notifications are queued until all the items have been added, but an item can
+		// still be updated directly in the meantime (e.g. when the user renames an item in the
+		// listview). If the enumeration reached the item after it was renamed, it will already
+		// exist under its new name.
+		auto existingItems = m_parsingNameIndex.GetItemsForParsingName(item.parsingName);
+		bool alreadyAdded = std::any_of(existingItems.begin(), existingItems.end(),
+			[this, &item](int internalIndex)
+			{
+				return ArePidlsEquivalent(m_itemInfoMap.at(internalIndex).pidlComplete.Raw(),
+					item.pidlComplete.Raw());
+			});
+
+		if (alreadyAdded)
+		{
+			continue;
+		}
+
+		internalIndexes.push_back(StoreItem(item));
+	}
+
+	if (internalIndexes.empty())
 	{
-		return {};
+		return;
 	}
 
-	std::vector<ItemInfo_t> items;
+	// The items that have already been inserted are in sorted order, so each new item can be
+	// inserted into its sorted position directly, without having to sort the entire folder again.
+	InsertItemsInSortedOrder(std::move(internalIndexes));
+}
 
-	for (const auto &pidl : itemPidls)
-	{
-		auto item = GetItemInformation(shellFolder.get(), request->GetNavigateParams().pidl.Raw(),
-			pidl.Raw());
+void ShellBrowserImpl::OnRemainingNavigationItemsFinished()
+{
+	m_directoryState.remainingNavigationItems.reset();
 
-		if (item)
+	// Every item in the folder has now been added, so the changes that were made while the items
+	// were being enumerated can be applied.
+	auto queuedChanges = std::exchange(m_directoryState.queuedDirectoryChanges, {});
+
+	for (const auto &change : queuedChanges)
+	{
+		// An item that was created while the folder was being enumerated may also have been
+		// returned by the enumeration.
+		if (change.event == DirectoryWatcher::Event::Added
+			&& GetItemInternalIndexForPidl(change.simplePidl1.Raw()))
 		{
-			items.push_back(*item);
+			continue;
 		}
+
+		ProcessDirectoryChangeNotification(change.event, change.simplePidl1, change.simplePidl2);
 	}
+}
 
-	return items;
+void ShellBrowserImpl::StopEnumeratingRemainingNavigationItems()
+{
+	if (m_directoryState.remainingNavigationItems)
+	{
+		m_directoryState.remainingNavigationItems->Stop();
+	}
 }
 
 void ShellBrowserImpl::InsertAwaitingItems()
@@ -705,8 +667,6 @@ BOOL ShellBrowserImpl::IsFileFiltered(const ItemInfo_t &itemInfo) const
 void ShellBrowserImpl::RemoveItem(int iItemInternal)
 {
 	ULARGE_INTEGER ulFileSize;
-	LVFINDINFO lvfi;
-	int iItem;
 
 	if (iItemInternal == -1)
 	{
@@ -720,19 +680,13 @@ void ShellBrowserImpl::RemoveItem(int iItemInternal)
 
 	m_directoryState.totalDirSize -= ulFileSize.QuadPart;
 
-	/* Locate the item within the listview.
-	Could use filename, providing removed
-	items are always deleted before new
-	items are inserted. */
-	lvfi.flags = LVFI_PARAM;
-	lvfi.lParam = iItemInternal;
-	iItem = ListView_FindItem(m_listView, -1, &lvfi);
+	auto iItem = LocateItemByInternalIndex(iItemInternal);
 
-	if (iItem != -1)
+	if (iItem)
 	{
 		if (m_folderSettings.showInGroups)
 		{
-			auto groupId = GetItemGroupId(iItem);
+			auto groupId = GetItemGroupId(*iItem);
 
 			if (groupId)
 			{
@@ -741,11 +695,24 @@ void ShellBrowserImpl::RemoveItem(int iItemInternal)
 		}
 
 		/* Remove the item from the listview. */
-		ListView_DeleteItem(m_listView, iItem);
+		ListView_DeleteItem(m_listView, *iItem);
 	}
 
 	m_directoryState.filteredItemsList.erase(iItemInternal);
+	m_parsingNameIndex.RemoveItem(m_itemInfoMap.at(iItemInternal).parsingName, iItemInternal);
 	m_itemInfoMap.erase(iItemInternal);
+	m_directoryState.sortItemCache.erase(iItemInternal);
+	InvalidateColumnText(iItemInternal);
+
+	if (m_directoryState.thumbnailSlotAllocator)
+	{
+		m_directoryState.thumbnailSlotAllocator->ReleaseItem(iItemInternal);
+	}
+
+	if (m_directoryState.thumbnailBitmapCache)
+	{
+		m_directoryState.thumbnailBitmapCache->InvalidateItem(iItemInternal);
+	}
 
 	m_directoryState.numItems--;
 }
@@ -6,10 +6,10 @@
 #include "ColumnDataRetrieval.h"
 #include "Columns.h"
 #include "FolderSettings.h"
+#include "FolderSizeCache.h"
 #include "ItemData.h"
 #include "../Helper/DriveInfo.h"
 #include "../Helper/FileOperations.h"
-#include "../Helper/FolderSize.h"
 #include "../Helper/Helper.h"
 #include "../Helper/StringHelper.h"
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -20,9 +20,89 @@
 
 BOOL GetPrinterStatusDescription(DWORD dwStatus, TCHAR *szStatus, size_t cchMax);
 
-std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicItemInfo,
-	const GlobalFolderSettings &globalFolderSettings)
+ColumnItemResources::ColumnItemResources(const BasicItemInfo_t &itemInfo) : m_itemInfo(itemInfo)
+{
+}
+
+ColumnItemResources::~ColumnItemResources() = default;
+
+const BasicItemInfo_t &ColumnItemResources::GetItemInfo() const
+{
+	return m_itemInfo;
+}
+
+const std::wstring &ColumnItemResources::GetFullPath()
+{
+	if (!m_fullPath)
+	{
+		m_fullPath = m_itemInfo.getFullPath();
+	}
+
+	return *m_fullPath;
+}
+
+IShellFolder2 *ColumnItemResources::GetParentFolder()
 {
+	if (!m_parentFolder)
+	{
+		wil::com_ptr_nothrow<IShellFolder2> parentFolder;
+		SHBindToParent(m_itemInfo.pidlComplete.get(), IID_PPV_ARGS(&parentFolder), nullptr);
+		m_parentFolder = std::move(parentFolder);
+	}
+
+	return m_parentFolder->get();
+}
+
+const std::vector<BYTE> *ColumnItemResources::GetVersionInfo()
+{
+	if (!m_versionInfo)
+	{
+		m_versionInfo.emplace();
+		LoadFileVersionInfo(GetFullPath().c_str(), *m_versionInfo);
+	}
+
+	if (m_versionInfo->empty())
+	{
+		return nullptr;
+	}
+
+	return &*m_versionInfo;
+}
+
+Gdiplus::Image *ColumnItemResources::GetImage()
+{
+	if (!m_image)
+	{
+		auto image = std::make_unique<Gdiplus::Image>(GetFullPath().c_str(), FALSE);
+
+		if (image->GetLastStatus() != Gdiplus::Ok)
+		{
+			image.reset();
+		}
+
+		m_image = std::move(image);
+	}
+
+	return m_image->get();
+}
+
+IWMHeaderInfo *ColumnItemResources::GetMediaHeaderInfo()
+{
+	if (!m_mediaHeaderInfo)
+	{
+		m_mediaHeaderInfo.emplace();
+		OpenMediaMetadata(GetFullPath().c_str(), m_wmvCore, *m_mediaHeaderInfo);
+	}
+
+	return m_mediaHeaderInfo->get();
+}
+
+std::wstring GetColumnText(ColumnType columnType, ColumnItemResources &itemResources,
+	const GlobalFolderSettings &globalFolderSettings, FolderSizeCache *folderSizeCache,
+	std::stop_token stopToken)
+{
+	const auto &basicItemInfo = itemResources.GetItemInfo();
+
 	switch (columnType)
 	{
 	case ColumnType::Name:
@@ -31,7 +111,7 @@ std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicIt
 	case ColumnType::Type:
 		return GetTypeColumnText(basicItemInfo);
 	case ColumnType::Size:
-		return GetSizeColumnText(basicItemInfo, globalFolderSettings);
+		return GetSizeColumnText(basicItemInfo, globalFolderSettings, folderSizeCache, stopToken);
 
 	case ColumnType::DateModified:
 		return GetTimeColumnText(basicItemInfo, TimeType::Modified, globalFolderSettings);
@@ -50,15 +130,15 @@ std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicIt
 		return GetOwnerColumnText(basicItemInfo);
 
 	case ColumnType::ProductName:
-		return GetVersionColumnText(basicItemInfo, VersionInfoType::ProductName);
+		return GetVersionColumnText(itemResources, VersionInfoType::ProductName);
 	case ColumnType::Company:
-		return GetVersionColumnText(basicItemInfo, VersionInfoType::Company);
+		return GetVersionColumnText(itemResources, VersionInfoType::Company);
 	case ColumnType::Description:
-		return GetVersionColumnText(basicItemInfo, VersionInfoType::Description);
+		return GetVersionColumnText(itemResources, VersionInfoType::Description);
 	case ColumnType::FileVersion:
-		return GetVersionColumnText(basicItemInfo, VersionInfoType::FileVersion);
+		return GetVersionColumnText(itemResources, VersionInfoType::FileVersion);
 	case ColumnType::ProductVersion:
-		return GetVersionColumnText(basicItemInfo, VersionInfoType::ProductVersion);
+		return GetVersionColumnText(itemResources, VersionInfoType::ProductVersion);
 
 	case ColumnType::ShortcutTo:
 		return GetShortcutToColumnText(basicItemInfo);
@@ -68,24 +148,24 @@ std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicIt
 		return GetExtensionColumnText(basicItemInfo);
 
 	case ColumnType::Title:
-		return GetItemDetailsColumnText(basicItemInfo, &PKEY_Title, globalFolderSettings);
+		return GetItemDetailsColumnText(itemResources, &PKEY_Title, globalFolderSettings);
 	case ColumnType::Subject:
-		return GetItemDetailsColumnText(basicItemInfo, &PKEY_Subject, globalFolderSettings);
+		return GetItemDetailsColumnText(itemResources, &PKEY_Subject, globalFolderSettings);
 	case ColumnType::Authors:
-		return GetItemDetailsColumnText(basicItemInfo, &PKEY_Author, globalFolderSettings);
+		return GetItemDetailsColumnText(itemResources, &PKEY_Author, globalFolderSettings);
 	case ColumnType::Keywords:
-		return GetItemDetailsColumnText(basicItemInfo, &PKEY_Keywords, globalFolderSettings);
+		return GetItemDetailsColumnText(itemResources, &PKEY_Keywords, globalFolderSettings);
 	case ColumnType::Comment:
-		return GetItemDetailsColumnText(basicItemInfo, &PKEY_Comment, globalFolderSettings);
+		return GetItemDetailsColumnText(itemResources, &PKEY_Comment, globalFolderSettings);
 
 	case ColumnType::CameraModel:
-		return GetImageColumnText(basicItemInfo, PropertyTagEquipModel);
+		return GetImageColumnText(itemResources, PropertyTagEquipModel);
 	case ColumnType::DateTaken:
-		return GetImageColumnText(basicItemInfo, PropertyTagDateTime);
+		return GetImageColumnText(itemResources, PropertyTagDateTime);
 	case ColumnType::Width:
-		return GetImageColumnText(basicItemInfo, PropertyTagImageWidth);
+		return GetImageColumnText(itemResources, PropertyTagImageWidth);
 	case ColumnType::Height:
-		return GetImageColumnText(basicItemInfo, PropertyTagImageHeight);
+		return GetImageColumnText(itemResources, PropertyTagImageHeight);
 
 	case ColumnType::VirtualComments:
 		return GetControlPanelCommentsColumnText(basicItemInfo);
@@ -100,11 +180,11 @@ std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicIt
 		return GetFileSystemColumnText(basicItemInfo);
 
 	case ColumnType::OriginalLocation:
-		return GetItemDetailsColumnText(basicItemInfo, &SCID_ORIGINAL_LOCATION,
+		return GetItemDetailsColumnText(itemResources, &SCID_ORIGINAL_LOCATION,
 			globalFolderSettings);
 
 	case ColumnType::DateDeleted:
-		return GetItemDetailsColumnText(basicItemInfo, &SCID_DATE_DELETED, globalFolderSettings);
+		return GetItemDetailsColumnText(itemResources, &SCID_DATE_DELETED, globalFolderSettings);
 
 	case ColumnType::PrinterNumDocuments:
 		return GetPrinterColumnText(basicItemInfo, PrinterInformationType::NumJobs);
@@ -125,53 +205,53 @@ std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicIt
 		return GetNetworkAdapterColumnText(basicItemInfo);
 
 	case ColumnType::MediaBitrate:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Bitrate);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Bitrate);
 	case ColumnType::MediaCopyright:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Copyright);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Copyright);
 	case ColumnType::MediaDuration:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Duration);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Duration);
 	case ColumnType::MediaProtected:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Protected);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Protected);
 	case ColumnType::MediaRating:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Rating);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Rating);
 	case ColumnType::MediaAlbumArtist:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::AlbumArtist);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::AlbumArtist);
 	case ColumnType::MediaAlbum:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::AlbumTitle);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::AlbumTitle);
 	case ColumnType::MediaBeatsPerMinute:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::BeatsPerMinute);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::BeatsPerMinute);
 	case ColumnType::MediaComposer:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Composer);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Composer);
 	case ColumnType::MediaConductor:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Conductor);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Conductor);
 	case ColumnType::MediaDirector:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Director);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Director);
 	case ColumnType::MediaGenre:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Genre);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Genre);
 	case ColumnType::MediaLanguage:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Language);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Language);
 	case ColumnType::MediaBroadcastDate:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::BroadcastDate);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::BroadcastDate);
 	case ColumnType::MediaChannel:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Channel);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Channel);
 	case ColumnType::MediaStationName:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::StationName);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::StationName);
 	case ColumnType::MediaMood:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Mood);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Mood);
 	case ColumnType::MediaParentalRating:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::ParentalRating);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::ParentalRating);
 	case ColumnType::MediaParentalRatingReason:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::ParentalRatingReason);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::ParentalRatingReason);
 	case ColumnType::MediaPeriod:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Period);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Period);
 	case ColumnType::MediaProducer:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Producer);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Producer);
 	case ColumnType::MediaPublisher:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Publisher);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Publisher);
 	case ColumnType::MediaWriter:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Writer);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Writer);
 	case ColumnType::MediaYear:
-		return GetMediaMetadataColumnText(basicItemInfo, MediaMetadataType::Year);
+		return GetMediaMetadataColumnText(itemResources, MediaMetadataType::Year);
 
 	default:
 		assert(false);
@@ -181,6 +261,62 @@ std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicIt
 	return L"";
 }
 
+bool CanCacheColumnText(ColumnType columnType)
+{
+	switch (columnType)
+	{
+	case ColumnType::Type:
+	case ColumnType::Owner:
+	case ColumnType::ProductName:
+	case ColumnType::Company:
+	case ColumnType::Description:
+	case ColumnType::FileVersion:
+	case ColumnType::ProductVersion:
+	case ColumnType::ShortcutTo:
+	case ColumnType::HardLinks:
+	case ColumnType::Title:
+	case ColumnType::Subject:
+	case ColumnType::Authors:
+	case ColumnType::Keywords:
+	case ColumnType::Comment:
+	case ColumnType::CameraModel:
+	case ColumnType::DateTaken:
+	case ColumnType::Width:
+	case ColumnType::Height:
+	case ColumnType::VirtualComments:
+	case ColumnType::FileSystem:
+	case ColumnType::OriginalLocation:
+	case ColumnType::MediaBitrate:
+	case ColumnType::MediaCopyright:
+	case ColumnType::MediaDuration:
+	case ColumnType::MediaProtected:
+	case ColumnType::MediaRating:
+	case ColumnType::MediaAlbumArtist:
+	case ColumnType::MediaAlbum:
+	case ColumnType::MediaBeatsPerMinute:
+	case ColumnType::MediaComposer:
+	case ColumnType::MediaConductor:
+	case ColumnType::MediaDirector:
+	case ColumnType::MediaGenre:
+	case ColumnType::MediaLanguage:
+	case ColumnType::MediaBroadcastDate:
+	case ColumnType::MediaChannel:
+	case ColumnType::MediaStationName:
+	case ColumnType::MediaMood:
+	case ColumnType::MediaParentalRating:
+	case ColumnType::MediaParentalRatingReason:
+	case ColumnType::MediaPeriod:
+	case ColumnType::MediaProducer:
+	case ColumnType::MediaPublisher:
+	case ColumnType::MediaWriter:
+	case ColumnType::MediaYear:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
 std::wstring GetNameColumnText(const BasicItemInfo_t &itemInfo,
 	const GlobalFolderSettings &globalFolderSettings)
 {
@@ -246,7 +382,8 @@ std::wstring GetTypeColumnText(const BasicItemInfo_t &itemInfo)
 }
 
 std::wstring GetSizeColumnText(const BasicItemInfo_t &itemInfo,
-	const GlobalFolderSettings &globalFolderSettings)
+	const GlobalFolderSettings &globalFolderSettings, FolderSizeCache *folderSizeCache,
+	std::stop_token stopToken)
 {
 	if (!itemInfo.isFindDataValid)
 	{
@@ -269,7 +406,8 @@ std::wstring GetSizeColumnText(const BasicItemInfo_t &itemInfo,
 		if (globalFolderSettings.showFolderSizes
 			&& !(globalFolderSettings.disableFolderSizesNetworkRemovable && bNetworkRemovable))
 		{
-			return GetFolderSizeColumnText(itemInfo, globalFolderSettings);
+			return GetFolderSizeColumnText(itemInfo, globalFolderSettings, folderSizeCache,
+				stopToken);
 		}
 		else
 		{
@@ -284,15 +422,11 @@ std::wstring GetSizeColumnText(const BasicItemInfo_t &itemInfo,
 }
 
 std::wstring GetFolderSizeColumnText(const BasicItemInfo_t &itemInfo,
-	const GlobalFolderSettings &globalFolderSettings)
+	const GlobalFolderSettings &globalFolderSettings, FolderSizeCache *folderSizeCache,
+	std::stop_token stopToken)
 {
-	auto folderInfo = GetFolderInfo(itemInfo.getFullPath());
-
-	/* TODO: This should
-	be done some other way.
-	Shouldn't depend on
-	the internal index. */
-	// m_cachedFolderSizes.insert({internalIndex, totalFolderSize.QuadPart});
+	auto folderInfo = folderSizeCache->GetOrCalculate(itemInfo.getFullPath(),
+		itemInfo.wfd.ftLastWriteTime, stopToken);
 
 	auto displayFormat = globalFolderSettings.forceSize ? globalFolderSettings.sizeDisplayFormat
 														: +SizeDisplayFormat::None;
@@ -314,17 +448,17 @@ std::wstring GetTimeColumnText(const BasicItemInfo_t &itemInfo, TimeType timeTyp
 	{
 	case TimeType::Modified:
 		bRet = CreateFileTimeString(&itemInfo.wfd.ftLastWriteTime, fileTime, std::size(fileTime),
-			globalFolderSettings.showFriendlyDates);
+			globalFolderSettings.showFriendlyDates.get());
 		break;
 
 	case TimeType::Created:
 		bRet = CreateFileTimeString(&itemInfo.wfd.ftCreationTime, fileTime, std::size(fileTime),
-			globalFolderSettings.showFriendlyDates);
+			globalFolderSettings.showFriendlyDates.get());
 		break;
 
 	case TimeType::Accessed:
 		bRet = CreateFileTimeString(&itemInfo.wfd.ftLastAccessTime, fileTime, std::size(fileTime),
-			globalFolderSettings.showFriendlyDates);
+			globalFolderSettings.showFriendlyDates.get());
 		break;
 
 	default:
@@ -434,12 +568,12 @@ std::wstring GetOwnerColumnText(const BasicItemInfo_t &itemInfo)
 	return owner;
 }
 
-std::wstring GetItemDetailsColumnText(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid,
+std::wstring GetItemDetailsColumnText(ColumnItemResources &itemResources, const SHCOLUMNID *pscid,
 	const GlobalFolderSettings &globalFolderSettings)
 {
 	TCHAR szDetail[512];
 	HRESULT hr =
-		GetItemDetails(itemInfo, pscid, szDetail, std::size(szDetail), globalFolderSettings);
+		GetItemDetails(itemResources, pscid, szDetail, std::size(szDetail), globalFolderSettings);
 
 	if (SUCCEEDED(hr))
 	{
@@ -451,13 +585,21 @@ std::wstring GetItemDetailsColumnText(const BasicItemInfo_t &itemInfo, const SHC
 
 HRESULT GetItemDetails(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid, TCHAR *szDetail,
 	size_t cchMax, const GlobalFolderSettings &globalFolderSettings)
+{
+	ColumnItemResources itemResources(itemInfo);
+	return GetItemDetails(itemResources, pscid, szDetail, cchMax, globalFolderSettings);
+}
+
+HRESULT GetItemDetails(ColumnItemResources &itemResources, const SHCOLUMNID *pscid, TCHAR *szDetail,
+	size_t cchMax, const GlobalFolderSettings &globalFolderSettings)
 {
 	VARIANT vt;
-	HRESULT hr = GetItemDetailsRawData(itemInfo, pscid, &vt);
+	HRESULT hr = GetItemDetailsRawData(itemResources, pscid, &vt);
 
 	if (SUCCEEDED(hr))
 	{
-		hr = ConvertVariantToString(&vt, szDetail, cchMax, globalFolderSettings.showFriendlyDates);
+		hr = ConvertVariantToString(&vt, szDetail, cchMax,
+			globalFolderSettings.showFriendlyDates.get());
 		VariantClear(&vt);
 	}
 
@@ -466,19 +608,39 @@ HRESULT GetItemDetails(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid,
 
 HRESULT GetItemDetailsRawData(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid, VARIANT *vt)
 {
-	wil::com_ptr_nothrow<IShellFolder2> pShellFolder;
-	HRESULT hr = SHBindToParent(itemInfo.pidlComplete.get(), IID_PPV_ARGS(&pShellFolder), nullptr);
+	ColumnItemResources itemResources(itemInfo);
+	return GetItemDetailsRawData(itemResources, pscid, vt);
+}
 
-	if (SUCCEEDED(hr))
+HRESULT GetItemDetailsRawData(ColumnItemResources &itemResources, const SHCOLUMNID *pscid,
+	VARIANT *vt)
+{
+	IShellFolder2 *parentFolder = itemResources.GetParentFolder();
+
+	if (!parentFolder)
 	{
-		hr = pShellFolder->GetDetailsEx(itemInfo.pridl.get(), pscid, vt);
+		return E_FAIL;
 	}
 
-	return hr;
+	return parentFolder->GetDetailsEx(itemResources.GetItemInfo().pridl.get(), pscid, vt);
 }
 
 std::wstring GetVersionColumnText(const BasicItemInfo_t &itemInfo, VersionInfoType versioninfoType)
 {
+	ColumnItemResources itemResources(itemInfo);
+	return GetVersionColumnText(itemResources, versioninfoType);
+}
+
+std::wstring GetVersionColumnText(ColumnItemResources &itemResources,
+	VersionInfoType versioninfoType)
+{
+	const auto *versionInfoBlock = itemResources.GetVersionInfo();
+
+	if (!versionInfoBlock)
+	{
+		return L"";
+	}
+
 	std::wstring versionInfoName;
 
 	switch (versioninfoType)
@@ -509,8 +671,8 @@ std::wstring GetVersionColumnText(const BasicItemInfo_t &itemInfo, VersionInfoTy
 	}
 
 	TCHAR versionInfo[512];
-	BOOL versionInfoObtained = GetVersionInfoString(itemInfo.getFullPath().c_str(),
-		versionInfoName.c_str(), versionInfo, std::size(versionInfo));
+	BOOL versionInfoObtained = GetVersionInfoString(*versionInfoBlock, versionInfoName.c_str(),
+		versionInfo, std::size(versionInfo));
 
 	if (!versionInfoObtained)
 	{
@@ -573,9 +735,21 @@ std::wstring GetExtensionColumnText(const BasicItemInfo_t &itemInfo)
 
 std::wstring GetImageColumnText(const BasicItemInfo_t &itemInfo, PROPID PropertyID)
 {
+	ColumnItemResources itemResources(itemInfo);
+	return GetImageColumnText(itemResources, PropertyID);
+}
+
+std::wstring GetImageColumnText(ColumnItemResources &itemResources, PROPID PropertyID)
+{
+	Gdiplus::Image *image = itemResources.GetImage();
+
+	if (!image)
+	{
+		return L"";
+	}
+
 	TCHAR imageProperty[512];
-	BOOL res = ReadImageProperty(itemInfo.getFullPath().c_str(), PropertyID, imageProperty,
-		std::size(imageProperty));
+	BOOL res = ReadImageProperty(image, PropertyID, imageProperty, std::size(imageProperty));
 
 	if (!res)
 	{
@@ -812,10 +986,24 @@ std::wstring GetNetworkAdapterColumnText(const BasicItemInfo_t &itemInfo)
 std::wstring GetMediaMetadataColumnText(const BasicItemInfo_t &itemInfo,
 	MediaMetadataType mediaMetadataType)
 {
+	ColumnItemResources itemResources(itemInfo);
+	return GetMediaMetadataColumnText(itemResources, mediaMetadataType);
+}
+
+std::wstring GetMediaMetadataColumnText(ColumnItemResources &itemResources,
+	MediaMetadataType mediaMetadataType)
+{
+	IWMHeaderInfo *headerInfo = itemResources.GetMediaHeaderInfo();
+
+	if (!headerInfo)
+	{
+		return L"";
+	}
+
 	const TCHAR *attributeName = GetMediaMetadataAttributeName(mediaMetadataType);
 
 	BYTE *tempBuffer = nullptr;
-	HRESULT hr = GetMediaMetadata(itemInfo.getFullPath().c_str(), attributeName, &tempBuffer);
+	HRESULT hr = GetMediaMetadata(headerInfo, attributeName, &tempBuffer);
 
 	if (!SUCCEEDED(hr))
 	{
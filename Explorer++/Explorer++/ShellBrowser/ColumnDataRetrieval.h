@@ -5,10 +5,17 @@
 #pragma once
 
 #include "Columns.h"
+#include <boost/core/noncopyable.hpp>
+#include <wil/com.h>
+#include <wil/resource.h>
+#include <memory>
 #include <optional>
+#include <stop_token>
 #include <string>
+#include <vector>
 
 struct BasicItemInfo_t;
+class FolderSizeCache;
 struct GlobalFolderSettings;
 
 enum class TimeType
@@ -64,8 +71,51 @@ enum class MediaMetadataType
 	Year
 };
 
-std::wstring GetColumnText(ColumnType columnType, const BasicItemInfo_t &basicItemInfo,
-	const GlobalFolderSettings &globalFolderSettings);
+// Several columns read their data from the same source (e.g. the version columns all read from the
+// file's version information). Each source is opened the first time one of the columns needs it
+// and is then reused for the rest of the item's columns, so that retrieving the text for all the
+// columns of an item only opens the item once.
+class ColumnItemResources : private boost::noncopyable
+{
+public:
+	explicit ColumnItemResources(const BasicItemInfo_t &itemInfo);
+	~ColumnItemResources();
+
+	const BasicItemInfo_t &GetItemInfo() const;
+	const std::wstring &GetFullPath();
+
+	// Each of the methods below returns null if the resource couldn't be opened.
+	IShellFolder2 *GetParentFolder();
+	const std::vector<BYTE> *GetVersionInfo();
+	Gdiplus::Image *GetImage();
+	IWMHeaderInfo *GetMediaHeaderInfo();
+
+private:
+	const BasicItemInfo_t &m_itemInfo;
+
+	// In each case, an empty optional indicates that no attempt has been made to open the
+	// resource yet.
+	std::optional<std::wstring> m_fullPath;
+	std::optional<wil::com_ptr_nothrow<IShellFolder2>> m_parentFolder;
+	std::optional<std::vector<BYTE>> m_versionInfo;
+	std::optional<std::unique_ptr<Gdiplus::Image>> m_image;
+
+	// The module needs to outlive the header, which is why it's declared first.
+	wil::unique_hmodule m_wmvCore;
+	std::optional<wil::com_ptr_nothrow<IWMHeaderInfo>> m_mediaHeaderInfo;
+};
+
+// The stop token is only used when retrieving the text is potentially long-running (e.g. when
+// calculating the size of a folder).
+std::wstring GetColumnText(ColumnType columnType, ColumnItemResources &itemResources,
+	const GlobalFolderSettings &globalFolderSettings, FolderSizeCache *folderSizeCache,
+	std::stop_token stopToken = {});
+
+// Returns true if the text for the column is worth caching. That's the case when the text is
+// expensive to retrieve and only depends on the item itself (i.e. it doesn't depend on the current
+// settings, or change over time, like the status of a printer).
+bool CanCacheColumnText(ColumnType columnType);
+
 std::wstring GetNameColumnText(const BasicItemInfo_t &itemInfo,
 	const GlobalFolderSettings &globalFolderSettings);
 std::wstring ProcessItemFileName(const BasicItemInfo_t &itemInfo,
@@ -79,18 +129,25 @@ bool GetRealSizeColumnRawData(const BasicItemInfo_t &itemInfo, ULARGE_INTEGER &R
 std::wstring GetAttributeColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetShortNameColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetOwnerColumnText(const BasicItemInfo_t &itemInfo);
-std::wstring GetItemDetailsColumnText(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid,
+std::wstring GetItemDetailsColumnText(ColumnItemResources &itemResources, const SHCOLUMNID *pscid,
 	const GlobalFolderSettings &globalFolderSettings);
 HRESULT GetItemDetails(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid, TCHAR *szDetail,
 	size_t cchMax, const GlobalFolderSettings &globalFolderSettings);
+HRESULT GetItemDetails(ColumnItemResources &itemResources, const SHCOLUMNID *pscid, TCHAR *szDetail,
+	size_t cchMax, const GlobalFolderSettings &globalFolderSettings);
 HRESULT GetItemDetailsRawData(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid,
 	VARIANT *vt);
+HRESULT GetItemDetailsRawData(ColumnItemResources &itemResources, const SHCOLUMNID *pscid,
+	VARIANT *vt);
 std::wstring GetVersionColumnText(const BasicItemInfo_t &itemInfo, VersionInfoType versioninfoType);
+std::wstring GetVersionColumnText(ColumnItemResources &itemResources,
+	VersionInfoType versioninfoType);
 std::wstring GetShortcutToColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetHardLinksColumnText(const BasicItemInfo_t &itemInfo);
 std::optional<DWORD> GetHardLinksColumnRawData(const BasicItemInfo_t &itemInfo);
 std::wstring GetExtensionColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetImageColumnText(const BasicItemInfo_t &itemInfo, PROPID PropertyID);
+std::wstring GetImageColumnText(ColumnItemResources &itemResources, PROPID PropertyID);
 std::wstring GetFileSystemColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetControlPanelCommentsColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetPrinterColumnText(const BasicItemInfo_t &itemInfo,
@@ -98,12 +155,16 @@ std::wstring GetPrinterColumnText(const BasicItemInfo_t &itemInfo,
 std::wstring GetNetworkAdapterColumnText(const BasicItemInfo_t &itemInfo);
 std::wstring GetMediaMetadataColumnText(const BasicItemInfo_t &itemInfo,
 	MediaMetadataType mediaMetadataType);
+std::wstring GetMediaMetadataColumnText(ColumnItemResources &itemResources,
+	MediaMetadataType mediaMetadataType);
 const TCHAR *GetMediaMetadataAttributeName(MediaMetadataType mediaMetadataType);
 std::wstring GetDriveSpaceColumnText(const BasicItemInfo_t &itemInfo, bool TotalSize,
 	const GlobalFolderSettings &globalFolderSettings);
 BOOL GetDriveSpaceColumnRawData(const BasicItemInfo_t &itemInfo, bool TotalSize,
 	ULARGE_INTEGER &DriveSpace);
 std::wstring GetSizeColumnText(const BasicItemInfo_t &itemInfo,
-	const GlobalFolderSettings &globalFolderSettings);
+	const GlobalFolderSettings &globalFolderSettings, FolderSizeCache *folderSizeCache,
+	std::stop_token stopToken = {});
 std::wstring GetFolderSizeColumnText(const BasicItemInfo_t &itemInfo,
-	const GlobalFolderSettings &globalFolderSettings);
+	const GlobalFolderSettings &globalFolderSettings, FolderSizeCache *folderSizeCache,
+	std::stop_token stopToken = {});
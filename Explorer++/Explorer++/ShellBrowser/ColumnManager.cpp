@@ -12,92 +12,264 @@
 #include "ItemData.h"
 #include "MainResource.h"
 #include "ResourceHelper.h"
+#include "Runtime.h"
 #include "SortModes.h"
+#include "TaskScheduler.h"
 #include "ViewModes.h"
+#include "../Helper/ScopedRedrawDisabler.h"
+#include <algorithm>
 #include <cassert>
 #include <list>
 
+// The listview requests the text for each cell separately. Rather than queuing a task for each
+// cell, the requests are grouped by item and the tasks are only queued once the listview has
+// finished making requests. That way, all the columns for an item are retrieved in a single task.
 void ShellBrowserImpl::QueueColumnTask(int itemInternalIndex, ColumnType columnType)
 {
-	int columnResultID = m_columnResultIDCounter++;
+	auto &pendingColumns = m_directoryState.pendingColumns[itemInternalIndex];
 
-	BasicItemInfo_t basicItemInfo = getBasicItemInfo(itemInternalIndex);
-	GlobalFolderSettings globalFolderSettings = m_config->globalFolderSettings;
+	if (std::ranges::any_of(pendingColumns, [columnType](const PendingColumn &pendingColumn)
+			{ return pendingColumn.columnType == columnType; }))
+	{
+		// The text for this column has already been requested. The listview will request the text
+		// again whenever the item is redrawn, until the text has been set.
+		return;
+	}
 
-	auto result = m_columnThreadPool.push(
-		[listView = m_listView, columnResultID, columnType, itemInternalIndex, basicItemInfo,
-			globalFolderSettings](int id)
-		{
-			UNREFERENCED_PARAMETER(id);
+	pendingColumns.push_back({ columnType, std::nullopt });
+	m_directoryState.itemsWithUnsubmittedColumns.push_back(itemInternalIndex);
 
-			return GetColumnTextAsync(listView, columnResultID, columnType, itemInternalIndex,
-				basicItemInfo, globalFolderSettings);
-		});
+	if (m_directoryState.columnTaskSubmissionScheduled)
+	{
+		return;
+	}
 
-	// The function call above might finish before this line runs,
-	// but that doesn't matter, as the results won't be processed
-	// until a message posted to the main thread has been handled
-	// (which can only occur after this function has returned).
-	m_columnResults.insert({ columnResultID, std::move(result) });
+	SubmitColumnTasksAfterUpdate(m_weakPtrFactory.GetWeakPtr(), m_app->GetRuntime());
+	m_directoryState.columnTaskSubmissionScheduled = true;
 }
 
-ShellBrowserImpl::ColumnResult_t ShellBrowserImpl::GetColumnTextAsync(HWND listView,
-	int columnResultId, ColumnType columnType, int internalIndex,
-	const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings)
+concurrencpp::null_result ShellBrowserImpl::SubmitColumnTasksAfterUpdate(
+	WeakPtr<ShellBrowserImpl> weakSelf, Runtime *runtime)
 {
-	std::wstring columnText = GetColumnText(columnType, basicItemInfo, globalFolderSettings);
+	co_await concurrencpp::resume_on(runtime->GetUiThreadExecutor());
+
+	if (!weakSelf)
+	{
+		co_return;
+	}
+
+	weakSelf->m_directoryState.columnTaskSubmissionScheduled = false;
+	weakSelf->SubmitColumnTasks();
+}
+
+void ShellBrowserImpl::SubmitColumnTasks()
+{
+	GlobalFolderSettings globalFolderSettings = m_config->globalFolderSettings;
+
+	std::vector<int> itemInternalIndexes;
+	itemInternalIndexes.swap(m_directoryState.itemsWithUnsubmittedColumns);
+
+	for (int itemInternalIndex : itemInternalIndexes)
+	{
+		auto itr = m_directoryState.pendingColumns.find(itemInternalIndex);
+
+		if (itr == m_directoryState.pendingColumns.end())
+		{
+			// The item has been updated or removed since the text was requested.
+			continue;
+		}
+
+		int columnResultId = m_columnResultIDCounter;
+		std::vector<ColumnType> columnTypes;
+
+		for (auto &pendingColumn : itr->second)
+		{
+			if (pendingColumn.columnResultId)
+			{
+				continue;
+			}
+
+			pendingColumn.columnResultId = columnResultId;
+			columnTypes.push_back(pendingColumn.columnType);
+		}
+
+		if (columnTypes.empty())
+		{
+			// The tasks for this item have already been queued (an item can appear in the list
+			// above multiple times).
+			continue;
+		}
 
-	// This message may be delivered before this function has returned.
-	// That doesn't actually matter, since the message handler will
-	// simply wait for the result to be returned.
-	PostMessage(listView, WM_APP_COLUMN_RESULT_READY, columnResultId, 0);
+		m_columnResultIDCounter++;
 
+		BasicItemInfo_t basicItemInfo = getBasicItemInfo(itemInternalIndex);
+
+		m_columnTaskQueue->Push(
+			[listView = m_listView, completedResults = m_completedColumnResults, columnResultId,
+				itemInternalIndex, columnTypes, basicItemInfo, globalFolderSettings,
+				folderSizeCache = m_app->GetFolderSizeCache(),
+				stopToken = m_columnTaskStopSource.get_token()]
+			{
+				GetColumnTextAsync(listView, completedResults, columnResultId, itemInternalIndex,
+					columnTypes, basicItemInfo, globalFolderSettings, folderSizeCache.get(),
+					stopToken);
+			},
+			itemInternalIndex);
+	}
+}
+
+void ShellBrowserImpl::GetColumnTextAsync(HWND listView,
+	std::shared_ptr<CompletedColumnResults> completedResults, int columnResultId,
+	int internalIndex, const std::vector<ColumnType> &columnTypes,
+	const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings,
+	FolderSizeCache *folderSizeCache, std::stop_token stopToken)
+{
 	ColumnResult_t result;
+	result.columnResultId = columnResultId;
 	result.itemInternalIndex = internalIndex;
-	result.columnType = columnType;
-	result.columnText = columnText;
 
-	return result;
+	ColumnItemResources itemResources(basicItemInfo);
+
+	for (auto columnType : columnTypes)
+	{
+		result.columnTexts.emplace_back(columnType,
+			GetColumnText(columnType, itemResources, globalFolderSettings, folderSizeCache,
+				stopToken));
+	}
+
+	std::unique_lock lock(completedResults->mutex);
+	bool notificationRequired = completedResults->results.empty();
+	completedResults->results.push_back(std::move(result));
+	lock.unlock();
+
+	// Only a single message is posted for each batch of results. Until the UI thread takes the
+	// current batch, any further results will simply be added to it.
+	if (notificationRequired)
+	{
+		PostMessage(listView, WM_APP_COLUMN_RESULT_READY, 0, 0);
+	}
 }
 
-void ShellBrowserImpl::ProcessColumnResult(int columnResultId)
+void ShellBrowserImpl::ProcessColumnResults()
 {
-	auto itr = m_columnResults.find(columnResultId);
+	std::vector<ColumnResult_t> results;
+
+	std::unique_lock lock(m_completedColumnResults->mutex);
+	results.swap(m_completedColumnResults->results);
+	lock.unlock();
 
-	if (itr == m_columnResults.end())
+	if (results.empty())
 	{
-		// This result is for a previous folder. It can be ignored.
 		return;
 	}
 
-	if (m_folderSettings.viewMode != +ViewMode::Details)
+	ScopedRedrawDisabler redrawDisabler(m_listView);
+
+	for (const auto &result : results)
 	{
-		return;
+		ProcessColumnResult(result);
 	}
+}
 
-	auto result = itr->second.get();
-
-	auto index = LocateItemByInternalIndex(result.itemInternalIndex);
+void ShellBrowserImpl::ProcessColumnResult(const ColumnResult_t &result)
+{
+	auto itr = m_directoryState.pendingColumns.find(result.itemInternalIndex);
 
-	if (!index)
+	if (itr == m_directoryState.pendingColumns.end())
 	{
-		// This is a valid state. The item may simply have been deleted.
+		// This result is for a previous folder, or the item has since been updated or removed. It
+		// can be ignored.
 		return;
 	}
 
-	auto columnIndex = GetColumnIndexByType(result.columnType);
+	auto &pendingColumns = itr->second;
+	std::optional<int> index;
 
-	if (!columnIndex)
+	if (m_folderSettings.viewMode == +ViewMode::Details)
 	{
-		// This is also a valid state. The column may have been removed.
-		return;
+		// Note that it's valid for the item not to be found, since it may have been filtered out.
+		index = LocateItemByInternalIndex(result.itemInternalIndex);
+	}
+
+	for (const auto &[columnType, columnText] : result.columnTexts)
+	{
+		// The column may have been requested again (e.g. because the item was updated) after
+		// this result was queued, in which case the text here is out of date.
+		auto numRemoved = std::erase_if(pendingColumns,
+			[&result, type = columnType](const PendingColumn &pendingColumn)
+			{
+				return pendingColumn.columnType == type
+					&& pendingColumn.columnResultId == result.columnResultId;
+			});
+
+		if (numRemoved == 0)
+		{
+			continue;
+		}
+
+		if (CanCacheColumnText(columnType))
+		{
+			m_columnTextCache.SetText(result.itemInternalIndex, columnType, columnText);
+		}
+
+		// Retrieving the size of a folder caches it, at which point the folder's size sort key can
+		// take that size into account.
+		if (columnType == ColumnType::Size)
+		{
+			m_directoryState.sortItemCache.erase(result.itemInternalIndex);
+		}
+
+		if (!index)
+		{
+			continue;
+		}
+
+		auto columnIndex = GetColumnIndexByType(columnType);
+
+		if (!columnIndex)
+		{
+			// This is a valid state. The column may have been removed.
+			continue;
+		}
+
+		auto columnTextCopy = std::make_unique<TCHAR[]>(columnText.size() + 1);
+		StringCchCopy(columnTextCopy.get(), columnText.size() + 1, columnText.c_str());
+		ListView_SetItemText(m_listView, *index, *columnIndex, columnTextCopy.get());
 	}
 
-	auto columnText = std::make_unique<TCHAR[]>(result.columnText.size() + 1);
-	StringCchCopy(columnText.get(), result.columnText.size() + 1, result.columnText.c_str());
-	ListView_SetItemText(m_listView, *index, *columnIndex, columnText.get());
+	if (pendingColumns.empty())
+	{
+		m_directoryState.pendingColumns.erase(itr);
+	}
+}
+
+// Drops any cached or pending text for the item, so that the text will be retrieved again the next
+// time it's requested.
+void ShellBrowserImpl::InvalidateColumnText(int itemInternalIndex)
+{
+	m_columnTextCache.InvalidateItem(itemInternalIndex);
+	m_directoryState.pendingColumns.erase(itemInternalIndex);
+}
+
+void ShellBrowserImpl::OnShowFriendlyDatesUpdated(bool newValue)
+{
+	UNREFERENCED_PARAMETER(newValue);
+
+	// The cached text for the date columns was formatted using the previous setting.
+	m_columnTextCache.Clear();
+}
+
+void ShellBrowserImpl::ClearColumnTasks()
+{
+	m_columnTaskStopSource.request_stop();
+	m_columnTaskStopSource = {};
+
+	m_columnTaskQueue->Clear();
+	m_directoryState.pendingColumns.clear();
+	m_directoryState.itemsWithUnsubmittedColumns.clear();
 
-	m_columnResults.erase(itr);
+	std::unique_lock lock(m_completedColumnResults->mutex);
+	m_completedColumnResults->results.clear();
 }
 
 std::optional<int> ShellBrowserImpl::GetColumnIndexByType(ColumnType columnType) const
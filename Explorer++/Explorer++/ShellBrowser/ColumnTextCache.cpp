@@ -0,0 +1,120 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ColumnTextCache.h"
+
+ColumnTextCache::ColumnTextCache(size_t maxSize, size_t maxEntries) :
+	m_maxSize(maxSize),
+	m_maxEntries(maxEntries)
+{
+}
+
+std::optional<std::wstring> ColumnTextCache::MaybeGetText(int internalIndex,
+	ColumnType columnType)
+{
+	auto itemItr = m_itemEntries.find(internalIndex);
+
+	if (itemItr == m_itemEntries.end())
+	{
+		return std::nullopt;
+	}
+
+	auto entryItr = itemItr->second.find(columnType._to_integral());
+
+	if (entryItr == itemItr->second.end())
+	{
+		return std::nullopt;
+	}
+
+	m_entries.splice(m_entries.begin(), m_entries, entryItr->second);
+
+	return entryItr->second->text;
+}
+
+void ColumnTextCache::SetText(int internalIndex, ColumnType columnType, const std::wstring &text)
+{
+	if (text.size() > m_maxSize || m_maxEntries == 0)
+	{
+		return;
+	}
+
+	auto &itemEntries = m_itemEntries[internalIndex];
+	auto entryItr = itemEntries.find(columnType._to_integral());
+
+	if (entryItr != itemEntries.end())
+	{
+		m_size -= entryItr->second->text.size();
+		entryItr->second->text = text;
+		m_entries.splice(m_entries.begin(), m_entries, entryItr->second);
+	}
+	else
+	{
+		m_entries.push_front({ internalIndex, columnType, text });
+		itemEntries.emplace(columnType._to_integral(), m_entries.begin());
+	}
+
+	m_size += text.size();
+
+	RemoveLeastRecentlyUsedEntries();
+}
+
+void ColumnTextCache::InvalidateItem(int internalIndex)
+{
+	auto itemItr = m_itemEntries.find(internalIndex);
+
+	if (itemItr == m_itemEntries.end())
+	{
+		return;
+	}
+
+	for (const auto &[columnType, entryItr] : itemItr->second)
+	{
+		m_size -= entryItr->text.size();
+		m_entries.erase(entryItr);
+	}
+
+	m_itemEntries.erase(itemItr);
+}
+
+void ColumnTextCache::Clear()
+{
+	m_entries.clear();
+	m_itemEntries.clear();
+	m_size = 0;
+}
+
+size_t ColumnTextCache::GetSize() const
+{
+	return m_size;
+}
+
+size_t ColumnTextCache::GetNumEntries() const
+{
+	return m_entries.size();
+}
+
+void ColumnTextCache::RemoveEntry(EntryList::iterator itr)
+{
+	auto itemItr = m_itemEntries.find(itr->internalIndex);
+	CHECK(itemItr != m_itemEntries.end());
+
+	itemItr->second.erase(itr->columnType._to_integral());
+
+	if (itemItr->second.empty())
+	{
+		m_itemEntries.erase(itemItr);
+	}
+
+	m_size -= itr->text.size();
+	m_entries.erase(itr);
+}
+
+void ColumnTextCache::RemoveLeastRecentlyUsedEntries()
+{
+	while (m_size > m_maxSize || m_entries.size() > m_maxEntries)
+	{
+		RemoveEntry(std::prev(m_entries.end()));
+	}
+}
@@ -0,0 +1,63 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "Columns.h"
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+// Caches the column text for each item in a folder. Retrieving the text for some columns (e.g. the
+// owner, version information or media metadata columns) requires the item to be opened, so caching
+// the text means it doesn't need to be retrieved again when an item is redisplayed (e.g. after
+// scrolling back to the item or switching view modes), or when the folder is sorted by the column.
+//
+// Both the total length of the text stored and the number of entries are limited. The entry limit
+// matters when the text is short (or empty), since each entry still has a fixed overhead. Once
+// either limit is reached, the least recently used entries are removed.
+class ColumnTextCache
+{
+public:
+	// The maximum size is the total number of characters that will be stored.
+	ColumnTextCache(size_t maxSize, size_t maxEntries);
+
+	ColumnTextCache(const ColumnTextCache &) = delete;
+	ColumnTextCache &operator=(const ColumnTextCache &) = delete;
+
+	std::optional<std::wstring> MaybeGetText(int internalIndex, ColumnType columnType);
+	void SetText(int internalIndex, ColumnType columnType, const std::wstring &text);
+
+	// Removes the cached text for every column of the item.
+	void InvalidateItem(int internalIndex);
+
+	void Clear();
+
+	size_t GetSize() const;
+	size_t GetNumEntries() const;
+
+private:
+	struct Entry
+	{
+		int internalIndex;
+		ColumnType columnType;
+		std::wstring text;
+	};
+
+	// The most recently used entry is at the front.
+	using EntryList = std::list<Entry>;
+
+	void RemoveEntry(EntryList::iterator itr);
+	void RemoveLeastRecentlyUsedEntries();
+
+	const size_t m_maxSize;
+	const size_t m_maxEntries;
+	EntryList m_entries;
+
+	// Maps each item to its entries, keyed by column type.
+	std::unordered_map<int, std::unordered_map<unsigned int, EntryList::iterator>> m_itemEntries;
+
+	size_t m_size = 0;
+};
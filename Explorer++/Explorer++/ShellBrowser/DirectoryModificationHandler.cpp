@@ -7,6 +7,7 @@
 #include "App.h"
 #include "ColumnDataRetrieval.h"
 #include "Config.h"
+#include "FolderSizeCache.h"
 #include "ItemData.h"
 #include "NavigateParams.h"
 #include "Runtime.h"
@@ -39,11 +40,44 @@ void ShellBrowserImpl::StartDirectoryMonitoring()
 			std::bind_front(&ShellBrowserImpl::ProcessDirectoryChangeNotification, this),
 			DirectoryWatcher::Behavior::Recursive);
 	}
+
+	if (m_config->globalFolderSettings.showFolderSizes)
+	{
+		m_directoryState.folderSizeWatcher = m_app->GetDirectoryWatcherFactory()->MaybeCreate(
+			m_directoryState.pidlDirectory, DirectoryWatcher::Filters::All,
+			std::bind_front(&ShellBrowserImpl::ProcessFolderSizeChangeNotification, this),
+			DirectoryWatcher::Behavior::Recursive);
+
+		if (m_directoryState.folderSizeWatcher)
+		{
+			m_directoryState.folderSizeWatchedTree =
+				m_app->GetFolderSizeCache()->RegisterWatchedTree(m_directoryState.directory);
+		}
+	}
 }
 
 void ShellBrowserImpl::ProcessDirectoryChangeNotification(DirectoryWatcher::Event event,
 	const PidlAbsolute &simplePidl1, const PidlAbsolute &simplePidl2)
 {
+	// If the change refers to an item that's still being enumerated, processing it now could mean
+	// that it has no effect (if the item is removed or renamed), or that the original item is
+	// added back once it's enumerated. The change is instead processed once all the items have
+	// been added. Changes to the directory itself don't depend on its items, so they're processed
+	// immediately.
+	if (m_directoryState.remainingNavigationItems
+		&& ILIsParent(m_directoryState.pidlDirectory.Raw(), simplePidl1.Raw(), TRUE))
+	{
+		m_directoryState.queuedDirectoryChanges.emplace_back(event, simplePidl1, simplePidl2);
+		return;
+	}
+
+	// Any items that are waiting to be inserted need to be inserted before other types of changes
+	// are processed, since those changes may reference the items.
+	if (event != DirectoryWatcher::Event::Added)
+	{
+		InsertPendingSortedItems();
+	}
+
 	switch (event)
 	{
 	case DirectoryWatcher::Event::Added:
@@ -125,6 +159,32 @@ void ShellBrowserImpl::ProcessDirectoryChangeNotification(DirectoryWatcher::Even
 	m_app->GetShellBrowserEvents()->NotifyItemsChanged(this);
 }
 
+void ShellBrowserImpl::ProcessFolderSizeChangeNotification(DirectoryWatcher::Event event,
+	const PidlAbsolute &simplePidl1, const PidlAbsolute &simplePidl2)
+{
+	// If a folder has been renamed or removed, or its contents are unknown, none of the cached
+	// sizes for the folders within it can be relied on.
+	bool includeSubtree = (event == DirectoryWatcher::Event::Renamed
+		|| event == DirectoryWatcher::Event::Removed
+		|| event == DirectoryWatcher::Event::DirectoryContentsChanged);
+
+	for (const auto *simplePidl : { &simplePidl1, &simplePidl2 })
+	{
+		if (!simplePidl->HasValue())
+		{
+			continue;
+		}
+
+		std::wstring path;
+		HRESULT hr = GetDisplayName(simplePidl->Raw(), SHGDN_FORPARSING, path);
+
+		if (SUCCEEDED(hr))
+		{
+			m_app->GetFolderSizeCache()->InvalidatePath(path, includeSubtree);
+		}
+	}
+}
+
 void ShellBrowserImpl::OnItemAdded(PCIDLIST_ABSOLUTE simplePidl)
 {
 	auto existingItemInternalIndex = GetItemInternalIndexForPidl(simplePidl);
@@ -185,10 +245,6 @@ void ShellBrowserImpl::AddItem(PCIDLIST_ABSOLUTE pidl)
 
 	if (m_config->globalFolderSettings.insertSorted)
 	{
-		// TODO: It would be better to pass the items details to this function directly
-		// instead (before the item is added to the awaiting list).
-		int sortedPosition = DetermineItemSortedPosition(*itemId);
-
 		auto itr = std::find_if(m_directoryState.awaitingAddList.begin(),
 			m_directoryState.awaitingAddList.end(), [itemId](const AwaitingAdd_t &awaitingItem)
 			{ return *itemId == awaitingItem.iItemInternal; });
@@ -197,14 +253,89 @@ void ShellBrowserImpl::AddItem(PCIDLIST_ABSOLUTE pidl)
 		// items.
 		CHECK(itr != m_directoryState.awaitingAddList.end());
 
-		itr->iItem = sortedPosition;
-		itr->bPosition = TRUE;
-		itr->iAfter = sortedPosition - 1;
+		// The position of the item will be determined once it's actually inserted.
+		m_directoryState.awaitingAddList.erase(itr);
+
+		if (m_directoryState.pendingSortedItems.empty())
+		{
+			InsertPendingSortedItemsAfterUpdate(m_weakPtrFactory.GetWeakPtr(), m_app->GetRuntime());
+		}
+
+		m_directoryState.pendingSortedItems.push_back(*itemId);
+		return;
 	}
 
 	InsertAwaitingItems();
 }
 
+void ShellBrowserImpl::InsertPendingSortedItems()
+{
+	if (m_directoryState.pendingSortedItems.empty())
+	{
+		return;
+	}
+
+	InsertItemsInSortedOrder(std::exchange(m_directoryState.pendingSortedItems, {}));
+}
+
+void ShellBrowserImpl::InsertItemsInSortedOrder(std::vector<int> internalIndexes)
+{
+	CacheSortItems(internalIndexes);
+
+	bool sortFoldersSeparately = ShouldSortFoldersSeparately();
+
+	std::sort(internalIndexes.begin(), internalIndexes.end(),
+		[this, sortFoldersSeparately](int internalIndex1, int internalIndex2)
+		{
+			return CompareSortItems(GetCachedSortItem(internalIndex1),
+					   GetCachedSortItem(internalIndex2), sortFoldersSeparately)
+				< 0;
+		});
+
+	// Each position here is determined relative to the current set of items in the listview. As
+	// the new items are in sorted order, each item will end up being placed after all the new items
+	// that come before it, which is why the number of items inserted so far needs to be taken into
+	// account.
+	int numItemsInserted = 0;
+
+	for (int internalIndex : internalIndexes)
+	{
+		int sortedPosition = DetermineItemSortedPosition(internalIndex) + numItemsInserted;
+
+		AwaitingAdd_t awaitingAdd;
+		awaitingAdd.iItem = sortedPosition;
+		awaitingAdd.iItemInternal = internalIndex;
+		awaitingAdd.bPosition = TRUE;
+		awaitingAdd.iAfter = sortedPosition - 1;
+		m_directoryState.awaitingAddList.push_back(awaitingAdd);
+
+		// Filtered items won't be inserted into the listview.
+		if (!IsFileFiltered(m_itemInfoMap.at(internalIndex)))
+		{
+			numItemsInserted++;
+		}
+	}
+
+	InsertAwaitingItems();
+
+	m_app->GetShellBrowserEvents()->NotifyItemsChanged(this);
+}
+
+concurrencpp::null_result ShellBrowserImpl::InsertPendingSortedItemsAfterUpdate(
+	WeakPtr<ShellBrowserImpl> weakSelf, Runtime *runtime)
+{
+	// Resuming on the UI thread here means that the items will be inserted once any change
+	// notifications that are currently queued have been processed.
+	co_await concurrencpp::resume_on(runtime->GetUiThreadExecutor());
+
+	if (!weakSelf)
+	{
+		co_return;
+	}
+
+	weakSelf->InsertPendingSortedItems();
+}
+
 void ShellBrowserImpl::OnItemRemoved(PCIDLIST_ABSOLUTE simplePidl)
 {
 	auto internalIndex = GetItemInternalIndexForPidl(simplePidl);
@@ -283,7 +414,18 @@ void ShellBrowserImpl::UpdateItem(PCIDLIST_ABSOLUTE pidl, PCIDLIST_ABSOLUTE upda
 
 	m_directoryState.totalDirSize += newFileSize.QuadPart - oldFileSize.QuadPart;
 
+	m_parsingNameIndex.RemoveItem(m_itemInfoMap[*internalIndex].parsingName, *internalIndex);
+	m_parsingNameIndex.AddItem(itemInfo->parsingName, *internalIndex);
+
 	m_itemInfoMap[*internalIndex] = *itemInfo;
+	m_directoryState.sortItemCache.erase(*internalIndex);
+	InvalidateColumnText(*internalIndex);
+
+	if (m_directoryState.thumbnailBitmapCache)
+	{
+		m_directoryState.thumbnailBitmapCache->InvalidateItem(*internalIndex);
+	}
+
 	const ItemInfo_t &updatedItemInfo = m_itemInfoMap[*internalIndex];
 
 	auto itemIndex = LocateItemByInternalIndex(*internalIndex);
@@ -382,6 +524,10 @@ void ShellBrowserImpl::OnItemRenamed(PCIDLIST_ABSOLUTE simplePidlOld,
 
 void ShellBrowserImpl::InvalidateAllColumnsForItem(int itemIndex)
 {
+	// The cached text is dropped regardless of the current view mode, since it will be used when
+	// switching back to details view.
+	InvalidateColumnText(GetItemInternalIndex(itemIndex));
+
 	if (m_folderSettings.viewMode != +ViewMode::Details)
 	{
 		return;
@@ -138,8 +138,13 @@ void ShellBrowserImpl::RemoveFilteredItem(int iItem, int iItemInternal)
 
 BOOL ShellBrowserImpl::IsFilenameFiltered(const TCHAR *FileName) const
 {
-	if (CheckWildcardMatch(m_folderSettings.filter.c_str(), FileName,
-			m_folderSettings.filterCaseSensitive))
+	if (!m_compiledFilter || m_compiledFilter->GetPattern() != m_folderSettings.filter
+		|| m_compiledFilter->IsCaseSensitive() != m_folderSettings.filterCaseSensitive)
+	{
+		m_compiledFilter.emplace(m_folderSettings.filter, m_folderSettings.filterCaseSensitive);
+	}
+
+	if (m_compiledFilter->Matches(FileName))
 	{
 		return FALSE;
 	}
@@ -39,7 +39,7 @@ struct FolderColumns
 struct GlobalFolderSettings
 {
 	bool showExtensions = true;
-	bool showFriendlyDates = true;
+	ValueWrapper<bool> showFriendlyDates = true;
 	bool showFolderSizes = false;
 	bool disableFolderSizesNetworkRemovable = false;
 	bool hideSystemFiles = false;
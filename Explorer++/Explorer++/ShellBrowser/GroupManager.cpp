@@ -11,6 +11,7 @@
 #include "MainResource.h"
 #include "ResourceLoader.h"
 #include "SortModes.h"
+#include "TaskScheduler.h"
 #include "../Helper/Helper.h"
 #include "../Helper/ScopedRedrawDisabler.h"
 #include "../Helper/ShellHelper.h"
@@ -51,6 +52,7 @@ void ShellBrowserImpl::SetShowInGroups(bool showInGroups)
 		ListView_EnableGroupView(m_listView, false);
 		ListView_RemoveAllGroups(m_listView);
 		m_directoryState.groups.clear();
+		ClearGroupTasks();
 	}
 	else
 	{
@@ -145,10 +147,64 @@ const ShellBrowserImpl::ListViewGroup ShellBrowserImpl::GetListViewGroupById(int
 
 int ShellBrowserImpl::DetermineItemGroup(int iItemInternal)
 {
-	BasicItemInfo_t basicItemInfo = getBasicItemInfo(iItemInternal);
+	if (IsGroupModeSlow(m_folderSettings.groupMode))
+	{
+		// The item will be placed into a provisional group for now and moved into its actual group
+		// once the background task has finished.
+		QueueGroupTask(iItemInternal);
+
+		return GetOrCreateListViewGroup(
+			GroupInfo(m_app->GetResourceLoader()->LoadString(IDS_GENERAL_CALCULATING), INT_MAX));
+	}
+
+	m_directoryState.pendingGroups.erase(iItemInternal);
+
+	auto groupInfo = DetermineItemGroupInfo(getBasicItemInfo(iItemInternal),
+		m_folderSettings.groupMode, m_config->globalFolderSettings);
+	return GetOrCreateListViewGroupForResult(groupInfo);
+}
+
+// Returns true if determining the group for an item may require opening the item (or walking the
+// filesystem, or querying a device). Groups for these modes are determined in the background, so
+// that grouping a large folder doesn't block the UI thread.
+bool ShellBrowserImpl::IsGroupModeSlow(SortMode groupMode)
+{
+	switch (groupMode)
+	{
+	case SortMode::TotalSize:
+	case SortMode::FreeSpace:
+	case SortMode::OriginalLocation:
+	case SortMode::Owner:
+	case SortMode::ProductName:
+	case SortMode::Company:
+	case SortMode::Description:
+	case SortMode::FileVersion:
+	case SortMode::ProductVersion:
+	case SortMode::Title:
+	case SortMode::Subject:
+	case SortMode::Authors:
+	case SortMode::Keywords:
+	case SortMode::Comments:
+	case SortMode::CameraModel:
+	case SortMode::DateTaken:
+	case SortMode::Width:
+	case SortMode::Height:
+	case SortMode::FileSystem:
+	case SortMode::NetworkAdapterStatus:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+std::optional<ShellBrowserImpl::GroupInfo> ShellBrowserImpl::DetermineItemGroupInfo(
+	const BasicItemInfo_t &basicItemInfo, SortMode groupMode,
+	const GlobalFolderSettings &globalFolderSettings) const
+{
 	std::optional<GroupInfo> groupInfo;
 
-	switch (m_folderSettings.groupMode)
+	switch (groupMode)
 	{
 	case SortMode::Name:
 		groupInfo = DetermineItemNameGroup(basicItemInfo);
@@ -179,7 +235,7 @@ int ShellBrowserImpl::DetermineItemGroup(int iItemInternal)
 
 	case SortMode::OriginalLocation:
 		groupInfo = DetermineItemSummaryGroup(basicItemInfo, &SCID_ORIGINAL_LOCATION,
-			m_config->globalFolderSettings);
+			globalFolderSettings);
 		break;
 
 	case SortMode::Attributes:
@@ -233,28 +289,23 @@ int ShellBrowserImpl::DetermineItemGroup(int iItemInternal)
 		break;
 
 	case SortMode::Title:
-		groupInfo =
-			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Title, m_config->globalFolderSettings);
+		groupInfo = DetermineItemSummaryGroup(basicItemInfo, &PKEY_Title, globalFolderSettings);
 		break;
 
 	case SortMode::Subject:
-		groupInfo =
-			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Subject, m_config->globalFolderSettings);
+		groupInfo = DetermineItemSummaryGroup(basicItemInfo, &PKEY_Subject, globalFolderSettings);
 		break;
 
 	case SortMode::Authors:
-		groupInfo =
-			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Author, m_config->globalFolderSettings);
+		groupInfo = DetermineItemSummaryGroup(basicItemInfo, &PKEY_Author, globalFolderSettings);
 		break;
 
 	case SortMode::Keywords:
-		groupInfo = DetermineItemSummaryGroup(basicItemInfo, &PKEY_Keywords,
-			m_config->globalFolderSettings);
+		groupInfo = DetermineItemSummaryGroup(basicItemInfo, &PKEY_Keywords, globalFolderSettings);
 		break;
 
 	case SortMode::Comments:
-		groupInfo =
-			DetermineItemSummaryGroup(basicItemInfo, &PKEY_Comment, m_config->globalFolderSettings);
+		groupInfo = DetermineItemSummaryGroup(basicItemInfo, &PKEY_Comment, globalFolderSettings);
 		break;
 
 	case SortMode::CameraModel:
@@ -301,15 +352,107 @@ int ShellBrowserImpl::DetermineItemGroup(int iItemInternal)
 		break;
 	}
 
+	return groupInfo;
+}
+
+int ShellBrowserImpl::GetOrCreateListViewGroupForResult(const std::optional<GroupInfo> &groupInfo)
+{
 	if (!groupInfo)
 	{
-		groupInfo =
-			GroupInfo(m_app->GetResourceLoader()->LoadString(IDS_GROUPBY_UNSPECIFIED), INT_MIN);
+		return GetOrCreateListViewGroup(
+			GroupInfo(m_app->GetResourceLoader()->LoadString(IDS_GROUPBY_UNSPECIFIED), INT_MIN));
 	}
 
 	return GetOrCreateListViewGroup(*groupInfo);
 }
 
+void ShellBrowserImpl::QueueGroupTask(int itemInternalIndex)
+{
+	int groupResultId = m_groupResultIDCounter++;
+
+	// If there's an existing task for this item, its result will be ignored, since the item may
+	// have changed since that task was queued.
+	m_directoryState.pendingGroups[itemInternalIndex] = groupResultId;
+
+	// Note that it's safe to reference this instance from the task, as the queue will wait for
+	// running tasks to finish when it's destroyed. The folder settings can change while the task is
+	// running, however, so they're copied here.
+	m_groupTaskQueue->Push(
+		[this, listView = m_listView, completedResults = m_completedGroupResults, groupResultId,
+			itemInternalIndex, basicItemInfo = getBasicItemInfo(itemInternalIndex),
+			groupMode = m_folderSettings.groupMode,
+			globalFolderSettings = m_config->globalFolderSettings]
+		{
+			GroupResult result;
+			result.groupResultId = groupResultId;
+			result.itemInternalIndex = itemInternalIndex;
+			result.groupInfo =
+				DetermineItemGroupInfo(basicItemInfo, groupMode, globalFolderSettings);
+
+			std::unique_lock lock(completedResults->mutex);
+			bool notificationRequired = completedResults->results.empty();
+			completedResults->results.push_back(std::move(result));
+			lock.unlock();
+
+			// As with column results, only a single message is posted for each batch of results.
+			if (notificationRequired)
+			{
+				PostMessage(listView, WM_APP_GROUP_RESULTS_READY, 0, 0);
+			}
+		},
+		itemInternalIndex);
+}
+
+void ShellBrowserImpl::ProcessGroupResults()
+{
+	std::vector<GroupResult> results;
+
+	std::unique_lock lock(m_completedGroupResults->mutex);
+	results.swap(m_completedGroupResults->results);
+	lock.unlock();
+
+	if (results.empty())
+	{
+		return;
+	}
+
+	ScopedRedrawDisabler redrawDisabler(m_listView);
+
+	for (const auto &result : results)
+	{
+		auto itr = m_directoryState.pendingGroups.find(result.itemInternalIndex);
+
+		if (itr == m_directoryState.pendingGroups.end() || itr->second != result.groupResultId)
+		{
+			// This result is for a previous folder or grouping, or the item has been updated since
+			// the task was queued.
+			continue;
+		}
+
+		m_directoryState.pendingGroups.erase(itr);
+
+		// The item may have been filtered out, in which case its group will be determined again
+		// when it's restored.
+		auto index = LocateItemByInternalIndex(result.itemInternalIndex);
+
+		if (!index)
+		{
+			continue;
+		}
+
+		InsertItemIntoGroup(*index, GetOrCreateListViewGroupForResult(result.groupInfo));
+	}
+}
+
+void ShellBrowserImpl::ClearGroupTasks()
+{
+	m_groupTaskQueue->Clear();
+	m_directoryState.pendingGroups.clear();
+
+	std::unique_lock lock(m_completedGroupResults->mutex);
+	m_completedGroupResults->results.clear();
+}
+
 int ShellBrowserImpl::GetOrCreateListViewGroup(const GroupInfo &groupInfo)
 {
 	// Note that this will return an existing group, if a group already exists with the specified
@@ -826,6 +969,7 @@ void ShellBrowserImpl::MoveItemsIntoGroups()
 
 	ListView_RemoveAllGroups(m_listView);
 	m_directoryState.groups.clear();
+	ClearGroupTasks();
 
 	ListView_EnableGroupView(m_listView, true);
 
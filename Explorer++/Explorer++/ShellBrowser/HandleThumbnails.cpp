@@ -4,15 +4,50 @@
 
 #include "stdafx.h"
 #include "ShellBrowserImpl.h"
+#include "Config.h"
 #include "ItemData.h"
+#include "TaskScheduler.h"
 #include "ViewModes.h"
+#include "../Helper/StringHelper.h"
 #include <wil/com.h>
 #include <thumbcache.h>
+#include <algorithm>
+#include <format>
+#include <limits>
 #include <list>
 
 #define THUMBNAIL_TYPE_ICON 0
 #define THUMBNAIL_TYPE_EXTRACTED 1
 
+namespace
+{
+
+// Creating the thumbnail cache object each time a thumbnail is retrieved is relatively expensive,
+// so a single instance is created on each worker thread and reused.
+//
+// Note that the instance is deliberately never released. The worker threads only exit once the
+// application is shutting down, by which point COM has already been uninitialized on the thread,
+// so releasing the instance when the thread exits wouldn't be safe.
+IThumbnailCache *GetThumbnailCacheForCurrentThread()
+{
+	static thread_local IThumbnailCache *thumbnailCache = nullptr;
+
+	if (!thumbnailCache)
+	{
+		HRESULT hr = CoCreateInstance(CLSID_LocalThumbnailCache, nullptr, CLSCTX_INPROC_SERVER,
+			IID_PPV_ARGS(&thumbnailCache));
+
+		if (FAILED(hr))
+		{
+			return nullptr;
+		}
+	}
+
+	return thumbnailCache;
+}
+
+}
+
 void ShellBrowserImpl::SetupThumbnailsView(int shellImageListType)
 {
 	// This will be used in cases where the thumbnail hasn't been retrieved yet and the standard
@@ -21,9 +56,22 @@ void ShellBrowserImpl::SetupThumbnailsView(int shellImageListType)
 	FAIL_FAST_IF_FAILED(SHGetImageList(shellImageListType, IID_PPV_ARGS(&imageList)));
 	m_directoryState.thumbnailsShellImageList = reinterpret_cast<HIMAGELIST>(imageList);
 
+	// The memory limit covers both the thumbnail bitmaps that are cached and the image list.
+	auto memoryLimit = static_cast<uint64_t>(m_config->thumbnailMemoryLimitMB) * 1024 * 1024;
+	auto bitmapCacheMemoryLimit = memoryLimit * THUMBNAIL_BITMAP_CACHE_MEMORY_PERCENTAGE / 100;
+	m_directoryState.thumbnailBitmapCache = std::make_unique<ThumbnailBitmapCache>(
+		static_cast<size_t>(bitmapCacheMemoryLimit), THUMBNAIL_BITMAP_CACHE_MAX_ENTRIES);
+
+	// Each slot in the image list holds a single 32bpp thumbnail.
+	auto slotSize = static_cast<uint64_t>(m_thumbnailItemWidth) * m_thumbnailItemHeight * 4;
+	auto maxSlots = static_cast<int>(std::clamp<uint64_t>(
+		(memoryLimit - bitmapCacheMemoryLimit) / slotSize, MIN_THUMBNAIL_SLOTS,
+		std::numeric_limits<int>::max()));
+	m_directoryState.thumbnailSlotAllocator = std::make_unique<ThumbnailSlotAllocator>(maxSlots);
+
 	int numItems = ListView_GetItemCount(m_listView);
-	m_directoryState.thumbnailsImageList.reset(
-		ImageList_Create(m_thumbnailItemWidth, m_thumbnailItemHeight, ILC_COLOR32, numItems, 10));
+	m_directoryState.thumbnailsImageList.reset(ImageList_Create(m_thumbnailItemWidth,
+		m_thumbnailItemHeight, ILC_COLOR32, std::min(numItems, maxSlots), 10));
 	ListView_SetImageList(m_listView, m_directoryState.thumbnailsImageList.get(), LVSIL_NORMAL);
 
 	InvalidateAllItemImages();
@@ -31,15 +79,22 @@ void ShellBrowserImpl::SetupThumbnailsView(int shellImageListType)
 
 void ShellBrowserImpl::RemoveThumbnailsView()
 {
-	m_thumbnailThreadPool.clear_queue();
+	m_thumbnailTaskQueue->Clear();
 	m_thumbnailResults.clear();
 
 	InvalidateAllItemImages();
 
 	ListView_SetImageList(m_listView, nullptr, LVSIL_NORMAL);
 
+	LogThumbnailSlotUsage();
+
 	m_directoryState.thumbnailsShellImageList = nullptr;
 	m_directoryState.thumbnailsImageList.reset();
+	m_directoryState.thumbnailSlotAllocator.reset();
+
+	// The cached bitmaps are only used in thumbnails mode, so there's no reason to continue holding
+	// on to them.
+	m_directoryState.thumbnailBitmapCache.reset();
 }
 
 void ShellBrowserImpl::InvalidateAllItemImages()
@@ -63,12 +118,12 @@ void ShellBrowserImpl::QueueThumbnailTask(int internalIndex)
 
 	BasicItemInfo_t basicItemInfo = getBasicItemInfo(internalIndex);
 
-	auto result = m_thumbnailThreadPool.push(
+	auto result = m_thumbnailTaskQueue->Push(
 		[listView = m_listView, thumbnailResultID, internalIndex, basicItemInfo,
-			thumbnailSize = m_thumbnailItemWidth](int id) -> std::optional<ThumbnailResult_t>
+			thumbnailSize = m_thumbnailItemWidth]() -> std::optional<ThumbnailResult_t>
 		{
-			UNREFERENCED_PARAMETER(id);
-
+			// Note that this will return the thumbnail from the system cache, if it's present
+			// there, and only extract the thumbnail if it isn't.
 			auto bitmap = GetThumbnail(basicItemInfo.pidlComplete.get(), thumbnailSize,
 				WTS_EXTRACT | WTS_SCALETOREQUESTEDSIZE);
 
@@ -81,27 +136,16 @@ void ShellBrowserImpl::QueueThumbnailTask(int internalIndex)
 
 			ThumbnailResult_t result;
 			result.itemInternalIndex = internalIndex;
+			result.thumbnailSize = thumbnailSize;
 			result.bitmap = std::move(bitmap);
 
 			return result;
-		});
+		},
+		internalIndex);
 
 	m_thumbnailResults.insert({ thumbnailResultID, std::move(result) });
 }
 
-std::optional<int> ShellBrowserImpl::GetCachedThumbnailIndex(const ItemInfo_t &itemInfo)
-{
-	auto bitmap = GetThumbnail(itemInfo.pidlComplete.Raw(), m_thumbnailItemWidth,
-		WTS_INCACHEONLY | WTS_SCALETOREQUESTEDSIZE);
-
-	if (!bitmap)
-	{
-		return std::nullopt;
-	}
-
-	return GetExtractedThumbnail(bitmap.get());
-}
-
 wil::unique_hbitmap ShellBrowserImpl::GetThumbnail(PCIDLIST_ABSOLUTE pidl, UINT thumbnailSize,
 	WTS_FLAGS flags)
 {
@@ -113,11 +157,9 @@ wil::unique_hbitmap ShellBrowserImpl::GetThumbnail(PCIDLIST_ABSOLUTE pidl, UINT
 		return nullptr;
 	}
 
-	wil::com_ptr_nothrow<IThumbnailCache> thumbnailCache;
-	hr = CoCreateInstance(CLSID_LocalThumbnailCache, nullptr, CLSCTX_INPROC_SERVER,
-		IID_PPV_ARGS(&thumbnailCache));
+	auto *thumbnailCache = GetThumbnailCacheForCurrentThread();
 
-	if (FAILED(hr))
+	if (!thumbnailCache)
 	{
 		return nullptr;
 	}
@@ -131,6 +173,15 @@ wil::unique_hbitmap ShellBrowserImpl::GetThumbnail(PCIDLIST_ABSOLUTE pidl, UINT
 		return nullptr;
 	}
 
+	// Detaching the bitmap transfers ownership of it, which avoids having to make a copy.
+	wil::unique_hbitmap detachedBitmap;
+	hr = sharedBitmap->Detach(wil::out_param(detachedBitmap));
+
+	if (SUCCEEDED(hr) && detachedBitmap)
+	{
+		return detachedBitmap;
+	}
+
 	HBITMAP bitmap;
 	hr = sharedBitmap->GetSharedBitmap(&bitmap);
 
@@ -139,8 +190,8 @@ wil::unique_hbitmap ShellBrowserImpl::GetThumbnail(PCIDLIST_ABSOLUTE pidl, UINT
 		return nullptr;
 	}
 
-	// Note that the bitmap is copied here, since it's owned by the ISharedBitmap instance. As soon
-	// as that instance is destroyed, the bitmap will be destroyed.
+	// If the bitmap can't be detached, it has to be copied, since it's owned by the ISharedBitmap
+	// instance. As soon as that instance is destroyed, the bitmap will be destroyed.
 	return wil::unique_hbitmap(
 		reinterpret_cast<HBITMAP>(CopyImage(bitmap, IMAGE_BITMAP, 0, 0, LR_DEFAULTCOLOR)));
 }
@@ -154,6 +205,8 @@ void ShellBrowserImpl::ProcessThumbnailResult(int thumbnailResultId)
 		return;
 	}
 
+	auto cleanup = wil::scope_exit([this, itr]() { m_thumbnailResults.erase(itr); });
+
 	if (!IsThumbnailsViewMode(m_folderSettings.viewMode))
 	{
 		return;
@@ -167,43 +220,46 @@ void ShellBrowserImpl::ProcessThumbnailResult(int thumbnailResultId)
 		return;
 	}
 
-	int imageIndex = GetExtractedThumbnail(result->bitmap.get());
-
 	auto index = LocateItemByInternalIndex(result->itemInternalIndex);
 
-	if (!index)
+	// The item may have been filtered out of the listview, in which case the thumbnail doesn't need
+	// to be drawn, though it's still worth caching.
+	if (index)
 	{
-		return;
+		LVITEM lvItem;
+		lvItem.mask = LVIF_IMAGE;
+		lvItem.iItem = *index;
+		lvItem.iSubItem = 0;
+		lvItem.iImage = GetExtractedThumbnail(result->itemInternalIndex, result->bitmap.get());
+		ListView_SetItem(m_listView, &lvItem);
+
+		// The thumbnail will typically be drawn into the slot the item is already using. In that
+		// case, the image index won't change, so the item needs to be explicitly redrawn.
+		ListView_RedrawItems(m_listView, *index, *index);
 	}
 
-	LVITEM lvItem;
-	lvItem.mask = LVIF_IMAGE;
-	lvItem.iItem = *index;
-	lvItem.iSubItem = 0;
-	lvItem.iImage = imageIndex;
-	ListView_SetItem(m_listView, &lvItem);
+	m_directoryState.thumbnailBitmapCache->SetThumbnail(result->itemInternalIndex,
+		result->thumbnailSize, std::move(result->bitmap));
 }
 
 /* Draws a thumbnail based on an items icon. */
-int ShellBrowserImpl::GetIconThumbnail(int iInternalIndex) const
+int ShellBrowserImpl::GetIconThumbnail(int iInternalIndex)
 {
 	return GetThumbnailInternal(THUMBNAIL_TYPE_ICON, iInternalIndex, nullptr);
 }
 
 /* Draws an items extracted thumbnail. */
-int ShellBrowserImpl::GetExtractedThumbnail(HBITMAP hThumbnailBitmap) const
+int ShellBrowserImpl::GetExtractedThumbnail(int iInternalIndex, HBITMAP hThumbnailBitmap)
 {
-	return GetThumbnailInternal(THUMBNAIL_TYPE_EXTRACTED, 0, hThumbnailBitmap);
+	return GetThumbnailInternal(THUMBNAIL_TYPE_EXTRACTED, iInternalIndex, hThumbnailBitmap);
 }
 
-int ShellBrowserImpl::GetThumbnailInternal(int iType, int iInternalIndex,
-	HBITMAP hThumbnailBitmap) const
+int ShellBrowserImpl::GetThumbnailInternal(int iType, int iInternalIndex, HBITMAP hThumbnailBitmap)
 {
 	HDC hdc;
 	HDC hdcBacking;
 	HBITMAP hBackingBitmap;
 	HBITMAP hBackingBitmapOld;
-	HIMAGELIST himl;
 	HBRUSH hbr;
 	int iImage;
 
@@ -237,9 +293,7 @@ int ShellBrowserImpl::GetThumbnailInternal(int iType, int iInternalIndex,
 	DeleteDC(hdcBacking);
 	ReleaseDC(m_listView, hdc);
 
-	/* Add the new bitmap to the imagelist. */
-	himl = ListView_GetImageList(m_listView, LVSIL_NORMAL);
-	iImage = ImageList_Add(himl, hBackingBitmap, nullptr);
+	iImage = StoreThumbnailImage(iInternalIndex, hBackingBitmap);
 
 	/* Now delete the backing bitmap. */
 	DeleteObject(hBackingBitmap);
@@ -247,6 +301,69 @@ int ShellBrowserImpl::GetThumbnailInternal(int iType, int iInternalIndex,
 	return iImage;
 }
 
+// Stores the image in the slot assigned to the item, returning the index of the slot within the
+// image list.
+int ShellBrowserImpl::StoreThumbnailImage(int internalIndex, HBITMAP bitmap)
+{
+	auto allocation = m_directoryState.thumbnailSlotAllocator->GetSlot(internalIndex);
+	HIMAGELIST imageList = m_directoryState.thumbnailsImageList.get();
+
+	if (allocation.newSlot)
+	{
+		[[maybe_unused]] int index = ImageList_Add(imageList, bitmap, nullptr);
+		DCHECK(index == allocation.slot);
+	}
+	else
+	{
+		ImageList_Replace(imageList, allocation.slot, bitmap, nullptr);
+	}
+
+	if (allocation.evictedItem)
+	{
+		// The item that was previously using this slot will have its thumbnail requested again
+		// the next time it's displayed.
+		auto evictedItemIndex = LocateItemByInternalIndex(*allocation.evictedItem);
+
+		if (evictedItemIndex)
+		{
+			InvalidateIconForItem(*evictedItemIndex);
+		}
+	}
+
+	return allocation.slot;
+}
+
+void ShellBrowserImpl::UpdateThumbnailSlotUsage(const std::unordered_set<int> &visibleItems)
+{
+	auto *allocator = m_directoryState.thumbnailSlotAllocator.get();
+
+	if (!allocator)
+	{
+		return;
+	}
+
+	// The number of slots is limited by the configured memory limit, unless more items are visible
+	// than that limit allows (e.g. on a large, high-DPI display). Visible items might not have been
+	// redrawn in a while, but their slots are never reused while they remain visible.
+	allocator->SetVisibleItems(visibleItems);
+}
+
+void ShellBrowserImpl::LogThumbnailSlotUsage() const
+{
+	const auto *allocator = m_directoryState.thumbnailSlotAllocator.get();
+
+	if (!allocator)
+	{
+		return;
+	}
+
+	DLOG(INFO) << std::format(
+		"Thumbnail slots: {} hits, {} misses, {} evictions ({} of {} slots created) in {}",
+		allocator->GetNumHits(), allocator->GetNumMisses(), allocator->GetNumEvictions(),
+		allocator->GetNumSlots(), allocator->GetMaxSlots(),
+		wstrToUtf8Str(m_directoryState.directory));
+}
+
 void ShellBrowserImpl::DrawIconThumbnailInternal(HDC hdcBacking, int iInternalIndex) const
 {
 	HICON hIcon;
@@ -4,8 +4,10 @@
 
 #pragma once
 
+#include "../Helper/Pidl.h"
 #include "../Helper/ShellHelper.h"
 #include <wil/resource.h>
+#include <optional>
 
 struct BasicItemInfo_t
 {
@@ -41,3 +43,35 @@ struct BasicItemInfo_t
 		return fullPath;
 	}
 };
+
+struct ItemInfo_t
+{
+	PidlAbsolute pidlComplete;
+	PidlChild pridl;
+	WIN32_FIND_DATA wfd;
+	bool isFindDataValid;
+	std::wstring parsingName;
+	std::wstring displayName;
+	std::wstring editingName;
+
+	/* These are only used for drives. They are
+	needed for when a drive is removed from the
+	system, in which case the drive name is needed
+	so that the removed drive can be found. */
+	BOOL bDrive;
+	TCHAR szDrive[4];
+
+	/* Used for temporary sorting in details mode (i.e.
+	when items need to be rearranged). */
+	int iRelativeSort;
+
+	// The text color applied to the item by the color rules. This is determined the first time the
+	// item is drawn and is reset whenever the color rules change. Since updating an item replaces
+	// this structure, the color will also be recalculated when the item changes.
+	bool textColorCalculated = false;
+	std::optional<COLORREF> textColor;
+
+	ItemInfo_t() : wfd({}), isFindDataValid(false), bDrive(FALSE)
+	{
+	}
+};
@@ -0,0 +1,31 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "../Helper/Pidl.h"
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+struct ItemInfo_t;
+
+// Contains values that are the same for every item in a folder. These values are retrieved once
+// per folder, rather than once for each item.
+struct ItemInfoContext
+{
+	// The display names for items in the recycle bin are retrieved differently.
+	bool isRecycleBin = false;
+};
+
+ItemInfoContext GetItemInfoContext(PCIDLIST_ABSOLUTE pidlDirectory);
+
+std::optional<ItemInfo_t> GetItemInformation(IShellFolder *shellFolder,
+	PCIDLIST_ABSOLUTE pidlDirectory, PCITEMID_CHILD pidlChild, const ItemInfoContext &context);
+
+// Retrieves the information for each of the specified items, skipping any items for which the
+// information can't be retrieved. This can be called from any thread.
+std::vector<ItemInfo_t> GetItemInformationForItems(PCIDLIST_ABSOLUTE pidlDirectory,
+	std::span<const PidlChild> items, const ItemInfoContext &context, std::stop_token stopToken);
@@ -11,7 +11,7 @@
 #include "ColumnHelper.h"
 #include "Config.h"
 #include "FolderView.h"
-#include "IconFetcher.h"
+#include "IconFetcherImpl.h"
 #include "ItemData.h"
 #include "LabelEditHandler.h"
 #include "MainResource.h"
@@ -25,6 +25,7 @@
 #include "ShellBrowserContextMenuDelegate.h"
 #include "ShellNavigationController.h"
 #include "ShellView.h"
+#include "TaskScheduler.h"
 #include "../Helper/CachedIcons.h"
 #include "../Helper/DragDropHelper.h"
 #include "../Helper/FileActionHandler.h"
@@ -38,7 +39,10 @@
 #include <boost/range/iterator_range.hpp>
 #include <glog/logging.h>
 #include <wil/common.h>
+#include <algorithm>
 #include <format>
+#include <iterator>
+#include <ranges>
 
 const std::vector<ColumnType> COMMON_REAL_FOLDER_COLUMNS = { ColumnType::Name, ColumnType::Type,
 	ColumnType::Size, ColumnType::DateModified, ColumnType::Authors, ColumnType::Title };
@@ -150,7 +154,7 @@ LRESULT ShellBrowserImpl::ListViewProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPAR
 		break;
 
 	case WM_APP_COLUMN_RESULT_READY:
-		ProcessColumnResult(static_cast<int>(wParam));
+		ProcessColumnResults();
 		break;
 
 	case WM_APP_THUMBNAIL_RESULT_READY:
@@ -160,6 +164,21 @@ LRESULT ShellBrowserImpl::ListViewProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPAR
 	case WM_APP_INFO_TIP_READY:
 		ProcessInfoTipResult(static_cast<int>(wParam));
 		break;
+
+	case WM_APP_GROUP_RESULTS_READY:
+		ProcessGroupResults();
+		break;
+
+	// Sorting changes the row of each item. Since there's no notification sent when the listview is
+	// sorted, the messages are intercepted here instead, which means that every sort operation will
+	// be handled, regardless of where it's initiated.
+	case LVM_SORTITEMS:
+	case LVM_SORTITEMSEX:
+	{
+		LRESULT res = DefSubclassProc(hwnd, uMsg, wParam, lParam);
+		InvalidateItemRowMap();
+		return res;
+	}
 	}
 
 	return DefSubclassProc(hwnd, uMsg, wParam, lParam);
@@ -204,6 +223,10 @@ LRESULT ShellBrowserImpl::ListViewParentProc(HWND hwnd, UINT uMsg, WPARAM wParam
 				OnListViewItemInserted(reinterpret_cast<NMLISTVIEW *>(lParam));
 				break;
 
+			case LVN_DELETEITEM:
+				OnListViewItemDeleted(reinterpret_cast<NMLISTVIEW *>(lParam));
+				break;
+
 			case LVN_ITEMCHANGED:
 				OnListViewItemChanged(reinterpret_cast<NMLISTVIEW *>(lParam));
 				break;
@@ -222,7 +245,13 @@ LRESULT ShellBrowserImpl::ListViewParentProc(HWND hwnd, UINT uMsg, WPARAM wParam
 			case LVN_ENDLABELEDIT:
 				return OnListViewEndLabelEdit(reinterpret_cast<NMLVDISPINFO *>(lParam));
 
+			case LVN_ENDSCROLL:
+				PrioritizeVisibleItemTasks();
+				break;
+
 			case LVN_DELETEALLITEMS:
+				OnListViewAllItemsDeleted();
+
 				// Respond to the notification in order to speed up calls to ListView_DeleteAllItems
 				// per http://www.verycomputer.com/5_0c959e6a4fd713e2_1.htm
 				return TRUE;
@@ -563,21 +592,23 @@ void ShellBrowserImpl::OnListViewGetDisplayInfo(LPARAM lParam)
 	if (IsThumbnailsViewMode(m_folderSettings.viewMode)
 		&& (plvItem->mask & LVIF_IMAGE) == LVIF_IMAGE)
 	{
-		const ItemInfo_t &itemInfo = m_itemInfoMap.at(internalIndex);
-		auto cachedThumbnailIndex = GetCachedThumbnailIndex(itemInfo);
+		// Only the in-memory cache is checked here. Checking the system thumbnail cache can block
+		// (e.g. if the cache database is in use), so that's left to the thumbnail task.
+		HBITMAP cachedThumbnail = m_directoryState.thumbnailBitmapCache->MaybeGetThumbnail(
+			internalIndex, m_thumbnailItemWidth);
 
-		if (cachedThumbnailIndex)
-		{
-			plvItem->iImage = *cachedThumbnailIndex;
-		}
-		else
+		plvItem->mask |= LVIF_DI_SETITEM;
+
+		if (cachedThumbnail)
 		{
-			plvItem->iImage = GetIconThumbnail(internalIndex);
+			plvItem->iImage = GetExtractedThumbnail(internalIndex, cachedThumbnail);
+			return;
 		}
 
-		plvItem->mask |= LVIF_DI_SETITEM;
+		plvItem->iImage = GetIconThumbnail(internalIndex);
 
 		QueueThumbnailTask(internalIndex);
+		ScheduleVisibleItemTaskPrioritization();
 
 		return;
 	}
@@ -587,7 +618,17 @@ void ShellBrowserImpl::OnListViewGetDisplayInfo(LPARAM lParam)
 		auto columnType = GetColumnTypeByIndex(plvItem->iSubItem);
 		CHECK(columnType);
 
-		QueueColumnTask(internalIndex, *columnType);
+		auto cachedText = m_columnTextCache.MaybeGetText(internalIndex, *columnType);
+
+		if (cachedText)
+		{
+			StringCchCopy(plvItem->pszText, plvItem->cchTextMax, cachedText->c_str());
+		}
+		else
+		{
+			QueueColumnTask(internalIndex, *columnType);
+			ScheduleVisibleItemTaskPrioritization();
+		}
 	}
 
 	if ((plvItem->mask & LVIF_IMAGE) == LVIF_IMAGE)
@@ -614,9 +655,10 @@ void ShellBrowserImpl::OnListViewGetDisplayInfo(LPARAM lParam)
 			}
 		}
 
-		m_iconFetcher->QueueIconTask(itemInfo.pidlComplete.Raw(),
+		m_iconFetcher->QueueIconTask(itemInfo.pidlComplete.Raw(), internalIndex,
 			[this, internalIndex](int iconIndex, int overlayIndex)
 			{ ProcessIconResult(internalIndex, iconIndex, overlayIndex); });
+		ScheduleVisibleItemTaskPrioritization();
 	}
 
 	plvItem->mask |= LVIF_DI_SETITEM;
@@ -641,6 +683,242 @@ void ShellBrowserImpl::ProcessIconResult(int internalIndex, int iconIndex, int o
 	ListView_SetItem(m_listView, &lvItem);
 }
 
+// Column text, icons and thumbnails are requested as items are displayed. When the user scrolls
+// quickly through a large folder, that means a lot of tasks can be queued for items that are no
+// longer visible. The items that are currently visible would then have to wait for all those tasks
+// to finish. Therefore, whenever new tasks are queued, or the listview is scrolled, the tasks for
+// the visible items are moved to the front of each queue.
+void ShellBrowserImpl::ScheduleVisibleItemTaskPrioritization()
+{
+	if (m_directoryState.visibleItemTaskPrioritizationScheduled)
+	{
+		return;
+	}
+
+	PrioritizeVisibleItemTasksAfterUpdate(m_weakPtrFactory.GetWeakPtr(), m_app->GetRuntime());
+	m_directoryState.visibleItemTaskPrioritizationScheduled = true;
+}
+
+concurrencpp::null_result ShellBrowserImpl::PrioritizeVisibleItemTasksAfterUpdate(
+	WeakPtr<ShellBrowserImpl> weakSelf, Runtime *runtime)
+{
+	// Display information is requested for each visible item in turn (e.g. when the listview is
+	// painted). Resuming on the UI thread here means the tasks will only be prioritized once all
+	// of those requests have been processed.
+	co_await concurrencpp::resume_on(runtime->GetUiThreadExecutor());
+
+	if (!weakSelf)
+	{
+		co_return;
+	}
+
+	weakSelf->m_directoryState.visibleItemTaskPrioritizationScheduled = false;
+	weakSelf->PrioritizeVisibleItemTasks();
+}
+
+void ShellBrowserImpl::PrioritizeVisibleItemTasks()
+{
+	auto visibleItems = GetVisibleItemInternalIndexes();
+
+	if (visibleItems.empty())
+	{
+		return;
+	}
+
+	m_columnTaskQueue->Prioritize(visibleItems);
+	m_iconFetcher->PrioritizeTasks(visibleItems);
+	m_thumbnailTaskQueue->Prioritize(visibleItems);
+	m_groupTaskQueue->Prioritize(visibleItems);
+
+	UpdateThumbnailSlotUsage(visibleItems);
+}
+
+std::unordered_set<int> ShellBrowserImpl::GetVisibleItemInternalIndexes() const
+{
+	int numItems = ListView_GetItemCount(m_listView);
+
+	if (numItems == 0)
+	{
+		return {};
+	}
+
+	std::unordered_set<int> visibleItems;
+
+	// In the details and list views, items are always displayed in index order (unless they're
+	// grouped), so the visible items form a contiguous range starting at the top index.
+	if ((m_folderSettings.viewMode == +ViewMode::Details
+			|| m_folderSettings.viewMode == +ViewMode::List)
+		&& !ListView_IsGroupViewEnabled(m_listView))
+	{
+		int firstVisibleItem = ListView_GetTopIndex(m_listView);
+
+		// The count here only includes items that are fully visible, so the last item is treated
+		// as being partially visible.
+		int lastVisibleItem =
+			std::min(firstVisibleItem + ListView_GetCountPerPage(m_listView), numItems - 1);
+
+		for (int i = firstVisibleItem; i <= lastVisibleItem; i++)
+		{
+			visibleItems.insert(GetItemInternalIndex(i));
+		}
+
+		return visibleItems;
+	}
+
+	RECT clientRect;
+	GetClientRect(m_listView, &clientRect);
+
+	if (m_folderSettings.autoArrangeEnabled && !ListView_IsGroupViewEnabled(m_listView))
+	{
+		return GetVisibleArrangedItems(numItems, clientRect);
+	}
+
+	return GetVisibleItemsFromSnapshot(numItems, clientRect);
+}
+
+// When items are arranged automatically (and aren't grouped), they're laid out in rows, in index
+// order. The top of each item therefore never decreases with its index, which means the visible
+// range can be found with a binary search, rather than by checking every item.
+std::unordered_set<int> ShellBrowserImpl::GetVisibleArrangedItems(int numItems,
+	const RECT &clientRect) const
+{
+	auto itemIndexes = std::views::iota(0, numItems);
+
+	// This is the first item in the first row that starts within the client area. The row above
+	// may still be partially visible, so it's included as well.
+	auto firstItr = std::ranges::partition_point(itemIndexes,
+		[this, &clientRect](int index) { return GetItemBounds(index).top < clientRect.top; });
+
+	if (firstItr != itemIndexes.begin())
+	{
+		int previousRowTop = GetItemBounds(*std::ranges::prev(firstItr)).top;
+		firstItr = std::ranges::partition_point(itemIndexes.begin(), firstItr,
+			[this, previousRowTop](int index)
+			{ return GetItemBounds(index).top < previousRowTop; });
+	}
+
+	auto endItr = std::ranges::partition_point(firstItr, itemIndexes.end(),
+		[this, &clientRect](int index) { return GetItemBounds(index).top < clientRect.bottom; });
+
+	std::unordered_set<int> visibleItems;
+
+	for (int index : std::ranges::subrange(firstItr, endItr))
+	{
+		visibleItems.insert(GetItemInternalIndex(index));
+	}
+
+	return visibleItems;
+}
+
+std::unordered_set<int> ShellBrowserImpl::GetVisibleItemsFromSnapshot(int numItems,
+	const RECT &clientRect) const
+{
+	POINT scrollPosition = { GetScrollPos(m_listView, SB_HORZ), GetScrollPos(m_listView, SB_VERT) };
+	auto now = std::chrono::steady_clock::now();
+	const auto &snapshot = m_directoryState.visibleItemsSnapshot;
+
+	if (snapshot && snapshot->scrollPosition.x == scrollPosition.x
+		&& snapshot->scrollPosition.y == scrollPosition.y
+		&& EqualRect(&snapshot->clientRect, &clientRect) && snapshot->numItems == numItems
+		&& (now - snapshot->creationTime) < VISIBLE_ITEMS_SNAPSHOT_LIFETIME)
+	{
+		return snapshot->items;
+	}
+
+	auto visibleItems = ListView_IsGroupViewEnabled(m_listView)
+		? GetVisibleGroupedItems(clientRect)
+		: GetVisibleFreelyPositionedItems(numItems, clientRect);
+
+	m_directoryState.visibleItemsSnapshot =
+		VisibleItemsSnapshot{ scrollPosition, clientRect, numItems, now, visibleItems };
+
+	return visibleItems;
+}
+
+std::unordered_set<int> ShellBrowserImpl::GetVisibleGroupedItems(const RECT &clientRect) const
+{
+	std::unordered_set<int> visibleItems;
+	int numGroups = static_cast<int>(ListView_GetGroupCount(m_listView));
+
+	for (int groupIndex = 0; groupIndex < numGroups; groupIndex++)
+	{
+		LVGROUP group = {};
+		group.cbSize = sizeof(group);
+		group.mask = LVGF_GROUPID;
+
+		if (!ListView_GetGroupInfoByIndex(m_listView, groupIndex, &group))
+		{
+			continue;
+		}
+
+		RECT groupRect;
+		RECT intersection;
+
+		// Only the items within the groups that are visible need to be checked.
+		if (!ListView_GetGroupRect(m_listView, group.iGroupId, LVGGR_GROUP, &groupRect)
+			|| !IntersectRect(&intersection, &groupRect, &clientRect))
+		{
+			continue;
+		}
+
+		// Items are sorted by index, so within a group, they're displayed in index order. Once an
+		// item below the client area is reached, none of the remaining items in the group will be
+		// visible.
+		LVITEMINDEX itemIndex = { -1, groupIndex };
+
+		while (ListView_GetNextItemIndex(m_listView, &itemIndex, LVNI_SAMEGROUPONLY))
+		{
+			RECT itemRect;
+
+			if (!ListView_GetItemIndexRect(m_listView, &itemIndex, 0, LVIR_BOUNDS, &itemRect))
+			{
+				continue;
+			}
+
+			if (itemRect.top >= clientRect.bottom)
+			{
+				break;
+			}
+
+			if (itemRect.bottom > clientRect.top)
+			{
+				visibleItems.insert(GetItemInternalIndex(itemIndex.iItem));
+			}
+		}
+	}
+
+	return visibleItems;
+}
+
+// When items have been freely positioned, there's no relationship between the index of an item and
+// its position, so each item needs to be checked.
+std::unordered_set<int> ShellBrowserImpl::GetVisibleFreelyPositionedItems(int numItems,
+	const RECT &clientRect) const
+{
+	std::unordered_set<int> visibleItems;
+
+	for (int i = 0; i < numItems; i++)
+	{
+		RECT itemRect;
+		RECT intersection;
+
+		if (ListView_GetItemRect(m_listView, i, &itemRect, LVIR_BOUNDS)
+			&& IntersectRect(&intersection, &itemRect, &clientRect))
+		{
+			visibleItems.insert(GetItemInternalIndex(i));
+		}
+	}
+
+	return visibleItems;
+}
+
+RECT ShellBrowserImpl::GetItemBounds(int index) const
+{
+	RECT itemRect = {};
+	ListView_GetItemRect(m_listView, index, &itemRect, LVIR_BOUNDS);
+	return itemRect;
+}
+
 LRESULT ShellBrowserImpl::OnListViewGetInfoTip(NMLVGETINFOTIP *getInfoTip)
 {
 	if (m_config->showInfoTips)
@@ -672,12 +950,10 @@ void ShellBrowserImpl::QueueInfoTipTask(int internalIndex, const std::wstring &e
 	Config configCopy = *m_config;
 	bool virtualFolder = InVirtualFolder();
 
-	auto result = m_infoTipsThreadPool.push(
+	auto result = m_infoTipTaskQueue->Push(
 		[this, infoTipResultId, internalIndex, basicItemInfo, configCopy, virtualFolder,
-			existingInfoTip](int id)
+			existingInfoTip]
 		{
-			UNREFERENCED_PARAMETER(id);
-
 			auto result = GetInfoTipAsync(m_listView, infoTipResultId, internalIndex, basicItemInfo,
 				configCopy, m_resourceInstance, virtualFolder);
 
@@ -721,9 +997,9 @@ std::optional<ShellBrowserImpl::InfoTipResult> ShellBrowserImpl::GetInfoTipAsync
 		auto dateModified = ResourceHelper::LoadString(resourceInstance, IDS_GENERAL_DATEMODIFIED);
 
 		TCHAR fileModificationText[256];
-		BOOL fileTimeResult =
-			CreateFileTimeString(&basicItemInfo.wfd.ftLastWriteTime, fileModificationText,
-				std::size(fileModificationText), config.globalFolderSettings.showFriendlyDates);
+		BOOL fileTimeResult = CreateFileTimeString(&basicItemInfo.wfd.ftLastWriteTime,
+			fileModificationText, std::size(fileModificationText),
+			config.globalFolderSettings.showFriendlyDates.get());
 
 		if (!fileTimeResult)
 		{
@@ -780,6 +1056,22 @@ void ShellBrowserImpl::ProcessInfoTipResult(int infoTipResultId)
 
 void ShellBrowserImpl::OnListViewItemInserted(const NMLISTVIEW *itemData)
 {
+	if (m_directoryState.itemRowMapValid)
+	{
+		// When navigating to a folder, each item is appended to the end of the listview. In that
+		// case, the existing rows remain valid and the map can be updated directly. Inserting an
+		// item anywhere else shifts the items that follow it.
+		if (itemData->iItem == ListView_GetItemCount(m_listView) - 1)
+		{
+			m_directoryState.itemRowMap.insert_or_assign(GetItemInternalIndex(itemData->iItem),
+				itemData->iItem);
+		}
+		else
+		{
+			InvalidateItemRowMap();
+		}
+	}
+
 	if (m_folderSettings.showInGroups)
 	{
 		auto groupId = GetItemGroupId(itemData->iItem);
@@ -791,6 +1083,31 @@ void ShellBrowserImpl::OnListViewItemInserted(const NMLISTVIEW *itemData)
 	}
 }
 
+void ShellBrowserImpl::OnListViewItemDeleted(const NMLISTVIEW *itemData)
+{
+	if (!m_directoryState.itemRowMapValid)
+	{
+		return;
+	}
+
+	// Note that the item is still in the listview at this point.
+	int internalIndex = GetItemInternalIndex(itemData->iItem);
+	m_directoryState.itemRowMap.erase(internalIndex);
+
+	// Removing the last item doesn't affect the row of any other item. Removing any other item will
+	// shift all items that follow it.
+	if (itemData->iItem != ListView_GetItemCount(m_listView) - 1)
+	{
+		InvalidateItemRowMap();
+	}
+}
+
+void ShellBrowserImpl::OnListViewAllItemsDeleted()
+{
+	m_directoryState.itemRowMap.clear();
+	m_directoryState.itemRowMapValid = true;
+}
+
 void ShellBrowserImpl::OnListViewItemChanged(const NMLISTVIEW *changeData)
 {
 	if (changeData->uChanged != LVIF_STATE)
@@ -942,6 +1259,7 @@ void ShellBrowserImpl::OnListViewKeyDown(const NMLVKEYDOWN *lvKeyDown)
 
 	case VK_ESCAPE:
 		m_navigationManager.StopLoading();
+		StopEnumeratingRemainingNavigationItems();
 		break;
 	}
 }
@@ -963,13 +1281,13 @@ std::optional<int> ShellBrowserImpl::MaybeGetItemIndex(PCIDLIST_ABSOLUTE pidlIte
 	return std::nullopt;
 }
 
-const ShellBrowserImpl::ItemInfo_t &ShellBrowserImpl::GetItemByIndex(int index) const
+const ItemInfo_t &ShellBrowserImpl::GetItemByIndex(int index) const
 {
 	int internalIndex = GetItemInternalIndex(index);
 	return m_itemInfoMap.at(internalIndex);
 }
 
-ShellBrowserImpl::ItemInfo_t &ShellBrowserImpl::GetItemByIndex(int index)
+ItemInfo_t &ShellBrowserImpl::GetItemByIndex(int index)
 {
 	int internalIndex = GetItemInternalIndex(index);
 	return m_itemInfoMap.at(internalIndex);
@@ -1545,47 +1863,13 @@ LRESULT ShellBrowserImpl::OnListViewCustomDraw(NMLVCUSTOMDRAW *listViewCustomDra
 
 	case CDDS_ITEMPREPAINT:
 	{
-		const auto &itemInfo =
-			GetItemByIndex(static_cast<int>(listViewCustomDraw->nmcd.dwItemSpec));
+		auto &itemInfo = GetItemByIndex(static_cast<int>(listViewCustomDraw->nmcd.dwItemSpec));
+		auto textColor = GetItemTextColor(itemInfo);
 
-		for (const auto &colorRule : m_app->GetColorRuleModel()->GetItems())
+		if (textColor)
 		{
-			bool matchedFileName = false;
-			bool matchedAttributes = false;
-
-			if (!colorRule->GetFilterPattern().empty())
-			{
-				if (CheckWildcardMatch(colorRule->GetFilterPattern().c_str(),
-						itemInfo.displayName.c_str(), !colorRule->GetFilterPatternCaseInsensitive())
-					== 1)
-				{
-					matchedFileName = true;
-				}
-			}
-			else
-			{
-				matchedFileName = true;
-			}
-
-			if (colorRule->GetFilterAttributes() != 0)
-			{
-				if (itemInfo.isFindDataValid
-					&& WI_IsAnyFlagSet(itemInfo.wfd.dwFileAttributes,
-						colorRule->GetFilterAttributes()))
-				{
-					matchedAttributes = true;
-				}
-			}
-			else
-			{
-				matchedAttributes = true;
-			}
-
-			if (matchedFileName && matchedAttributes)
-			{
-				listViewCustomDraw->clrText = colorRule->GetColor();
-				return CDRF_NEWFONT;
-			}
+			listViewCustomDraw->clrText = *textColor;
+			return CDRF_NEWFONT;
 		}
 	}
 	break;
@@ -1594,8 +1878,40 @@ LRESULT ShellBrowserImpl::OnListViewCustomDraw(NMLVCUSTOMDRAW *listViewCustomDra
 	return CDRF_DODEFAULT;
 }
 
+std::optional<COLORREF> ShellBrowserImpl::GetItemTextColor(ItemInfo_t &itemInfo)
+{
+	if (itemInfo.textColorCalculated)
+	{
+		return itemInfo.textColor;
+	}
+
+	if (!m_colorRuleMatcher)
+	{
+		m_colorRuleMatcher.emplace(m_app->GetColorRuleModel());
+	}
+
+	std::optional<DWORD> attributes;
+
+	if (itemInfo.isFindDataValid)
+	{
+		attributes = itemInfo.wfd.dwFileAttributes;
+	}
+
+	itemInfo.textColor = m_colorRuleMatcher->GetColor(itemInfo.displayName, attributes);
+	itemInfo.textColorCalculated = true;
+
+	return itemInfo.textColor;
+}
+
 void ShellBrowserImpl::OnColorRulesUpdated()
 {
+	m_colorRuleMatcher.reset();
+
+	for (auto &[internalIndex, itemInfo] : m_itemInfoMap)
+	{
+		itemInfo.textColorCalculated = false;
+	}
+
 	// Any changes to the color rules will require the listview to be redrawn.
 	InvalidateRect(m_listView, nullptr, false);
 }
@@ -73,7 +73,8 @@ public:
 		SlotGroup slotGroup = SlotGroup::Default);
 
 	// Triggered when the enumeration for a directory successfully finishes. At this point, the
-	// requested folder has become the current folder and the enumerated items have been displayed.
+	// requested folder has become the current folder and the first set of enumerated items has been
+	// displayed. In a large folder, the rest of the items will be added as they're enumerated.
 	//
 	// This can also be triggered if the initial navigation fails. Typically, if a navigation fails,
 	// no folder change will occur. Instead, the original folder will continue to be shown. However,
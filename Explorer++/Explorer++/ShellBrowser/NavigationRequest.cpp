@@ -5,11 +5,17 @@
 #include "stdafx.h"
 #include "NavigationRequest.h"
 #include "FolderSettings.h"
+#include "ItemInformation.h"
 #include "NavigationEvents.h"
 #include "NavigationRequestDelegate.h"
+#include "RemainingNavigationItems.h"
 #include "ShellBrowser.h"
 #include "ShellEnumerator.h"
 #include "../Helper/ShellHelper.h"
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <utility>
 
 NavigationRequest::NavigationRequest(const ShellBrowser *shellBrowser,
 	NavigationEvents *navigationEvents, NavigationRequestDelegate *delegate,
@@ -24,7 +30,8 @@ NavigationRequest::NavigationRequest(const ShellBrowser *shellBrowser,
 	m_enumerationExecutor(enumerationExecutor),
 	m_originalExecutor(originalExecutor),
 	m_navigateParams(navigateParams),
-	m_stopToken(stopToken)
+	m_stopToken(stopToken),
+	m_remainingItems(std::make_shared<RemainingNavigationItems>())
 {
 }
 
@@ -32,6 +39,9 @@ void NavigationRequest::Start()
 {
 	SetState(State::Started);
 
+	m_stopCallback.emplace(m_stopToken,
+		[remainingItems = m_remainingItems] { remainingItems->Stop(); });
+
 	StartInternal(m_weakPtrFactory.GetWeakPtr());
 }
 
@@ -50,6 +60,8 @@ void NavigationRequest::Fail()
 {
 	SetState(State::Failed);
 
+	m_remainingItems->Stop();
+
 	m_navigationEvents->NotifyFailed(this);
 
 	m_delegate->OnFinished(this);
@@ -59,6 +71,8 @@ void NavigationRequest::Cancel()
 {
 	SetState(State::Cancelled);
 
+	m_remainingItems->Stop();
+
 	m_navigationEvents->NotifyCancelled(this);
 
 	m_delegate->OnFinished(this);
@@ -79,11 +93,16 @@ const ShellBrowser *NavigationRequest::GetShellBrowser() const
 	return m_shellBrowser;
 }
 
-const std::vector<PidlChild> &NavigationRequest::GetItems() const
+const std::vector<ItemInfo_t> &NavigationRequest::GetItems() const
 {
 	return m_items;
 }
 
+std::shared_ptr<RemainingNavigationItems> NavigationRequest::GetRemainingItems() const
+{
+	return m_remainingItems;
+}
+
 bool NavigationRequest::Stopped() const
 {
 	return m_stopToken.stop_requested();
@@ -102,7 +121,8 @@ concurrencpp::null_result NavigationRequest::StartInternal(WeakPtr<NavigationReq
 	auto *shellBrowser = weakSelf->m_shellBrowser;
 	auto showHidden = shellBrowser ? shellBrowser->GetFolderSettings().showHidden : true;
 
-	auto stopToken = weakSelf->m_stopToken;
+	auto remainingItems = weakSelf->m_remainingItems;
+	auto stopToken = remainingItems->GetStopToken();
 
 	weakSelf->m_navigationEvents->NotifyStarted(weakSelf.Get());
 
@@ -129,37 +149,165 @@ concurrencpp::null_result NavigationRequest::StartInternal(WeakPtr<NavigationReq
 		navigateParams.pidl = targetPidl.get();
 	}
 
-	std::vector<PidlChild> items;
-	hr = shellEnumerator->EnumerateDirectory(navigateParams.pidl.Raw(),
+	auto context = GetItemInfoContext(navigateParams.pidl.Raw());
+	std::vector<PidlChild> pendingItems;
+	std::vector<concurrencpp::result<void>> chunkResults;
+
+	// In a large folder, the information for each chunk of items is retrieved in a separate task,
+	// while the enumeration continues. The first chunk finishes the enumeration for this
+	// navigation, which allows the navigation to be committed and the first set of items to be
+	// shown straight away. The chunks after that are passed on as they become available.
+	auto submitChunk = [&]()
+	{
+		bool initialChunk = chunkResults.empty();
+
+		chunkResults.push_back(enumerationExecutor->submit(
+			[weakSelf, navigateParams, items = std::exchange(pendingItems, {}), &context,
+				initialChunk, remainingItems, originalExecutor, stopToken]() mutable
+			{
+				auto itemInfos = GetItemInformationForItems(navigateParams.pidl.Raw(), items,
+					context, stopToken);
+
+				if (initialChunk)
+				{
+					originalExecutor->post(
+						[weakSelf, navigateParams, itemInfos = std::move(itemInfos),
+							remainingItems, stopToken]() mutable
+						{
+							if (!weakSelf)
+							{
+								remainingItems->Stop();
+								return;
+							}
+
+							weakSelf->OnEnumerationFinished(navigateParams, std::move(itemInfos),
+								S_OK, stopToken.stop_requested());
+						});
+				}
+				else
+				{
+					originalExecutor->post(
+						[remainingItems, itemInfos = std::move(itemInfos)]() mutable
+						{ remainingItems->AddItems(std::move(itemInfos)); });
+				}
+			}));
+	};
+
+	hr = shellEnumerator->EnumerateDirectoryInBatches(navigateParams.pidl.Raw(),
 		ShellItemFilter::ItemType::FoldersAndFiles,
 		showHidden ? ShellItemFilter::HiddenItemPolicy::Include
 				   : ShellItemFilter::HiddenItemPolicy::Exclude,
-		items, stopToken);
+		[&pendingItems, &submitChunk](std::vector<PidlChild> items)
+		{
+			std::ranges::move(items, std::back_inserter(pendingItems));
+
+			if (pendingItems.size() >= ITEMS_CHUNK_SIZE)
+			{
+				submitChunk();
+			}
+		},
+		stopToken);
+
+	bool initialChunkSubmitted = !chunkResults.empty();
+	std::vector<ItemInfo_t> itemInfos;
+
+	if (initialChunkSubmitted)
+	{
+		// The navigation may already have been committed at this point, so a failure here simply
+		// means that no further items will be shown.
+		if (!pendingItems.empty() && !stopToken.stop_requested())
+		{
+			submitChunk();
+		}
+
+		for (auto &result : chunkResults)
+		{
+			co_await std::move(result);
+		}
+	}
+	else if (SUCCEEDED(hr) && !stopToken.stop_requested())
+	{
+		itemInfos = co_await RetrieveItemInformation(navigateParams.pidl, std::move(pendingItems),
+			enumerationExecutor, stopToken);
+	}
 
 	co_await concurrencpp::resume_on(originalExecutor);
 
-	if (!weakSelf)
+	// Each of the chunks above was posted to this executor before this point was reached, so all
+	// the items have been passed on by now.
+	if (!initialChunkSubmitted && weakSelf)
+	{
+		weakSelf->OnEnumerationFinished(navigateParams, std::move(itemInfos), hr,
+			stopToken.stop_requested());
+	}
+
+	remainingItems->Finish();
+}
+
+concurrencpp::result<std::vector<ItemInfo_t>> NavigationRequest::RetrieveItemInformation(
+	PidlAbsolute directory, std::vector<PidlChild> items,
+	std::shared_ptr<concurrencpp::executor> executor, std::stop_token stopToken)
+{
+	// Retrieving the information for an item involves several calls into the shell, which adds up
+	// in a large folder. The items are therefore split into chunks, which are processed in
+	// parallel. Values that are the same for every item are only retrieved once.
+	auto context = GetItemInfoContext(directory.Raw());
+
+	size_t numChunks = std::max(executor->max_concurrency_level(), 1);
+	size_t chunkSize =
+		std::max((items.size() + numChunks - 1) / numChunks, MIN_ITEM_INFORMATION_CHUNK_SIZE);
+
+	std::vector<concurrencpp::result<std::vector<ItemInfo_t>>> results;
+
+	for (size_t start = 0; start < items.size(); start += chunkSize)
 	{
-		co_return;
+		size_t end = std::min(start + chunkSize, items.size());
+
+		results.push_back(executor->submit(
+			[&directory, &items, &context, stopToken, start, end]
+			{
+				return GetItemInformationForItems(directory.Raw(),
+					std::span(items.begin() + start, items.begin() + end), context, stopToken);
+			}));
 	}
 
-	weakSelf->m_navigateParams = navigateParams;
-	weakSelf->m_items = items;
-	weakSelf->SetState(State::EnumerationFinished);
+	std::vector<ItemInfo_t> itemInfos;
+	itemInfos.reserve(items.size());
+
+	for (auto &result : results)
+	{
+		auto chunkItemInfos = co_await std::move(result);
+		std::move(chunkItemInfos.begin(), chunkItemInfos.end(), std::back_inserter(itemInfos));
+	}
+
+	co_return itemInfos;
+}
+
+void NavigationRequest::OnEnumerationFinished(const NavigateParams &navigateParams,
+	std::vector<ItemInfo_t> items, HRESULT hr, bool stopped)
+{
+	// Stopping the navigation from this point won't stop the enumeration. If the navigation is
+	// committed, the rest of the items will continue to be enumerated. Otherwise, the enumeration
+	// will be stopped when the navigation fails or is cancelled.
+	m_stopCallback.reset();
+
+	m_navigateParams = navigateParams;
+	m_items = std::move(items);
+	SetState(State::EnumerationFinished);
 
-	if (stopToken.stop_requested())
+	if (stopped)
 	{
-		weakSelf->m_delegate->OnEnumerationStopped(weakSelf.Get());
-		co_return;
+		m_delegate->OnEnumerationStopped(this);
+		return;
 	}
 
 	if (FAILED(hr))
 	{
-		weakSelf->m_delegate->OnEnumerationFailed(weakSelf.Get());
-		co_return;
+		m_delegate->OnEnumerationFailed(this);
+		return;
 	}
 
-	weakSelf->m_delegate->OnEnumerationCompleted(weakSelf.Get());
+	m_delegate->OnEnumerationCompleted(this);
 }
 
 void NavigationRequest::SetState(State state)
@@ -4,16 +4,22 @@
 
 #pragma once
 
+#include "ItemData.h"
 #include "NavigateParams.h"
 #include "../Helper/Pidl.h"
 #include "../Helper/WeakPtr.h"
 #include "../Helper/WeakPtrFactory.h"
 #include <boost/core/noncopyable.hpp>
 #include <concurrencpp/concurrencpp.h>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stop_token>
 #include <vector>
 
 class NavigationEvents;
 class NavigationRequestDelegate;
+class RemainingNavigationItems;
 class ShellBrowser;
 class ShellEnumerator;
 
@@ -48,18 +54,33 @@ public:
 	const NavigateParams &GetNavigateParams() const;
 	const ShellBrowser *GetShellBrowser() const;
 
-	// This will return the set of enumerated items, to be used when the navigation is in the
-	// `WillCommit` or `Committed` state.
-	const std::vector<PidlChild> &GetItems() const;
+	// This will return the first set of enumerated items, to be used when the navigation is in the
+	// `WillCommit` or `Committed` state. The enumeration finishes (from the perspective of this
+	// class) once this set of items is available, so that a large folder can be shown without
+	// having to wait for all of its items to be enumerated. Any items enumerated after that point
+	// are passed on through the object returned by `GetRemainingItems`.
+	const std::vector<ItemInfo_t> &GetItems() const;
+	std::shared_ptr<RemainingNavigationItems> GetRemainingItems() const;
 
 	// Indicates whether the enumeration process was stopped early. Note that this is independent of
 	// whether the navigation is ultimately committed or cancelled. That is, it's up to the caller
 	// to decide whether a stopped enumeration should result in a cancellation or not.
 	bool Stopped() const;
 
+	// The number of enumerated items that are passed on at once.
+	static constexpr size_t ITEMS_CHUNK_SIZE = 2000;
+
 private:
+	// Chunks smaller than this aren't worth scheduling separately.
+	static constexpr size_t MIN_ITEM_INFORMATION_CHUNK_SIZE = 256;
+
 	static concurrencpp::null_result StartInternal(WeakPtr<NavigationRequest> weakSelf);
+	static concurrencpp::result<std::vector<ItemInfo_t>> RetrieveItemInformation(
+		PidlAbsolute directory, std::vector<PidlChild> items,
+		std::shared_ptr<concurrencpp::executor> executor, std::stop_token stopToken);
 
+	void OnEnumerationFinished(const NavigateParams &navigateParams, std::vector<ItemInfo_t> items,
+		HRESULT hr, bool stopped);
 	void SetState(State state);
 
 	const ShellBrowser *const m_shellBrowser;
@@ -76,7 +97,13 @@ private:
 	std::stop_token m_stopToken;
 
 	State m_state = State::NotStarted;
-	std::vector<PidlChild> m_items;
+	std::vector<ItemInfo_t> m_items;
+
+	// The enumeration is stopped through this object, since it can outlive the navigation.
+	// Stopping the navigation stops the enumeration, up until the point the first set of items is
+	// available. After that, the enumeration belongs to whoever receives the remaining items.
+	const std::shared_ptr<RemainingNavigationItems> m_remainingItems;
+	std::optional<std::stop_callback<std::function<void()>>> m_stopCallback;
 
 	WeakPtrFactory<NavigationRequest> m_weakPtrFactory{ this };
 };
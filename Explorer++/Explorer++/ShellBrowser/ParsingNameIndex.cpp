@@ -0,0 +1,74 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ParsingNameIndex.h"
+
+void ParsingNameIndex::AddItem(const std::wstring &parsingName, int internalIndex)
+{
+	m_parsingNameToItemMap.emplace(NormalizeParsingName(parsingName), internalIndex);
+}
+
+void ParsingNameIndex::RemoveItem(const std::wstring &parsingName, int internalIndex)
+{
+	auto [begin, end] = m_parsingNameToItemMap.equal_range(NormalizeParsingName(parsingName));
+
+	for (auto itr = begin; itr != end; ++itr)
+	{
+		if (itr->second == internalIndex)
+		{
+			m_parsingNameToItemMap.erase(itr);
+			return;
+		}
+	}
+
+	// Every item that's removed should have been added previously.
+	DCHECK(false);
+}
+
+std::vector<int> ParsingNameIndex::GetItemsForParsingName(const std::wstring &parsingName) const
+{
+	std::vector<int> items;
+	auto [begin, end] = m_parsingNameToItemMap.equal_range(NormalizeParsingName(parsingName));
+
+	for (auto itr = begin; itr != end; ++itr)
+	{
+		items.push_back(itr->second);
+	}
+
+	return items;
+}
+
+size_t ParsingNameIndex::GetSize() const
+{
+	return m_parsingNameToItemMap.size();
+}
+
+void ParsingNameIndex::Clear()
+{
+	m_parsingNameToItemMap.clear();
+}
+
+std::wstring ParsingNameIndex::NormalizeParsingName(const std::wstring &parsingName)
+{
+	if (parsingName.empty())
+	{
+		return parsingName;
+	}
+
+	std::wstring normalizedName(parsingName.size(), '\0');
+	int res = LCMapStringEx(LOCALE_NAME_INVARIANT, LCMAP_UPPERCASE, parsingName.c_str(),
+		static_cast<int>(parsingName.size()), normalizedName.data(),
+		static_cast<int>(normalizedName.size()), nullptr, nullptr, 0);
+
+	if (res == 0)
+	{
+		DCHECK(false);
+		return parsingName;
+	}
+
+	normalizedName.resize(res);
+
+	return normalizedName;
+}
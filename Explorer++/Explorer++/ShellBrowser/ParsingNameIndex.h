@@ -0,0 +1,31 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Maps the parsing name of each item in a folder to the item's internal index. This allows an item
+// to be found from a pidl (e.g. one contained in a change notification) without having to compare
+// the pidl against every item in the folder.
+//
+// Parsing names are compared case-insensitively, since that's how filesystem paths are typically
+// compared. That does mean that a lookup can return multiple items (e.g. within a case-sensitive
+// directory), so it's up to the caller to determine which of the returned items actually matches.
+class ParsingNameIndex
+{
+public:
+	void AddItem(const std::wstring &parsingName, int internalIndex);
+	void RemoveItem(const std::wstring &parsingName, int internalIndex);
+	std::vector<int> GetItemsForParsingName(const std::wstring &parsingName) const;
+	size_t GetSize() const;
+	void Clear();
+
+private:
+	static std::wstring NormalizeParsingName(const std::wstring &parsingName);
+
+	std::unordered_multimap<std::wstring, int> m_parsingNameToItemMap;
+};
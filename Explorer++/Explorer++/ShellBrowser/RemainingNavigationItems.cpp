@@ -0,0 +1,67 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "RemainingNavigationItems.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+void RemainingNavigationItems::SetCallbacks(ItemsCallback itemsCallback,
+	FinishedCallback finishedCallback)
+{
+	m_itemsCallback = itemsCallback;
+	m_finishedCallback = finishedCallback;
+
+	if (!m_queuedItems.empty())
+	{
+		m_itemsCallback(std::exchange(m_queuedItems, {}));
+	}
+
+	if (m_finished)
+	{
+		m_finishedCallback();
+	}
+}
+
+void RemainingNavigationItems::AddItems(std::vector<ItemInfo_t> items)
+{
+	CHECK(!m_finished);
+
+	if (!m_itemsCallback)
+	{
+		// The navigation hasn't been committed yet, so the items are held on to until it is.
+		std::ranges::move(items, std::back_inserter(m_queuedItems));
+		return;
+	}
+
+	m_itemsCallback(std::move(items));
+}
+
+void RemainingNavigationItems::Finish()
+{
+	CHECK(!m_finished);
+
+	m_finished = true;
+
+	if (m_finishedCallback)
+	{
+		m_finishedCallback();
+	}
+}
+
+bool RemainingNavigationItems::IsFinished() const
+{
+	return m_finished;
+}
+
+void RemainingNavigationItems::Stop()
+{
+	m_stopSource.request_stop();
+}
+
+std::stop_token RemainingNavigationItems::GetStopToken() const
+{
+	return m_stopSource.get_token();
+}
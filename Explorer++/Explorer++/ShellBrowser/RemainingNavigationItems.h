@@ -0,0 +1,45 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "ItemData.h"
+#include <boost/core/noncopyable.hpp>
+#include <functional>
+#include <stop_token>
+#include <vector>
+
+// A navigation is committed once the first set of items in the folder has been enumerated. The
+// items that are enumerated after that point are passed on through this class. Other than Stop()
+// and GetStopToken(), the methods here should only be called on the navigation's original
+// executor.
+class RemainingNavigationItems : private boost::noncopyable
+{
+public:
+	using ItemsCallback = std::function<void(std::vector<ItemInfo_t> items)>;
+	using FinishedCallback = std::function<void()>;
+
+	// Any items that have already arrived are passed to `itemsCallback` immediately. If the
+	// enumeration has already finished, `finishedCallback` will then be invoked as well.
+	void SetCallbacks(ItemsCallback itemsCallback, FinishedCallback finishedCallback);
+
+	void AddItems(std::vector<ItemInfo_t> items);
+
+	// Called once all the items have been passed on, whether the enumeration finished or was
+	// stopped early.
+	void Finish();
+	bool IsFinished() const;
+
+	// Stops the enumeration. Items that have already been enumerated may still be passed on, but
+	// no further items will be retrieved. This can be called from any thread.
+	void Stop();
+	std::stop_token GetStopToken() const;
+
+private:
+	ItemsCallback m_itemsCallback;
+	FinishedCallback m_finishedCallback;
+	std::vector<ItemInfo_t> m_queuedItems;
+	bool m_finished = false;
+	std::stop_source m_stopSource;
+};
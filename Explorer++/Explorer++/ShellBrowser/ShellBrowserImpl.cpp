@@ -22,11 +22,16 @@
 #include "MergeFilesDialog.h"
 #include "PreservedShellBrowser.h"
 #include "ResourceLoader.h"
+#include "Runtime.h"
+#include "RuntimeHelper.h"
 #include "ServiceProvider.h"
 #include "ShellEnumeratorImpl.h"
 #include "ShellNavigationController.h"
 #include "SortModes.h"
 #include "SplitFileDialog.h"
+#include "Tab.h"
+#include "TabEvents.h"
+#include "TaskScheduler.h"
 #include "ThemeManager.h"
 #include "ViewModeHelper.h"
 #include "ViewModes.h"
@@ -85,16 +90,18 @@ ShellBrowserImpl::ShellBrowserImpl(HWND owner, App *app, BrowserWindow *browser,
 	m_fontSetter(GetHWND(), app->GetConfig()),
 	m_tooltipFontSetter(reinterpret_cast<HWND>(SendMessage(GetHWND(), LVM_GETTOOLTIPS, 0, 0)),
 		app->GetConfig()),
-	m_columnThreadPool(1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED),
-		CoUninitialize),
+	m_columnTextCache(COLUMN_TEXT_CACHE_MAX_SIZE, COLUMN_TEXT_CACHE_MAX_ENTRIES),
+	m_columnTaskQueue(app->GetRuntime()->GetTaskScheduler()->CreateQueue()),
+	m_completedColumnResults(std::make_shared<CompletedColumnResults>()),
 	m_columnResultIDCounter(0),
 	m_cachedIcons(app->GetCachedIcons()),
-	m_thumbnailThreadPool(1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED),
-		CoUninitialize),
+	m_thumbnailTaskQueue(app->GetRuntime()->GetTaskScheduler()->CreateQueue()),
 	m_thumbnailResultIDCounter(0),
-	m_infoTipsThreadPool(1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED),
-		CoUninitialize),
+	m_infoTipTaskQueue(app->GetRuntime()->GetTaskScheduler()->CreateQueue()),
 	m_infoTipResultIDCounter(0),
+	m_groupTaskQueue(app->GetRuntime()->GetTaskScheduler()->CreateQueue()),
+	m_completedGroupResults(std::make_shared<CompletedGroupResults>()),
+	m_groupResultIDCounter(0),
 	m_resourceInstance(app->GetResourceInstance()),
 	m_acceleratorManager(app->GetAcceleratorManager()),
 	m_config(app->GetConfig()),
@@ -105,7 +112,8 @@ ShellBrowserImpl::ShellBrowserImpl(HWND owner, App *app, BrowserWindow *browser,
 	m_weakPtrFactory(this)
 {
 	InitializeListView();
-	m_iconFetcher = std::make_unique<IconFetcherImpl>(m_listView, m_cachedIcons);
+	m_iconFetcher = std::make_unique<IconFetcherImpl>(m_listView, m_cachedIcons,
+		m_app->GetRuntime()->GetTaskScheduler());
 
 	m_connections.push_back(m_app->GetNavigationEvents()->AddStartedObserver(
 		std::bind_front(&ShellBrowserImpl::OnNavigationStarted, this),
@@ -122,6 +130,10 @@ ShellBrowserImpl::ShellBrowserImpl(HWND owner, App *app, BrowserWindow *browser,
 	m_connections.push_back(m_app->GetClipboardWatcher()->updateSignal.AddObserver(
 		std::bind_front(&ShellBrowserImpl::OnClipboardUpdate, this)));
 
+	m_connections.push_back(m_app->GetTabEvents()->AddSelectedObserver(
+		std::bind_front(&ShellBrowserImpl::OnTabSelected, this),
+		TabEventScope::ForBrowser(*m_browser)));
+
 	m_performingDrag = false;
 	m_nCurrentColumns = 0;
 	m_pActiveColumns = nullptr;
@@ -156,9 +168,30 @@ ShellBrowserImpl::~ShellBrowserImpl()
 
 	DestroyWindow(m_listView);
 
-	m_columnThreadPool.clear_queue();
-	m_thumbnailThreadPool.clear_queue();
-	m_infoTipsThreadPool.clear_queue();
+	// The column task queue will wait for any running tasks to finish when it's destroyed, so any
+	// long-running tasks are stopped here.
+	m_columnTaskStopSource.request_stop();
+
+	// Any items in the current folder that are still being enumerated are no longer needed.
+	StopEnumeratingRemainingNavigationItems();
+
+	m_columnTaskQueue->Clear();
+	m_thumbnailTaskQueue->Clear();
+	m_infoTipTaskQueue->Clear();
+	m_groupTaskQueue->Clear();
+}
+
+void ShellBrowserImpl::OnTabSelected(const Tab &tab)
+{
+	// The results of the background tasks for the selected tab are immediately visible, so those
+	// tasks are run ahead of the tasks for other tabs.
+	auto priority = (tab.GetShellBrowserImpl() == this) ? TaskPriority::High : TaskPriority::Low;
+
+	m_columnTaskQueue->SetPriority(priority);
+	m_thumbnailTaskQueue->SetPriority(priority);
+	m_infoTipTaskQueue->SetPriority(priority);
+	m_groupTaskQueue->SetPriority(priority);
+	m_iconFetcher->SetTaskPriority(priority);
 }
 
 HWND ShellBrowserImpl::CreateListView(HWND parent)
@@ -201,6 +234,8 @@ void ShellBrowserImpl::InitializeListView()
 
 	m_connections.push_back(m_config->globalFolderSettings.showGridlines.addObserver(
 		std::bind_front(&ShellBrowserImpl::OnShowGridlinesUpdated, this)));
+	m_connections.push_back(m_config->globalFolderSettings.showFriendlyDates.addObserver(
+		std::bind_front(&ShellBrowserImpl::OnShowFriendlyDatesUpdated, this)));
 
 	ListViewHelper::ActivateOneClickSelect(m_listView,
 		m_config->globalFolderSettings.oneClickActivate.get(),
@@ -421,8 +456,7 @@ void ShellBrowserImpl::SetViewModeInternal(ViewMode viewMode)
 
 	if (viewMode != +ViewMode::Details)
 	{
-		m_columnThreadPool.clear_queue();
-		m_columnResults.clear();
+		ClearColumnTasks();
 	}
 
 	if (viewMode != +ViewMode::Details && viewMode != +ViewMode::Tiles)
@@ -602,7 +636,11 @@ unique_pidl_absolute ShellBrowserImpl::GetDirectoryIdl() const
 void ShellBrowserImpl::SelectItems(const std::vector<PidlAbsolute> &pidls)
 {
 	ListViewHelper::SelectAllItems(m_listView, false);
+	AddItemsToSelection(pidls);
+}
 
+void ShellBrowserImpl::AddItemsToSelection(const std::vector<PidlAbsolute> &pidls)
+{
 	int smallestIndex = INT_MAX;
 
 	for (auto &pidl : pidls)
@@ -632,19 +670,11 @@ void ShellBrowserImpl::SelectItems(const std::vector<PidlAbsolute> &pidls)
 
 int ShellBrowserImpl::LocateFileItemIndex(const TCHAR *szFileName) const
 {
-	LV_FINDINFO lvFind;
-	int iItem;
-	int iInternalIndex;
-
-	iInternalIndex = LocateFileItemInternalIndex(szFileName);
+	int iInternalIndex = LocateFileItemInternalIndex(szFileName);
 
 	if (iInternalIndex != -1)
 	{
-		lvFind.flags = LVFI_PARAM;
-		lvFind.lParam = iInternalIndex;
-		iItem = ListView_FindItem(m_listView, -1, &lvFind);
-
-		return iItem;
+		return LocateItemByInternalIndex(iInternalIndex).value_or(-1);
 	}
 
 	return -1;
@@ -679,30 +709,73 @@ std::optional<int> ShellBrowserImpl::GetItemIndexForPidl(PCIDLIST_ABSOLUTE pidl)
 
 std::optional<int> ShellBrowserImpl::GetItemInternalIndexForPidl(PCIDLIST_ABSOLUTE pidl) const
 {
-	auto itr = std::find_if(m_itemInfoMap.begin(), m_itemInfoMap.end(), [pidl](const auto &pair)
-		{ return ArePidlsEquivalent(pidl, pair.second.pidlComplete.Raw()); });
+	std::wstring parsingName;
+	HRESULT hr = GetDisplayName(pidl, SHGDN_FORPARSING, parsingName);
 
-	if (itr == m_itemInfoMap.end())
+	// Every item is stored with its parsing name (an item whose parsing name can't be retrieved is
+	// never added) and the index is updated whenever an item is updated or renamed. So, if the
+	// parsing name for the pidl can't be retrieved, or doesn't appear in the index, the pidl
+	// doesn't refer to any item in the folder. That's also the common case when a new item is
+	// added, which is why there's no fallback to comparing the pidl against every item.
+	if (FAILED(hr))
 	{
 		return std::nullopt;
 	}
 
-	return itr->first;
+	// Names in the index are compared case-insensitively, so there may be more than one candidate
+	// here. Comparing the pidls directly is what determines whether an item actually matches,
+	// though there will typically only be a single comparison made.
+	for (int internalIndex : m_parsingNameIndex.GetItemsForParsingName(parsingName))
+	{
+		if (ArePidlsEquivalent(pidl, m_itemInfoMap.at(internalIndex).pidlComplete.Raw()))
+		{
+			return internalIndex;
+		}
+	}
+
+	return std::nullopt;
 }
 
 std::optional<int> ShellBrowserImpl::LocateItemByInternalIndex(int internalIndex) const
 {
-	LVFINDINFO lvfi;
-	lvfi.flags = LVFI_PARAM;
-	lvfi.lParam = internalIndex;
-	int item = ListView_FindItem(m_listView, -1, &lvfi);
+	m_directoryState.numItemRowLookups++;
+
+	if (!m_directoryState.itemRowMapValid)
+	{
+		RebuildItemRowMap();
+	}
+
+	auto itr = m_directoryState.itemRowMap.find(internalIndex);
 
-	if (item == -1)
+	if (itr == m_directoryState.itemRowMap.end())
 	{
 		return std::nullopt;
 	}
 
-	return item;
+	DCHECK_EQ(GetItemInternalIndex(itr->second), internalIndex);
+
+	return itr->second;
+}
+
+void ShellBrowserImpl::RebuildItemRowMap() const
+{
+	m_directoryState.itemRowMap.clear();
+
+	int numItems = ListView_GetItemCount(m_listView);
+	m_directoryState.itemRowMap.reserve(numItems);
+
+	for (int i = 0; i < numItems; i++)
+	{
+		m_directoryState.itemRowMap.insert({ GetItemInternalIndex(i), i });
+	}
+
+	m_directoryState.itemRowMapValid = true;
+	m_directoryState.numItemRowMapRebuilds++;
+}
+
+void ShellBrowserImpl::InvalidateItemRowMap() const
+{
+	m_directoryState.itemRowMapValid = false;
 }
 
 WIN32_FIND_DATA ShellBrowserImpl::GetItemFileFindData(int index) const
@@ -743,48 +816,32 @@ int ShellBrowserImpl::GenerateUniqueItemId()
 	return m_directoryState.itemIDCounter++;
 }
 
-int ShellBrowserImpl::DetermineItemSortedPosition(LPARAM lParam) const
+int ShellBrowserImpl::DetermineItemSortedPosition(int internalIndex) const
 {
-	LVITEM lvItem;
-	BOOL bItem;
-	int res = 1;
-	int nItems = 0;
-	int i = 0;
+	const auto &sortItem = GetCachedSortItem(internalIndex);
+	bool sortFoldersSeparately = ShouldSortFoldersSeparately();
 
-	nItems = ListView_GetItemCount(m_listView);
+	// The items in the listview are sorted, so the position of the item can be found via a binary
+	// search. The item will be inserted before the first item that doesn't sort before it.
+	int low = 0;
+	int high = ListView_GetItemCount(m_listView);
 
-	while (res > 0 && i < nItems)
+	while (low < high)
 	{
-		lvItem.mask = LVIF_PARAM;
-		lvItem.iItem = i;
-		lvItem.iSubItem = 0;
-		bItem = ListView_GetItem(m_listView, &lvItem);
+		int mid = low + (high - low) / 2;
+		const auto &currentSortItem = GetCachedSortItem(GetItemInternalIndex(mid));
 
-		if (bItem)
+		if (CompareSortItems(currentSortItem, sortItem, sortFoldersSeparately) < 0)
 		{
-			res = Sort(static_cast<int>(lParam), static_cast<int>(lvItem.lParam));
+			low = mid + 1;
 		}
 		else
 		{
-			res = 0;
+			high = mid;
 		}
-
-		i++;
-	}
-
-	/* The item will always be inserted BEFORE
-	the item at position i that we specify here.
-	For example, specifying 0, will place the item
-	at 0 (and push 0 to 1), specifying 1 will place
-	the item at 1 (and push 1 to 2).
-	Therefore, to place in the last position, need
-	to place AFTER last item. */
-	if ((i - 1) == nItems - 1 && res > 0)
-	{
-		i++;
 	}
 
-	return i - 1;
+	return low;
 }
 
 int ShellBrowserImpl::GetNumItems() const
@@ -1128,17 +1185,55 @@ void ShellBrowserImpl::PasteHardLinks()
 {
 	auto pastedItems = ClipboardOperations::PasteHardLinks(
 		m_app->GetPlatformContext()->GetClipboardStore(), GetDirectoryPath());
-	OnInternalPaste(pastedItems);
+	SelectItems(GetPastedItemPidls(pastedItems));
 }
 
 void ShellBrowserImpl::PasteSymLinks()
 {
-	auto pastedItems = ClipboardOperations::PasteSymLinks(
-		m_app->GetPlatformContext()->GetClipboardStore(), GetDirectoryPath());
-	OnInternalPaste(pastedItems);
+	// The results can arrive in multiple batches, so each batch is added to the selection, rather
+	// than replacing it.
+	ListViewHelper::SelectAllItems(m_listView, false);
+
+	bool completed = ClipboardOperations::PasteSymLinks(
+		m_app->GetPlatformContext()->GetClipboardStore(), GetDirectoryPath(),
+		[this](const ClipboardOperations::PastedItems &pastedItems)
+		{ AddItemsToSelection(GetPastedItemPidls(pastedItems)); });
+
+	if (completed)
+	{
+		return;
+	}
+
+	PasteSymLinksViaElevatedProcess(m_weakPtrFactory.GetWeakPtr(), GetDirectoryPath(),
+		m_app->GetRuntime());
+}
+
+concurrencpp::null_result ShellBrowserImpl::PasteSymLinksViaElevatedProcess(
+	WeakPtr<ShellBrowserImpl> weakSelf, std::wstring destination, Runtime *runtime)
+{
+	// Waiting for the elevated process can take some time (e.g. if the user has to respond to a
+	// UAC prompt), so that's done in the background. Each batch of results is then posted back to
+	// the UI thread, so that the selection is updated as the results arrive.
+	co_await ResumeOnComStaThread(runtime);
+
+	ClipboardOperations::PasteSymLinksViaElevatedProcess(destination,
+		[weakSelf, runtime](const ClipboardOperations::PastedItems &pastedItems)
+		{
+			runtime->GetUiThreadExecutor()->post(
+				[weakSelf, pastedItems]
+				{
+					if (!weakSelf)
+					{
+						return;
+					}
+
+					weakSelf->AddItemsToSelection(GetPastedItemPidls(pastedItems));
+				});
+		});
 }
 
-void ShellBrowserImpl::OnInternalPaste(const ClipboardOperations::PastedItems &pastedItems)
+std::vector<PidlAbsolute> ShellBrowserImpl::GetPastedItemPidls(
+	const ClipboardOperations::PastedItems &pastedItems)
 {
 	std::vector<PidlAbsolute> pidls;
 
@@ -1153,7 +1248,7 @@ void ShellBrowserImpl::OnInternalPaste(const ClipboardOperations::PastedItems &p
 		}
 	}
 
-	SelectItems(pidls);
+	return pidls;
 }
 
 WeakPtr<ShellBrowserImpl> ShellBrowserImpl::GetWeakPtr()
@@ -1370,7 +1465,8 @@ void ShellBrowserImpl::MergeFiles()
 	}
 
 	auto *mergeFilesDialog = MergeFilesDialog::Create(m_app->GetResourceLoader(), m_owner,
-		m_directoryState.directory, *items, m_config->globalFolderSettings.showFriendlyDates);
+		m_directoryState.directory, *items,
+		m_config->globalFolderSettings.showFriendlyDates.get());
 	mergeFilesDialog->ShowModalDialog();
 }
 
@@ -1459,13 +1555,14 @@ void ShellBrowserImpl::StartWildcardSelection(SelectionType selectionType)
 void ShellBrowserImpl::SelectItemsMatchingPattern(const std::wstring &pattern,
 	SelectionType selectionType)
 {
+	WildcardPattern compiledPattern(pattern, false);
 	int numItems = ListView_GetItemCount(m_listView);
 
 	for (int i = 0; i < numItems; i++)
 	{
 		std::wstring filename = GetItemName(i);
 
-		if (CheckWildcardMatch(pattern.c_str(), filename.c_str(), false))
+		if (compiledPattern.Matches(filename))
 		{
 			ListViewHelper::SelectItem(m_listView, i, selectionType == SelectionType::Select);
 		}
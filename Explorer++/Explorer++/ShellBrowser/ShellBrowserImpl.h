@@ -6,15 +6,24 @@
 
 #include "BrowserCommandTarget.h"
 #include "ClipboardOperations.h"
+#include "ColorRuleMatcher.h"
+#include "ColumnTextCache.h"
 #include "Columns.h"
 #include "DirectoryWatcher.h"
 #include "FolderSettings.h"
+#include "FolderSizeCache.h"
+#include "ItemData.h"
+#include "ItemInformation.h"
 #include "MainFontSetter.h"
 #include "NavigationManager.h"
+#include "ParsingNameIndex.h"
 #include "ScopedBrowserCommandTarget.h"
 #include "ServiceProvider.h"
 #include "ShellBrowser.h"
+#include "SortHelper.h"
 #include "SortModes.h"
+#include "ThumbnailBitmapCache.h"
+#include "ThumbnailSlotAllocator.h"
 #include "ViewModes.h"
 #include "../Helper/ClipboardHelper.h"
 #include "../Helper/FileOperations.h"
@@ -22,8 +31,8 @@
 #include "../Helper/ShellHelper.h"
 #include "../Helper/WeakPtr.h"
 #include "../Helper/WeakPtrFactory.h"
+#include "../Helper/WildcardPattern.h"
 #include "../Helper/WinRTBaseWrapper.h"
-#include "../ThirdParty/CTPL/cpl_stl.h"
 #include <boost/core/noncopyable.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
@@ -33,11 +42,16 @@
 #include <wil/com.h>
 #include <wil/resource.h>
 #include <thumbcache.h>
+#include <chrono>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
+#include <stop_token>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 class AcceleratorManager;
 class App;
@@ -46,12 +60,15 @@ class BrowserWindow;
 class CachedIcons;
 struct Config;
 class FileActionHandler;
-class IconFetcher;
+class IconFetcherImpl;
 class NavigationRequest;
 struct PreservedShellBrowser;
+class RemainingNavigationItems;
 class Runtime;
 class ShellEnumeratorImpl;
 class ShellNavigationController;
+class Tab;
+class TaskQueue;
 class WindowSubclass;
 
 typedef struct
@@ -157,7 +174,6 @@ public:
 	void PasteShortcut();
 	void PasteHardLinks();
 	void PasteSymLinks();
-	void OnInternalPaste(const ClipboardOperations::PastedItems &pastedItems);
 	void StartRenamingItems(const std::vector<PidlAbsolute> &items);
 
 	bool GetShowInGroups() const;
@@ -177,32 +193,6 @@ protected:
 	const NavigationManager *GetNavigationManager() const override;
 
 private:
-	struct ItemInfo_t
-	{
-		PidlAbsolute pidlComplete;
-		PidlChild pridl;
-		WIN32_FIND_DATA wfd;
-		bool isFindDataValid;
-		std::wstring parsingName;
-		std::wstring displayName;
-		std::wstring editingName;
-
-		/* These are only used for drives. They are
-		needed for when a drive is removed from the
-		system, in which case the drive name is needed
-		so that the removed drive can be found. */
-		BOOL bDrive;
-		TCHAR szDrive[4];
-
-		/* Used for temporary sorting in details mode (i.e.
-		when items need to be rearranged). */
-		int iRelativeSort;
-
-		ItemInfo_t() : wfd({}), isFindDataValid(false), bDrive(FALSE)
-		{
-		}
-	};
-
 	struct AwaitingAdd_t
 	{
 		int iItem;
@@ -225,17 +215,73 @@ private:
 
 	struct ColumnResult_t
 	{
+		int columnResultId;
 		int itemInternalIndex;
+		std::vector<std::pair<ColumnType, std::wstring>> columnTexts;
+	};
+
+	// Column results are added to this by background tasks and then processed in batches on the
+	// UI thread.
+	struct CompletedColumnResults
+	{
+		std::mutex mutex;
+		std::vector<ColumnResult_t> results;
+	};
+
+	// Represents column text that has been requested by the listview, but not set yet.
+	struct PendingColumn
+	{
 		ColumnType columnType;
-		std::wstring columnText;
+
+		// The ID of the task that's retrieving the text. This will be empty if the task hasn't been
+		// queued yet.
+		std::optional<int> columnResultId;
 	};
 
 	struct ThumbnailResult_t
 	{
 		int itemInternalIndex;
+		int thumbnailSize;
 		wil::unique_hbitmap bitmap;
 	};
 
+	struct SortItem
+	{
+		int internalIndex;
+		bool isFolder;
+		std::wstring displayName;
+		SortKey key;
+	};
+
+	// The settings that the sort keys are built from.
+	struct SortItemCacheSettings
+	{
+		SortMode sortMode;
+		bool showExtensions;
+		bool hideLinkExtension;
+		bool showFolderSizes;
+		bool showFriendlyDates;
+
+		bool operator==(const SortItemCacheSettings &) const = default;
+	};
+
+	// The visible items in the listview at a particular point in time.
+	struct VisibleItemsSnapshot
+	{
+		POINT scrollPosition;
+		RECT clientRect;
+		int numItems;
+		std::chrono::steady_clock::time_point creationTime;
+		std::unordered_set<int> items;
+	};
+
+	struct QueuedDirectoryChange
+	{
+		DirectoryWatcher::Event event;
+		PidlAbsolute simplePidl1;
+		PidlAbsolute simplePidl2;
+	};
+
 	struct InfoTipResult
 	{
 		int itemInternalIndex;
@@ -258,6 +304,21 @@ private:
 		}
 	};
 
+	struct GroupResult
+	{
+		int groupResultId;
+		int itemInternalIndex;
+		std::optional<GroupInfo> groupInfo;
+	};
+
+	// Group results are added to this by background tasks and then processed in batches on the UI
+	// thread.
+	struct CompletedGroupResults
+	{
+		std::mutex mutex;
+		std::vector<GroupResult> results;
+	};
+
 	struct ListViewGroup
 	{
 	public:
@@ -303,6 +364,7 @@ private:
 		PidlAbsolute pidlDirectory;
 		std::wstring directory;
 		bool virtualFolder = false;
+		ItemInfoContext itemInfoContext;
 		int itemIDCounter = 0;
 
 		/* Stores information on files that have
@@ -310,12 +372,67 @@ private:
 		into the listview. */
 		std::vector<AwaitingAdd_t> awaitingAddList;
 
+		// Items that have been created and need to be inserted into the listview in sorted order.
+		// Change notifications tend to arrive in bursts, so these items are inserted as a batch,
+		// once the notifications that are currently queued have been processed.
+		std::vector<int> pendingSortedItems;
+
+		// Caches the sort key for each item. This allows the sorted position of a new item to be
+		// found via a binary search over the listview, without having to retrieve the key for each
+		// item it's compared against. The cache is only valid for the sort mode and settings it was
+		// built with.
+		mutable std::unordered_map<int, SortItem> sortItemCache;
+		mutable std::optional<SortItemCacheSettings> sortItemCacheSettings;
+
 		// Directory monitoring
 		std::unique_ptr<DirectoryWatcher> directoryWatcher;
 		std::unique_ptr<DirectoryWatcher> rootDirectoryWatcher;
 
+		// Set while the rest of the items in the folder are still being enumerated. An item that's
+		// changed during that time may not have been added yet, so changes to the items in the
+		// folder are queued and only processed once all the items have been added.
+		std::shared_ptr<RemainingNavigationItems> remainingNavigationItems;
+		std::vector<QueuedDirectoryChange> queuedDirectoryChanges;
+
+		// Only created when folder sizes are shown. Folder sizes include everything below a
+		// folder, so this watches the entire tree below the current directory, in order to
+		// invalidate cached sizes.
+		std::unique_ptr<DirectoryWatcher> folderSizeWatcher;
+
+		// Cached folder sizes are only retained while the tree they're in is being watched.
+		std::unique_ptr<FolderSizeCache::WatchedTree> folderSizeWatchedTree;
+
 		std::unordered_set<int> filteredItemsList;
 
+		// Maps the internal index of each item in the listview to the item's current row. Finding
+		// an item via ListView_FindItem() requires a linear scan of the listview, so this map is
+		// used instead. It's updated in place when items are appended or removed from the end of
+		// the listview and lazily rebuilt after any other change that can shift rows (e.g. sorting
+		// or inserting an item in the middle of the listview).
+		mutable std::unordered_map<int, int> itemRowMap;
+		mutable bool itemRowMapValid = true;
+
+		// Used to track how effective the map above is for the current folder.
+		mutable int numItemRowLookups = 0;
+		mutable int numItemRowMapRebuilds = 0;
+
+		// Set when the background tasks for the items that are currently visible are going to be
+		// moved ahead of the tasks for other items.
+		bool visibleItemTaskPrioritizationScheduled = false;
+
+		// Determining the visible items requires checking individual items when the items are
+		// grouped or freely positioned, so the result in those cases is reused for a short time,
+		// provided the listview hasn't been scrolled or resized and no items have been added or
+		// removed.
+		mutable std::optional<VisibleItemsSnapshot> visibleItemsSnapshot;
+
+		// The column text requested for each item. The text for an item is retrieved in a single
+		// task, which is queued once the listview has finished requesting text. The items are
+		// queued in the order in which they were first requested.
+		std::unordered_map<int, std::vector<PendingColumn>> pendingColumns;
+		std::vector<int> itemsWithUnsubmittedColumns;
+		bool columnTaskSubmissionScheduled = false;
+
 		// When an item is pasted or dropped, it will be selected. However, the item may not exist
 		// at the time the call is made to select the file. This field keeps track of items in the
 		// current directory which need to be selected, once added.
@@ -333,15 +450,20 @@ private:
 		uint64_t totalDirSize = 0;
 		uint64_t fileSelectionSize = 0;
 
-		mutable std::unordered_map<int, ULONGLONG> cachedFolderSizes;
-
 		// Thumbnails
 		// The first imagelist will be used to retrieve item icons in thumbnails mode.
 		HIMAGELIST thumbnailsShellImageList = nullptr;
 		wil::unique_himagelist thumbnailsImageList;
+		std::unique_ptr<ThumbnailSlotAllocator> thumbnailSlotAllocator;
+		std::unique_ptr<ThumbnailBitmapCache> thumbnailBitmapCache;
 
 		ListViewGroupSet groups;
 
+		// Maps the internal index of each item whose group is being determined in the background to
+		// the ID of the task that's determining it. The item will be in a provisional group until
+		// the result arrives.
+		std::unordered_map<int, int> pendingGroups;
+
 		// Drag and drop
 		bool isCurrentFolderDragSource = false;
 		std::optional<int> highlightedItemInternalIndex;
@@ -357,6 +479,31 @@ private:
 	static const UINT WM_APP_COLUMN_RESULT_READY = WM_APP + 150;
 	static const UINT WM_APP_THUMBNAIL_RESULT_READY = WM_APP + 151;
 	static const UINT WM_APP_INFO_TIP_READY = WM_APP + 152;
+	static const UINT WM_APP_GROUP_RESULTS_READY = WM_APP + 153;
+
+	// The maximum number of characters of column text that will be cached for a folder.
+	static constexpr size_t COLUMN_TEXT_CACHE_MAX_SIZE = 1024 * 1024;
+
+	// Each entry has a fixed overhead (the list and map nodes, as well as the string itself),
+	// however short its text is, so the number of entries is also limited.
+	static constexpr size_t COLUMN_TEXT_CACHE_MAX_ENTRIES = 64 * 1024;
+
+	// The percentage of the thumbnail memory limit that's used to cache thumbnail bitmaps. The rest
+	// is used by the image list.
+	static constexpr uint64_t THUMBNAIL_BITMAP_CACHE_MEMORY_PERCENTAGE = 25;
+
+	// Each cached thumbnail holds a GDI bitmap, so the number of cached thumbnails is also limited,
+	// regardless of their size, to avoid exhausting the GDI objects available to the process.
+	static constexpr size_t THUMBNAIL_BITMAP_CACHE_MAX_ENTRIES = 500;
+
+	// The minimum number of thumbnails that can be displayed in thumbnails mode at once,
+	// regardless of the configured memory limit.
+	static constexpr int MIN_THUMBNAIL_SLOTS = 100;
+
+	// The amount of time for which the set of visible items can be reused, in cases where
+	// determining that set is expensive.
+	static constexpr std::chrono::milliseconds VISIBLE_ITEMS_SNAPSHOT_LIFETIME =
+		std::chrono::milliseconds(500);
 
 	ShellBrowserImpl(HWND owner, App *app, BrowserWindow *browser,
 		FileActionHandler *fileActionHandler, const FolderSettings &folderSettings,
@@ -368,11 +515,12 @@ private:
 	int GenerateUniqueItemId();
 	void MarkItemAsCut(int item, bool cut);
 	void VerifySortMode();
+	void OnTabSelected(const Tab &tab);
 
 	/* Browsing support. */
 	void OnNavigationStarted(const NavigationRequest *request);
-	static std::optional<ItemInfo_t> GetItemInformation(IShellFolder *shellFolder,
-		PCIDLIST_ABSOLUTE pidlDirectory, PCITEMID_CHILD pidlChild);
+	std::optional<ItemInfo_t> GetItemInformation(IShellFolder *shellFolder,
+		PCIDLIST_ABSOLUTE pidlDirectory, PCITEMID_CHILD pidlChild) const;
 	void ChangeFolders(const PidlAbsolute &directory);
 	void PrepareToChangeFolders();
 	void ClearPendingResults();
@@ -380,17 +528,18 @@ private:
 	void ResetFolderState();
 	void OnNavigationWillCommit(const NavigationRequest *request);
 	void OnNavigationComitted(const NavigationRequest *request);
-	void AddNavigationItems(const NavigationRequest *request,
-		const std::vector<PidlChild> &itemPidls);
-	std::vector<ItemInfo_t> GetItemInformationFromPidls(const NavigationRequest *request,
-		const std::vector<PidlChild> &itemPidls);
+	void AddNavigationItems(const NavigationRequest *request, const std::vector<ItemInfo_t> &items);
+	void ReceiveRemainingNavigationItems(
+		std::shared_ptr<RemainingNavigationItems> remainingNavigationItems);
+	void AddNavigationItemsChunk(std::span<const ItemInfo_t> items);
+	void OnRemainingNavigationItemsFinished();
+	void StopEnumeratingRemainingNavigationItems();
 	void InsertAwaitingItems();
 	BOOL IsFileFiltered(const ItemInfo_t &itemInfo) const;
 	std::optional<int> AddItemInternal(IShellFolder *shellFolder, PCIDLIST_ABSOLUTE pidlDirectory,
 		PCITEMID_CHILD pidlChild, int itemIndex, BOOL setPosition);
 	int AddItemInternal(int itemIndex, const ItemInfo_t &itemInfo, BOOL setPosition);
-	static HRESULT ExtractFindDataUsingPropertyStore(IShellFolder *shellFolder,
-		PCITEMID_CHILD pidlChild, WIN32_FIND_DATA &output);
+	int StoreItem(const ItemInfo_t &itemInfo);
 	void SetViewModeInternal(ViewMode viewMode);
 	void SetFirstColumnTextToCallback();
 	void SetFirstColumnTextToFilename();
@@ -404,8 +553,6 @@ private:
 	LRESULT ListViewProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 	LRESULT ListViewParentProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 
-	static int CALLBACK SortStub(LPARAM lParam1, LPARAM lParam2, LPARAM lParamSort);
-
 	/* Message handlers. */
 	void ColumnClicked(int iClickedColumn);
 
@@ -430,6 +577,8 @@ private:
 		HINSTANCE resourceInstance, bool virtualFolder);
 	void ProcessInfoTipResult(int infoTipResultId);
 	void OnListViewItemInserted(const NMLISTVIEW *itemData);
+	void OnListViewItemDeleted(const NMLISTVIEW *itemData);
+	void OnListViewAllItemsDeleted();
 	void OnListViewItemChanged(const NMLISTVIEW *changeData);
 	void UpdateFileSelectionInfo(int internalIndex, BOOL selected);
 	void OnListViewKeyDown(const NMLVKEYDOWN *lvKeyDown);
@@ -441,9 +590,11 @@ private:
 	BOOL OnListViewEndLabelEdit(const NMLVDISPINFO *dispInfo);
 	LRESULT OnListViewCustomDraw(NMLVCUSTOMDRAW *listViewCustomDraw);
 	void OnColorRulesUpdated();
+	std::optional<COLORREF> GetItemTextColor(ItemInfo_t &itemInfo);
 	void OnFullRowSelectUpdated(BOOL newValue);
 	void OnCheckBoxSelectionUpdated(BOOL newValue);
 	void OnShowGridlinesUpdated(BOOL newValue);
+	void OnShowFriendlyDatesUpdated(bool newValue);
 	void OnOneClickActivateUpdated(BOOL newValue);
 	void OnOneClickActivateHoverTimeUpdated(UINT newValue);
 	void OnListViewHeaderItemChanged(const NMHEADER *changeInfo);
@@ -482,22 +633,37 @@ private:
 
 	/* Sorting. */
 	void SortFolder();
-	int CALLBACK Sort(int InternalIndex1, int InternalIndex2) const;
+	void InvalidateSortItemCacheIfNecessary() const;
+	void CacheSortItems(const std::vector<int> &internalIndexes) const;
+	SortItem BuildSortItem(int internalIndex) const;
+	std::optional<SortKey> MaybeGetSortKeyFromColumnText(int internalIndex) const;
+	const SortItem &GetCachedSortItem(int internalIndex) const;
+	int CompareSortItems(const SortItem &item1, const SortItem &item2,
+		bool sortFoldersSeparately) const;
+	bool ShouldSortFoldersSeparately() const;
 
 	/* Listview column support. */
 	void AddFirstColumn();
 	void SetUpListViewColumns();
 	void DeleteAllColumns();
 	void QueueColumnTask(int itemInternalIndex, ColumnType columnType);
-	static ColumnResult_t GetColumnTextAsync(HWND listView, int columnResultId,
-		ColumnType columnType, int internalIndex, const BasicItemInfo_t &basicItemInfo,
-		const GlobalFolderSettings &globalFolderSettings);
+	static concurrencpp::null_result SubmitColumnTasksAfterUpdate(
+		WeakPtr<ShellBrowserImpl> weakSelf, Runtime *runtime);
+	void SubmitColumnTasks();
+	static void GetColumnTextAsync(HWND listView,
+		std::shared_ptr<CompletedColumnResults> completedResults, int columnResultId,
+		int internalIndex, const std::vector<ColumnType> &columnTypes,
+		const BasicItemInfo_t &basicItemInfo, const GlobalFolderSettings &globalFolderSettings,
+		FolderSizeCache *folderSizeCache, std::stop_token stopToken);
 	void InsertColumn(ColumnType columnType, int columnIndex, int width);
 	void SetActiveColumnSet();
 	void GetColumnInternal(ColumnType columnType, Column_t *pci) const;
 	Column_t GetFirstCheckedColumn();
 	size_t GetColumnIndexFromDisplayIndex(int displayIndex);
-	void ProcessColumnResult(int columnResultId);
+	void ProcessColumnResults();
+	void ProcessColumnResult(const ColumnResult_t &result);
+	void InvalidateColumnText(int itemInternalIndex);
+	void ClearColumnTasks();
 	std::optional<int> GetColumnIndexByType(ColumnType columnType) const;
 	std::optional<ColumnType> GetColumnTypeByIndex(int index) const;
 
@@ -505,6 +671,8 @@ private:
 	void StartDirectoryMonitoring();
 	void ProcessDirectoryChangeNotification(DirectoryWatcher::Event event,
 		const PidlAbsolute &simplePidl1, const PidlAbsolute &simplePidl2);
+	void ProcessFolderSizeChangeNotification(DirectoryWatcher::Event event,
+		const PidlAbsolute &simplePidl1, const PidlAbsolute &simplePidl2);
 	void OnItemAdded(PCIDLIST_ABSOLUTE simplePidl);
 	void AddItem(PCIDLIST_ABSOLUTE pidl);
 	void RemoveItem(int iItemInternal);
@@ -514,7 +682,11 @@ private:
 	void OnItemRenamed(PCIDLIST_ABSOLUTE simplePidlOld, PCIDLIST_ABSOLUTE simplePidlNew);
 	void InvalidateAllColumnsForItem(int itemIndex);
 	void InvalidateIconForItem(int itemIndex);
-	int DetermineItemSortedPosition(LPARAM lParam) const;
+	int DetermineItemSortedPosition(int internalIndex) const;
+	void InsertPendingSortedItems();
+	void InsertItemsInSortedOrder(std::vector<int> internalIndexes);
+	static concurrencpp::null_result InsertPendingSortedItemsAfterUpdate(
+		WeakPtr<ShellBrowserImpl> weakSelf, Runtime *runtime);
 	static concurrencpp::null_result OnCurrentDirectoryRenamed(WeakPtr<ShellBrowserImpl> weakSelf,
 		PidlAbsolute simplePidlUpdated, Runtime *runtime);
 	static concurrencpp::null_result OnDirectoryPropertiesChanged(
@@ -540,6 +712,13 @@ private:
 	int GroupRelativePositionComparison(const ListViewGroup &group1, const ListViewGroup &group2);
 	const ListViewGroup GetListViewGroupById(int groupId);
 	int DetermineItemGroup(int iItemInternal);
+	static bool IsGroupModeSlow(SortMode groupMode);
+	std::optional<GroupInfo> DetermineItemGroupInfo(const BasicItemInfo_t &basicItemInfo,
+		SortMode groupMode, const GlobalFolderSettings &globalFolderSettings) const;
+	int GetOrCreateListViewGroupForResult(const std::optional<GroupInfo> &groupInfo);
+	void QueueGroupTask(int itemInternalIndex);
+	void ProcessGroupResults();
+	void ClearGroupTasks();
 	std::optional<GroupInfo> DetermineItemNameGroup(const BasicItemInfo_t &itemInfo) const;
 	std::optional<GroupInfo> DetermineItemSizeGroup(const BasicItemInfo_t &itemInfo) const;
 	std::optional<GroupInfo> DetermineItemTotalSizeGroup(const BasicItemInfo_t &itemInfo) const;
@@ -575,18 +754,33 @@ private:
 	/* Listview icons. */
 	void ProcessIconResult(int internalIndex, int iconIndex, int overlayIndex);
 
+	/* Background task prioritization. */
+	void ScheduleVisibleItemTaskPrioritization();
+	static concurrencpp::null_result PrioritizeVisibleItemTasksAfterUpdate(
+		WeakPtr<ShellBrowserImpl> weakSelf, Runtime *runtime);
+	void PrioritizeVisibleItemTasks();
+	std::unordered_set<int> GetVisibleItemInternalIndexes() const;
+	std::unordered_set<int> GetVisibleArrangedItems(int numItems, const RECT &clientRect) const;
+	std::unordered_set<int> GetVisibleItemsFromSnapshot(int numItems, const RECT &clientRect) const;
+	std::unordered_set<int> GetVisibleGroupedItems(const RECT &clientRect) const;
+	std::unordered_set<int> GetVisibleFreelyPositionedItems(int numItems,
+		const RECT &clientRect) const;
+	RECT GetItemBounds(int index) const;
+
 	/* Thumbnails view. */
 	void QueueThumbnailTask(int internalIndex);
-	std::optional<int> GetCachedThumbnailIndex(const ItemInfo_t &itemInfo);
 	static wil::unique_hbitmap GetThumbnail(PCIDLIST_ABSOLUTE pidl, UINT thumbnailSize,
 		WTS_FLAGS flags);
 	void ProcessThumbnailResult(int thumbnailResultId);
 	void SetupThumbnailsView(int shellImageListType);
 	void RemoveThumbnailsView();
 	void InvalidateAllItemImages();
-	int GetIconThumbnail(int iInternalIndex) const;
-	int GetExtractedThumbnail(HBITMAP hThumbnailBitmap) const;
-	int GetThumbnailInternal(int iType, int iInternalIndex, HBITMAP hThumbnailBitmap) const;
+	int GetIconThumbnail(int iInternalIndex);
+	int GetExtractedThumbnail(int iInternalIndex, HBITMAP hThumbnailBitmap);
+	int GetThumbnailInternal(int iType, int iInternalIndex, HBITMAP hThumbnailBitmap);
+	int StoreThumbnailImage(int internalIndex, HBITMAP bitmap);
+	void UpdateThumbnailSlotUsage(const std::unordered_set<int> &visibleItems);
+	void LogThumbnailSlotUsage() const;
 	void DrawIconThumbnailInternal(HDC hdcBacking, int iInternalIndex) const;
 	void DrawThumbnailInternal(HDC hdcBacking, HBITMAP hThumbnailBitmap) const;
 
@@ -615,10 +809,17 @@ private:
 
 	/* Miscellaneous. */
 	BOOL CompareVirtualFolders(UINT uFolderCSIDL) const;
+	void AddItemsToSelection(const std::vector<PidlAbsolute> &pidls);
+	static std::vector<PidlAbsolute> GetPastedItemPidls(
+		const ClipboardOperations::PastedItems &pastedItems);
+	static concurrencpp::null_result PasteSymLinksViaElevatedProcess(
+		WeakPtr<ShellBrowserImpl> weakSelf, std::wstring destination, Runtime *runtime);
 	int LocateFileItemInternalIndex(const TCHAR *szFileName) const;
 	std::optional<int> GetItemIndexForPidl(PCIDLIST_ABSOLUTE pidl) const;
 	std::optional<int> GetItemInternalIndexForPidl(PCIDLIST_ABSOLUTE pidl) const;
 	std::optional<int> LocateItemByInternalIndex(int internalIndex) const;
+	void RebuildItemRowMap() const;
+	void InvalidateItemRowMap() const;
 	void ApplyHeaderSortArrow();
 
 	HWND m_listView;
@@ -652,21 +853,42 @@ private:
 	as display name. */
 	std::unordered_map<int, ItemInfo_t> m_itemInfoMap;
 
-	ctpl::thread_pool m_columnThreadPool;
-	std::unordered_map<int, std::future<ColumnResult_t>> m_columnResults;
+	// Built from the color rules the first time an item is drawn and reset whenever the rules
+	// change.
+	std::optional<ColorRuleMatcher> m_colorRuleMatcher;
+
+	// Allows items to be looked up by their parsing name, which is used when processing directory
+	// change notifications. This needs to be kept in sync with m_itemInfoMap.
+	ParsingNameIndex m_parsingNameIndex;
+
+	// Caches the column text for items in the folder. This is mutable, since sort keys can be built
+	// from the cached text and the sort methods are const.
+	mutable ColumnTextCache m_columnTextCache;
+
+	std::unique_ptr<TaskQueue> m_columnTaskQueue;
+
+	// Stopped whenever the column tasks are cleared, so that any long-running tasks (e.g. folder
+	// size calculations) that have already started finish early.
+	std::stop_source m_columnTaskStopSource;
+
+	const std::shared_ptr<CompletedColumnResults> m_completedColumnResults;
 	int m_columnResultIDCounter;
 
-	std::unique_ptr<IconFetcher> m_iconFetcher;
+	std::unique_ptr<IconFetcherImpl> m_iconFetcher;
 	CachedIcons *m_cachedIcons;
 
-	ctpl::thread_pool m_thumbnailThreadPool;
+	std::unique_ptr<TaskQueue> m_thumbnailTaskQueue;
 	std::unordered_map<int, std::future<std::optional<ThumbnailResult_t>>> m_thumbnailResults;
 	int m_thumbnailResultIDCounter;
 
-	ctpl::thread_pool m_infoTipsThreadPool;
+	std::unique_ptr<TaskQueue> m_infoTipTaskQueue;
 	std::unordered_map<int, std::future<std::optional<InfoTipResult>>> m_infoTipResults;
 	int m_infoTipResultIDCounter;
 
+	std::unique_ptr<TaskQueue> m_groupTaskQueue;
+	const std::shared_ptr<CompletedGroupResults> m_completedGroupResults;
+	int m_groupResultIDCounter;
+
 	/* Internal state. */
 	const HINSTANCE m_resourceInstance;
 	AcceleratorManager *const m_acceleratorManager;
@@ -683,6 +905,10 @@ private:
 	const Config *m_config;
 	FolderSettings m_folderSettings;
 
+	// The compiled form of the filter in m_folderSettings. This is built lazily and is rebuilt
+	// whenever the filter text or case sensitivity changes.
+	mutable std::optional<WildcardPattern> m_compiledFilter;
+
 	int m_middleButtonItem;
 
 	// Shell window integration
@@ -4,383 +4,576 @@
 
 #include "stdafx.h"
 #include "SortHelper.h"
+#include "ColumnDataRetrieval.h"
+#include "FolderSettings.h"
+#include "FolderSizeCache.h"
 #include "ItemData.h"
 #include <wil/common.h>
+#include <propkey.h>
 #include <propvarutil.h>
+#include <cassert>
 
-int SortByName(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
+namespace
+{
+
+// Items that don't have a value for the sort key will be placed in this group, which sorts before
+// the group containing items that do have a value.
+constexpr int MISSING_VALUE_GROUP = 0;
+constexpr int DEFAULT_GROUP = 1;
+
+SortKey BuildMissingKey()
+{
+	return { MISSING_VALUE_GROUP, std::monostate() };
+}
+
+SortKey BuildStringKey(std::wstring value)
+{
+	return { DEFAULT_GROUP, std::move(value) };
+}
+
+SortKey BuildNumericKey(ULONGLONG value)
+{
+	return { DEFAULT_GROUP, value };
+}
+
+SortKey GetNameSortKey(const BasicItemInfo_t &itemInfo,
 	const GlobalFolderSettings &globalFolderSettings)
 {
-	if (itemInfo1.isRoot && !itemInfo2.isRoot)
+	// Drives are always sorted before other items and are sorted by drive letter, rather than
+	// display name.
+	if (itemInfo.isRoot)
 	{
-		return -1;
+		return { MISSING_VALUE_GROUP, itemInfo.getFullPath() };
 	}
-	else if (!itemInfo1.isRoot && itemInfo2.isRoot)
+
+	return BuildStringKey(GetNameColumnText(itemInfo, globalFolderSettings));
+}
+
+SortKey GetTypeSortKey(const BasicItemInfo_t &itemInfo)
+{
+	return { itemInfo.isRoot ? MISSING_VALUE_GROUP : DEFAULT_GROUP, GetTypeColumnText(itemInfo) };
+}
+
+SortKey GetSizeSortKey(const BasicItemInfo_t &itemInfo,
+	const GlobalFolderSettings &globalFolderSettings, const FolderSizeCache *folderSizeCache)
+{
+	if (!itemInfo.isFindDataValid)
 	{
-		return 1;
+		return BuildMissingKey();
 	}
-	else if (itemInfo1.isRoot && itemInfo2.isRoot)
+
+	if (WI_IsFlagSet(itemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY))
 	{
-		/* If the items been compared are both drives,
-		sort by drive letter, rather than display name. */
-		if (globalFolderSettings.useNaturalSortOrder)
-		{
-			return StrCmpLogicalW(itemInfo1.getFullPath().c_str(), itemInfo2.getFullPath().c_str());
-		}
-		else
+		// Calculating the size of a folder can take a significant amount of time, so only sizes
+		// that have already been calculated (e.g. for the size column) are used here.
+		std::optional<FolderInfo> folderInfo;
+
+		if (globalFolderSettings.showFolderSizes && folderSizeCache)
 		{
-			return StrCmpIW(itemInfo1.getFullPath().c_str(), itemInfo2.getFullPath().c_str());
+			folderInfo =
+				folderSizeCache->MaybeGet(itemInfo.getFullPath(), itemInfo.wfd.ftLastWriteTime);
 		}
+
+		return BuildNumericKey(folderInfo ? folderInfo->size : 0);
 	}
 
-	std::wstring name1 = GetNameColumnText(itemInfo1, globalFolderSettings);
-	std::wstring name2 = GetNameColumnText(itemInfo2, globalFolderSettings);
+	ULARGE_INTEGER fileSize = { { itemInfo.wfd.nFileSizeLow, itemInfo.wfd.nFileSizeHigh } };
+	return BuildNumericKey(fileSize.QuadPart);
+}
 
-	if (globalFolderSettings.useNaturalSortOrder)
+SortKey GetDateSortKey(const BasicItemInfo_t &itemInfo, TimeType timeType)
+{
+	if (!itemInfo.isFindDataValid)
 	{
-		return StrCmpLogicalW(name1.c_str(), name2.c_str());
+		return BuildMissingKey();
 	}
-	else
+
+	const FILETIME *fileTime = nullptr;
+
+	switch (timeType)
 	{
-		return StrCmpIW(name1.c_str(), name2.c_str());
+	case TimeType::Created:
+		fileTime = &itemInfo.wfd.ftCreationTime;
+		break;
+
+	case TimeType::Modified:
+		fileTime = &itemInfo.wfd.ftLastWriteTime;
+		break;
+
+	case TimeType::Accessed:
+		fileTime = &itemInfo.wfd.ftLastAccessTime;
+		break;
+
+	default:
+		assert(false);
+		return BuildMissingKey();
 	}
+
+	ULARGE_INTEGER time = { { fileTime->dwLowDateTime, fileTime->dwHighDateTime } };
+	return BuildNumericKey(time.QuadPart);
 }
 
-int SortBySize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
+SortKey GetDriveSpaceSortKey(const BasicItemInfo_t &itemInfo, bool totalSize)
 {
-	if (!itemInfo1.isFindDataValid && itemInfo2.isFindDataValid)
-	{
-		return -1;
-	}
-	else if (itemInfo1.isFindDataValid && !itemInfo2.isFindDataValid)
-	{
-		return 1;
-	}
-	else if (!itemInfo1.isFindDataValid && !itemInfo2.isFindDataValid)
+	ULARGE_INTEGER driveSpace;
+	BOOL res = GetDriveSpaceColumnRawData(itemInfo, totalSize, driveSpace);
+
+	if (!res)
 	{
-		return 0;
+		return BuildMissingKey();
 	}
 
-	bool isFolder1 = WI_IsFlagSet(itemInfo1.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY);
-	bool isFolder2 = WI_IsFlagSet(itemInfo2.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY);
+	return BuildNumericKey(driveSpace.QuadPart);
+}
 
-	ULONGLONG size1;
-	ULONGLONG size2;
+SortKey GetRealSizeSortKey(const BasicItemInfo_t &itemInfo)
+{
+	ULARGE_INTEGER realFileSize;
+	bool res = GetRealSizeColumnRawData(itemInfo, realFileSize);
 
-	if (isFolder1 && isFolder2)
+	if (!res)
 	{
-		// Temporarily disabled.
-		/*auto itr1 = m_cachedFolderSizes.find(InternalIndex1);
-		auto itr2 = m_cachedFolderSizes.find(InternalIndex2);
+		return BuildMissingKey();
+	}
 
-		if (itr1 == m_cachedFolderSizes.end() && itr2 == m_cachedFolderSizes.end())
-		{
-			return 0;
-		}
-		else if (itr1 != m_cachedFolderSizes.end() && itr2 == m_cachedFolderSizes.end())
-		{
-			return 1;
-		}
-		else if (itr1 == m_cachedFolderSizes.end() && itr2 != m_cachedFolderSizes.end())
-		{
-			return -1;
-		}
+	return BuildNumericKey(realFileSize.QuadPart);
+}
 
-		size1 = itr1->second;
-		size2 = itr2->second;*/
+SortKey GetHardLinksSortKey(const BasicItemInfo_t &itemInfo)
+{
+	auto numHardLinks = GetHardLinksColumnRawData(itemInfo);
 
-		size1 = 0;
-		size2 = 0;
-	}
-	else
+	if (!numHardLinks)
 	{
-		// Both items are files (as opposed to folders).
-		ULARGE_INTEGER fileSize1 = { { itemInfo1.wfd.nFileSizeLow, itemInfo1.wfd.nFileSizeHigh } };
-		ULARGE_INTEGER fileSize2 = { { itemInfo2.wfd.nFileSizeLow, itemInfo2.wfd.nFileSizeHigh } };
-
-		size1 = fileSize1.QuadPart;
-		size2 = fileSize2.QuadPart;
+		return BuildMissingKey();
 	}
 
-	if (size1 > size2)
-	{
-		return 1;
-	}
-	else if (size1 < size2)
+	return BuildNumericKey(*numHardLinks);
+}
+
+SortKey GetItemDetailsSortKey(const BasicItemInfo_t &itemInfo, const SHCOLUMNID *pscid)
+{
+	wil::unique_variant value;
+	HRESULT hr = GetItemDetailsRawData(itemInfo, pscid, value.addressof());
+
+	if (FAILED(hr))
 	{
-		return -1;
+		return BuildMissingKey();
 	}
 
-	return 0;
+	return { DEFAULT_GROUP, std::move(value) };
 }
 
-int SortByType(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
+int CompareVariants(const VARIANT &variant1, const VARIANT &variant2)
 {
-	if (itemInfo1.isRoot && !itemInfo2.isRoot)
+	// VariantCompare can only meaningfully compare values of the same type. Ordering values of
+	// different types by their type ensures that the comparison remains consistent.
+	if (variant1.vt != variant2.vt)
 	{
-		return -1;
-	}
-	else if (!itemInfo1.isRoot && itemInfo2.isRoot)
-	{
-		return 1;
+		return variant1.vt < variant2.vt ? -1 : 1;
 	}
 
-	std::wstring type1 = GetTypeColumnText(itemInfo1);
-	std::wstring type2 = GetTypeColumnText(itemInfo2);
+	return VariantCompare(variant1, variant2);
+}
 
-	return StrCmpLogicalW(type1.c_str(), type2.c_str());
 }
 
-int SortByDate(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	DateType dateType)
+SortKey GetSortKey(const BasicItemInfo_t &itemInfo, SortMode sortMode,
+	const GlobalFolderSettings &globalFolderSettings, const FolderSizeCache *folderSizeCache)
 {
-	if (!itemInfo1.isFindDataValid && itemInfo2.isFindDataValid)
-	{
-		return -1;
-	}
-	else if (itemInfo1.isFindDataValid && !itemInfo2.isFindDataValid)
-	{
-		return 1;
-	}
-	else if (!itemInfo1.isFindDataValid && !itemInfo2.isFindDataValid)
+	switch (sortMode)
 	{
-		return 0;
-	}
+	case SortMode::Name:
+		return GetNameSortKey(itemInfo, globalFolderSettings);
 
-	switch (dateType)
-	{
-	case DateType::Created:
-		return CompareFileTime(&itemInfo1.wfd.ftCreationTime, &itemInfo2.wfd.ftCreationTime);
+	case SortMode::Type:
+		return GetTypeSortKey(itemInfo);
+
+	case SortMode::Size:
+		return GetSizeSortKey(itemInfo, globalFolderSettings, folderSizeCache);
+
+	case SortMode::DateModified:
+		return GetDateSortKey(itemInfo, TimeType::Modified);
+
+	case SortMode::TotalSize:
+		return GetDriveSpaceSortKey(itemInfo, true);
+
+	case SortMode::FreeSpace:
+		return GetDriveSpaceSortKey(itemInfo, false);
+
+	case SortMode::DateDeleted:
+		return GetItemDetailsSortKey(itemInfo, &SCID_DATE_DELETED);
+
+	case SortMode::OriginalLocation:
+		return GetItemDetailsSortKey(itemInfo, &SCID_ORIGINAL_LOCATION);
+
+	case SortMode::Attributes:
+		return BuildStringKey(GetAttributeColumnText(itemInfo));
+
+	case SortMode::RealSize:
+		return GetRealSizeSortKey(itemInfo);
+
+	case SortMode::ShortName:
+		return BuildStringKey(GetShortNameColumnText(itemInfo));
+
+	case SortMode::Owner:
+		return BuildStringKey(GetOwnerColumnText(itemInfo));
+
+	case SortMode::ProductName:
+		return BuildStringKey(GetVersionColumnText(itemInfo, VersionInfoType::ProductName));
+
+	case SortMode::Company:
+		return BuildStringKey(GetVersionColumnText(itemInfo, VersionInfoType::Company));
+
+	case SortMode::Description:
+		return BuildStringKey(GetVersionColumnText(itemInfo, VersionInfoType::Description));
+
+	case SortMode::FileVersion:
+		return BuildStringKey(GetVersionColumnText(itemInfo, VersionInfoType::FileVersion));
+
+	case SortMode::ProductVersion:
+		return BuildStringKey(GetVersionColumnText(itemInfo, VersionInfoType::ProductVersion));
+
+	case SortMode::ShortcutTo:
+		return BuildStringKey(GetShortcutToColumnText(itemInfo));
+
+	case SortMode::HardLinks:
+		return GetHardLinksSortKey(itemInfo);
+
+	case SortMode::Extension:
+		return BuildStringKey(GetExtensionColumnText(itemInfo));
+
+	case SortMode::Created:
+		return GetDateSortKey(itemInfo, TimeType::Created);
+
+	case SortMode::Accessed:
+		return GetDateSortKey(itemInfo, TimeType::Accessed);
+
+	case SortMode::Title:
+		return GetItemDetailsSortKey(itemInfo, &PKEY_Title);
+
+	case SortMode::Subject:
+		return GetItemDetailsSortKey(itemInfo, &PKEY_Subject);
+
+	case SortMode::Authors:
+		return GetItemDetailsSortKey(itemInfo, &PKEY_Author);
+
+	case SortMode::Keywords:
+		return GetItemDetailsSortKey(itemInfo, &PKEY_Keywords);
+
+	case SortMode::Comments:
+		return GetItemDetailsSortKey(itemInfo, &PKEY_Comment);
+
+	case SortMode::CameraModel:
+		return BuildStringKey(GetImageColumnText(itemInfo, PropertyTagEquipModel));
+
+	case SortMode::DateTaken:
+		return BuildStringKey(GetImageColumnText(itemInfo, PropertyTagDateTime));
+
+	case SortMode::Width:
+		return BuildStringKey(GetImageColumnText(itemInfo, PropertyTagImageWidth));
+
+	case SortMode::Height:
+		return BuildStringKey(GetImageColumnText(itemInfo, PropertyTagImageHeight));
+
+	case SortMode::VirtualComments:
+		return BuildStringKey(GetControlPanelCommentsColumnText(itemInfo));
+
+	case SortMode::FileSystem:
+		return BuildStringKey(GetFileSystemColumnText(itemInfo));
+
+	case SortMode::NumPrinterDocuments:
+		return BuildStringKey(GetPrinterColumnText(itemInfo, PrinterInformationType::NumJobs));
+
+	case SortMode::PrinterStatus:
+		return BuildStringKey(GetPrinterColumnText(itemInfo, PrinterInformationType::Status));
+
+	case SortMode::PrinterComments:
+		return BuildStringKey(GetPrinterColumnText(itemInfo, PrinterInformationType::Comments));
+
+	case SortMode::PrinterLocation:
+		return BuildStringKey(GetPrinterColumnText(itemInfo, PrinterInformationType::Location));
+
+	case SortMode::NetworkAdapterStatus:
+		return BuildStringKey(GetNetworkAdapterColumnText(itemInfo));
+
+	case SortMode::MediaBitrate:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Bitrate));
+
+	case SortMode::MediaCopyright:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Copyright));
+
+	case SortMode::MediaDuration:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Duration));
+
+	case SortMode::MediaProtected:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Protected));
 
-	case DateType::Modified:
-		return CompareFileTime(&itemInfo1.wfd.ftLastWriteTime, &itemInfo2.wfd.ftLastWriteTime);
+	case SortMode::MediaRating:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Rating));
 
-	case DateType::Accessed:
-		return CompareFileTime(&itemInfo1.wfd.ftLastAccessTime, &itemInfo2.wfd.ftLastAccessTime);
+	case SortMode::MediaAlbumArtist:
+		return BuildStringKey(
+			GetMediaMetadataColumnText(itemInfo, MediaMetadataType::AlbumArtist));
+
+	case SortMode::MediaAlbum:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::AlbumTitle));
+
+	case SortMode::MediaBeatsPerMinute:
+		return BuildStringKey(
+			GetMediaMetadataColumnText(itemInfo, MediaMetadataType::BeatsPerMinute));
+
+	case SortMode::MediaComposer:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Composer));
+
+	case SortMode::MediaConductor:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Conductor));
+
+	case SortMode::MediaDirector:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Director));
+
+	case SortMode::MediaGenre:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Genre));
+
+	case SortMode::MediaLanguage:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Language));
+
+	case SortMode::MediaBroadcastDate:
+		return BuildStringKey(
+			GetMediaMetadataColumnText(itemInfo, MediaMetadataType::BroadcastDate));
+
+	case SortMode::MediaChannel:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Channel));
+
+	case SortMode::MediaStationName:
+		return BuildStringKey(
+			GetMediaMetadataColumnText(itemInfo, MediaMetadataType::StationName));
+
+	case SortMode::MediaMood:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Mood));
+
+	case SortMode::MediaParentalRating:
+		return BuildStringKey(
+			GetMediaMetadataColumnText(itemInfo, MediaMetadataType::ParentalRating));
+
+	case SortMode::MediaParentalRatingReason:
+		return BuildStringKey(
+			GetMediaMetadataColumnText(itemInfo, MediaMetadataType::ParentalRatingReason));
+
+	case SortMode::MediaPeriod:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Period));
+
+	case SortMode::MediaProducer:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Producer));
+
+	case SortMode::MediaPublisher:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Publisher));
+
+	case SortMode::MediaWriter:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Writer));
+
+	case SortMode::MediaYear:
+		return BuildStringKey(GetMediaMetadataColumnText(itemInfo, MediaMetadataType::Year));
 
 	default:
 		assert(false);
 		break;
 	}
 
-	return 0;
+	return BuildMissingKey();
 }
 
-int SortByTotalSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	bool TotalSize)
+bool IsSortKeyRetrievalExpensive(SortMode sortMode)
 {
-	ULARGE_INTEGER driveSpace1;
-	BOOL res1 = GetDriveSpaceColumnRawData(itemInfo1, TotalSize, driveSpace1);
+	switch (sortMode)
+	{
+	// The keys for these sort modes are derived entirely from information that's retrieved when
+	// an item is first added.
+	case SortMode::Name:
+	case SortMode::Size:
+	case SortMode::DateModified:
+	case SortMode::Created:
+	case SortMode::Accessed:
+	case SortMode::Attributes:
+	case SortMode::Extension:
+		return false;
 
-	ULARGE_INTEGER driveSpace2;
-	BOOL res2 = GetDriveSpaceColumnRawData(itemInfo2, TotalSize, driveSpace2);
-
-	if (res1 && !res2)
-	{
-		return 1;
-	}
-	else if (!res1 && res2)
-	{
-		return -1;
-	}
-	else if (!res1 && !res2)
-	{
-		return 0;
+	default:
+		return true;
 	}
+}
 
-	if (driveSpace1.QuadPart > driveSpace2.QuadPart)
-	{
-		return 1;
-	}
-	else if (driveSpace1.QuadPart < driveSpace2.QuadPart)
+std::optional<ColumnType> GetSortKeyTextColumn(SortMode sortMode)
+{
+	// Only columns whose text can be cached are included here, since there's no benefit in
+	// building the key from the column text otherwise.
+	switch (sortMode)
 	{
-		return -1;
-	}
+	case SortMode::Owner:
+		return ColumnType::Owner;
 
-	return 0;
-}
+	case SortMode::ProductName:
+		return ColumnType::ProductName;
 
-int SortByAttributes(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
-{
-	std::wstring attributeString1 = GetAttributeColumnText(itemInfo1);
-	std::wstring attributeString2 = GetAttributeColumnText(itemInfo2);
+	case SortMode::Company:
+		return ColumnType::Company;
 
-	return StrCmpLogicalW(attributeString1.c_str(), attributeString2.c_str());
-}
+	case SortMode::Description:
+		return ColumnType::Description;
 
-int SortByRealSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
-{
-	ULARGE_INTEGER realFileSize1;
-	bool res1 = GetRealSizeColumnRawData(itemInfo1, realFileSize1);
+	case SortMode::FileVersion:
+		return ColumnType::FileVersion;
 
-	ULARGE_INTEGER realFileSize2;
-	bool res2 = GetRealSizeColumnRawData(itemInfo2, realFileSize2);
+	case SortMode::ProductVersion:
+		return ColumnType::ProductVersion;
 
-	if (res1 && !res2)
-	{
-		return 1;
-	}
-	else if (!res1 && res2)
-	{
-		return -1;
-	}
-	else if (!res1 && !res2)
-	{
-		return 0;
-	}
+	case SortMode::ShortcutTo:
+		return ColumnType::ShortcutTo;
 
-	if (realFileSize1.QuadPart > realFileSize2.QuadPart)
-	{
-		return 1;
-	}
-	else if (realFileSize1.QuadPart < realFileSize2.QuadPart)
-	{
-		return -1;
-	}
+	case SortMode::CameraModel:
+		return ColumnType::CameraModel;
 
-	return 0;
-}
+	case SortMode::DateTaken:
+		return ColumnType::DateTaken;
 
-int SortByShortName(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
-{
-	std::wstring shortName1 = GetShortNameColumnText(itemInfo1);
-	std::wstring shortName2 = GetShortNameColumnText(itemInfo2);
+	case SortMode::Width:
+		return ColumnType::Width;
 
-	return StrCmpLogicalW(shortName1.c_str(), shortName2.c_str());
-}
+	case SortMode::Height:
+		return ColumnType::Height;
 
-int SortByOwner(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
-{
-	std::wstring owner1 = GetOwnerColumnText(itemInfo1);
-	std::wstring owner2 = GetOwnerColumnText(itemInfo2);
+	case SortMode::VirtualComments:
+		return ColumnType::VirtualComments;
 
-	return StrCmpLogicalW(owner1.c_str(), owner2.c_str());
-}
+	case SortMode::FileSystem:
+		return ColumnType::FileSystem;
 
-int SortByVersionInfo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	VersionInfoType versionInfoType)
-{
-	std::wstring versionInfo1 = GetVersionColumnText(itemInfo1, versionInfoType);
-	std::wstring versionInfo2 = GetVersionColumnText(itemInfo2, versionInfoType);
+	case SortMode::MediaBitrate:
+		return ColumnType::MediaBitrate;
 
-	return StrCmpLogicalW(versionInfo1.c_str(), versionInfo2.c_str());
-}
+	case SortMode::MediaCopyright:
+		return ColumnType::MediaCopyright;
 
-int SortByShortcutTo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
-{
-	std::wstring resolvedLinkPath1 = GetShortcutToColumnText(itemInfo1);
-	std::wstring resolvedLinkPath2 = GetShortcutToColumnText(itemInfo2);
+	case SortMode::MediaDuration:
+		return ColumnType::MediaDuration;
 
-	return StrCmpLogicalW(resolvedLinkPath1.c_str(), resolvedLinkPath2.c_str());
-}
+	case SortMode::MediaProtected:
+		return ColumnType::MediaProtected;
 
-int SortByHardlinks(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
-{
-	auto numHardLinks1 = GetHardLinksColumnRawData(itemInfo1);
-	auto numHardLinks2 = GetHardLinksColumnRawData(itemInfo2);
+	case SortMode::MediaRating:
+		return ColumnType::MediaRating;
 
-	if (!numHardLinks1 && !numHardLinks2)
-	{
-		return 0;
-	}
-	else if (!numHardLinks1 && numHardLinks2)
-	{
-		return -1;
-	}
-	else if (numHardLinks1 && !numHardLinks2)
-	{
-		return 1;
-	}
-	else
-	{
-		return *numHardLinks1 - *numHardLinks2;
-	}
-}
+	case SortMode::MediaAlbumArtist:
+		return ColumnType::MediaAlbumArtist;
 
-int SortByExtension(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
-{
-	std::wstring extension1 = GetExtensionColumnText(itemInfo1);
-	std::wstring extension2 = GetExtensionColumnText(itemInfo2);
+	case SortMode::MediaAlbum:
+		return ColumnType::MediaAlbum;
 
-	return StrCmpLogicalW(extension1.c_str(), extension2.c_str());
-}
+	case SortMode::MediaBeatsPerMinute:
+		return ColumnType::MediaBeatsPerMinute;
 
-int SortByItemDetails(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	const SHCOLUMNID *pscid)
-{
-	VARIANT vt1;
-	HRESULT hr1 = GetItemDetailsRawData(itemInfo1, pscid, &vt1);
+	case SortMode::MediaComposer:
+		return ColumnType::MediaComposer;
 
-	VARIANT vt2;
-	HRESULT hr2 = GetItemDetailsRawData(itemInfo2, pscid, &vt2);
+	case SortMode::MediaConductor:
+		return ColumnType::MediaConductor;
 
-	int ret = 0;
+	case SortMode::MediaDirector:
+		return ColumnType::MediaDirector;
 
-	if (SUCCEEDED(hr1) && SUCCEEDED(hr2) && vt1.vt == vt2.vt)
-	{
-		ret = VariantCompare(vt1, vt2);
-	}
+	case SortMode::MediaGenre:
+		return ColumnType::MediaGenre;
 
-	if (SUCCEEDED(hr1))
-	{
-		VariantClear(&vt1);
-	}
+	case SortMode::MediaLanguage:
+		return ColumnType::MediaLanguage;
 
-	if (SUCCEEDED(hr2))
-	{
-		VariantClear(&vt2);
-	}
+	case SortMode::MediaBroadcastDate:
+		return ColumnType::MediaBroadcastDate;
 
-	return ret;
-}
+	case SortMode::MediaChannel:
+		return ColumnType::MediaChannel;
 
-int SortByImageProperty(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	PROPID PropertyId)
-{
-	std::wstring imageProperty1 = GetImageColumnText(itemInfo1, PropertyId);
-	std::wstring imageProperty2 = GetImageColumnText(itemInfo2, PropertyId);
+	case SortMode::MediaStationName:
+		return ColumnType::MediaStationName;
 
-	return StrCmpLogicalW(imageProperty1.c_str(), imageProperty2.c_str());
-}
+	case SortMode::MediaMood:
+		return ColumnType::MediaMood;
 
-int SortByVirtualComments(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
-{
-	std::wstring comments1 = GetControlPanelCommentsColumnText(itemInfo1);
-	std::wstring comments2 = GetControlPanelCommentsColumnText(itemInfo2);
+	case SortMode::MediaParentalRating:
+		return ColumnType::MediaParentalRating;
 
-	return StrCmpLogicalW(comments1.c_str(), comments2.c_str());
-}
+	case SortMode::MediaParentalRatingReason:
+		return ColumnType::MediaParentalRatingReason;
 
-int SortByFileSystem(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
-{
-	std::wstring fileSystemName1 = GetFileSystemColumnText(itemInfo1);
-	std::wstring fileSystemName2 = GetFileSystemColumnText(itemInfo2);
+	case SortMode::MediaPeriod:
+		return ColumnType::MediaPeriod;
+
+	case SortMode::MediaProducer:
+		return ColumnType::MediaProducer;
+
+	case SortMode::MediaPublisher:
+		return ColumnType::MediaPublisher;
+
+	case SortMode::MediaWriter:
+		return ColumnType::MediaWriter;
 
-	return StrCmpLogicalW(fileSystemName1.c_str(), fileSystemName2.c_str());
+	case SortMode::MediaYear:
+		return ColumnType::MediaYear;
+
+	default:
+		return std::nullopt;
+	}
 }
 
-int SortByPrinterProperty(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	PrinterInformationType printerInformationType)
+SortKey BuildSortKeyFromColumnText(std::wstring columnText)
 {
-	std::wstring printerInformation1 = GetPrinterColumnText(itemInfo1, printerInformationType);
-	std::wstring printerInformation2 = GetPrinterColumnText(itemInfo2, printerInformationType);
-
-	return StrCmpLogicalW(printerInformation1.c_str(), printerInformation2.c_str());
+	return BuildStringKey(std::move(columnText));
 }
 
-int SortByNetworkAdapterStatus(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2)
+int CompareSortKeys(const SortKey &key1, const SortKey &key2, StringComparison stringComparison)
 {
-	std::wstring status1 = GetNetworkAdapterColumnText(itemInfo1);
-	std::wstring status2 = GetNetworkAdapterColumnText(itemInfo2);
+	if (key1.group != key2.group)
+	{
+		return key1.group < key2.group ? -1 : 1;
+	}
+
+	if (key1.value.index() != key2.value.index())
+	{
+		return key1.value.index() < key2.value.index() ? -1 : 1;
+	}
+
+	if (const auto *string1 = std::get_if<std::wstring>(&key1.value))
+	{
+		return CompareStrings(*string1, std::get<std::wstring>(key2.value), stringComparison);
+	}
+	else if (const auto *number1 = std::get_if<ULONGLONG>(&key1.value))
+	{
+		auto number2 = std::get<ULONGLONG>(key2.value);
+
+		if (*number1 == number2)
+		{
+			return 0;
+		}
+
+		return *number1 < number2 ? -1 : 1;
+	}
+	else if (const auto *variant1 = std::get_if<wil::unique_variant>(&key1.value))
+	{
+		return CompareVariants(*variant1, std::get<wil::unique_variant>(key2.value));
+	}
 
-	return StrCmpLogicalW(status1.c_str(), status2.c_str());
+	return 0;
 }
 
-int SortByMediaMetadata(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	MediaMetadataType mediaMetadataType)
+int CompareStrings(const std::wstring &string1, const std::wstring &string2,
+	StringComparison stringComparison)
 {
-	std::wstring mediaMetadata1 = GetMediaMetadataColumnText(itemInfo1, mediaMetadataType);
-	std::wstring mediaMetadata2 = GetMediaMetadataColumnText(itemInfo2, mediaMetadataType);
-
-	return StrCmpLogicalW(mediaMetadata1.c_str(), mediaMetadata2.c_str());
+	if (stringComparison == StringComparison::Logical)
+	{
+		return StrCmpLogicalW(string1.c_str(), string2.c_str());
+	}
+	else
+	{
+		return StrCmpIW(string1.c_str(), string2.c_str());
+	}
 }
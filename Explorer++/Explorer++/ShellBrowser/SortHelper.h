@@ -4,43 +4,53 @@
 
 #pragma once
 
-#include "ColumnDataRetrieval.h"
-#include "FolderSettings.h"
+#include "Columns.h"
+#include "SortModes.h"
+#include <wil/resource.h>
+#include <optional>
+#include <string>
+#include <variant>
 
 struct BasicItemInfo_t;
+class FolderSizeCache;
+struct GlobalFolderSettings;
 
-enum class DateType
+// The value an item is sorted on. Retrieving that value can be expensive (e.g. when sorting by
+// owner or version info, the item needs to be opened), so the key for each item is retrieved once,
+// before any comparisons take place.
+struct SortKey
 {
-	Created,
-	Modified,
-	Accessed
+	// Keys are compared by group first. This is used, for example, to ensure that items without a
+	// value appear before items that do have a value.
+	int group = 0;
+
+	std::variant<std::monostate, std::wstring, ULONGLONG, wil::unique_variant> value;
+};
+
+enum class StringComparison
+{
+	// Compares strings the way Windows Explorer does, with numbers being compared by value.
+	Logical,
+
+	CaseInsensitive
 };
 
-int SortByName(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	const GlobalFolderSettings &globalFolderSettings);
-int SortBySize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByType(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByDate(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	DateType dateType);
-int SortByTotalSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	bool TotalSize);
-int SortByAttributes(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByRealSize(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByShortName(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByOwner(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByVersionInfo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	VersionInfoType versionInfoType);
-int SortByShortcutTo(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByHardlinks(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByExtension(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByItemDetails(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	const SHCOLUMNID *pscid);
-int SortByImageProperty(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	PROPID PropertyId);
-int SortByVirtualComments(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByFileSystem(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByPrinterProperty(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	PrinterInformationType printerInformationType);
-int SortByNetworkAdapterStatus(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2);
-int SortByMediaMetadata(const BasicItemInfo_t &itemInfo1, const BasicItemInfo_t &itemInfo2,
-	MediaMetadataType mediaMetadataType);
+// When folder sizes are shown, the cache is used to sort folders by size. Folders that don't have a
+// cached size are treated as being empty.
+SortKey GetSortKey(const BasicItemInfo_t &itemInfo, SortMode sortMode,
+	const GlobalFolderSettings &globalFolderSettings,
+	const FolderSizeCache *folderSizeCache = nullptr);
+
+// Returns true if retrieving the sort key for an item may involve accessing the item itself (e.g.
+// reading from the file). The keys for these sort modes are best retrieved in parallel.
+bool IsSortKeyRetrievalExpensive(SortMode sortMode);
+
+// For some sort modes, the sort key is simply the text shown in the corresponding column. In that
+// case, this returns the column, which allows the sort key to be built from column text that has
+// already been retrieved (see BuildSortKeyFromColumnText()).
+std::optional<ColumnType> GetSortKeyTextColumn(SortMode sortMode);
+SortKey BuildSortKeyFromColumnText(std::wstring columnText);
+
+int CompareSortKeys(const SortKey &key1, const SortKey &key2, StringComparison stringComparison);
+int CompareStrings(const std::wstring &string1, const std::wstring &string2,
+	StringComparison stringComparison);
@@ -4,18 +4,70 @@
 
 #include "stdafx.h"
 #include "ShellBrowserImpl.h"
+#include "App.h"
 #include "Config.h"
 #include "ItemData.h"
+#include "Runtime.h"
 #include "SortHelper.h"
 #include "SortModes.h"
 #include "ViewModes.h"
-#include <propkey.h>
-#include <cassert>
+#include <wil/common.h>
+#include <algorithm>
+#include <atomic>
+#include <latch>
+#include <memory>
+#include <unordered_map>
+
+namespace
+{
+
+int CALLBACK SortByPositionStub(LPARAM lParam1, LPARAM lParam2, LPARAM lParamSort)
+{
+	const auto *sortedPositions = reinterpret_cast<std::unordered_map<int, int> *>(lParamSort);
+	return sortedPositions->at(static_cast<int>(lParam1))
+		- sortedPositions->at(static_cast<int>(lParam2));
+}
+
+}
 
 void ShellBrowserImpl::SortFolder()
 {
-	SendMessage(m_listView, LVM_SORTITEMS, reinterpret_cast<WPARAM>(this),
-		reinterpret_cast<LPARAM>(SortStub));
+	int numItems = ListView_GetItemCount(m_listView);
+
+	std::vector<int> internalIndexes;
+	internalIndexes.reserve(numItems);
+
+	for (int i = 0; i < numItems; i++)
+	{
+		internalIndexes.push_back(GetItemInternalIndex(i));
+	}
+
+	// The sort key for each item is retrieved once up front, so that the comparisons themselves
+	// are cheap. Keys that were retrieved previously (e.g. while items were being added) are
+	// reused.
+	CacheSortItems(internalIndexes);
+	bool sortFoldersSeparately = ShouldSortFoldersSeparately();
+
+	std::sort(internalIndexes.begin(), internalIndexes.end(),
+		[this, sortFoldersSeparately](int internalIndex1, int internalIndex2)
+		{
+			return CompareSortItems(m_directoryState.sortItemCache.at(internalIndex1),
+					   m_directoryState.sortItemCache.at(internalIndex2), sortFoldersSeparately)
+				< 0;
+		});
+
+	std::unordered_map<int, int> sortedPositions;
+	sortedPositions.reserve(internalIndexes.size());
+
+	for (size_t i = 0; i < internalIndexes.size(); i++)
+	{
+		sortedPositions[internalIndexes[i]] = static_cast<int>(i);
+	}
+
+	// The listview doesn't provide a way of directly setting the position of each item, so the
+	// sorted order is applied by sorting the listview on the precomputed positions.
+	SendMessage(m_listView, LVM_SORTITEMS, reinterpret_cast<WPARAM>(&sortedPositions),
+		reinterpret_cast<LPARAM>(SortByPositionStub));
 
 	if (m_folderSettings.viewMode == +ViewMode::Details)
 	{
@@ -23,352 +75,240 @@ void ShellBrowserImpl::SortFolder()
 	}
 }
 
-int CALLBACK ShellBrowserImpl::SortStub(LPARAM lParam1, LPARAM lParam2, LPARAM lParamSort)
+// The sort keys depend on several global settings (e.g. whether extensions are shown, for the name
+// key), so the cached keys are discarded if any of those settings have changed since the keys were
+// built.
+void ShellBrowserImpl::InvalidateSortItemCacheIfNecessary() const
 {
-	auto *pShellBrowser = reinterpret_cast<ShellBrowserImpl *>(lParamSort);
-	return pShellBrowser->Sort(static_cast<int>(lParam1), static_cast<int>(lParam2));
+	const auto &globalFolderSettings = m_config->globalFolderSettings;
+	SortItemCacheSettings settings = { m_folderSettings.sortMode,
+		globalFolderSettings.showExtensions, globalFolderSettings.hideLinkExtension,
+		globalFolderSettings.showFolderSizes, globalFolderSettings.showFriendlyDates.get() };
+
+	if (m_directoryState.sortItemCacheSettings == settings)
+	{
+		return;
+	}
+
+	m_directoryState.sortItemCache.clear();
+	m_directoryState.sortItemCacheSettings = settings;
 }
 
-/* Also see NBookmarkHelper::Sort. */
-int CALLBACK ShellBrowserImpl::Sort(int InternalIndex1, int InternalIndex2) const
+void ShellBrowserImpl::CacheSortItems(const std::vector<int> &internalIndexes) const
 {
-	int comparisonResult = 0;
+	InvalidateSortItemCacheIfNecessary();
 
-	BasicItemInfo_t basicItemInfo1 = getBasicItemInfo(InternalIndex1);
-	BasicItemInfo_t basicItemInfo2 = getBasicItemInfo(InternalIndex2);
+	std::vector<int> missingIndexes;
+	auto textColumn = GetSortKeyTextColumn(m_folderSettings.sortMode);
 
-	bool isFolder1 = ((basicItemInfo1.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-						 == FILE_ATTRIBUTE_DIRECTORY)
-		? true
-		: false;
-	bool isFolder2 = ((basicItemInfo2.wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-						 == FILE_ATTRIBUTE_DIRECTORY)
-		? true
-		: false;
+	for (int internalIndex : internalIndexes)
+	{
+		if (m_directoryState.sortItemCache.contains(internalIndex))
+		{
+			continue;
+		}
 
-	/* Folders will by default be sorted separately from files,
-	except in the recycle bin. */
-	if (!m_config->globalFolderSettings.displayMixedFilesAndFolders && isFolder1 && !isFolder2
-		&& !CompareVirtualFolders(CSIDL_BITBUCKET))
+		// If the text for the sort column has already been retrieved, the key can be built
+		// directly from that.
+		if (textColumn && m_columnTextCache.MaybeGetText(internalIndex, *textColumn))
+		{
+			m_directoryState.sortItemCache.emplace(internalIndex, BuildSortItem(internalIndex));
+			continue;
+		}
+
+		missingIndexes.push_back(internalIndex);
+	}
+
+	if (missingIndexes.empty())
+	{
+		return;
+	}
+
+	if (!IsSortKeyRetrievalExpensive(m_folderSettings.sortMode))
+	{
+		for (int internalIndex : missingIndexes)
+		{
+			m_directoryState.sortItemCache.emplace(internalIndex, BuildSortItem(internalIndex));
+		}
+
+		return;
+	}
+
+	// Retrieving the key for each item may involve opening the item, so the keys are retrieved in
+	// parallel on the shared COM STA executor. The item information is copied here, since
+	// m_itemInfoMap can only be accessed from this thread.
+	struct SortKeyRetrievalState
+	{
+		SortKeyRetrievalState(size_t numItems, size_t numThreads) :
+			sortItems(numItems),
+			// Using several chunks per thread means the work stays evenly spread, even if some of
+			// the threads start late.
+			numChunks(std::min(numItems, numThreads * 4)),
+			chunkSize((numItems + numChunks - 1) / numChunks),
+			chunksRemaining(static_cast<std::ptrdiff_t>(numChunks))
+		{
+			basicItemInfos.reserve(numItems);
+		}
+
+		std::vector<SortItem> sortItems;
+		std::vector<BasicItemInfo_t> basicItemInfos;
+		const size_t numChunks;
+		const size_t chunkSize;
+		std::atomic<size_t> nextChunk = 0;
+		std::latch chunksRemaining;
+	};
+
+	auto executor = m_app->GetRuntime()->GetComStaExecutor();
+	size_t numWorkers = static_cast<size_t>(std::max(executor->max_concurrency_level(), 1));
+	auto state = std::make_shared<SortKeyRetrievalState>(missingIndexes.size(), numWorkers + 1);
+
+	for (size_t i = 0; i < missingIndexes.size(); i++)
+	{
+		const auto &itemInfo = m_itemInfoMap.at(missingIndexes[i]);
+
+		auto &sortItem = state->sortItems[i];
+		sortItem.internalIndex = missingIndexes[i];
+		sortItem.isFolder = WI_IsFlagSet(itemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY);
+		sortItem.displayName = itemInfo.displayName;
+
+		state->basicItemInfos.push_back(getBasicItemInfo(missingIndexes[i]));
+	}
+
+	SortMode sortMode = m_folderSettings.sortMode;
+	const GlobalFolderSettings *globalFolderSettings = &m_config->globalFolderSettings;
+	const FolderSizeCache *folderSizeCache = m_app->GetFolderSizeCache().get();
+
+	// Each worker (including this thread) claims chunks until there are none left. This thread
+	// only waits for the chunks that have been claimed, so if the executor is busy with other
+	// background work, this thread will simply process most (or all) of the chunks itself. A
+	// worker that only starts after every chunk has been claimed will find nothing to do. That's
+	// also why the state is shared, since such a worker can run after this method has returned.
+	auto retrieveKeys = [state, sortMode, globalFolderSettings, folderSizeCache]
+	{
+		for (size_t chunk = state->nextChunk++; chunk < state->numChunks;
+			chunk = state->nextChunk++)
+		{
+			size_t start = chunk * state->chunkSize;
+			size_t end = std::min(start + state->chunkSize, state->sortItems.size());
+
+			for (size_t i = start; i < end; i++)
+			{
+				state->sortItems[i].key = GetSortKey(state->basicItemInfos[i], sortMode,
+					*globalFolderSettings, folderSizeCache);
+			}
+
+			state->chunksRemaining.count_down();
+		}
+	};
+
+	for (size_t i = 0; i < numWorkers; i++)
+	{
+		executor->post(retrieveKeys);
+	}
+
+	retrieveKeys();
+	state->chunksRemaining.wait();
+
+	for (auto &sortItem : state->sortItems)
+	{
+		int internalIndex = sortItem.internalIndex;
+
+		// The key is the column text in this case, so it can be displayed without having to be
+		// retrieved again.
+		if (const auto *columnText = std::get_if<std::wstring>(&sortItem.key.value);
+			textColumn && columnText)
+		{
+			m_columnTextCache.SetText(internalIndex, *textColumn, *columnText);
+		}
+
+		m_directoryState.sortItemCache.emplace(internalIndex, std::move(sortItem));
+	}
+}
+
+ShellBrowserImpl::SortItem ShellBrowserImpl::BuildSortItem(int internalIndex) const
+{
+	const auto &itemInfo = m_itemInfoMap.at(internalIndex);
+	auto sortKey = MaybeGetSortKeyFromColumnText(internalIndex);
+
+	if (!sortKey)
+	{
+		BasicItemInfo_t basicItemInfo = getBasicItemInfo(internalIndex);
+		sortKey = GetSortKey(basicItemInfo, m_folderSettings.sortMode,
+			m_config->globalFolderSettings, m_app->GetFolderSizeCache().get());
+	}
+
+	return { internalIndex, WI_IsFlagSet(itemInfo.wfd.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY),
+		itemInfo.displayName, std::move(*sortKey) };
+}
+
+std::optional<SortKey> ShellBrowserImpl::MaybeGetSortKeyFromColumnText(int internalIndex) const
+{
+	auto textColumn = GetSortKeyTextColumn(m_folderSettings.sortMode);
+
+	if (!textColumn)
+	{
+		return std::nullopt;
+	}
+
+	auto columnText = m_columnTextCache.MaybeGetText(internalIndex, *textColumn);
+
+	if (!columnText)
+	{
+		return std::nullopt;
+	}
+
+	return BuildSortKeyFromColumnText(std::move(*columnText));
+}
+
+const ShellBrowserImpl::SortItem &ShellBrowserImpl::GetCachedSortItem(int internalIndex) const
+{
+	InvalidateSortItemCacheIfNecessary();
+
+	auto itr = m_directoryState.sortItemCache.find(internalIndex);
+
+	if (itr == m_directoryState.sortItemCache.end())
+	{
+		itr = m_directoryState.sortItemCache.emplace(internalIndex, BuildSortItem(internalIndex))
+				  .first;
+	}
+
+	return itr->second;
+}
+
+/* Also see NBookmarkHelper::Sort. */
+int ShellBrowserImpl::CompareSortItems(const SortItem &item1, const SortItem &item2,
+	bool sortFoldersSeparately) const
+{
+	int comparisonResult = 0;
+
+	if (sortFoldersSeparately && item1.isFolder && !item2.isFolder)
 	{
 		comparisonResult = -1;
 	}
-	else if (!m_config->globalFolderSettings.displayMixedFilesAndFolders && !isFolder1 && isFolder2
-		&& !CompareVirtualFolders(CSIDL_BITBUCKET))
+	else if (sortFoldersSeparately && !item1.isFolder && item2.isFolder)
 	{
 		comparisonResult = 1;
 	}
 	else
 	{
-		switch (m_folderSettings.sortMode)
+		StringComparison stringComparison = StringComparison::Logical;
+
+		if (m_folderSettings.sortMode == +SortMode::Name
+			&& !m_config->globalFolderSettings.useNaturalSortOrder)
 		{
-		case SortMode::Name:
-			comparisonResult =
-				SortByName(basicItemInfo1, basicItemInfo2, m_config->globalFolderSettings);
-			break;
-
-		case SortMode::Type:
-			comparisonResult = SortByType(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::Size:
-			comparisonResult = SortBySize(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::DateModified:
-			comparisonResult = SortByDate(basicItemInfo1, basicItemInfo2, DateType::Modified);
-			break;
-
-		case SortMode::TotalSize:
-			comparisonResult = SortByTotalSize(basicItemInfo1, basicItemInfo2, TRUE);
-			break;
-
-		case SortMode::FreeSpace:
-			comparisonResult = SortByTotalSize(basicItemInfo1, basicItemInfo2, FALSE);
-			break;
-
-		case SortMode::DateDeleted:
-			comparisonResult =
-				SortByItemDetails(basicItemInfo1, basicItemInfo2, &SCID_DATE_DELETED);
-			break;
-
-		case SortMode::OriginalLocation:
-			comparisonResult =
-				SortByItemDetails(basicItemInfo1, basicItemInfo2, &SCID_ORIGINAL_LOCATION);
-			break;
-
-		case SortMode::Attributes:
-			comparisonResult = SortByAttributes(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::RealSize:
-			comparisonResult = SortByRealSize(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::ShortName:
-			comparisonResult = SortByShortName(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::Owner:
-			comparisonResult = SortByOwner(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::ProductName:
-			comparisonResult =
-				SortByVersionInfo(basicItemInfo1, basicItemInfo2, VersionInfoType::ProductName);
-			break;
-
-		case SortMode::Company:
-			comparisonResult =
-				SortByVersionInfo(basicItemInfo1, basicItemInfo2, VersionInfoType::Company);
-			break;
-
-		case SortMode::Description:
-			comparisonResult =
-				SortByVersionInfo(basicItemInfo1, basicItemInfo2, VersionInfoType::Description);
-			break;
-
-		case SortMode::FileVersion:
-			comparisonResult =
-				SortByVersionInfo(basicItemInfo1, basicItemInfo2, VersionInfoType::FileVersion);
-			break;
-
-		case SortMode::ProductVersion:
-			comparisonResult =
-				SortByVersionInfo(basicItemInfo1, basicItemInfo2, VersionInfoType::ProductVersion);
-			break;
-
-		case SortMode::ShortcutTo:
-			comparisonResult = SortByShortcutTo(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::HardLinks:
-			comparisonResult = SortByHardlinks(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::Extension:
-			comparisonResult = SortByExtension(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::Created:
-			comparisonResult = SortByDate(basicItemInfo1, basicItemInfo2, DateType::Created);
-			break;
-
-		case SortMode::Accessed:
-			comparisonResult = SortByDate(basicItemInfo1, basicItemInfo2, DateType::Accessed);
-			break;
-
-		case SortMode::Title:
-			comparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &PKEY_Title);
-			break;
-
-		case SortMode::Subject:
-			comparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &PKEY_Subject);
-			break;
-
-		case SortMode::Authors:
-			comparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &PKEY_Author);
-			break;
-
-		case SortMode::Keywords:
-			comparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &PKEY_Keywords);
-			break;
-
-		case SortMode::Comments:
-			comparisonResult = SortByItemDetails(basicItemInfo1, basicItemInfo2, &PKEY_Comment);
-			break;
-
-		case SortMode::CameraModel:
-			comparisonResult =
-				SortByImageProperty(basicItemInfo1, basicItemInfo2, PropertyTagEquipModel);
-			break;
-
-		case SortMode::DateTaken:
-			comparisonResult =
-				SortByImageProperty(basicItemInfo1, basicItemInfo2, PropertyTagDateTime);
-			break;
-
-		case SortMode::Width:
-			comparisonResult =
-				SortByImageProperty(basicItemInfo1, basicItemInfo2, PropertyTagImageWidth);
-			break;
-
-		case SortMode::Height:
-			comparisonResult =
-				SortByImageProperty(basicItemInfo1, basicItemInfo2, PropertyTagImageHeight);
-			break;
-
-		case SortMode::VirtualComments:
-			comparisonResult = SortByVirtualComments(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::FileSystem:
-			comparisonResult = SortByFileSystem(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::NumPrinterDocuments:
-			comparisonResult = SortByPrinterProperty(basicItemInfo1, basicItemInfo2,
-				PrinterInformationType::NumJobs);
-			break;
-
-		case SortMode::PrinterStatus:
-			comparisonResult = SortByPrinterProperty(basicItemInfo1, basicItemInfo2,
-				PrinterInformationType::Status);
-			break;
-
-		case SortMode::PrinterComments:
-			comparisonResult = SortByPrinterProperty(basicItemInfo1, basicItemInfo2,
-				PrinterInformationType::Comments);
-			break;
-
-		case SortMode::PrinterLocation:
-			comparisonResult = SortByPrinterProperty(basicItemInfo1, basicItemInfo2,
-				PrinterInformationType::Location);
-			break;
-
-		case SortMode::NetworkAdapterStatus:
-			comparisonResult = SortByNetworkAdapterStatus(basicItemInfo1, basicItemInfo2);
-			break;
-
-		case SortMode::MediaBitrate:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Bitrate);
-			break;
-
-		case SortMode::MediaCopyright:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Copyright);
-			break;
-
-		case SortMode::MediaDuration:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Duration);
-			break;
-
-		case SortMode::MediaProtected:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Protected);
-			break;
-
-		case SortMode::MediaRating:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Rating);
-			break;
-
-		case SortMode::MediaAlbumArtist:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::AlbumArtist);
-			break;
-
-		case SortMode::MediaAlbum:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::AlbumTitle);
-			break;
-
-		case SortMode::MediaBeatsPerMinute:
-			comparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,
-				MediaMetadataType::BeatsPerMinute);
-			break;
-
-		case SortMode::MediaComposer:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Composer);
-			break;
-
-		case SortMode::MediaConductor:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Conductor);
-			break;
-
-		case SortMode::MediaDirector:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Director);
-			break;
-
-		case SortMode::MediaGenre:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Genre);
-			break;
-
-		case SortMode::MediaLanguage:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Language);
-			break;
-
-		case SortMode::MediaBroadcastDate:
-			comparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,
-				MediaMetadataType::BroadcastDate);
-			break;
-
-		case SortMode::MediaChannel:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Channel);
-			break;
-
-		case SortMode::MediaStationName:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::StationName);
-			break;
-
-		case SortMode::MediaMood:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Mood);
-			break;
-
-		case SortMode::MediaParentalRating:
-			comparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,
-				MediaMetadataType::ParentalRating);
-			break;
-
-		case SortMode::MediaParentalRatingReason:
-			comparisonResult = SortByMediaMetadata(basicItemInfo1, basicItemInfo2,
-				MediaMetadataType::ParentalRatingReason);
-			break;
-
-		case SortMode::MediaPeriod:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Period);
-			break;
-
-		case SortMode::MediaProducer:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Producer);
-			break;
-
-		case SortMode::MediaPublisher:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Publisher);
-			break;
-
-		case SortMode::MediaWriter:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Writer);
-			break;
-
-		case SortMode::MediaYear:
-			comparisonResult =
-				SortByMediaMetadata(basicItemInfo1, basicItemInfo2, MediaMetadataType::Year);
-			break;
-
-		default:
-			assert(false);
-			break;
+			stringComparison = StringComparison::CaseInsensitive;
 		}
+
+		comparisonResult = CompareSortKeys(item1.key, item2.key, stringComparison);
 	}
 
 	if (comparisonResult == 0)
 	{
 		/* By default, items that are equal will be sub-sorted
 		by their display names. */
-		if (m_config->globalFolderSettings.useNaturalSortOrder)
-		{
-			comparisonResult =
-				StrCmpLogicalW(basicItemInfo1.szDisplayName, basicItemInfo2.szDisplayName);
-		}
-		else
-		{
-			comparisonResult = StrCmpIW(basicItemInfo1.szDisplayName, basicItemInfo2.szDisplayName);
-		}
+		comparisonResult = CompareStrings(item1.displayName, item2.displayName,
+			m_config->globalFolderSettings.useNaturalSortOrder ? StringComparison::Logical
+															   : StringComparison::CaseInsensitive);
 	}
 
 	if (m_folderSettings.sortDirection == +SortDirection::Descending)
@@ -378,3 +318,11 @@ int CALLBACK ShellBrowserImpl::Sort(int InternalIndex1, int InternalIndex2) cons
 
 	return comparisonResult;
 }
+
+bool ShellBrowserImpl::ShouldSortFoldersSeparately() const
+{
+	/* Folders will by default be sorted separately from files,
+	except in the recycle bin. */
+	return !m_config->globalFolderSettings.displayMixedFilesAndFolders
+		&& !CompareVirtualFolders(CSIDL_BITBUCKET);
+}
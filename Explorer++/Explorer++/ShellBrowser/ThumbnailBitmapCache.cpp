@@ -0,0 +1,137 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ThumbnailBitmapCache.h"
+
+ThumbnailBitmapCache::ThumbnailBitmapCache(size_t maxSize, size_t maxEntries) :
+	m_maxSize(maxSize),
+	m_maxEntries(maxEntries)
+{
+}
+
+HBITMAP ThumbnailBitmapCache::MaybeGetThumbnail(int internalIndex, int thumbnailSize)
+{
+	auto itemItr = m_itemEntries.find(internalIndex);
+
+	if (itemItr == m_itemEntries.end())
+	{
+		return nullptr;
+	}
+
+	auto entryItr = itemItr->second.find(thumbnailSize);
+
+	if (entryItr == itemItr->second.end())
+	{
+		return nullptr;
+	}
+
+	m_entries.splice(m_entries.begin(), m_entries, entryItr->second);
+
+	return entryItr->second->bitmap.get();
+}
+
+void ThumbnailBitmapCache::SetThumbnail(int internalIndex, int thumbnailSize,
+	wil::unique_hbitmap bitmap)
+{
+	size_t bitmapSize = GetBitmapSize(bitmap.get());
+
+	if (bitmapSize > m_maxSize || m_maxEntries == 0)
+	{
+		return;
+	}
+
+	auto &itemEntries = m_itemEntries[internalIndex];
+	auto entryItr = itemEntries.find(thumbnailSize);
+
+	if (entryItr != itemEntries.end())
+	{
+		m_size -= entryItr->second->bitmapSize;
+		entryItr->second->bitmap = std::move(bitmap);
+		entryItr->second->bitmapSize = bitmapSize;
+		m_entries.splice(m_entries.begin(), m_entries, entryItr->second);
+	}
+	else
+	{
+		m_entries.push_front({ internalIndex, thumbnailSize, std::move(bitmap), bitmapSize });
+		itemEntries.emplace(thumbnailSize, m_entries.begin());
+	}
+
+	m_size += bitmapSize;
+
+	RemoveLeastRecentlyUsedEntries();
+}
+
+void ThumbnailBitmapCache::InvalidateItem(int internalIndex)
+{
+	auto itemItr = m_itemEntries.find(internalIndex);
+
+	if (itemItr == m_itemEntries.end())
+	{
+		return;
+	}
+
+	for (const auto &[thumbnailSize, entryItr] : itemItr->second)
+	{
+		m_size -= entryItr->bitmapSize;
+		m_entries.erase(entryItr);
+	}
+
+	m_itemEntries.erase(itemItr);
+}
+
+void ThumbnailBitmapCache::Clear()
+{
+	m_entries.clear();
+	m_itemEntries.clear();
+	m_size = 0;
+}
+
+size_t ThumbnailBitmapCache::GetSize() const
+{
+	return m_size;
+}
+
+size_t ThumbnailBitmapCache::GetNumEntries() const
+{
+	return m_entries.size();
+}
+
+size_t ThumbnailBitmapCache::GetBitmapSize(HBITMAP bitmap)
+{
+	BITMAP bitmapInfo;
+	int res = GetObject(bitmap, sizeof(bitmapInfo), &bitmapInfo);
+
+	if (res == 0)
+	{
+		DCHECK(false);
+		return 0;
+	}
+
+	return static_cast<size_t>(bitmapInfo.bmWidthBytes) * bitmapInfo.bmHeight;
+}
+
+void ThumbnailBitmapCache::RemoveEntry(EntryList::iterator itr)
+{
+	auto itemItr = m_itemEntries.find(itr->internalIndex);
+	CHECK(itemItr != m_itemEntries.end());
+
+	itemItr->second.erase(itr->thumbnailSize);
+
+	if (itemItr->second.empty())
+	{
+		m_itemEntries.erase(itemItr);
+	}
+
+	m_size -= itr->bitmapSize;
+	m_entries.erase(itr);
+}
+
+void ThumbnailBitmapCache::RemoveLeastRecentlyUsedEntries()
+{
+	while (m_size > m_maxSize || m_entries.size() > m_maxEntries)
+	{
+		RemoveEntry(std::prev(m_entries.end()));
+	}
+}
@@ -0,0 +1,65 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <wil/resource.h>
+#include <list>
+#include <unordered_map>
+
+// Caches the thumbnail bitmaps that have been retrieved for the items in a folder, keyed by item
+// and thumbnail size. That means an item that's redisplayed (e.g. after scrolling back to it, once
+// its image list slot has been reused) can be drawn immediately, without going back to the system
+// thumbnail cache.
+//
+// Both the total size of the bitmaps stored and the number of bitmaps are limited. Once either
+// limit is reached, the least recently used entries are removed.
+class ThumbnailBitmapCache
+{
+public:
+	// The maximum size is the total number of bytes of bitmap data that will be stored.
+	ThumbnailBitmapCache(size_t maxSize, size_t maxEntries);
+
+	ThumbnailBitmapCache(const ThumbnailBitmapCache &) = delete;
+	ThumbnailBitmapCache &operator=(const ThumbnailBitmapCache &) = delete;
+
+	// The returned bitmap is owned by the cache and is only valid until the cache is next
+	// modified.
+	HBITMAP MaybeGetThumbnail(int internalIndex, int thumbnailSize);
+	void SetThumbnail(int internalIndex, int thumbnailSize, wil::unique_hbitmap bitmap);
+
+	// Removes the cached thumbnails of every size for the item.
+	void InvalidateItem(int internalIndex);
+
+	void Clear();
+
+	size_t GetSize() const;
+	size_t GetNumEntries() const;
+
+private:
+	struct Entry
+	{
+		int internalIndex;
+		int thumbnailSize;
+		wil::unique_hbitmap bitmap;
+		size_t bitmapSize;
+	};
+
+	// The most recently used entry is at the front.
+	using EntryList = std::list<Entry>;
+
+	static size_t GetBitmapSize(HBITMAP bitmap);
+
+	void RemoveEntry(EntryList::iterator itr);
+	void RemoveLeastRecentlyUsedEntries();
+
+	const size_t m_maxSize;
+	const size_t m_maxEntries;
+	EntryList m_entries;
+
+	// Maps each item to its entries, keyed by thumbnail size.
+	std::unordered_map<int, std::unordered_map<int, EntryList::iterator>> m_itemEntries;
+
+	size_t m_size = 0;
+};
@@ -0,0 +1,140 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ThumbnailSlotAllocator.h"
+
+ThumbnailSlotAllocator::ThumbnailSlotAllocator(int maxSlots) : m_maxSlots(maxSlots)
+{
+	CHECK(maxSlots > 0);
+}
+
+ThumbnailSlotAllocator::Allocation ThumbnailSlotAllocator::GetSlot(int internalIndex)
+{
+	auto itr = m_itemEntries.find(internalIndex);
+
+	if (itr != m_itemEntries.end())
+	{
+		m_numHits++;
+		m_entries.splice(m_entries.begin(), m_entries, itr->second);
+		return { itr->second->slot, false, std::nullopt };
+	}
+
+	m_numMisses++;
+
+	Allocation allocation;
+	allocation.slot = TakeSlot(allocation.evictedItem, allocation.newSlot);
+
+	m_entries.push_front({ internalIndex, allocation.slot });
+	m_itemEntries.emplace(internalIndex, m_entries.begin());
+
+	return allocation;
+}
+
+int ThumbnailSlotAllocator::TakeSlot(std::optional<int> &evictedItem, bool &newSlot)
+{
+	newSlot = false;
+
+	if (!m_freeSlots.empty())
+	{
+		int slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+		return slot;
+	}
+
+	if (m_numSlots < m_maxSlots)
+	{
+		newSlot = true;
+		return m_numSlots++;
+	}
+
+	// Visible items are marked as used whenever the visible set changes, so they will typically be
+	// at the front of the list and this search will stop at the last entry.
+	auto itr = std::find_if(m_entries.rbegin(), m_entries.rend(),
+		[this](const Entry &entry) { return !m_visibleItems.contains(entry.internalIndex); });
+
+	if (itr == m_entries.rend())
+	{
+		// Every item that has a slot is visible, so the only option is to create a new slot.
+		newSlot = true;
+		return m_numSlots++;
+	}
+
+	int slot = itr->slot;
+	evictedItem = itr->internalIndex;
+
+	m_itemEntries.erase(itr->internalIndex);
+	m_entries.erase(std::next(itr).base());
+	m_numEvictions++;
+
+	return slot;
+}
+
+void ThumbnailSlotAllocator::MarkItemUsed(int internalIndex)
+{
+	auto itr = m_itemEntries.find(internalIndex);
+
+	if (itr == m_itemEntries.end())
+	{
+		return;
+	}
+
+	m_entries.splice(m_entries.begin(), m_entries, itr->second);
+}
+
+void ThumbnailSlotAllocator::SetVisibleItems(const std::unordered_set<int> &visibleItems)
+{
+	m_visibleItems = visibleItems;
+
+	for (int internalIndex : visibleItems)
+	{
+		MarkItemUsed(internalIndex);
+	}
+}
+
+void ThumbnailSlotAllocator::ReleaseItem(int internalIndex)
+{
+	m_visibleItems.erase(internalIndex);
+
+	auto itr = m_itemEntries.find(internalIndex);
+
+	if (itr == m_itemEntries.end())
+	{
+		return;
+	}
+
+	m_freeSlots.push_back(itr->second->slot);
+	m_entries.erase(itr->second);
+	m_itemEntries.erase(itr);
+}
+
+int ThumbnailSlotAllocator::GetMaxSlots() const
+{
+	return m_maxSlots;
+}
+
+int ThumbnailSlotAllocator::GetNumSlots() const
+{
+	return m_numSlots;
+}
+
+int ThumbnailSlotAllocator::GetNumAssignedItems() const
+{
+	return static_cast<int>(m_itemEntries.size());
+}
+
+size_t ThumbnailSlotAllocator::GetNumHits() const
+{
+	return m_numHits;
+}
+
+size_t ThumbnailSlotAllocator::GetNumMisses() const
+{
+	return m_numMisses;
+}
+
+size_t ThumbnailSlotAllocator::GetNumEvictions() const
+{
+	return m_numEvictions;
+}
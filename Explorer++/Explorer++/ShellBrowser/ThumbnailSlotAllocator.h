@@ -0,0 +1,90 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// In thumbnails mode, each item that's displayed has its thumbnail drawn into a slot in the
+// listview image list. Since each slot holds a full-size thumbnail, the number of slots is limited.
+// Once every slot is in use, the slot belonging to the least recently used item is reassigned. The
+// item that lost its slot will then have its thumbnail requested again if it's redisplayed.
+//
+// Slots are never taken from items that are currently visible, since those items would simply
+// request their thumbnails again, taking a slot from another visible item in turn. If more items
+// are visible than there are slots, additional slots will be created instead.
+//
+// This class only tracks which item is assigned to which slot. It's up to the caller to update the
+// image list.
+class ThumbnailSlotAllocator
+{
+public:
+	struct Allocation
+	{
+		int slot;
+
+		// True if this is a slot that hasn't been used before, in which case an image will need to
+		// be appended to the image list. Otherwise, the existing image in the slot should be
+		// replaced.
+		bool newSlot;
+
+		// If the slot was taken from another item, this will contain that item.
+		std::optional<int> evictedItem;
+	};
+
+	explicit ThumbnailSlotAllocator(int maxSlots);
+
+	ThumbnailSlotAllocator(const ThumbnailSlotAllocator &) = delete;
+	ThumbnailSlotAllocator &operator=(const ThumbnailSlotAllocator &) = delete;
+
+	// Returns the slot assigned to the item, assigning a slot if the item doesn't already have one.
+	// In either case, the item will be marked as the most recently used.
+	Allocation GetSlot(int internalIndex);
+
+	// Marks the item as the most recently used, if it has a slot. That's useful for items that are
+	// still visible, but haven't been redrawn recently.
+	void MarkItemUsed(int internalIndex);
+
+	// Replaces the set of visible items and marks each of them as used.
+	void SetVisibleItems(const std::unordered_set<int> &visibleItems);
+
+	// Releases the item's slot (if it has one), so that it can be assigned to another item.
+	void ReleaseItem(int internalIndex);
+
+	int GetMaxSlots() const;
+	int GetNumSlots() const;
+	int GetNumAssignedItems() const;
+
+	size_t GetNumHits() const;
+	size_t GetNumMisses() const;
+	size_t GetNumEvictions() const;
+
+private:
+	struct Entry
+	{
+		int internalIndex;
+		int slot;
+	};
+
+	// The most recently used entry is at the front.
+	using EntryList = std::list<Entry>;
+
+	int TakeSlot(std::optional<int> &evictedItem, bool &newSlot);
+
+	const int m_maxSlots;
+	int m_numSlots = 0;
+	std::vector<int> m_freeSlots;
+
+	EntryList m_entries;
+	std::unordered_map<int, EntryList::iterator> m_itemEntries;
+	std::unordered_set<int> m_visibleItems;
+
+	size_t m_numHits = 0;
+	size_t m_numMisses = 0;
+	size_t m_numEvictions = 0;
+};
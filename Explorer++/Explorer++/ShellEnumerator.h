@@ -6,15 +6,38 @@
 
 #include "ShellItemFilter.h"
 #include "../Helper/Pidl.h"
+#include <functional>
 #include <stop_token>
 #include <vector>
 
 class ShellEnumerator
 {
 public:
+	using BatchCallback = std::function<void(std::vector<PidlChild> items)>;
+
 	virtual ~ShellEnumerator() = default;
 
 	virtual HRESULT EnumerateDirectory(PCIDLIST_ABSOLUTE pidlDirectory,
 		ShellItemFilter::ItemType itemType, ShellItemFilter::HiddenItemPolicy hiddenItemPolicy,
 		std::vector<PidlChild> &outputItems, std::stop_token stopToken) const = 0;
+
+	// Enumerates the directory in the same way as EnumerateDirectory(), but passes the items to
+	// `batchCallback` as they're retrieved, rather than only once the enumeration has finished.
+	// The callback is invoked on the calling thread. By default, all the items are passed on in a
+	// single batch.
+	virtual HRESULT EnumerateDirectoryInBatches(PCIDLIST_ABSOLUTE pidlDirectory,
+		ShellItemFilter::ItemType itemType, ShellItemFilter::HiddenItemPolicy hiddenItemPolicy,
+		const BatchCallback &batchCallback, std::stop_token stopToken) const
+	{
+		std::vector<PidlChild> items;
+		HRESULT hr =
+			EnumerateDirectory(pidlDirectory, itemType, hiddenItemPolicy, items, stopToken);
+
+		if (!items.empty())
+		{
+			batchCallback(std::move(items));
+		}
+
+		return hr;
+	}
 };
@@ -6,6 +6,8 @@
 #include "ShellEnumeratorImpl.h"
 #include "../Helper/ShellHelper.h"
 #include <wil/common.h>
+#include <algorithm>
+#include <iterator>
 
 ShellEnumeratorImpl::ShellEnumeratorImpl(HWND embedder) : m_embedder(embedder)
 {
@@ -14,6 +16,16 @@ ShellEnumeratorImpl::ShellEnumeratorImpl(HWND embedder) : m_embedder(embedder)
 HRESULT ShellEnumeratorImpl::EnumerateDirectory(PCIDLIST_ABSOLUTE pidlDirectory,
 	ShellItemFilter::ItemType itemType, ShellItemFilter::HiddenItemPolicy hiddenItemPolicy,
 	std::vector<PidlChild> &outputItems, std::stop_token stopToken) const
+{
+	return EnumerateDirectoryInBatches(pidlDirectory, itemType, hiddenItemPolicy,
+		[&outputItems](std::vector<PidlChild> items)
+		{ std::ranges::move(items, std::back_inserter(outputItems)); },
+		stopToken);
+}
+
+HRESULT ShellEnumeratorImpl::EnumerateDirectoryInBatches(PCIDLIST_ABSOLUTE pidlDirectory,
+	ShellItemFilter::ItemType itemType, ShellItemFilter::HiddenItemPolicy hiddenItemPolicy,
+	const BatchCallback &batchCallback, std::stop_token stopToken) const
 {
 	wil::com_ptr_nothrow<IShellFolder> shellFolder;
 	RETURN_IF_FAILED(SHBindToObject(nullptr, pidlDirectory, nullptr, IID_PPV_ARGS(&shellFolder)));
@@ -44,13 +56,20 @@ HRESULT ShellEnumeratorImpl::EnumerateDirectory(PCIDLIST_ABSOLUTE pidlDirectory,
 		return hr;
 	}
 
-	ULONG numFetched = 1;
-	unique_pidl_child pidlItem;
-
-	while (!stopToken.stop_requested()
-		&& enumerator->Next(1, wil::out_param(pidlItem), &numFetched) == S_OK && (numFetched == 1))
+	while (!stopToken.stop_requested())
 	{
-		outputItems.emplace_back(pidlItem.get());
+		std::vector<PidlChild> items;
+		hr = GetNextEnumeratedItems(enumerator.get(), ENUMERATION_BATCH_SIZE, items);
+
+		if (!items.empty())
+		{
+			batchCallback(std::move(items));
+		}
+
+		if (hr != S_OK)
+		{
+			break;
+		}
 	}
 
 	return S_OK;
@@ -14,7 +14,13 @@ public:
 	HRESULT EnumerateDirectory(PCIDLIST_ABSOLUTE pidlDirectory, ShellItemFilter::ItemType itemType,
 		ShellItemFilter::HiddenItemPolicy hiddenItemPolicy, std::vector<PidlChild> &outputItems,
 		std::stop_token stopToken) const override;
+	HRESULT EnumerateDirectoryInBatches(PCIDLIST_ABSOLUTE pidlDirectory,
+		ShellItemFilter::ItemType itemType, ShellItemFilter::HiddenItemPolicy hiddenItemPolicy,
+		const BatchCallback &batchCallback, std::stop_token stopToken) const override;
 
 private:
+	// The maximum number of items that will be requested from the enumerator at once.
+	static constexpr ULONG ENUMERATION_BATCH_SIZE = 256;
+
 	const HWND m_embedder;
 };
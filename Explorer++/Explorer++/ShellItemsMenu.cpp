@@ -31,29 +31,72 @@ void ShellItemsMenu::RebuildMenu(const std::vector<PidlAbsolute> &pidls)
 {
 	m_menuView->ClearMenu();
 	m_idCounter = GetIdRange().startId;
+	m_releasedIds.clear();
 	m_idPidlMap.clear();
 
 	for (const auto &pidl : pidls)
 	{
-		AddMenuItemForPidl(pidl.Raw());
+		auto id = InsertItem(static_cast<int>(m_idPidlMap.size()), pidl);
+
+		if (!id)
+		{
+			break;
+		}
 	}
 }
 
-void ShellItemsMenu::AddMenuItemForPidl(PCIDLIST_ABSOLUTE pidl)
+std::optional<UINT> ShellItemsMenu::InsertItem(int position, const PidlAbsolute &pidl)
 {
-	auto id = m_idCounter++;
+	auto id = MaybeAllocateId();
 
-	if (id >= GetIdRange().endId)
+	if (!id)
 	{
-		return;
+		return std::nullopt;
 	}
 
-	m_menuView->AppendItem(id, GetDisplayNameWithFallback(pidl, SHGDN_NORMAL),
-		std::make_unique<ShellIconModel>(m_shellIconLoader, pidl),
-		GetFolderPathForDisplayWithFallback(pidl));
+	m_menuView->InsertItem(position, *id, GetDisplayNameWithFallback(pidl.Raw(), SHGDN_NORMAL),
+		std::make_unique<ShellIconModel>(m_shellIconLoader, pidl.Raw()),
+		GetFolderPathForDisplayWithFallback(pidl.Raw()));
 
-	auto [itr, didInsert] = m_idPidlMap.insert({ id, pidl });
+	auto [itr, didInsert] = m_idPidlMap.insert({ *id, pidl });
 	DCHECK(didInsert);
+
+	return id;
+}
+
+void ShellItemsMenu::MoveItem(UINT id, int newPosition)
+{
+	DCHECK(m_idPidlMap.contains(id));
+	m_menuView->MoveItem(id, newPosition);
+}
+
+void ShellItemsMenu::RemoveItem(UINT id)
+{
+	auto numErased = m_idPidlMap.erase(id);
+	CHECK_EQ(numErased, 1u);
+
+	m_menuView->RemoveItem(id);
+	m_releasedIds.push_back(id);
+}
+
+std::optional<UINT> ShellItemsMenu::MaybeAllocateId()
+{
+	if (m_idCounter < GetIdRange().endId)
+	{
+		return m_idCounter++;
+	}
+
+	// Released IDs are only reused once the rest of the range has been used, and then in the order
+	// they were released. An item's icon can be updated asynchronously, so immediately reusing an
+	// ID could result in an update meant for a removed item being applied to a new item.
+	if (!m_releasedIds.empty())
+	{
+		UINT id = m_releasedIds.front();
+		m_releasedIds.pop_front();
+		return id;
+	}
+
+	return std::nullopt;
 }
 
 void ShellItemsMenu::OnMenuItemSelected(UINT menuItemId, bool isCtrlKeyDown, bool isShiftKeyDown)
@@ -6,6 +6,8 @@
 
 #include "MenuBase.h"
 #include "../Helper/Pidl.h"
+#include <deque>
+#include <optional>
 
 class BrowserWindow;
 class ShellIconLoader;
@@ -23,8 +25,15 @@ public:
 
 	void RebuildMenu(const std::vector<PidlAbsolute> &pidls);
 
+protected:
+	// Inserts an item for the pidl at the specified position, returning the ID of the item. If
+	// there are no IDs left in the menu's range, the item won't be inserted.
+	std::optional<UINT> InsertItem(int position, const PidlAbsolute &pidl);
+	void MoveItem(UINT id, int newPosition);
+	void RemoveItem(UINT id);
+
 private:
-	void AddMenuItemForPidl(PCIDLIST_ABSOLUTE pidl);
+	std::optional<UINT> MaybeAllocateId();
 
 	void OnMenuItemSelected(UINT menuItemId, bool isCtrlKeyDown, bool isShiftKeyDown);
 	void OnMenuItemMiddleClicked(UINT menuItemId, bool isCtrlKeyDown, bool isShiftKeyDown);
@@ -34,6 +43,10 @@ private:
 	BrowserWindow *const m_browserWindow;
 	ShellIconLoader *const m_shellIconLoader;
 	UINT m_idCounter;
+
+	// IDs that were previously allocated to items that have since been removed.
+	std::deque<UINT> m_releasedIds;
+
 	std::unordered_map<UINT, PidlAbsolute> m_idPidlMap;
 
 	std::vector<boost::signals2::scoped_connection> m_connections;
@@ -7,6 +7,7 @@
 #include "App.h"
 #include "FeatureList.h"
 #include "ShellTreeNode.h"
+#include "../Helper/AutoReset.h"
 #include "../Helper/ScopedRedrawDisabler.h"
 
 void ShellTreeView::StartDirectoryMonitoringForNode(ShellTreeNode *node)
@@ -65,6 +66,18 @@ void ShellTreeView::RestartDirectoryMonitoringForNode(ShellTreeNode *node)
 void ShellTreeView::ProcessDirectoryChangeNotification(DirectoryWatcher::Event event,
 	const PidlAbsolute &simplePidl1, const PidlAbsolute &simplePidl2)
 {
+	if (event == DirectoryWatcher::Event::Added || event == DirectoryWatcher::Event::Renamed
+		|| event == DirectoryWatcher::Event::Removed)
+	{
+		auto *expansionRequest = MaybeGetExpansionRequestForChild(simplePidl1.Raw());
+
+		if (expansionRequest)
+		{
+			expansionRequest->queuedDirectoryChanges.emplace_back(event, simplePidl1, simplePidl2);
+			return;
+		}
+	}
+
 	switch (event)
 	{
 	case DirectoryWatcher::Event::Added:
@@ -89,14 +102,67 @@ void ShellTreeView::ProcessDirectoryChangeNotification(DirectoryWatcher::Event e
 	}
 }
 
+// Returns the expansion request for the item's parent, if the parent is currently being expanded in
+// the background.
+ShellTreeView::ExpansionRequest *ShellTreeView::MaybeGetExpansionRequestForChild(
+	PCIDLIST_ABSOLUTE simplePidl)
+{
+	if (m_expansionRequests.empty())
+	{
+		return nullptr;
+	}
+
+	unique_pidl_absolute parent(ILCloneFull(simplePidl));
+
+	if (!ILRemoveLastID(parent.get()))
+	{
+		return nullptr;
+	}
+
+	auto parentItem = LocateExistingItem(parent.get());
+
+	if (!parentItem)
+	{
+		return nullptr;
+	}
+
+	auto itr = m_expansionRequests.find(GetNodeFromTreeViewItem(parentItem)->GetId());
+
+	if (itr == m_expansionRequests.end())
+	{
+		return nullptr;
+	}
+
+	return &itr->second;
+}
+
+// The changes were made while the parent folder was being enumerated, so the enumeration may or
+// may not have picked them up already.
+void ShellTreeView::ApplyQueuedDirectoryChanges(const std::vector<QueuedDirectoryChange> &changes)
+{
+	for (const auto &change : changes)
+	{
+		if (change.event == DirectoryWatcher::Event::Renamed
+			&& LocateExistingItem(change.simplePidl2.Raw()))
+		{
+			// The item was enumerated under its new name, so any entry for the old name is stale.
+			OnItemRemoved(change.simplePidl1.Raw());
+			continue;
+		}
+
+		ProcessDirectoryChangeNotification(change.event, change.simplePidl1, change.simplePidl2);
+	}
+}
+
 void ShellTreeView::OnItemAdded(PCIDLIST_ABSOLUTE simplePidl)
 {
 	auto existingItem = LocateExistingItem(simplePidl);
 
-	// Items shouldn't be added more than once.
+	// Directory monitoring starts before a folder is enumerated, so an item that's reported as
+	// added may already have been found by the enumeration. Items shouldn't be added more than
+	// once.
 	if (existingItem)
 	{
-		assert(false);
 		return;
 	}
 
@@ -174,11 +240,12 @@ void ShellTreeView::OnItemUpdated(PCIDLIST_ABSOLUTE simplePidl, PCIDLIST_ABSOLUT
 	ShellTreeNode *node = GetNodeFromTreeViewItem(item);
 	node->UpdateItemDetails(currentPidl);
 
-	// Directory monitoring only needs to be restarted if the parsing name changed. Updates to the
-	// display name aren't relevant.
+	// Directory monitoring and the node indexes only need to be updated if the parsing name
+	// changed. Updates to the display name aren't relevant.
 	if (simpleUpdatedPidl)
 	{
 		RestartDirectoryMonitoringForNodeAndChildren(node);
+		UpdateIndexesForNodeAndChildren(node);
 	}
 
 	// The display name might have changed, even if the item wasn't renamed, so the updated display
@@ -230,7 +297,9 @@ void ShellTreeView::OnItemRemoved(PCIDLIST_ABSOLUTE simplePidl)
 void ShellTreeView::RemoveItem(HTREEITEM item)
 {
 	auto *node = GetNodeFromTreeViewItem(item);
+	CancelExpansionsForNodeAndChildren(node);
 	StopDirectoryMonitoringForNodeAndChildren(node);
+	RemoveNodeAndChildrenFromIndexes(node);
 
 	auto parent = TreeView_GetParent(m_hTreeView, item);
 
@@ -303,14 +372,19 @@ void ShellTreeView::OnDirectoryUpdated(PCIDLIST_ABSOLUTE simplePidl)
 		selectedItemPidl = selectedNode->GetFullPidl();
 	}
 
+	CancelExpansionsForNodeAndChildren(quickAccessRootNode);
 	StopDirectoryMonitoringForNodeAndChildren(quickAccessRootNode);
-	quickAccessRootNode->RemoveAllChildren();
+	RemoveAllChildNodes(quickAccessRootNode);
 
 	SendMessage(m_hTreeView, TVM_EXPAND, TVE_COLLAPSE | TVE_COLLAPSERESET,
 		reinterpret_cast<LPARAM>(m_quickAccessRootItem));
 
-	SendMessage(m_hTreeView, TVM_EXPAND, TVE_EXPAND,
-		reinterpret_cast<LPARAM>(m_quickAccessRootItem));
+	{
+		// The previous selection is restored below, which requires the children to be present.
+		AutoReset expandSynchronously(&m_expandSynchronously, true);
+		SendMessage(m_hTreeView, TVM_EXPAND, TVE_EXPAND,
+			reinterpret_cast<LPARAM>(m_quickAccessRootItem));
+	}
 
 	if (selectedItemPidl)
 	{
@@ -20,7 +20,15 @@ HTREEITEM ShellTreeView::GetDropTargetItem(const POINT &pt)
 
 	TVHITTESTINFO hitTestInfo = {};
 	hitTestInfo.pt = ptClient;
-	return TreeView_HitTest(m_hTreeView, &hitTestInfo);
+	auto item = TreeView_HitTest(m_hTreeView, &hitTestInfo);
+
+	// Items can't be dropped on the placeholder item shown while a folder is being expanded.
+	if (IsPlaceholderItem(item))
+	{
+		return nullptr;
+	}
+
+	return item;
 }
 
 unique_pidl_absolute ShellTreeView::GetPidlForTargetItem(HTREEITEM targetItem)
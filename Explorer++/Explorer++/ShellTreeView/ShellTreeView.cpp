@@ -26,12 +26,16 @@
 #include "MainResource.h"
 #include "OpenItemsContextMenuDelegate.h"
 #include "ResourceLoader.h"
+#include "Runtime.h"
+#include "RuntimeHelper.h"
 #include "ShellBrowser/NavigateParams.h"
 #include "ShellBrowser/ShellBrowserImpl.h"
 #include "ShellBrowser/ShellNavigationController.h"
 #include "ShellTreeNode.h"
 #include "ShellTreeViewContextMenuDelegate.h"
 #include "TabContainer.h"
+#include "TaskScheduler.h"
+#include "../Helper/AutoReset.h"
 #include "../Helper/CachedIcons.h"
 #include "../Helper/Controls.h"
 #include "../Helper/DragDropHelper.h"
@@ -42,7 +46,11 @@
 #include "../Helper/ScopedRedrawDisabler.h"
 #include "../Helper/ShellHelper.h"
 #include "../Helper/ShellItemContextMenu.h"
+#include <fmt/format.h>
+#include <fmt/xchar.h>
 #include <wil/common.h>
+#include <algorithm>
+#include <iterator>
 #include <propkey.h>
 
 ShellTreeView *ShellTreeView::Create(HWND hParent, App *app, BrowserWindow *browser,
@@ -61,11 +69,9 @@ ShellTreeView::ShellTreeView(HWND hParent, App *app, BrowserWindow *browser,
 	m_fileActionHandler(fileActionHandler),
 	m_commandTarget(browser->GetCommandTargetManager(), this),
 	m_fontSetter(GetHWND(), app->GetConfig()),
-	m_iconThreadPool(1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED),
-		CoUninitialize),
+	m_iconTaskQueue(app->GetRuntime()->GetTaskScheduler()->CreateQueue(TaskPriority::High)),
 	m_iconResultIDCounter(0),
-	m_subfoldersThreadPool(1, std::bind(CoInitializeEx, nullptr, COINIT_APARTMENTTHREADED),
-		CoUninitialize),
+	m_subfoldersTaskQueue(app->GetRuntime()->GetTaskScheduler()->CreateQueue()),
 	m_subfoldersResultIDCounter(0),
 	m_cachedIcons(app->GetCachedIcons()),
 	m_dropExpandItem(nullptr)
@@ -147,7 +153,12 @@ ShellTreeView::~ShellTreeView()
 		clipboardStore->FlushDataObject();
 	}
 
-	m_iconThreadPool.clear_queue();
+	m_iconTaskQueue->Clear();
+
+	for (auto &[nodeId, request] : m_expansionRequests)
+	{
+		request.stopSource.request_stop();
+	}
 }
 
 LRESULT ShellTreeView::TreeViewProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
@@ -243,6 +254,9 @@ LRESULT ShellTreeView::ParentWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM
 			case TVN_ENDLABELEDIT:
 				return OnEndLabelEdit(reinterpret_cast<NMTVDISPINFO *>(lParam));
 
+			case TVN_SELCHANGING:
+				return OnSelectionChanging(reinterpret_cast<NMTREEVIEW *>(lParam));
+
 			case TVN_SELCHANGED:
 				OnSelectionChanged(reinterpret_cast<NMTREEVIEW *>(lParam));
 				break;
@@ -323,6 +337,8 @@ HTREEITEM ShellTreeView::AddRootItem(PCIDLIST_ABSOLUTE pidl, HTREEITEM insertAft
 {
 	auto rootItem = AddItem(nullptr, pidl, insertAfter);
 	assert(rootItem);
+
+	AutoReset expandSynchronously(&m_expandSynchronously, true);
 	SendMessage(m_hTreeView, TVM_EXPAND, TVE_EXPAND, reinterpret_cast<LPARAM>(rootItem));
 
 	return rootItem;
@@ -399,11 +415,9 @@ void ShellTreeView::QueueIconTask(HTREEITEM treeItem)
 
 	int iconResultID = m_iconResultIDCounter++;
 
-	auto result = m_iconThreadPool.push(
-		[this, iconResultID, nodeId = node->GetId(), treeItem, basicItemInfo](int id)
+	auto result = m_iconTaskQueue->Push(
+		[this, iconResultID, nodeId = node->GetId(), treeItem, basicItemInfo]
 		{
-			UNREFERENCED_PARAMETER(id);
-
 			return FindIconAsync(m_hTreeView, iconResultID, nodeId, treeItem,
 				basicItemInfo.pidl.get());
 		});
@@ -490,11 +504,9 @@ void ShellTreeView::QueueSubfoldersTask(HTREEITEM item)
 
 	int subfoldersResultID = m_subfoldersResultIDCounter++;
 
-	auto result = m_subfoldersThreadPool.push(
-		[this, subfoldersResultID, item, basicItemInfo](int id)
+	auto result = m_subfoldersTaskQueue->Push(
+		[this, subfoldersResultID, item, basicItemInfo]
 		{
-			UNREFERENCED_PARAMETER(id);
-
 			return CheckSubfoldersAsync(m_hTreeView, subfoldersResultID, item,
 				basicItemInfo.pidl.get());
 		});
@@ -662,8 +674,9 @@ void ShellTreeView::OnItemExpanding(const NMTREEVIEW *nmtv)
 		}
 
 		ShellTreeNode *parentNode = GetNodeFromTreeViewItem(parentItem);
+		CancelExpansionsForNodeAndChildren(parentNode);
 		StopDirectoryMonitoringForNodeAndChildren(parentNode);
-		parentNode->RemoveAllChildren();
+		RemoveAllChildNodes(parentNode);
 
 		SendMessage(m_hTreeView, TVM_EXPAND, TVE_COLLAPSE | TVE_COLLAPSERESET,
 			reinterpret_cast<LPARAM>(parentItem));
@@ -797,12 +810,175 @@ int CALLBACK ShellTreeView::CompareItems(LPARAM lParam1, LPARAM lParam2)
 	}
 }
 
-HRESULT ShellTreeView::ExpandDirectory(HTREEITEM hParent)
+void ShellTreeView::ExpandDirectory(HTREEITEM hParent)
+{
+	if (m_expandSynchronously)
+	{
+		ExpandDirectorySynchronously(hParent);
+	}
+	else
+	{
+		StartExpansionRequest(hParent);
+	}
+}
+
+HRESULT ShellTreeView::ExpandDirectorySynchronously(HTREEITEM hParent)
 {
 	auto pidlDirectory = GetNodePidl(hParent);
+	ShellTreeNode *parentNode = GetNodeFromTreeViewItem(hParent);
+
+	// Directory monitoring is started before the folder is enumerated, so that changes made during
+	// the enumeration aren't lost. If the folder was partially expanded in the background,
+	// monitoring will already be in place.
+	if (!parentNode->GetDirectoryWatcher())
+	{
+		StartDirectoryMonitoringForNode(parentNode);
+	}
+
+	std::vector<PidlAbsolute> items;
+	HRESULT hr = EnumerateChildFolders(pidlDirectory.get(), GetExpansionOptions(), {},
+		[&items](std::vector<PidlAbsolute> batch)
+		{ std::ranges::move(batch, std::back_inserter(items)); });
+
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	ScopedRedrawDisabler redrawDisabler(m_hTreeView);
+
+	// If the directory was partially expanded in the background, some of the children will already
+	// be present (and the user may have interacted with them), so only the remaining children are
+	// added. The existing children are indexed by parsing name, so that each enumerated item
+	// doesn't need to be compared against every existing child.
+	ParsingNameIndex existingChildren;
+
+	for (const auto &child : parentNode->GetChildren())
+	{
+		existingChildren.AddItem(m_nodeIdIndex.at(child->GetId()).parsingName, child->GetId());
+	}
+
+	for (const auto &item : items)
+	{
+		if (existingChildren.GetSize() > 0 && IsExistingChild(existingChildren, item.Raw()))
+		{
+			continue;
+		}
+
+		AddItem(hParent, item.Raw());
+	}
+
+	SortChildren(hParent);
+
+	return hr;
+}
+
+bool ShellTreeView::IsExistingChild(const ParsingNameIndex &existingChildren,
+	PCIDLIST_ABSOLUTE pidl) const
+{
+	std::wstring parsingName;
+	HRESULT hr = GetDisplayName(pidl, SHGDN_FORPARSING, parsingName);
+
+	if (FAILED(hr))
+	{
+		return false;
+	}
+
+	return std::ranges::any_of(existingChildren.GetItemsForParsingName(parsingName),
+		[this, pidl](int nodeId)
+		{ return ArePidlsEquivalent(m_nodeIdIndex.at(nodeId).node->GetFullPidl().get(), pidl); });
+}
+
+void ShellTreeView::StartExpansionRequest(HTREEITEM parentItem)
+{
+	auto *parentNode = GetNodeFromTreeViewItem(parentItem);
+	auto pidlDirectory = parentNode->GetFullPidl();
+
+	std::wstring loadingTemplate = m_app->GetResourceLoader()->LoadString(IDS_GENERAL_LOADING);
+	std::wstring loadingText = fmt::format(fmt::runtime(loadingTemplate),
+		fmt::arg(L"folder_name", GetDisplayNameWithFallback(pidlDirectory.get(), SHGDN_INFOLDER)));
+
+	// The placeholder isn't associated with a node, so its lParam is left as 0. It's shown as the
+	// last child, so that keyboard navigation into the folder reaches the items that have already
+	// been added. Items added as the expansion progresses are inserted before it.
+	TVITEMEX tvItem = {};
+	tvItem.mask = TVIF_TEXT | TVIF_IMAGE | TVIF_SELECTEDIMAGE | TVIF_PARAM | TVIF_CHILDREN;
+	tvItem.pszText = loadingText.data();
+	tvItem.iImage = m_iFolderIcon;
+	tvItem.iSelectedImage = m_iFolderIcon;
+	tvItem.lParam = 0;
+	tvItem.cChildren = 0;
+
+	TVINSERTSTRUCT tvInsertData = {};
+	tvInsertData.hInsertAfter = TVI_LAST;
+	tvInsertData.hParent = parentItem;
+	tvInsertData.itemex = tvItem;
+
+	auto placeholderItem = TreeView_InsertItem(m_hTreeView, &tvInsertData);
+	CHECK(placeholderItem);
+
+	int requestId = m_expansionRequestIdCounter++;
+
+	ExpansionRequest request;
+	request.requestId = requestId;
+	request.parentItem = parentItem;
+	request.placeholderItem = placeholderItem;
+	auto stopToken = request.stopSource.get_token();
 
+	// Any previous request for this node will have been cancelled when the node was collapsed.
+	[[maybe_unused]] auto [itr, inserted] =
+		m_expansionRequests.insert({ parentNode->GetId(), std::move(request) });
+	DCHECK(inserted);
+
+	// Changes made while the folder is being enumerated will be queued and applied once the
+	// expansion has finished.
+	StartDirectoryMonitoringForNode(parentNode);
+
+	ExpandDirectoryAsync(m_weakPtrFactory.GetWeakPtr(), m_app->GetRuntime(), parentNode->GetId(),
+		requestId, pidlDirectory.get(), GetExpansionOptions(), stopToken);
+}
+
+concurrencpp::null_result ShellTreeView::ExpandDirectoryAsync(WeakPtr<ShellTreeView> weakSelf,
+	Runtime *runtime, int nodeId, int requestId, PidlAbsolute directory, ExpansionOptions options,
+	std::stop_token stopToken)
+{
+	co_await ResumeOnComStaThread(runtime);
+
+	auto uiThreadExecutor = runtime->GetUiThreadExecutor();
+
+	// The enumerator has to be used on the thread it was created on, so each batch of items is
+	// posted back to the UI thread, rather than switching threads within the enumeration loop.
+	EnumerateChildFolders(directory.Raw(), options, stopToken,
+		[weakSelf, uiThreadExecutor, nodeId, requestId](std::vector<PidlAbsolute> batch)
+		{
+			uiThreadExecutor->post(
+				[weakSelf, nodeId, requestId, batch = std::move(batch)]
+				{
+					if (!weakSelf)
+					{
+						return;
+					}
+
+					weakSelf->OnExpansionItemsAvailable(nodeId, requestId, batch);
+				});
+		});
+
+	co_await ResumeOnUiThread(runtime);
+
+	if (!weakSelf)
+	{
+		co_return;
+	}
+
+	weakSelf->OnExpansionFinished(nodeId, requestId);
+}
+
+HRESULT ShellTreeView::EnumerateChildFolders(PCIDLIST_ABSOLUTE directory,
+	const ExpansionOptions &options, std::stop_token stopToken,
+	std::function<void(std::vector<PidlAbsolute>)> batchCallback)
+{
 	wil::com_ptr_nothrow<IShellFolder2> shellFolder2;
-	HRESULT hr = SHBindToObject(nullptr, pidlDirectory.get(), nullptr, IID_PPV_ARGS(&shellFolder2));
+	HRESULT hr = SHBindToObject(nullptr, directory, nullptr, IID_PPV_ARGS(&shellFolder2));
 
 	if (FAILED(hr))
 	{
@@ -811,7 +987,7 @@ HRESULT ShellTreeView::ExpandDirectory(HTREEITEM hParent)
 
 	SHCONTF enumFlags = SHCONTF_FOLDERS;
 
-	if (m_bShowHidden)
+	if (options.showHidden)
 	{
 		enumFlags |= SHCONTF_INCLUDEHIDDEN | SHCONTF_INCLUDESUPERHIDDEN;
 	}
@@ -824,52 +1000,209 @@ HRESULT ShellTreeView::ExpandDirectory(HTREEITEM hParent)
 		return hr;
 	}
 
-	ScopedRedrawDisabler redrawDisabler(m_hTreeView);
+	HRESULT enumerationResult;
 
-	std::vector<unique_pidl_absolute> items;
+	do
+	{
+		std::vector<PidlChild> enumeratedItems;
+		enumerationResult = GetNextEnumeratedItems(pEnumIDList.get(), ENUMERATION_BATCH_SIZE,
+			enumeratedItems);
 
-	unique_pidl_child pidlItem;
-	ULONG uFetched = 1;
+		std::vector<PidlAbsolute> batch;
 
-	while (pEnumIDList->Next(1, wil::out_param(pidlItem), &uFetched) == S_OK && (uFetched == 1))
-	{
-		if (m_config->checkPinnedToNamespaceTreeProperty)
+		for (const auto &pidlItem : enumeratedItems)
 		{
-			BOOL showItem = GetBooleanVariant(shellFolder2.get(), pidlItem.get(),
-				&PKEY_IsPinnedToNameSpaceTree, TRUE);
+			if (options.checkPinnedToNamespaceTree)
+			{
+				BOOL showItem = GetBooleanVariant(shellFolder2.get(), pidlItem.Raw(),
+					&PKEY_IsPinnedToNameSpaceTree, TRUE);
 
-			if (!showItem)
+				if (!showItem)
+				{
+					continue;
+				}
+			}
+
+			if (options.hideSystemFiles)
 			{
-				continue;
+				PCITEMID_CHILD child = pidlItem.Raw();
+				SFGAOF attributes = SFGAO_SYSTEM;
+				hr = shellFolder2->GetAttributesOf(1, &child, &attributes);
+
+				if (FAILED(hr) || (WI_IsFlagSet(attributes, SFGAO_SYSTEM)))
+				{
+					continue;
+				}
 			}
+
+			batch.emplace_back(ILCombine(directory, pidlItem.Raw()), Pidl::takeOwnership);
 		}
 
-		if (m_config->globalFolderSettings.hideSystemFiles)
+		if (!batch.empty())
 		{
-			PCITEMID_CHILD child = pidlItem.get();
-			SFGAOF attributes = SFGAO_SYSTEM;
-			hr = shellFolder2->GetAttributesOf(1, &child, &attributes);
-
-			if (FAILED(hr) || (WI_IsFlagSet(attributes, SFGAO_SYSTEM)))
-			{
-				continue;
-			}
+			batchCallback(std::move(batch));
 		}
+	} while (enumerationResult == S_OK && !stopToken.stop_requested());
+
+	return S_OK;
+}
+
+void ShellTreeView::OnExpansionItemsAvailable(int nodeId, int requestId,
+	const std::vector<PidlAbsolute> &items)
+{
+	auto itr = m_expansionRequests.find(nodeId);
 
-		items.emplace_back(ILCombine(pidlDirectory.get(), pidlItem.get()));
+	// The request may have been cancelled (e.g. because the folder was collapsed), or replaced by a
+	// newer request.
+	if (itr == m_expansionRequests.end() || itr->second.requestId != requestId)
+	{
+		return;
 	}
 
+	ScopedRedrawDisabler redrawDisabler(m_hTreeView);
+
+	// There's no way to insert an item before another item, so each item is inserted after the
+	// item that precedes the placeholder.
+	auto placeholderItem = itr->second.placeholderItem;
+
 	for (const auto &item : items)
 	{
-		AddItem(hParent, item.get());
+		auto previousItem = TreeView_GetPrevSibling(m_hTreeView, placeholderItem);
+		AddItem(itr->second.parentItem, item.Raw(), previousItem ? previousItem : TVI_FIRST);
 	}
+}
 
-	SortChildren(hParent);
+void ShellTreeView::OnExpansionFinished(int nodeId, int requestId)
+{
+	auto itr = m_expansionRequests.find(nodeId);
 
-	ShellTreeNode *parentNode = GetNodeFromTreeViewItem(hParent);
-	StartDirectoryMonitoringForNode(parentNode);
+	if (itr == m_expansionRequests.end() || itr->second.requestId != requestId)
+	{
+		return;
+	}
 
-	return hr;
+	auto parentItem = itr->second.parentItem;
+	auto queuedDirectoryChanges = std::move(itr->second.queuedDirectoryChanges);
+	[[maybe_unused]] bool deleted = TreeView_DeleteItem(m_hTreeView, itr->second.placeholderItem);
+	assert(deleted);
+	m_expansionRequests.erase(itr);
+
+	// Items are only sorted once all of them have been added, since sorting is relatively
+	// expensive.
+	SortChildren(parentItem);
+
+	ApplyQueuedDirectoryChanges(queuedDirectoryChanges);
+
+	ShellTreeNode *parentNode = GetNodeFromTreeViewItem(parentItem);
+
+	if (parentNode->GetChildren().empty())
+	{
+		// The expand button would otherwise remain, even though there's nothing to show.
+		TVITEM tvParentItem = {};
+		tvParentItem.mask = TVIF_CHILDREN;
+		tvParentItem.hItem = parentItem;
+		tvParentItem.cChildren = 0;
+		TreeView_SetItem(m_hTreeView, &tvParentItem);
+	}
+}
+
+void ShellTreeView::FinishExpansionSynchronously(HTREEITEM parentItem)
+{
+	ShellTreeNode *parentNode = GetNodeFromTreeViewItem(parentItem);
+	auto itr = m_expansionRequests.find(parentNode->GetId());
+
+	if (itr == m_expansionRequests.end())
+	{
+		return;
+	}
+
+	itr->second.stopSource.request_stop();
+	auto queuedDirectoryChanges = std::move(itr->second.queuedDirectoryChanges);
+	[[maybe_unused]] bool deleted = TreeView_DeleteItem(m_hTreeView, itr->second.placeholderItem);
+	assert(deleted);
+	m_expansionRequests.erase(itr);
+
+	ExpandDirectorySynchronously(parentItem);
+	ApplyQueuedDirectoryChanges(queuedDirectoryChanges);
+}
+
+void ShellTreeView::CancelExpansionsForNodeAndChildren(ShellTreeNode *node)
+{
+	auto itr = m_expansionRequests.find(node->GetId());
+
+	if (itr != m_expansionRequests.end())
+	{
+		itr->second.stopSource.request_stop();
+		m_expansionRequests.erase(itr);
+	}
+
+	for (auto &child : node->GetChildren())
+	{
+		CancelExpansionsForNodeAndChildren(child.get());
+	}
+}
+
+ShellTreeView::ExpansionOptions ShellTreeView::GetExpansionOptions() const
+{
+	return { .showHidden = static_cast<bool>(m_bShowHidden),
+		.checkPinnedToNamespaceTree = m_config->checkPinnedToNamespaceTreeProperty,
+		.hideSystemFiles = m_config->globalFolderSettings.hideSystemFiles };
+}
+
+bool ShellTreeView::IsPlaceholderItem(HTREEITEM item) const
+{
+	return item && !GetNodeFromTreeViewItem(item);
+}
+
+bool ShellTreeView::OnSelectionChanging(const NMTREEVIEW *eventInfo)
+{
+	HTREEITEM placeholderItem = eventInfo->itemNew.hItem;
+
+	// The placeholder item shown while a folder is being expanded can't be selected.
+	if (!IsPlaceholderItem(placeholderItem))
+	{
+		return false;
+	}
+
+	if (eventInfo->action != TVC_BYKEYBOARD)
+	{
+		return true;
+	}
+
+	// When moving through the tree with the keyboard, the selection skips past the placeholder (in
+	// the direction the selection was moving), so that the placeholder doesn't block navigation.
+	// The selection can't be changed while this notification is being processed, so that's done
+	// afterwards.
+	HTREEITEM previousItem = TreeView_GetPrevVisible(m_hTreeView, placeholderItem);
+	HTREEITEM targetItem = (eventInfo->itemOld.hItem == previousItem)
+		? TreeView_GetNextVisible(m_hTreeView, placeholderItem)
+		: previousItem;
+
+	if (!targetItem || targetItem == eventInfo->itemOld.hItem)
+	{
+		return true;
+	}
+
+	PidlAbsolute targetPidl = GetNodePidl(targetItem).get();
+
+	m_app->GetRuntime()->GetUiThreadExecutor()->post(
+		[weakSelf = m_weakPtrFactory.GetWeakPtr(), targetPidl]
+		{
+			if (!weakSelf)
+			{
+				return;
+			}
+
+			// The target item may have been removed in the meantime.
+			auto item = weakSelf->LocateExistingItem(targetPidl.Raw());
+
+			if (item)
+			{
+				TreeView_SelectItem(weakSelf->m_hTreeView, item);
+			}
+		});
+
+	return true;
 }
 
 HTREEITEM ShellTreeView::AddItem(HTREEITEM parent, PCIDLIST_ABSOLUTE pidl, HTREEITEM insertAfter)
@@ -942,6 +1275,8 @@ HTREEITEM ShellTreeView::AddItem(HTREEITEM parent, PCIDLIST_ABSOLUTE pidl, HTREE
 	auto item = TreeView_InsertItem(m_hTreeView, &tvInsertData);
 	CHECK(item);
 
+	AddNodeToIndexes(rawNode, item);
+
 	return item;
 }
 
@@ -985,33 +1320,108 @@ ShellTreeNode *ShellTreeView::GetNodeFromTreeViewItem(HTREEITEM item) const
 
 ShellTreeNode *ShellTreeView::GetNodeById(int id) const
 {
-	for (auto &rootNode : m_nodes)
+	auto itr = m_nodeIdIndex.find(id);
+
+	if (itr == m_nodeIdIndex.end())
 	{
-		auto *foundNode = GetNodeByIdRecursive(rootNode.get(), id);
+		return nullptr;
+	}
 
-		if (foundNode)
-		{
-			return foundNode;
-		}
+	return itr->second.node;
+}
+
+void ShellTreeView::AddNodeToIndexes(ShellTreeNode *node, HTREEITEM treeItem)
+{
+	std::wstring parsingName;
+	HRESULT hr = GetDisplayName(node->GetFullPidl().get(), SHGDN_FORPARSING, parsingName);
+	DCHECK(SUCCEEDED(hr));
+
+	[[maybe_unused]] auto [itr, inserted] =
+		m_nodeIdIndex.insert({ node->GetId(), { node, treeItem, parsingName } });
+	DCHECK(inserted);
+
+	m_parsingNameIndex.AddItem(parsingName, node->GetId());
+}
+
+void ShellTreeView::RemoveNodeAndChildrenFromIndexes(ShellTreeNode *node)
+{
+	auto itr = m_nodeIdIndex.find(node->GetId());
+	CHECK(itr != m_nodeIdIndex.end());
+
+	m_parsingNameIndex.RemoveItem(itr->second.parsingName, node->GetId());
+	m_nodeIdIndex.erase(itr);
+
+	for (auto &child : node->GetChildren())
+	{
+		RemoveNodeAndChildrenFromIndexes(child.get());
 	}
+}
 
-	return nullptr;
+void ShellTreeView::RemoveAllChildNodes(ShellTreeNode *node)
+{
+	for (auto &child : node->GetChildren())
+	{
+		RemoveNodeAndChildrenFromIndexes(child.get());
+	}
+
+	node->RemoveAllChildren();
+}
+
+// When a folder is renamed, the parsing names of the folder and all of its children change, so the
+// nodes need to be indexed under their updated names.
+void ShellTreeView::UpdateIndexesForNodeAndChildren(ShellTreeNode *node)
+{
+	auto itr = m_nodeIdIndex.find(node->GetId());
+	CHECK(itr != m_nodeIdIndex.end());
+
+	std::wstring updatedParsingName;
+	HRESULT hr = GetDisplayName(node->GetFullPidl().get(), SHGDN_FORPARSING, updatedParsingName);
+	DCHECK(SUCCEEDED(hr));
+
+	m_parsingNameIndex.RemoveItem(itr->second.parsingName, node->GetId());
+	m_parsingNameIndex.AddItem(updatedParsingName, node->GetId());
+	itr->second.parsingName = updatedParsingName;
+
+	for (auto &child : node->GetChildren())
+	{
+		UpdateIndexesForNodeAndChildren(child.get());
+	}
 }
 
-ShellTreeNode *ShellTreeView::GetNodeByIdRecursive(ShellTreeNode *node, int id) const
+HTREEITEM ShellTreeView::FindIndexedItem(PCIDLIST_ABSOLUTE pidl) const
 {
-	if (node->GetId() == id)
+	std::wstring parsingName;
+	HRESULT hr = GetDisplayName(pidl, SHGDN_FORPARSING, parsingName);
+
+	if (FAILED(hr))
 	{
-		return node;
+		return nullptr;
 	}
 
-	for (auto &childNode : node->GetChildren())
+	for (int nodeId : m_parsingNameIndex.GetItemsForParsingName(parsingName))
 	{
-		auto *foundNode = GetNodeByIdRecursive(childNode.get(), id);
+		const auto &indexedNode = m_nodeIdIndex.at(nodeId);
+
+		if (!ArePidlsEquivalent(indexedNode.node->GetFullPidl().get(), pidl))
+		{
+			continue;
+		}
+
+		// The same folder can appear in the tree more than once (e.g. underneath the quick access
+		// folder). In that case, the item underneath the root that actually contains the folder is
+		// the one that's wanted, which is consistent with walking the tree down from the root.
+		auto *rootNode = indexedNode.node;
+
+		while (rootNode->GetParent())
+		{
+			rootNode = rootNode->GetParent();
+		}
 
-		if (foundNode)
+		auto rootPidl = rootNode->GetFullPidl();
+
+		if (rootNode == indexedNode.node || ILIsParent(rootPidl.get(), pidl, FALSE))
 		{
-			return foundNode;
+			return indexedNode.treeItem;
 		}
 	}
 
@@ -1036,8 +1446,35 @@ HTREEITEM ShellTreeView::LocateItemInternal(PCIDLIST_ABSOLUTE pidlDirectory,
 	TVITEMEX item;
 	BOOL bFound = FALSE;
 
-	/* Get the root of the tree (root of namespace). */
-	hRoot = TreeView_GetRoot(m_hTreeView);
+	if (auto existingItem = FindIndexedItem(pidlDirectory))
+	{
+		return existingItem;
+	}
+
+	if (bOnlyLocateExistingItem)
+	{
+		return nullptr;
+	}
+
+	// Any folders expanded here need to have their children available immediately.
+	AutoReset expandSynchronously(&m_expandSynchronously, true);
+
+	// The search can start from the closest ancestor that's already in the tree, since only the
+	// levels below that need to be expanded.
+	hRoot = nullptr;
+	PidlAbsolute ancestorPidl(pidlDirectory);
+
+	while (!hRoot && ancestorPidl.RemoveLastItem())
+	{
+		hRoot = FindIndexedItem(ancestorPidl.Raw());
+	}
+
+	if (!hRoot)
+	{
+		/* Get the root of the tree (root of namespace). */
+		hRoot = TreeView_GetRoot(m_hTreeView);
+	}
+
 	hItem = hRoot;
 
 	item.mask = TVIF_PARAM | TVIF_HANDLE;
@@ -1053,6 +1490,18 @@ HTREEITEM ShellTreeView::LocateItemInternal(PCIDLIST_ABSOLUTE pidlDirectory,
 	while (!bFound && hItem != nullptr)
 	{
 		auto *node = reinterpret_cast<ShellTreeNode *>(item.lParam);
+
+		// The placeholder shown while a folder is being expanded doesn't correspond to any item.
+		if (!node)
+		{
+			hItem = TreeView_GetNextSibling(m_hTreeView, hItem);
+
+			item.mask = TVIF_PARAM | TVIF_HANDLE;
+			item.hItem = hItem;
+			TreeView_GetItem(m_hTreeView, &item);
+			continue;
+		}
+
 		auto currentPidl = node->GetFullPidl();
 
 		if (ArePidlsEquivalent(currentPidl.get(), pidlDirectory))
@@ -1064,19 +1513,34 @@ HTREEITEM ShellTreeView::LocateItemInternal(PCIDLIST_ABSOLUTE pidlDirectory,
 
 		if (ILIsParent(currentPidl.get(), pidlDirectory, FALSE))
 		{
-			if ((TreeView_GetChild(m_hTreeView, hItem)) == nullptr)
+			// If the folder is still being expanded in the background, the next item on the path
+			// may already have been added, in which case the search can move straight to it.
+			// Otherwise, the rest of the expansion has to be completed here, since the item being
+			// searched for may not have been added yet.
+			PidlAbsolute nextPidl(pidlDirectory);
+
+			while (ILGetCount(nextPidl.Raw()) > ILGetCount(currentPidl.get()) + 1)
 			{
-				if (bOnlyLocateExistingItem)
-				{
-					return nullptr;
-				}
-				else
+				nextPidl.RemoveLastItem();
+			}
+
+			HTREEITEM nextItem = FindIndexedItem(nextPidl.Raw());
+
+			if (nextItem && TreeView_GetParent(m_hTreeView, nextItem) == hItem)
+			{
+				hItem = nextItem;
+			}
+			else
+			{
+				FinishExpansionSynchronously(hItem);
+
+				if ((TreeView_GetChild(m_hTreeView, hItem)) == nullptr)
 				{
 					SendMessage(m_hTreeView, TVM_EXPAND, TVE_EXPAND, (LPARAM) hItem);
 				}
-			}
 
-			hItem = TreeView_GetChild(m_hTreeView, hItem);
+				hItem = TreeView_GetChild(m_hTreeView, hItem);
+			}
 		}
 		else
 		{
@@ -1122,7 +1586,7 @@ void ShellTreeView::OnMiddleButtonUp(const POINT *pt, UINT keysDown)
 
 	// Only open an item if it was the one on which the middle mouse button was initially clicked
 	// on.
-	if (hitTestInfo.hItem != m_middleButtonItem)
+	if (hitTestInfo.hItem != m_middleButtonItem || IsPlaceholderItem(hitTestInfo.hItem))
 	{
 		return;
 	}
@@ -1140,6 +1604,12 @@ void ShellTreeView::SetShowHidden(BOOL bShowHidden)
 
 void ShellTreeView::OnBeginDrag(const ShellTreeNode *node)
 {
+	// This will be the case if the placeholder item is dragged.
+	if (!node)
+	{
+		return;
+	}
+
 	auto pidl = node->GetFullPidl();
 
 	StartDragForShellItems({ pidl.get() });
@@ -1282,7 +1752,7 @@ void ShellTreeView::OnShowContextMenu(const POINT &ptScreen)
 		hitTestInfo.pt = ptClient;
 		auto item = TreeView_HitTest(m_hTreeView, &hitTestInfo);
 
-		if (!item)
+		if (!item || IsPlaceholderItem(item))
 		{
 			return;
 		}
@@ -8,26 +8,35 @@
 #include "DirectoryWatcher.h"
 #include "MainFontSetter.h"
 #include "ScopedBrowserCommandTarget.h"
+#include "ShellBrowser/ParsingNameIndex.h"
 #include "../Helper/ClipboardHelper.h"
 #include "../Helper/DropHandler.h"
 #include "../Helper/FileOperations.h"
 #include "../Helper/ShellDropTargetWindow.h"
+#include "../Helper/Pidl.h"
 #include "../Helper/ShellHelper.h"
 #include "../Helper/SignalWrapper.h"
+#include "../Helper/WeakPtr.h"
+#include "../Helper/WeakPtrFactory.h"
 #include "../Helper/WindowSubclass.h"
-#include "../ThirdParty/CTPL/cpl_stl.h"
 #include <boost/signals2.hpp>
 #include <concurrencpp/concurrencpp.h>
 #include <wil/com.h>
+#include <functional>
 #include <optional>
+#include <stop_token>
+#include <unordered_map>
+#include <vector>
 
 class App;
 class BrowserWindow;
 class CachedIcons;
 struct Config;
 class FileActionHandler;
+class Runtime;
 class ShellBrowserImpl;
 class ShellTreeNode;
+class TaskQueue;
 
 class ShellTreeView : public ShellDropTargetWindow<HTREEITEM>, public BrowserCommandTarget
 {
@@ -60,6 +69,9 @@ private:
 
 	static const SIGDN DISPLAY_NAME_TYPE = SIGDN_NORMALDISPLAY;
 
+	// The maximum number of items that will be requested from an enumerator at once.
+	static const ULONG ENUMERATION_BATCH_SIZE = 256;
+
 	struct BasicItemInfo
 	{
 		BasicItemInfo() = default;
@@ -86,6 +98,46 @@ private:
 		bool hasSubfolder;
 	};
 
+	struct IndexedNode
+	{
+		ShellTreeNode *node;
+		HTREEITEM treeItem;
+
+		// The parsing name the node was indexed under. This is needed to remove the node from the
+		// parsing name index, since the name returned for the node can change (e.g. if a parent
+		// folder is renamed).
+		std::wstring parsingName;
+	};
+
+	// The settings that determine which children are shown when a folder is expanded. These are
+	// retrieved up front, so that they can be used on a background thread.
+	struct ExpansionOptions
+	{
+		bool showHidden;
+		bool checkPinnedToNamespaceTree;
+		bool hideSystemFiles;
+	};
+
+	struct QueuedDirectoryChange
+	{
+		DirectoryWatcher::Event event;
+		PidlAbsolute simplePidl1;
+		PidlAbsolute simplePidl2;
+	};
+
+	// Tracks a folder that's being expanded in the background. While the expansion is in progress,
+	// a placeholder item is shown as the last child of the folder. Changes to the folder's children
+	// are queued until the expansion has finished, since the enumeration may or may not include
+	// them.
+	struct ExpansionRequest
+	{
+		int requestId;
+		HTREEITEM parentItem;
+		HTREEITEM placeholderItem;
+		std::stop_source stopSource;
+		std::vector<QueuedDirectoryChange> queuedDirectoryChanges;
+	};
+
 	// Maintains information about an item that was cut or copied within the treeview.
 	class CutCopiedItemManager
 	{
@@ -127,7 +179,24 @@ private:
 	void AddShellNamespaceRootItem();
 	HTREEITEM AddRootItem(PCIDLIST_ABSOLUTE pidl, HTREEITEM insertAfter = TVI_LAST);
 	void OnShowQuickAccessUpdated(bool newValue);
-	HRESULT ExpandDirectory(HTREEITEM hParent);
+	void ExpandDirectory(HTREEITEM hParent);
+	HRESULT ExpandDirectorySynchronously(HTREEITEM hParent);
+	bool IsExistingChild(const ParsingNameIndex &existingChildren, PCIDLIST_ABSOLUTE pidl) const;
+	void StartExpansionRequest(HTREEITEM parentItem);
+	static concurrencpp::null_result ExpandDirectoryAsync(WeakPtr<ShellTreeView> weakSelf,
+		Runtime *runtime, int nodeId, int requestId, PidlAbsolute directory,
+		ExpansionOptions options, std::stop_token stopToken);
+	static HRESULT EnumerateChildFolders(PCIDLIST_ABSOLUTE directory,
+		const ExpansionOptions &options, std::stop_token stopToken,
+		std::function<void(std::vector<PidlAbsolute>)> batchCallback);
+	void OnExpansionItemsAvailable(int nodeId, int requestId,
+		const std::vector<PidlAbsolute> &items);
+	void OnExpansionFinished(int nodeId, int requestId);
+	void FinishExpansionSynchronously(HTREEITEM parentItem);
+	void CancelExpansionsForNodeAndChildren(ShellTreeNode *node);
+	ExpansionOptions GetExpansionOptions() const;
+	bool IsPlaceholderItem(HTREEITEM item) const;
+	bool OnSelectionChanging(const NMTREEVIEW *eventInfo);
 	HTREEITEM AddItem(HTREEITEM parent, PCIDLIST_ABSOLUTE pidl, HTREEITEM insertAfter = TVI_LAST);
 	void SortChildren(HTREEITEM parent);
 	void OnGetDisplayInfo(NMTVDISPINFO *pnmtvdi);
@@ -164,6 +233,8 @@ private:
 	void RestartDirectoryMonitoringForNode(ShellTreeNode *node);
 	void ProcessDirectoryChangeNotification(DirectoryWatcher::Event event,
 		const PidlAbsolute &simplePidl1, const PidlAbsolute &simplePidl2);
+	ExpansionRequest *MaybeGetExpansionRequestForChild(PCIDLIST_ABSOLUTE simplePidl);
+	void ApplyQueuedDirectoryChanges(const std::vector<QueuedDirectoryChange> &changes);
 	void OnItemAdded(PCIDLIST_ABSOLUTE simplePidl);
 	void OnItemUpdated(PCIDLIST_ABSOLUTE simplePidl, PCIDLIST_ABSOLUTE simpleUpdatedPidl);
 	void OnItemRemoved(PCIDLIST_ABSOLUTE simplePidl);
@@ -185,7 +256,13 @@ private:
 	ShellTreeNode *GetSelectedNode() const;
 	ShellTreeNode *GetNodeFromTreeViewItem(HTREEITEM item) const;
 	ShellTreeNode *GetNodeById(int id) const;
-	ShellTreeNode *GetNodeByIdRecursive(ShellTreeNode *node, int id) const;
+
+	// Node indexes
+	void AddNodeToIndexes(ShellTreeNode *node, HTREEITEM treeItem);
+	void RemoveNodeAndChildrenFromIndexes(ShellTreeNode *node);
+	void RemoveAllChildNodes(ShellTreeNode *node);
+	void UpdateIndexesForNodeAndChildren(ShellTreeNode *node);
+	HTREEITEM FindIndexedItem(PCIDLIST_ABSOLUTE pidl) const;
 
 	// ShellDropTargetWindow
 	HTREEITEM GetDropTargetItem(const POINT &pt) override;
@@ -229,11 +306,13 @@ private:
 	// be set. Once the treeview font is set, the same font will be applied to the tooltip control.
 	MainFontSetter m_fontSetter;
 
-	ctpl::thread_pool m_iconThreadPool;
+	// The treeview is always visible, so the icon tasks are run ahead of the tasks for background
+	// tabs.
+	const std::unique_ptr<TaskQueue> m_iconTaskQueue;
 	std::unordered_map<int, std::future<std::optional<IconResult>>> m_iconResults;
 	int m_iconResultIDCounter;
 
-	ctpl::thread_pool m_subfoldersThreadPool;
+	const std::unique_ptr<TaskQueue> m_subfoldersTaskQueue;
 	std::unordered_map<int, std::future<std::optional<SubfoldersResult>>> m_subfoldersResults;
 	int m_subfoldersResultIDCounter;
 
@@ -241,6 +320,11 @@ private:
 	// in this vector; child nodes are stored underneath their parent node.
 	std::vector<std::unique_ptr<ShellTreeNode>> m_nodes;
 
+	// Allow a node to be found by its ID, or by its pidl, without walking the tree. Every node in
+	// the tree is contained in both indexes.
+	std::unordered_map<int, IndexedNode> m_nodeIdIndex;
+	ParsingNameIndex m_parsingNameIndex;
+
 	CachedIcons *m_cachedIcons;
 
 	int m_iFolderIcon;
@@ -255,4 +339,15 @@ private:
 	concurrencpp::timer m_dropExpandTimer;
 
 	CutCopiedItemManager m_cutCopiedItemManager;
+
+	// Folder expansions that are taking place in the background, keyed by the ID of the node being
+	// expanded.
+	std::unordered_map<int, ExpansionRequest> m_expansionRequests;
+	int m_expansionRequestIdCounter = 0;
+
+	// Set when the children of a folder are needed immediately (e.g. when locating an item), in
+	// which case the folder will be expanded on the UI thread.
+	bool m_expandSynchronously = false;
+
+	WeakPtrFactory<ShellTreeView> m_weakPtrFactory{ this };
 };
@@ -6,6 +6,7 @@
 #include "SplitFileDialog.h"
 #include "MainResource.h"
 #include "ResourceLoader.h"
+#include "TransferProgressHelper.h"
 #include "../Helper/FileOperations.h"
 #include "../Helper/RegistrySettings.h"
 #include "../Helper/ShellHelper.h"
@@ -14,14 +15,17 @@
 #include "../Helper/XMLSettings.h"
 #include <wil/resource.h>
 #include <comdef.h>
+#include <algorithm>
 #include <unordered_map>
 
 namespace NSplitFileDialog
 {
-const int WM_APP_SETTOTALSPLITCOUNT = WM_APP + 1;
-const int WM_APP_SETCURRENTSPLITCOUNT = WM_APP + 2;
-const int WM_APP_SPLITFINISHED = WM_APP + 3;
-const int WM_APP_INPUTFILEINVALID = WM_APP + 4;
+const int WM_APP_SETPROGRESS = WM_APP + 1;
+const int WM_APP_SPLITFINISHED = WM_APP + 2;
+const int WM_APP_INPUTFILEINVALID = WM_APP + 3;
+
+// The progress bar tracks the number of bytes copied, scaled to this range.
+const int PROGRESS_BAR_RANGE = 1000;
 
 const TCHAR COUNTER_PATTERN[] = _T("/N");
 
@@ -223,20 +227,14 @@ void SplitFileDialog::SaveState()
 
 INT_PTR SplitFileDialog::OnPrivateMessage(UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
-	UNREFERENCED_PARAMETER(lParam);
-
 	switch (uMsg)
 	{
-	case NSplitFileDialog::WM_APP_SETTOTALSPLITCOUNT:
-		SendDlgItemMessage(m_hDlg, IDC_SPLIT_PROGRESS, PBM_SETRANGE32, 0, wParam);
-		break;
-
-	case NSplitFileDialog::WM_APP_SETCURRENTSPLITCOUNT:
-		SendDlgItemMessage(m_hDlg, IDC_SPLIT_PROGRESS, PBM_SETPOS, wParam, 0);
+	case NSplitFileDialog::WM_APP_SETPROGRESS:
+		OnSplitProgress(static_cast<int>(wParam), static_cast<std::uint64_t>(lParam));
 		break;
 
 	case NSplitFileDialog::WM_APP_SPLITFINISHED:
-		OnSplitFinished();
+		OnSplitFinished(static_cast<bool>(wParam));
 		break;
 
 	case NSplitFileDialog::WM_APP_INPUTFILEINVALID:
@@ -308,9 +306,9 @@ void SplitFileDialog::OnOk()
 		std::wstring strOutputDirectory = GetWindowString(hEditOutputDirectory);
 
 		BOOL bTranslated;
-		UINT uSplitSize = GetDlgItemInt(m_hDlg, IDC_SPLIT_EDIT_SIZE, &bTranslated, FALSE);
+		std::uint64_t splitSize = GetDlgItemInt(m_hDlg, IDC_SPLIT_EDIT_SIZE, &bTranslated, FALSE);
 
-		if (!bTranslated || uSplitSize == 0)
+		if (!bTranslated || splitSize == 0)
 		{
 			auto errorMessage = m_resourceLoader->LoadString(IDS_SPLITFILEDIALOG_SIZEERROR);
 			SetDlgItemText(m_hDlg, IDC_SPLIT_STATIC_MESSAGE, errorMessage.c_str());
@@ -334,21 +332,21 @@ void SplitFileDialog::OnOk()
 				break;
 
 			case SizeType::KB:
-				uSplitSize *= KB;
+				splitSize *= KB;
 				break;
 
 			case SizeType::MB:
-				uSplitSize *= MB;
+				splitSize *= MB;
 				break;
 
 			case SizeType::GB:
-				uSplitSize *= GB;
+				splitSize *= GB;
 				break;
 			}
 		}
 
 		m_pSplitFile = new SplitFile(m_hDlg, m_strFullFilename, strOutputFilename,
-			strOutputDirectory, uSplitSize);
+			strOutputDirectory, splitSize);
 
 		GetDlgItemText(m_hDlg, IDOK, m_szOk, static_cast<int>(std::size(m_szOk)));
 
@@ -363,6 +361,10 @@ void SplitFileDialog::OnOk()
 		auto splittingText = m_resourceLoader->LoadString(IDS_SPLITFILEDIALOG_SPLITTING);
 		SetDlgItemText(m_hDlg, IDC_SPLIT_STATIC_MESSAGE, splittingText.c_str());
 
+		SendDlgItemMessage(m_hDlg, IDC_SPLIT_PROGRESS, PBM_SETRANGE32, 0,
+			NSplitFileDialog::PROGRESS_BAR_RANGE);
+		SendDlgItemMessage(m_hDlg, IDC_SPLIT_PROGRESS, PBM_SETPOS, 0, 0);
+
 		HANDLE hThread = CreateThread(nullptr, 0, NSplitFileDialog::SplitFileThreadProcStub,
 			reinterpret_cast<LPVOID>(m_pSplitFile), 0, nullptr);
 		SetThreadPriority(hThread, THREAD_PRIORITY_LOWEST);
@@ -414,17 +416,21 @@ void SplitFileDialog::OnChangeOutputDirectory()
 	SetDlgItemText(m_hDlg, IDC_SPLIT_EDIT_OUTPUT, parsingName.c_str());
 }
 
-void SplitFileDialog::OnSplitFinished()
+void SplitFileDialog::OnSplitFinished(bool succeeded)
 {
 	std::wstring message;
 
-	if (!m_bStopSplitting)
+	if (m_bStopSplitting)
 	{
-		message = m_resourceLoader->LoadString(IDS_SPLITFILEDIALOG_FINISHED);
+		message = m_resourceLoader->LoadString(IDS_SPLITFILEDIALOG_CANCELLED);
+	}
+	else if (!succeeded)
+	{
+		message = m_resourceLoader->LoadString(IDS_SPLITFILEDIALOG_FAILED);
 	}
 	else
 	{
-		message = m_resourceLoader->LoadString(IDS_SPLITFILEDIALOG_CANCELLED);
+		message = m_resourceLoader->LoadString(IDS_SPLITFILEDIALOG_FINISHED);
 	}
 
 	SetDlgItemText(m_hDlg, IDC_SPLIT_STATIC_MESSAGE, message.c_str());
@@ -439,13 +445,33 @@ void SplitFileDialog::OnSplitFinished()
 
 	KillTimer(m_hDlg, ELPASED_TIMER_ID);
 
-	int iHighLimit =
-		static_cast<int>(SendDlgItemMessage(m_hDlg, IDC_SPLIT_PROGRESS, PBM_GETRANGE, FALSE, 0));
-	SendDlgItemMessage(m_hDlg, IDC_SPLIT_PROGRESS, PBM_SETPOS, iHighLimit, 0);
+	int position = 0;
+
+	if (succeeded)
+	{
+		position = static_cast<int>(
+			SendDlgItemMessage(m_hDlg, IDC_SPLIT_PROGRESS, PBM_GETRANGE, FALSE, 0));
+	}
+
+	SendDlgItemMessage(m_hDlg, IDC_SPLIT_PROGRESS, PBM_SETPOS, position, 0);
 
 	SetDlgItemText(m_hDlg, IDOK, m_szOk);
 }
 
+void SplitFileDialog::OnSplitProgress(int position, std::uint64_t bytesPerSecond)
+{
+	if (!m_bSplittingFile)
+	{
+		return;
+	}
+
+	SendDlgItemMessage(m_hDlg, IDC_SPLIT_PROGRESS, PBM_SETPOS, position, 0);
+
+	auto message = TransferProgressHelper::FormatStatus(m_resourceLoader,
+		m_resourceLoader->LoadString(IDS_SPLITFILEDIALOG_SPLITTING), bytesPerSecond);
+	SetDlgItemText(m_hDlg, IDC_SPLIT_STATIC_MESSAGE, message.c_str());
+}
+
 DWORD WINAPI NSplitFileDialog::SplitFileThreadProcStub(LPVOID pParam)
 {
 	assert(pParam != nullptr);
@@ -457,100 +483,90 @@ DWORD WINAPI NSplitFileDialog::SplitFileThreadProcStub(LPVOID pParam)
 }
 
 SplitFile::SplitFile(HWND hDlg, const std::wstring &strFullFilename,
-	const std::wstring &strOutputFilename, const std::wstring &strOutputDirectory, UINT uSplitSize)
+	const std::wstring &strOutputFilename, const std::wstring &strOutputDirectory,
+	std::uint64_t splitSize)
 {
 	m_hDlg = hDlg;
 	m_strFullFilename = strFullFilename;
 	m_strOutputFilename = strOutputFilename;
 	m_strOutputDirectory = strOutputDirectory;
-	m_uSplitSize = uSplitSize;
-
-	m_bStopSplitting = false;
-
-	InitializeCriticalSection(&m_csStop);
-}
-
-SplitFile::~SplitFile()
-{
-	DeleteCriticalSection(&m_csStop);
+	m_splitSize = splitSize;
 }
 
 void SplitFile::Split()
 {
-	HANDLE hInputFile = CreateFile(m_strFullFilename.c_str(), GENERIC_READ, FILE_SHARE_READ,
-		nullptr, OPEN_EXISTING, 0, nullptr);
+	wil::unique_hfile inputFile(CreateFile(m_strFullFilename.c_str(), GENERIC_READ,
+		FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN,
+		nullptr));
 
-	if (hInputFile == INVALID_HANDLE_VALUE)
+	if (!inputFile)
 	{
 		PostMessage(m_hDlg, NSplitFileDialog::WM_APP_INPUTFILEINVALID, 0, 0);
 		return;
 	}
 
 	LARGE_INTEGER lFileSize;
-	GetFileSizeEx(hInputFile, &lFileSize);
-
-	LONGLONG nSplits = lFileSize.QuadPart / m_uSplitSize;
-
-	if ((lFileSize.QuadPart % m_uSplitSize) != 0)
-	{
-		nSplits++;
-	}
-
-	PostMessage(m_hDlg, NSplitFileDialog::WM_APP_SETTOTALSPLITCOUNT, static_cast<WPARAM>(nSplits),
-		0);
-
-	SplitInternal(hInputFile, lFileSize);
+	GetFileSizeEx(inputFile.get(), &lFileSize);
 
-	CloseHandle(hInputFile);
+	bool succeeded = SplitInternal(inputFile.get(), lFileSize.QuadPart);
 
-	SendMessage(m_hDlg, NSplitFileDialog::WM_APP_SPLITFINISHED, 0, 0);
+	SendMessage(m_hDlg, NSplitFileDialog::WM_APP_SPLITFINISHED, succeeded, 0);
 }
 
-void SplitFile::SplitInternal(HANDLE hInputFile, const LARGE_INTEGER &lFileSize)
+// Returns true if every part was written in full. Otherwise, the part that was being written is
+// removed, leaving only the parts that are complete.
+bool SplitFile::SplitInternal(HANDLE hInputFile, std::uint64_t fileSize)
 {
-	LARGE_INTEGER lRunningSplitSize = {};
+	// The same set of buffers is used for every part, so the amount of memory used is independent
+	// of the split size.
+	PipelinedFileCopier copier(m_stopSource.get_token(),
+		[this, fileSize](const PipelinedFileCopier::Progress &progress)
+		{ OnProgress(progress, fileSize); });
 
-	char *pBuffer = new char[m_uSplitSize];
-	bool bStop = false;
+	std::uint64_t offset = 0;
 	int nSplitsMade = 1;
 
-	while (lRunningSplitSize.QuadPart < lFileSize.QuadPart && !bStop)
+	while (offset < fileSize)
 	{
-		DWORD dwNumberOfBytesRead;
-		ReadFile(hInputFile, reinterpret_cast<LPVOID>(pBuffer), m_uSplitSize, &dwNumberOfBytesRead,
-			nullptr);
+		if (m_stopSource.stop_requested())
+		{
+			return false;
+		}
+
+		auto partSize = std::min(m_splitSize, fileSize - offset);
 
 		std::wstring strOutputFullFilename;
 		ProcessFilename(nSplitsMade, strOutputFullFilename);
 
-		HANDLE hOutputFile = CreateFile(strOutputFullFilename.c_str(), GENERIC_WRITE, 0, nullptr,
-			CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+		wil::unique_hfile outputFile(CreateFile(strOutputFullFilename.c_str(), GENERIC_WRITE, 0,
+			nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr));
 
-		if (hOutputFile != INVALID_HANDLE_VALUE)
+		if (!outputFile)
 		{
-			DWORD dwNumberOfBytesWritten;
-			WriteFile(hOutputFile, reinterpret_cast<LPCVOID>(pBuffer), dwNumberOfBytesRead,
-				&dwNumberOfBytesWritten, nullptr);
-
-			CloseHandle(hOutputFile);
+			LOG(ERROR) << "Failed to create split file part " << nSplitsMade << " (error "
+					   << GetLastError() << ")";
+			return false;
 		}
 
-		/* TODO: Wait for a set period of time before sending message
-		(so as not to block the GUI). */
-		PostMessage(m_hDlg, NSplitFileDialog::WM_APP_SETCURRENTSPLITCOUNT, nSplitsMade, 0);
-
-		lRunningSplitSize.QuadPart += dwNumberOfBytesRead;
-		nSplitsMade++;
-
-		EnterCriticalSection(&m_csStop);
-		if (m_bStopSplitting)
+		if (!copier.CopyRange(hInputFile, offset, outputFile.get(), 0, partSize))
 		{
-			bStop = true;
+			outputFile.reset();
+			DeleteFile(strOutputFullFilename.c_str());
+			return false;
 		}
-		LeaveCriticalSection(&m_csStop);
+
+		offset += partSize;
+		nSplitsMade++;
 	}
 
-	delete[] pBuffer;
+	return true;
+}
+
+void SplitFile::OnProgress(const PipelinedFileCopier::Progress &progress, std::uint64_t fileSize)
+{
+	TransferProgressHelper::PostProgressMessage(m_hDlg, NSplitFileDialog::WM_APP_SETPROGRESS,
+		progress.bytesCopied, fileSize, NSplitFileDialog::PROGRESS_BAR_RANGE,
+		progress.bytesPerSecond);
 }
 
 void SplitFile::ProcessFilename(int nSplitsMade, std::wstring &strOutputFullFilename)
@@ -567,9 +583,7 @@ void SplitFile::ProcessFilename(int nSplitsMade, std::wstring &strOutputFullFile
 
 void SplitFile::StopSplitting()
 {
-	EnterCriticalSection(&m_csStop);
-	m_bStopSplitting = true;
-	LeaveCriticalSection(&m_csStop);
+	m_stopSource.request_stop();
 }
 
 SplitFileDialogPersistentSettings::SplitFileDialogPersistentSettings() :
@@ -6,7 +6,10 @@
 
 #include "BaseDialog.h"
 #include "../Helper/DialogSettings.h"
+#include "../Helper/PipelinedFileCopier.h"
 #include "../Helper/ReferenceCount.h"
+#include <cstdint>
+#include <stop_token>
 #include <string>
 #include <unordered_map>
 
@@ -44,25 +47,24 @@ class SplitFile : public ReferenceCount
 {
 public:
 	SplitFile(HWND hDlg, const std::wstring &strFullFilename, const std::wstring &strOutputFilename,
-		const std::wstring &strOutputDirectory, UINT uSplitSize);
-	~SplitFile();
+		const std::wstring &strOutputDirectory, std::uint64_t splitSize);
 
 	void Split();
 	void StopSplitting();
 
 private:
-	void SplitInternal(HANDLE hInputFile, const LARGE_INTEGER &lFileSize);
+	bool SplitInternal(HANDLE hInputFile, std::uint64_t fileSize);
 	void ProcessFilename(int nSplitsMade, std::wstring &strOutputFullFilename);
+	void OnProgress(const PipelinedFileCopier::Progress &progress, std::uint64_t fileSize);
 
 	HWND m_hDlg;
 
 	std::wstring m_strFullFilename;
 	std::wstring m_strOutputFilename;
 	std::wstring m_strOutputDirectory;
-	UINT m_uSplitSize;
+	std::uint64_t m_splitSize;
 
-	CRITICAL_SECTION m_csStop;
-	bool m_bStopSplitting;
+	std::stop_source m_stopSource;
 };
 
 class SplitFileDialog : public BaseDialog
@@ -107,7 +109,8 @@ private:
 	void OnOk();
 	void OnCancel();
 	void OnChangeOutputDirectory();
-	void OnSplitFinished();
+	void OnSplitFinished(bool succeeded);
+	void OnSplitProgress(int position, std::uint64_t bytesPerSecond);
 
 	std::wstring m_strFullFilename;
 	bool m_bSplittingFile;
@@ -45,11 +45,14 @@ std::optional<ExitCode> Process(const CommandLine::Settings *commandLineSettings
 
 	if (commandLineSettings->pasteSymLinksDestination)
 	{
-		auto pastedItems = ClipboardOperations::PasteSymLinks(clipboardStore,
-			*commandLineSettings->pasteSymLinksDestination);
-
+		// The client is created before the paste begins, so that the server knows this process has
+		// started. Each batch of results is then sent as soon as it's been completed.
 		PasteSymLinksClient client;
-		client.NotifyServerOfResult(pastedItems);
+		ClipboardOperations::PasteSymLinks(clipboardStore,
+			*commandLineSettings->pasteSymLinksDestination,
+			[&client](const ClipboardOperations::PastedItems &pastedItems)
+			{ client.NotifyServerOfResult(pastedItems); });
+		client.FinishStream();
 
 		return EXIT_CODE_NORMAL;
 	}
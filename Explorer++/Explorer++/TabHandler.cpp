@@ -340,6 +340,7 @@ void Explorerplusplus::OnTabListViewSelectionChanged(const ShellBrowser *shellBr
 		if (item.iTabId == tab->GetId())
 		{
 			item.bValid = FALSE;
+			item.stopSource.request_stop();
 		}
 	}
 
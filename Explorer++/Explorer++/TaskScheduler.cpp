@@ -0,0 +1,203 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "TaskScheduler.h"
+#include <algorithm>
+
+TaskScheduler::TaskScheduler(std::shared_ptr<concurrencpp::executor> executor,
+	std::optional<int> maxConcurrentTasks) :
+	m_executor(executor),
+	m_maxRunners(std::max(maxConcurrentTasks.value_or(executor->max_concurrency_level()), 1)),
+	m_state(std::make_shared<State>())
+{
+}
+
+std::unique_ptr<TaskQueue> TaskScheduler::CreateQueue(TaskPriority priority)
+{
+	auto queueState = std::make_shared<QueueState>();
+	queueState->priority = priority;
+
+	std::unique_lock lock(m_state->mutex);
+	m_state->queues.push_back(queueState);
+	lock.unlock();
+
+	return std::unique_ptr<TaskQueue>(new TaskQueue(this, queueState));
+}
+
+TaskCounters TaskScheduler::GetCounters() const
+{
+	std::unique_lock lock(m_state->mutex);
+	return m_state->counters;
+}
+
+void TaskScheduler::Enqueue(std::shared_ptr<QueueState> queueState, std::optional<int> id,
+	std::function<void()> task)
+{
+	std::unique_lock lock(m_state->mutex);
+	queueState->pendingTasks.push_back({ m_state->sequenceNumberCounter++, id, std::move(task) });
+	queueState->counters.numTasksQueued++;
+	m_state->counters.numTasksQueued++;
+
+	if (m_state->numRunners >= m_maxRunners)
+	{
+		// One of the existing runners will pick this task up.
+		return;
+	}
+
+	m_state->numRunners++;
+	lock.unlock();
+
+	// The runner that's submitted here doesn't necessarily run the task that was just queued.
+	// Rather, it runs whichever task has the highest priority at the point it starts.
+	m_executor->post([state = m_state, executor = m_executor] { RunNextTask(state, executor); });
+}
+
+void TaskScheduler::RunNextTask(std::shared_ptr<State> state,
+	std::shared_ptr<concurrencpp::executor> executor)
+{
+	std::unique_lock lock(state->mutex);
+
+	auto queueState = FindNextQueue(*state);
+
+	if (!queueState)
+	{
+		// All the remaining tasks have been run by other runners, or removed.
+		state->numRunners--;
+		return;
+	}
+
+	auto task = std::move(queueState->pendingTasks.front().task);
+	queueState->pendingTasks.pop_front();
+	queueState->numRunningTasks++;
+
+	lock.unlock();
+
+	task();
+
+	// The task may hold resources that should be released before any waiting queue is destroyed.
+	task = nullptr;
+
+	lock.lock();
+	queueState->numRunningTasks--;
+	queueState->counters.numTasksExecuted++;
+	state->counters.numTasksExecuted++;
+
+	bool tasksRemaining = FindNextQueue(*state) != nullptr;
+
+	if (!tasksRemaining)
+	{
+		state->numRunners--;
+	}
+
+	lock.unlock();
+
+	state->taskFinishedCondition.notify_all();
+
+	if (tasksRemaining && !executor->shutdown_requested())
+	{
+		// Rather than looping here, the runner is resubmitted, so that other work on the executor
+		// (which is shared) gets a chance to run in between tasks.
+		executor->post([state, executor] { RunNextTask(state, executor); });
+	}
+}
+
+std::shared_ptr<TaskScheduler::QueueState> TaskScheduler::FindNextQueue(const State &state)
+{
+	std::shared_ptr<QueueState> nextQueue;
+
+	for (const auto &queueState : state.queues)
+	{
+		if (queueState->pendingTasks.empty())
+		{
+			continue;
+		}
+
+		if (!nextQueue || queueState->priority > nextQueue->priority
+			|| (queueState->priority == nextQueue->priority
+				&& queueState->pendingTasks.front().sequenceNumber
+					< nextQueue->pendingTasks.front().sequenceNumber))
+		{
+			nextQueue = queueState;
+		}
+	}
+
+	return nextQueue;
+}
+
+TaskQueue::TaskQueue(TaskScheduler *scheduler,
+	std::shared_ptr<TaskScheduler::QueueState> queueState) :
+	m_scheduler(scheduler),
+	m_queueState(queueState)
+{
+}
+
+TaskQueue::~TaskQueue()
+{
+	Clear();
+
+	auto &state = *m_scheduler->m_state;
+	std::unique_lock lock(state.mutex);
+
+	std::erase(state.queues, m_queueState);
+
+	// Tasks are allowed to reference the owner of this queue, so the owner can't be destroyed
+	// while any of the tasks are still running.
+	state.taskFinishedCondition.wait(lock, [this] { return m_queueState->numRunningTasks == 0; });
+}
+
+void TaskQueue::Clear()
+{
+	std::deque<TaskScheduler::PendingTask> pendingTasks;
+
+	std::unique_lock lock(m_scheduler->m_state->mutex);
+	pendingTasks.swap(m_queueState->pendingTasks);
+	m_queueState->counters.numTasksDiscarded += pendingTasks.size();
+	m_scheduler->m_state->counters.numTasksDiscarded += pendingTasks.size();
+	lock.unlock();
+
+	// The removed tasks will be destroyed once this function returns, outside of the lock.
+}
+
+void TaskQueue::Prioritize(const std::unordered_set<int> &ids)
+{
+	std::unique_lock lock(m_scheduler->m_state->mutex);
+
+	auto &pendingTasks = m_queueState->pendingTasks;
+
+	std::vector<uint64_t> sequenceNumbers;
+	sequenceNumbers.reserve(pendingTasks.size());
+	std::ranges::transform(pendingTasks, std::back_inserter(sequenceNumbers),
+		&TaskScheduler::PendingTask::sequenceNumber);
+
+	std::ranges::stable_partition(pendingTasks, [&ids](const TaskScheduler::PendingTask &task)
+		{ return task.id && ids.contains(*task.id); });
+
+	// The scheduler picks between queues based on the sequence number of the task at the front of
+	// each queue, so the sequence numbers need to remain in increasing order. Reassigning the
+	// original set of sequence numbers means that the prioritized tasks effectively take the place
+	// of the earliest tasks in the queue.
+	for (size_t i = 0; i < pendingTasks.size(); i++)
+	{
+		pendingTasks[i].sequenceNumber = sequenceNumbers[i];
+	}
+}
+
+TaskPriority TaskQueue::GetPriority() const
+{
+	std::unique_lock lock(m_scheduler->m_state->mutex);
+	return m_queueState->priority;
+}
+
+void TaskQueue::SetPriority(TaskPriority priority)
+{
+	std::unique_lock lock(m_scheduler->m_state->mutex);
+	m_queueState->priority = priority;
+}
+
+TaskCounters TaskQueue::GetCounters() const
+{
+	std::unique_lock lock(m_scheduler->m_state->mutex);
+	return m_queueState->counters;
+}
@@ -0,0 +1,150 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <boost/core/noncopyable.hpp>
+#include <concurrencpp/concurrencpp.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+class TaskQueue;
+
+struct TaskCounters
+{
+	uint64_t numTasksQueued = 0;
+	uint64_t numTasksExecuted = 0;
+
+	// The number of tasks that were removed (e.g. because the queue was cleared) before they had a
+	// chance to run.
+	uint64_t numTasksDiscarded = 0;
+};
+
+// Determines the order in which tasks from different queues are run. Tasks with the same priority
+// are run in the order in which they were queued.
+enum class TaskPriority
+{
+	Low,
+	Normal,
+	High
+};
+
+// Runs background tasks on a shared executor. Each component that needs to run background tasks
+// (e.g. each tab) creates its own TaskQueue. That allows the pending tasks for a component to be
+// cancelled as a group and prioritized relative to the tasks from other components.
+//
+// Queued tasks aren't submitted to the executor directly. Instead, a bounded number of runners are
+// submitted, each of which picks the highest priority task at the point it starts. That means that
+// a task that's prioritized only has to wait for the runners already submitted, rather than for
+// every task queued before it. It also means that the number of threads used is independent of the
+// number of tabs that are open.
+class TaskScheduler : private boost::noncopyable
+{
+public:
+	// If the maximum number of concurrent tasks isn't specified, the concurrency level of the
+	// executor will be used.
+	TaskScheduler(std::shared_ptr<concurrencpp::executor> executor,
+		std::optional<int> maxConcurrentTasks = std::nullopt);
+
+	std::unique_ptr<TaskQueue> CreateQueue(TaskPriority priority = TaskPriority::Normal);
+
+	// Returns the counters for all tasks that have been queued through this scheduler, including
+	// the tasks from queues that have since been destroyed.
+	TaskCounters GetCounters() const;
+
+private:
+	friend class TaskQueue;
+
+	struct PendingTask
+	{
+		uint64_t sequenceNumber;
+		std::optional<int> id;
+		std::function<void()> task;
+	};
+
+	struct QueueState
+	{
+		TaskPriority priority = TaskPriority::Normal;
+		std::deque<PendingTask> pendingTasks;
+		int numRunningTasks = 0;
+		TaskCounters counters;
+	};
+
+	// This is shared with each task that's submitted to the executor, so that the state remains
+	// valid until all of those tasks have run.
+	struct State
+	{
+		std::mutex mutex;
+		std::condition_variable taskFinishedCondition;
+		std::vector<std::shared_ptr<QueueState>> queues;
+		uint64_t sequenceNumberCounter = 0;
+		TaskCounters counters;
+		int numRunners = 0;
+	};
+
+	void Enqueue(std::shared_ptr<QueueState> queueState, std::optional<int> id,
+		std::function<void()> task);
+	static void RunNextTask(std::shared_ptr<State> state,
+		std::shared_ptr<concurrencpp::executor> executor);
+	static std::shared_ptr<QueueState> FindNextQueue(const State &state);
+
+	const std::shared_ptr<concurrencpp::executor> m_executor;
+	const int m_maxRunners;
+	const std::shared_ptr<State> m_state;
+};
+
+// A queue of tasks, run by a TaskScheduler. Destroying the queue cancels any tasks that haven't
+// started yet and waits for any running tasks to finish, so it's safe for a task to reference the
+// owner of the queue.
+class TaskQueue : private boost::noncopyable
+{
+public:
+	~TaskQueue();
+
+	// The ID is optional and only needs to be provided if the task may later be prioritized (see
+	// Prioritize()). Multiple tasks can share the same ID.
+	template <typename Function>
+	auto Push(Function &&function, std::optional<int> id = std::nullopt)
+		-> std::future<std::invoke_result_t<Function>>
+	{
+		using ResultType = std::invoke_result_t<Function>;
+
+		auto task =
+			std::make_shared<std::packaged_task<ResultType()>>(std::forward<Function>(function));
+		auto future = task->get_future();
+		m_scheduler->Enqueue(m_queueState, id, [task] { (*task)(); });
+		return future;
+	}
+
+	// Moves any pending tasks with one of the specified IDs to the front of the queue, so that
+	// they'll run before the other tasks in the queue. The relative order of the tasks that are
+	// moved, as well as the relative order of the remaining tasks, is preserved.
+	void Prioritize(const std::unordered_set<int> &ids);
+
+	// Removes any tasks that haven't started running. The futures for those tasks will be left
+	// without a value.
+	void Clear();
+
+	TaskPriority GetPriority() const;
+	void SetPriority(TaskPriority priority);
+
+	TaskCounters GetCounters() const;
+
+private:
+	friend class TaskScheduler;
+
+	TaskQueue(TaskScheduler *scheduler, std::shared_ptr<TaskScheduler::QueueState> queueState);
+
+	TaskScheduler *const m_scheduler;
+	const std::shared_ptr<TaskScheduler::QueueState> m_queueState;
+};
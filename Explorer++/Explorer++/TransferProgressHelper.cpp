@@ -0,0 +1,52 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "TransferProgressHelper.h"
+#include "MainResource.h"
+#include "ResourceLoader.h"
+#include "../Helper/StringHelper.h"
+#include <fmt/format.h>
+#include <fmt/xchar.h>
+#include <algorithm>
+#include <limits>
+
+namespace TransferProgressHelper
+{
+
+void PostProgressMessage(HWND hwnd, UINT message, std::uint64_t bytesCompleted,
+	std::uint64_t totalBytes, int range, std::uint64_t bytesPerSecond)
+{
+	int position = range;
+
+	if (totalBytes > 0)
+	{
+		position = static_cast<int>((bytesCompleted * range) / totalBytes);
+	}
+
+	// The rate is passed via the lParam, so needs to fit within it. In practice, that will only
+	// be an issue on 32-bit builds, where a rate of over 2 GB/s would be truncated.
+	auto clampedBytesPerSecond = std::min<std::uint64_t>(bytesPerSecond,
+		static_cast<std::uint64_t>(std::numeric_limits<LPARAM>::max()));
+
+	PostMessage(hwnd, message, position, static_cast<LPARAM>(clampedBytesPerSecond));
+}
+
+std::wstring FormatStatus(const ResourceLoader *resourceLoader, const std::wstring &status,
+	std::uint64_t bytesPerSecond)
+{
+	return fmt::format(fmt::runtime(resourceLoader->LoadString(IDS_TRANSFER_RATE_STATUS)),
+		fmt::arg(L"status", status), fmt::arg(L"rate", FormatSizeString(bytesPerSecond)));
+}
+
+std::wstring FormatStatus(const ResourceLoader *resourceLoader, const std::wstring &status,
+	int percentage, std::uint64_t bytesPerSecond)
+{
+	return fmt::format(
+		fmt::runtime(resourceLoader->LoadString(IDS_TRANSFER_RATE_STATUS_WITH_PERCENTAGE)),
+		fmt::arg(L"status", status), fmt::arg(L"percentage", percentage),
+		fmt::arg(L"rate", FormatSizeString(bytesPerSecond)));
+}
+
+}
@@ -0,0 +1,28 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class ResourceLoader;
+
+// Used by the dialogs that copy or overwrite file data on a background thread (split, merge and
+// destroy) to pass progress back to the dialog and display it.
+namespace TransferProgressHelper
+{
+
+// Posts the specified message to the window. The wParam will contain the progress, scaled to the
+// range [0, range], while the lParam will contain the transfer rate, in bytes per second. A
+// transfer with no data is treated as being complete.
+void PostProgressMessage(HWND hwnd, UINT message, std::uint64_t bytesCompleted,
+	std::uint64_t totalBytes, int range, std::uint64_t bytesPerSecond);
+
+std::wstring FormatStatus(const ResourceLoader *resourceLoader, const std::wstring &status,
+	std::uint64_t bytesPerSecond);
+std::wstring FormatStatus(const ResourceLoader *resourceLoader, const std::wstring &status,
+	int percentage, std::uint64_t bytesPerSecond);
+
+}
@@ -658,6 +658,12 @@
 #define IDS_APPLICATION_CONTEXT_MENU_NEW_HELP_TEXT 2173
 #define IDS_APPLICATION_CONTEXT_MENU_DELETE_HELP_TEXT 2174
 #define IDS_APPLICATION_CONTEXT_MENU_PROPERTIES_HELP_TEXT 2175
+#define IDS_MERGE_FILES_FAILED          2176
+#define IDS_SPLITFILEDIALOG_FAILED      2177
+#define IDS_TRANSFER_RATE_STATUS        2178
+#define IDS_TRANSFER_RATE_STATUS_WITH_PERCENTAGE 2179
+#define IDS_SEARCH_FINISHED_WITH_REGULAR_EXPRESSION_ERRORS_MESSAGE 2180
+#define IDS_DESTROY_FILES_FAILED        2181
 #define IDM_FILE_SAVEDIRECTORYLISTING   8002
 #define IDS_MERGE_FILES_COLUMN_FILE     8003
 #define IDS_OK                          8004
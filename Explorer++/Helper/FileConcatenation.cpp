@@ -0,0 +1,76 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "FileConcatenation.h"
+#include "PipelinedFileCopier.h"
+#include <wil/resource.h>
+
+namespace
+{
+
+struct InputFile
+{
+	wil::unique_hfile file;
+	std::uint64_t size;
+};
+
+bool SetFileSize(HANDLE file, std::uint64_t size)
+{
+	FILE_END_OF_FILE_INFO endOfFileInfo;
+	endOfFileInfo.EndOfFile.QuadPart = size;
+	return SetFileInformationByHandle(file, FileEndOfFileInfo, &endOfFileInfo,
+		sizeof(endOfFileInfo));
+}
+
+}
+
+bool ConcatenateFiles(const std::vector<std::wstring> &inputPaths, HANDLE outputFile,
+	PipelinedFileCopier &copier, ConcatenationSizeCallback sizeCallback)
+{
+	std::vector<InputFile> inputFiles;
+	std::uint64_t totalSize = 0;
+
+	for (const auto &inputPath : inputPaths)
+	{
+		wil::unique_hfile file(CreateFile(inputPath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+			nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+		LARGE_INTEGER size;
+
+		if (!file || !GetFileSizeEx(file.get(), &size))
+		{
+			LOG(WARNING) << "Failed to open input file (error " << GetLastError() << ")";
+			return false;
+		}
+
+		inputFiles.emplace_back(std::move(file), size.QuadPart);
+		totalSize += size.QuadPart;
+	}
+
+	if (sizeCallback)
+	{
+		sizeCallback(totalSize);
+	}
+
+	if (!SetFileSize(outputFile, totalSize))
+	{
+		LOG(ERROR) << "Failed to set size of output file (error " << GetLastError() << ")";
+		return false;
+	}
+
+	std::uint64_t outputOffset = 0;
+
+	for (const auto &inputFile : inputFiles)
+	{
+		if (!copier.CopyRange(inputFile.file.get(), 0, outputFile, outputOffset, inputFile.size))
+		{
+			SetFileSize(outputFile, outputOffset);
+			return false;
+		}
+
+		outputOffset += inputFile.size;
+	}
+
+	return true;
+}
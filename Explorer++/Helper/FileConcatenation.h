@@ -0,0 +1,25 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class PipelinedFileCopier;
+
+// Called once the combined size of the input files is known, before any data is copied.
+using ConcatenationSizeCallback = std::function<void(std::uint64_t totalSize)>;
+
+// Writes the contents of each of the input files, in order, to the output file, which should be
+// empty and opened for overlapped writes. Every input file is opened upfront and if any of them
+// can't be opened, nothing is written and false is returned. The size of the output file is also
+// set upfront, which reduces fragmentation and means that a lack of disk space is detected before
+// any data is copied. If an error occurs, or a stop is requested via the copier, the output file is
+// truncated so that it only contains the input files that were copied in full, and false is
+// returned.
+bool ConcatenateFiles(const std::vector<std::wstring> &inputPaths, HANDLE outputFile,
+	PipelinedFileCopier &copier, ConcatenationSizeCallback sizeCallback = nullptr);
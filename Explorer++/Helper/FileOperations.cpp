@@ -8,6 +8,7 @@
 #include "DragDropHelper.h"
 #include "DriveInfo.h"
 #include "Helper.h"
+#include "SecureDelete.h"
 #include "ShellHelper.h"
 #include "StringHelper.h"
 #include <wil/com.h>
@@ -15,8 +16,6 @@
 #include <list>
 #include <sstream>
 
-BOOL GetFileClusterSize(const std::wstring &strFilename, PLARGE_INTEGER lpRealFileSize);
-
 HRESULT FileOperations::RenameFile(IShellItem *item, const std::wstring &newName)
 {
 	wil::com_ptr_nothrow<IFileOperation> fo;
@@ -512,141 +511,8 @@ BOOL FileOperations::CreateBrowseDialog(HWND hOwner, const std::wstring &strTitl
 	return bSuccessful;
 }
 
-BOOL GetFileClusterSize(const std::wstring &strFilename, PLARGE_INTEGER lpRealFileSize)
-{
-	DWORD dwClusterSize;
-
-	LARGE_INTEGER lFileSize;
-	BOOL bRet = GetFileSizeEx(strFilename.c_str(), &lFileSize);
-
-	if (!bRet)
-	{
-		return FALSE;
-	}
-
-	TCHAR szRoot[MAX_PATH];
-	HRESULT hr = StringCchCopy(szRoot, std::size(szRoot), strFilename.c_str());
-
-	if (FAILED(hr))
-	{
-		return FALSE;
-	}
-
-	bRet = PathStripToRoot(szRoot);
-
-	if (!bRet)
-	{
-		return FALSE;
-	}
-
-	bRet = GetClusterSize(szRoot, &dwClusterSize);
-
-	if (!bRet)
-	{
-		return FALSE;
-	}
-
-	if ((lFileSize.QuadPart % dwClusterSize) != 0)
-	{
-		/* The real size is the logical file size rounded up to the end of the
-		nearest cluster. */
-		lFileSize.QuadPart += dwClusterSize - (lFileSize.QuadPart % dwClusterSize);
-	}
-
-	*lpRealFileSize = lFileSize;
-
-	return TRUE;
-}
-
 void FileOperations::DeleteFileSecurely(const std::wstring &strFilename,
 	OverwriteMethod overwriteMethod)
 {
-	HANDLE hFile;
-	WIN32_FIND_DATA wfd;
-	HANDLE hFindFile;
-	HCRYPTPROV hProv;
-	LARGE_INTEGER lRealFileSize;
-	BYTE pass1Data;
-	BYTE pass2Data;
-	BYTE pass3Data;
-	DWORD nBytesWritten;
-	BOOL bFolder;
-	int i = 0;
-
-	hFindFile = FindFirstFile(strFilename.c_str(), &wfd);
-
-	if (hFindFile == INVALID_HANDLE_VALUE)
-	{
-		return;
-	}
-
-	bFolder = (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY;
-
-	FindClose(hFindFile);
-
-	if (bFolder)
-	{
-		return;
-	}
-
-	/* Determine the actual size of the file on disk
-	(i.e. how many clusters it is allocated). */
-	GetFileClusterSize(strFilename, &lRealFileSize);
-
-	/* Open the file, block any sharing mode, to stop the file
-	been opened while it is overwritten. */
-	hFile =
-		CreateFile(strFilename.c_str(), FILE_WRITE_DATA, 0, nullptr, OPEN_EXISTING, NULL, nullptr);
-
-	if (hFile == INVALID_HANDLE_VALUE)
-	{
-		return;
-	}
-
-	/* Extend the file out to the end of its last sector. */
-	SetFilePointerEx(hFile, lRealFileSize, nullptr, FILE_BEGIN);
-	SetEndOfFile(hFile);
-
-	/* Start at the beginning of the file, and
-	write in the first-pass data, 0x00 over
-	the length of the whole file. */
-	SetFilePointer(hFile, 0, nullptr, FILE_BEGIN);
-	pass1Data = 0x00;
-
-	for (i = 0; i < lRealFileSize.QuadPart; i++)
-	{
-		WriteFile(hFile, (LPVOID) &pass1Data, 1, &nBytesWritten, nullptr);
-	}
-
-	if (overwriteMethod == OverwriteMethod::ThreePass)
-	{
-		/* Start at the beginning of the file, and
-		write in the second-pass data, 0xFF over
-		the length of the whole file. */
-		SetFilePointer(hFile, 0, nullptr, FILE_BEGIN);
-		pass2Data = 0xFF;
-
-		for (i = 0; i < lRealFileSize.QuadPart; i++)
-		{
-			WriteFile(hFile, (LPVOID) &pass2Data, 1, &nBytesWritten, nullptr);
-		}
-
-		SetFilePointer(hFile, 0, nullptr, FILE_BEGIN);
-
-		CryptAcquireContext(&hProv, _T("SecureDelete"), nullptr, PROV_RSA_AES, CRYPT_NEWKEYSET);
-
-		for (i = 0; i < lRealFileSize.QuadPart; i++)
-		{
-			CryptGenRandom(hProv, 1, (LPBYTE) &pass3Data);
-			WriteFile(hFile, (LPVOID) &pass3Data, 1, &nBytesWritten, nullptr);
-		}
-
-		CryptAcquireContext(&hProv, _T("SecureDelete"), nullptr, PROV_RSA_AES, CRYPT_DELETEKEYSET);
-	}
-
-	FlushFileBuffers(hFile);
-
-	CloseHandle(hFile);
-
-	DeleteFile(strFilename.c_str());
+	DeleteFilesSecurely({ strFilename }, overwriteMethod);
 }
@@ -0,0 +1,221 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "FileSearch.h"
+#include "ParallelDirectoryWalker.h"
+#include "WildcardPattern.h"
+#include <boost/core/noncopyable.hpp>
+#include <wil/resource.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <regex>
+
+namespace
+{
+
+// The minimum amount of time between progress updates.
+constexpr auto PROGRESS_INTERVAL = std::chrono::milliseconds(100);
+
+// Once this many results are waiting to be delivered, they'll be delivered immediately, so that the
+// number of results held at any one time is bounded.
+constexpr size_t MAX_PENDING_RESULTS = 5000;
+
+class FileSearcher : private boost::noncopyable
+{
+public:
+	FileSearcher(const FileSearchOptions &options, std::stop_token stopToken,
+		FileSearchProgressCallback progressCallback) :
+		m_options(options),
+		m_stopToken(stopToken),
+		m_progressCallback(progressCallback),
+		m_walker(stopToken, std::bind_front(&FileSearcher::ProcessDirectory, this)),
+		m_lastProgressTime(std::chrono::steady_clock::now())
+	{
+		if (!m_options.pattern.empty() && m_options.useRegularExpressions)
+		{
+			auto flags = std::regex_constants::ECMAScript;
+
+			if (m_options.caseInsensitive)
+			{
+				flags |= std::regex_constants::icase;
+			}
+
+			m_regex.assign(m_options.pattern, flags);
+		}
+		else if (!m_options.pattern.empty())
+		{
+			m_wildcardPattern.emplace(m_options.pattern, !m_options.caseInsensitive);
+		}
+	}
+
+	FileSearchSummary Search(const std::wstring &directory)
+	{
+		m_walker.Walk(directory);
+
+		std::scoped_lock lock(m_progressMutex);
+
+		if (m_progressCallback && !m_pendingProgress.results.empty())
+		{
+			m_progressCallback(std::move(m_pendingProgress));
+		}
+
+		return { m_numFoldersFound, m_numFilesFound, m_regexMatchFailed };
+	}
+
+private:
+	void ProcessDirectory(const std::wstring &path, std::vector<std::wstring> &subdirectories)
+	{
+		std::vector<FileSearchResult> results;
+		int numFoldersFound = 0;
+		int numFilesFound = 0;
+
+		// The path may already end in a separator (e.g. if it's the root of a drive).
+		std::wstring directoryPrefix = path;
+
+		if (!directoryPrefix.ends_with(L'\\'))
+		{
+			directoryPrefix += L'\\';
+		}
+
+		WIN32_FIND_DATA findData;
+		wil::unique_hfind findFile(FindFirstFileEx((directoryPrefix + L"*").c_str(),
+			FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH));
+
+		if (findFile)
+		{
+			do
+			{
+				bool isFolder = WI_IsFlagSet(findData.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY);
+
+				if (isFolder
+					&& (lstrcmp(findData.cFileName, L".") == 0
+						|| lstrcmp(findData.cFileName, L"..") == 0))
+				{
+					continue;
+				}
+
+				if (DoesItemMatch(findData))
+				{
+					results.emplace_back(directoryPrefix + findData.cFileName, isFolder);
+
+					if (isFolder)
+					{
+						numFoldersFound++;
+					}
+					else
+					{
+						numFilesFound++;
+					}
+				}
+
+				// Following a junction or symbolic link could result in the same items being found
+				// more than once, or in a cycle.
+				if (isFolder && m_options.searchSubfolders
+					&& WI_IsFlagClear(findData.dwFileAttributes, FILE_ATTRIBUTE_REPARSE_POINT))
+				{
+					subdirectories.push_back(directoryPrefix + findData.cFileName);
+				}
+			} while (!m_stopToken.stop_requested() && FindNextFile(findFile.get(), &findData));
+		}
+
+		m_numFoldersFound += numFoldersFound;
+		m_numFilesFound += numFilesFound;
+
+		AddProgress(std::move(results), path);
+	}
+
+	bool DoesItemMatch(const WIN32_FIND_DATA &findData) const
+	{
+		if ((findData.dwFileAttributes & m_options.attributes) != m_options.attributes)
+		{
+			return false;
+		}
+
+		if (m_options.pattern.empty())
+		{
+			return true;
+		}
+
+		if (m_options.useRegularExpressions)
+		{
+			return DoesNameMatchRegex(findData.cFileName);
+		}
+
+		return m_wildcardPattern->Matches(findData.cFileName);
+	}
+
+	bool DoesNameMatchRegex(const wchar_t *name) const
+	{
+		// This runs on the walker's threads, so an exception can't be allowed to escape. A valid
+		// expression can still fail to match if it's too complex to evaluate against a particular
+		// name (e.g. std::regex_constants::error_complexity or error_stack).
+		try
+		{
+			return std::regex_match(name, m_regex);
+		}
+		catch (const std::regex_error &e)
+		{
+			if (!m_regexMatchFailed.exchange(true))
+			{
+				LOG(WARNING) << "Regular expression match failed: " << e.what();
+			}
+
+			return false;
+		}
+	}
+
+	void AddProgress(std::vector<FileSearchResult> &&results, const std::wstring &directory)
+	{
+		if (!m_progressCallback)
+		{
+			return;
+		}
+
+		std::scoped_lock lock(m_progressMutex);
+
+		m_pendingProgress.results.insert(m_pendingProgress.results.end(),
+			std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+		m_pendingProgress.currentDirectory = directory;
+
+		auto now = std::chrono::steady_clock::now();
+
+		if (now - m_lastProgressTime < PROGRESS_INTERVAL
+			&& m_pendingProgress.results.size() < MAX_PENDING_RESULTS)
+		{
+			return;
+		}
+
+		m_lastProgressTime = now;
+		m_progressCallback(std::move(m_pendingProgress));
+		m_pendingProgress = {};
+	}
+
+	const FileSearchOptions m_options;
+	const std::stop_token m_stopToken;
+	const FileSearchProgressCallback m_progressCallback;
+	std::wregex m_regex;
+	std::optional<WildcardPattern> m_wildcardPattern;
+	ParallelDirectoryWalker m_walker;
+
+	std::atomic<int> m_numFoldersFound = 0;
+	std::atomic<int> m_numFilesFound = 0;
+	mutable std::atomic<bool> m_regexMatchFailed = false;
+
+	std::mutex m_progressMutex;
+	FileSearchProgress m_pendingProgress;
+	std::chrono::steady_clock::time_point m_lastProgressTime;
+};
+
+}
+
+FileSearchSummary SearchFiles(const std::wstring &directory, const FileSearchOptions &options,
+	std::stop_token stopToken, FileSearchProgressCallback progressCallback)
+{
+	FileSearcher searcher(options, stopToken, progressCallback);
+	return searcher.Search(directory);
+}
@@ -0,0 +1,65 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <functional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+struct FileSearchOptions
+{
+	// The pattern that item names are matched against. This is either a wildcard pattern or a
+	// regular expression. If the pattern is empty, every item will match.
+	std::wstring pattern;
+	bool useRegularExpressions = false;
+	bool caseInsensitive = true;
+	bool searchSubfolders = true;
+
+	// If set, only items that have all of these attributes will match.
+	DWORD attributes = 0;
+};
+
+struct FileSearchResult
+{
+	std::wstring path;
+	bool isFolder;
+};
+
+struct FileSearchProgress
+{
+	// The items that have been found since the previous update.
+	std::vector<FileSearchResult> results;
+
+	// One of the directories that's currently being searched.
+	std::wstring currentDirectory;
+};
+
+struct FileSearchSummary
+{
+	int numFoldersFound;
+	int numFilesFound;
+
+	// True if the regular expression couldn't be evaluated against at least one of the item names
+	// (e.g. because the expression was too complex to evaluate against a long name). Those items
+	// are treated as not matching.
+	bool regexMatchFailed;
+};
+
+// Called periodically while a search is in progress. Results are delivered in batches, rather than
+// individually, so that a search that finds a large number of items doesn't have to notify the
+// caller for every one of them. This may be called from any of the threads that are used to
+// perform the search, though it will never be called concurrently. Once the search has finished,
+// this will be called one final time with any remaining results.
+using FileSearchProgressCallback = std::function<void(FileSearchProgress &&progress)>;
+
+// Searches the specified directory for items that match the options provided. Subdirectories are
+// searched in parallel. Directory junctions and symbolic links to folders can be matched, but
+// aren't searched. If a stop is requested, the search will finish early.
+//
+// Throws std::regex_error if a regular expression is being used and it's invalid. Errors that occur
+// while matching an individual item are reported through the summary instead.
+FileSearchSummary SearchFiles(const std::wstring &directory, const FileSearchOptions &options,
+	std::stop_token stopToken, FileSearchProgressCallback progressCallback);
@@ -4,63 +4,290 @@
 
 #include "stdafx.h"
 #include "FolderSize.h"
-#include <filesystem>
+#include "ParallelDirectoryWalker.h"
+#include <boost/core/noncopyable.hpp>
+#include <wil/resource.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
-FolderInfo GetFolderInfo(const std::wstring &path)
+namespace
 {
-	FolderInfo folderInfo = {};
-	std::error_code error;
 
-	for (const auto &entry : std::filesystem::directory_iterator(path, error))
+// The minimum amount of time between progress updates.
+constexpr auto PROGRESS_INTERVAL = std::chrono::milliseconds(100);
+
+void AddFolderInfo(FolderInfo &target, const FolderInfo &source)
+{
+	target.size += source.size;
+	target.numFolders += source.numFolders;
+	target.numFiles += source.numFiles;
+}
+
+// Totals the files in a folder tree. The tree is scanned in parallel by ParallelDirectoryWalker.
+class FolderSizeCalculator : private boost::noncopyable
+{
+public:
+	FolderSizeCalculator(std::stop_token stopToken, FolderInfoProgressCallback progressCallback,
+		FolderInfoLookup subfolderLookup, FolderInfoSubfolderCallback subfolderCallback) :
+		m_stopToken(stopToken),
+		m_progressCallback(progressCallback),
+		m_subfolderLookup(subfolderLookup),
+		m_subfolderCallback(subfolderCallback),
+		m_walker(stopToken, std::bind_front(&FolderSizeCalculator::ProcessDirectory, this)),
+		m_lastProgressTime(std::chrono::steady_clock::now())
 	{
-		std::error_code typeErrorCode;
-		auto isDirectory = entry.is_directory(typeErrorCode);
+	}
 
-		if (typeErrorCode)
+	FolderInfo Calculate(const std::wstring &path)
+	{
+		if (m_subfolderCallback)
 		{
-			continue;
+			m_pendingFolders.emplace(path, PendingFolder());
 		}
 
-		if (isDirectory)
+		m_walker.Walk(path);
+		return { m_size, m_numFolders, m_numFiles };
+	}
+
+private:
+	// Tracks a folder whose totals aren't yet known, because either the folder itself, or one of
+	// the folders below it, hasn't been scanned yet.
+	struct PendingFolder
+	{
+		// This will be empty for the root folder.
+		std::wstring parentPath;
+
+		FILETIME lastWriteTime = {};
+		FolderInfo totals = {};
+		size_t numPendingSubfolders = 0;
+		bool scanned = false;
+	};
+
+	void ProcessDirectory(const std::wstring &path, std::vector<std::wstring> &subdirectories)
+	{
+		std::uintmax_t size = 0;
+		int numFolders = 0;
+		int numFiles = 0;
+		std::vector<FILETIME> subdirectoryWriteTimes;
+
+		// The path may already end in a separator (e.g. if it's the root of a drive).
+		std::wstring directoryPrefix = path;
+
+		if (!directoryPrefix.ends_with(L'\\'))
 		{
-			folderInfo.numFolders++;
+			directoryPrefix += L'\\';
+		}
+
+		WIN32_FIND_DATA findData;
+		wil::unique_hfind findFile(FindFirstFileEx((directoryPrefix + L"*").c_str(),
+			FindExInfoBasic, &findData, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH));
 
-			FolderInfo subFolderInfo = GetFolderInfo(entry.path());
+		if (findFile)
+		{
+			do
+			{
+				if (WI_IsFlagSet(findData.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY))
+				{
+					if (lstrcmp(findData.cFileName, L".") == 0
+						|| lstrcmp(findData.cFileName, L"..") == 0)
+					{
+						continue;
+					}
 
-			folderInfo.size += subFolderInfo.size;
-			folderInfo.numFolders += subFolderInfo.numFolders;
-			folderInfo.numFiles += subFolderInfo.numFiles;
+					numFolders++;
+
+					// Following a junction or symbolic link could result in the same files being
+					// counted more than once, or in a cycle.
+					if (WI_IsFlagSet(findData.dwFileAttributes, FILE_ATTRIBUTE_REPARSE_POINT))
+					{
+						continue;
+					}
+
+					auto subdirectory = directoryPrefix + findData.cFileName;
+					std::optional<FolderInfo> existingInfo;
+
+					if (m_subfolderLookup)
+					{
+						existingInfo = m_subfolderLookup(subdirectory, findData.ftLastWriteTime);
+					}
+
+					if (existingInfo)
+					{
+						size += existingInfo->size;
+						numFolders += existingInfo->numFolders;
+						numFiles += existingInfo->numFiles;
+					}
+					else
+					{
+						subdirectories.push_back(std::move(subdirectory));
+						subdirectoryWriteTimes.push_back(findData.ftLastWriteTime);
+					}
+				}
+				else
+				{
+					// The size returned during enumeration is used directly, which avoids having to
+					// open each file to query its size.
+					ULARGE_INTEGER fileSize = { { findData.nFileSizeLow, findData.nFileSizeHigh } };
+					size += fileSize.QuadPart;
+					numFiles++;
+				}
+			} while (!m_stopToken.stop_requested() && FindNextFile(findFile.get(), &findData));
 		}
-		else
+
+		m_size += size;
+		m_numFolders += numFolders;
+		m_numFiles += numFiles;
+
+		// If a stop was requested, this folder may not have been fully scanned, so its totals (and
+		// those of the folders above it) are never considered complete.
+		if (m_subfolderCallback && !m_stopToken.stop_requested())
+		{
+			OnFolderScanned(path, { size, numFolders, numFiles }, subdirectories,
+				subdirectoryWriteTimes);
+		}
+
+		MaybeReportProgress();
+	}
+
+	void OnFolderScanned(const std::wstring &path, const FolderInfo &folderInfo,
+		const std::vector<std::wstring> &subdirectories,
+		const std::vector<FILETIME> &subdirectoryWriteTimes)
+	{
+		std::vector<std::tuple<std::wstring, FILETIME, FolderInfo>> completedFolders;
+
+		std::unique_lock lock(m_pendingFoldersMutex);
+
+		auto itr = m_pendingFolders.find(path);
+
+		if (itr == m_pendingFolders.end())
 		{
-			std::error_code sizeErrorCode;
-			const auto size = std::filesystem::file_size(entry.path(), sizeErrorCode);
+			// A folder above this one wasn't fully scanned.
+			return;
+		}
 
-			// If the size can't be retrieved, the error will be ignored and the current file will
-			// effectively be skipped over.
-			if (!sizeErrorCode)
+		auto &pendingFolder = itr->second;
+		AddFolderInfo(pendingFolder.totals, folderInfo);
+		pendingFolder.numPendingSubfolders += subdirectories.size();
+		pendingFolder.scanned = true;
+
+		for (size_t i = 0; i < subdirectories.size(); i++)
+		{
+			m_pendingFolders.emplace(subdirectories[i],
+				PendingFolder{ .parentPath = path, .lastWriteTime = subdirectoryWriteTimes[i] });
+		}
+
+		// Completing a folder may also complete the folders above it.
+		auto currentPath = path;
+
+		while (true)
+		{
+			auto currentItr = m_pendingFolders.find(currentPath);
+			auto &currentFolder = currentItr->second;
+
+			if (!currentFolder.scanned || currentFolder.numPendingSubfolders > 0)
 			{
-				folderInfo.size += size;
-				folderInfo.numFiles++;
+				break;
 			}
+
+			if (currentFolder.parentPath.empty())
+			{
+				// The totals for the root folder are returned directly.
+				m_pendingFolders.erase(currentItr);
+				break;
+			}
+
+			auto &parentFolder = m_pendingFolders.at(currentFolder.parentPath);
+			AddFolderInfo(parentFolder.totals, currentFolder.totals);
+			parentFolder.numPendingSubfolders--;
+
+			auto parentPath = currentFolder.parentPath;
+			completedFolders.emplace_back(std::move(currentPath), currentFolder.lastWriteTime,
+				currentFolder.totals);
+			m_pendingFolders.erase(currentItr);
+
+			currentPath = std::move(parentPath);
+		}
+
+		lock.unlock();
+
+		for (const auto &[completedPath, lastWriteTime, totals] : completedFolders)
+		{
+			m_subfolderCallback(completedPath, lastWriteTime, totals);
+		}
+	}
+
+	void MaybeReportProgress()
+	{
+		if (!m_progressCallback)
+		{
+			return;
+		}
+
+		std::unique_lock lock(m_progressMutex, std::try_to_lock);
+
+		if (!lock.owns_lock())
+		{
+			// Another worker is reporting progress.
+			return;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+
+		if (now - m_lastProgressTime < PROGRESS_INTERVAL)
+		{
+			return;
 		}
+
+		m_lastProgressTime = now;
+		m_progressCallback({ m_size, m_numFolders, m_numFiles });
 	}
 
-	return folderInfo;
+	const std::stop_token m_stopToken;
+	const FolderInfoProgressCallback m_progressCallback;
+	const FolderInfoLookup m_subfolderLookup;
+	const FolderInfoSubfolderCallback m_subfolderCallback;
+	ParallelDirectoryWalker m_walker;
+
+	std::atomic<std::uintmax_t> m_size = 0;
+	std::atomic<int> m_numFolders = 0;
+	std::atomic<int> m_numFiles = 0;
+
+	std::mutex m_progressMutex;
+	std::chrono::steady_clock::time_point m_lastProgressTime;
+
+	std::mutex m_pendingFoldersMutex;
+	std::unordered_map<std::wstring, PendingFolder> m_pendingFolders;
+};
+
+}
+
+FolderInfo GetFolderInfo(const std::wstring &path, std::stop_token stopToken,
+	FolderInfoProgressCallback progressCallback, FolderInfoLookup subfolderLookup,
+	FolderInfoSubfolderCallback subfolderCallback)
+{
+	FolderSizeCalculator calculator(stopToken, progressCallback, subfolderLookup,
+		subfolderCallback);
+	return calculator.Calculate(path);
 }
 
 DWORD WINAPI Thread_CalculateFolderSize(LPVOID lpParameter)
 {
 	FolderSize_t *pFolderSize = reinterpret_cast<FolderSize_t *>(lpParameter);
 
-	auto folderInfo = GetFolderInfo(pFolderSize->szPath);
+	auto folderInfo = GetFolderInfo(pFolderSize->szPath, pFolderSize->stopToken);
 
 	ULARGE_INTEGER size;
 	size.QuadPart = folderInfo.size;
 
 	pFolderSize->pfnCallback(folderInfo.numFolders, folderInfo.numFiles, &size, pFolderSize->pData);
 
-	free(pFolderSize);
+	delete pFolderSize;
 
 	return 1;
 }
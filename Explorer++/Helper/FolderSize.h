@@ -4,20 +4,58 @@
 
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stop_token>
+#include <string>
+
 struct FolderInfo
 {
 	std::uintmax_t size;
 	int numFolders;
 	int numFiles;
+
+	bool operator==(const FolderInfo &) const = default;
 };
 
-FolderInfo GetFolderInfo(const std::wstring &path);
+// Called periodically while a folder is being scanned, with the totals found so far. This may be
+// called from any of the threads that are used to scan the folder, though it will never be called
+// concurrently.
+using FolderInfoProgressCallback = std::function<void(const FolderInfo &folderInfo)>;
+
+// Called for each subfolder that's found while a folder is being scanned. If previously calculated
+// totals for the subfolder are returned, those totals will be used and the subfolder won't be
+// scanned. This will be called concurrently from the threads that are used to scan the folder.
+using FolderInfoLookup = std::function<std::optional<FolderInfo>(const std::wstring &path,
+	const FILETIME &lastWriteTime)>;
+
+// Called once the totals for a subfolder that was scanned are known (i.e. once the subfolder and
+// everything below it have been scanned). This allows the totals for each subfolder to be reused
+// later, without having to scan the subfolder again. This will be called concurrently from the
+// threads that are used to scan the folder. It won't be called for any subfolder that wasn't
+// completely scanned because a stop was requested.
+using FolderInfoSubfolderCallback = std::function<void(const std::wstring &path,
+	const FILETIME &lastWriteTime, const FolderInfo &folderInfo)>;
+
+// Calculates the total size of the specified folder, along with the number of files and folders it
+// contains. Subfolders are scanned in parallel. Directory junctions and symbolic links to folders
+// are counted, but not followed. If a stop is requested, the scan will finish early and the totals
+// found up to that point will be returned.
+FolderInfo GetFolderInfo(const std::wstring &path, std::stop_token stopToken = {},
+	FolderInfoProgressCallback progressCallback = nullptr,
+	FolderInfoLookup subfolderLookup = nullptr,
+	FolderInfoSubfolderCallback subfolderCallback = nullptr);
 
 typedef struct
 {
 	TCHAR szPath[MAX_PATH];
 	LPVOID pData;
 	void (*pfnCallback)(int nFolders, int nFiles, PULARGE_INTEGER lTotalFolderSize, LPVOID pData);
+
+	// If a stop is requested, the calculation will finish early. The callback will still be
+	// invoked, with the totals found up to that point.
+	std::stop_token stopToken;
 } FolderSize_t;
 
 DWORD WINAPI Thread_CalculateFolderSize(LPVOID lpParameter);
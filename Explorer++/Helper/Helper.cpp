@@ -28,7 +28,10 @@ enum class VersionSubBlockType
 BOOL GetFileVersionValue(const TCHAR *szFullFileName, VersionSubBlockType subBlockType,
 	WORD *pwLanguage, DWORD *pdwProductVersionLS, DWORD *pdwProductVersionMS,
 	const TCHAR *szVersionInfo, TCHAR *szVersionBuffer, UINT cchMax);
-BOOL GetStringTableValue(void *pBlock, LangAndCodePage *plcp, UINT nItems,
+BOOL GetVersionInfoValue(const void *pBlock, VersionSubBlockType subBlockType, WORD *pwLanguage,
+	DWORD *pdwProductVersionLS, DWORD *pdwProductVersionMS, const TCHAR *szVersionInfo,
+	TCHAR *szVersionBuffer, UINT cchMax);
+BOOL GetStringTableValue(const void *pBlock, LangAndCodePage *plcp, UINT nItems,
 	const TCHAR *szVersionInfo, TCHAR *szVersionBuffer, UINT cchMax);
 
 BOOL CreateFileTimeString(const FILETIME *utcFileTime, TCHAR *szBuffer, size_t cchMax,
@@ -329,51 +332,59 @@ BOOL ReadImageProperty(const TCHAR *lpszImage, PROPID propId, TCHAR *szProperty,
 
 	if (image->GetLastStatus() == Gdiplus::Ok)
 	{
-		if (propId == PropertyTagImageWidth)
-		{
-			bSuccess = TRUE;
-			StringCchPrintf(szProperty, cchMax, _T("%u pixels"), image->GetWidth());
-		}
-		else if (propId == PropertyTagImageHeight)
-		{
-			bSuccess = TRUE;
-			StringCchPrintf(szProperty, cchMax, _T("%u pixels"), image->GetHeight());
-		}
-		else
+		bSuccess = ReadImageProperty(image, propId, szProperty, cchMax);
+	}
+
+	delete image;
+
+	return bSuccess;
+}
+
+BOOL ReadImageProperty(Gdiplus::Image *image, PROPID propId, TCHAR *szProperty, int cchMax)
+{
+	BOOL bSuccess = FALSE;
+
+	if (propId == PropertyTagImageWidth)
+	{
+		bSuccess = TRUE;
+		StringCchPrintf(szProperty, cchMax, _T("%u pixels"), image->GetWidth());
+	}
+	else if (propId == PropertyTagImageHeight)
+	{
+		bSuccess = TRUE;
+		StringCchPrintf(szProperty, cchMax, _T("%u pixels"), image->GetHeight());
+	}
+	else
+	{
+		UINT size = image->GetPropertyItemSize(propId);
+
+		if (size != 0)
 		{
-			UINT size = image->GetPropertyItemSize(propId);
+			auto *propertyItem = reinterpret_cast<Gdiplus::PropertyItem *>(malloc(size));
 
-			if (size != 0)
+			if (propertyItem != nullptr)
 			{
-				auto *propertyItem = reinterpret_cast<Gdiplus::PropertyItem *>(malloc(size));
+				Gdiplus::Status status = image->GetPropertyItem(propId, size, propertyItem);
 
-				if (propertyItem != nullptr)
+				if (status == Gdiplus::Ok)
 				{
-					Gdiplus::Status status = image->GetPropertyItem(propId, size, propertyItem);
-
-					if (status == Gdiplus::Ok)
+					if (propertyItem->type == PropertyTagTypeASCII)
 					{
-						if (propertyItem->type == PropertyTagTypeASCII)
+						int iRes = MultiByteToWideChar(CP_ACP, 0,
+							reinterpret_cast<LPCSTR>(propertyItem->value), -1, szProperty, cchMax);
+
+						if (iRes != 0)
 						{
-							int iRes = MultiByteToWideChar(CP_ACP, 0,
-								reinterpret_cast<LPCSTR>(propertyItem->value), -1, szProperty,
-								cchMax);
-
-							if (iRes != 0)
-							{
-								bSuccess = TRUE;
-							}
+							bSuccess = TRUE;
 						}
 					}
-
-					free(propertyItem);
 				}
+
+				free(propertyItem);
 			}
 		}
 	}
 
-	delete image;
-
 	return bSuccess;
 }
 
@@ -423,77 +434,103 @@ BOOL GetVersionInfoString(const TCHAR *szFullFileName, const TCHAR *szVersionInf
 		nullptr, nullptr, szVersionInfo, szVersionBuffer, cchMax);
 }
 
+BOOL GetVersionInfoString(const std::vector<BYTE> &versionInfo, const TCHAR *szVersionInfo,
+	TCHAR *szVersionBuffer, UINT cchMax)
+{
+	return GetVersionInfoValue(versionInfo.data(), VersionSubBlockType::StringTableValue, nullptr,
+		nullptr, nullptr, szVersionInfo, szVersionBuffer, cchMax);
+}
+
+bool LoadFileVersionInfo(const TCHAR *szFullFileName, std::vector<BYTE> &versionInfo)
+{
+	DWORD dwLen = GetFileVersionInfoSize(szFullFileName, nullptr);
+
+	if (dwLen == 0)
+	{
+		return false;
+	}
+
+	versionInfo.resize(dwLen);
+	BOOL bRet = GetFileVersionInfo(szFullFileName, NULL, dwLen, versionInfo.data());
+
+	if (!bRet)
+	{
+		versionInfo.clear();
+		return false;
+	}
+
+	return true;
+}
+
 BOOL GetFileVersionValue(const TCHAR *szFullFileName, VersionSubBlockType subBlockType,
 	WORD *pwLanguage, DWORD *pdwProductVersionLS, DWORD *pdwProductVersionMS,
 	const TCHAR *szVersionInfo, TCHAR *szVersionBuffer, UINT cchMax)
 {
-	BOOL bSuccess = FALSE;
-	DWORD dwLen = GetFileVersionInfoSize(szFullFileName, nullptr);
+	std::vector<BYTE> versionInfo;
+	bool loaded = LoadFileVersionInfo(szFullFileName, versionInfo);
 
-	if (dwLen > 0)
+	if (!loaded)
 	{
-		void *pBlock = malloc(dwLen);
-
-		if (pBlock != nullptr)
-		{
-			BOOL bRet = GetFileVersionInfo(szFullFileName, NULL, dwLen, pBlock);
+		return FALSE;
+	}
 
-			if (bRet)
-			{
-				TCHAR szSubBlock[64];
-				LPVOID *pBuffer = nullptr;
-				UINT uStructureSize = 0;
+	return GetVersionInfoValue(versionInfo.data(), subBlockType, pwLanguage, pdwProductVersionLS,
+		pdwProductVersionMS, szVersionInfo, szVersionBuffer, cchMax);
+}
 
-				LangAndCodePage *plcp = nullptr;
-				VS_FIXEDFILEINFO *pvsffi = nullptr;
+BOOL GetVersionInfoValue(const void *pBlock, VersionSubBlockType subBlockType, WORD *pwLanguage,
+	DWORD *pdwProductVersionLS, DWORD *pdwProductVersionMS, const TCHAR *szVersionInfo,
+	TCHAR *szVersionBuffer, UINT cchMax)
+{
+	BOOL bSuccess = FALSE;
+	TCHAR szSubBlock[64];
+	LPVOID *pBuffer = nullptr;
+	UINT uStructureSize = 0;
 
-				if (subBlockType == VersionSubBlockType::Root)
-				{
-					StringCchCopy(szSubBlock, std::size(szSubBlock), _T("\\"));
-					pBuffer = reinterpret_cast<LPVOID *>(&pvsffi);
-					uStructureSize = sizeof(VS_FIXEDFILEINFO);
-				}
-				else if (subBlockType == VersionSubBlockType::Translation
-					|| subBlockType == VersionSubBlockType::StringTableValue)
-				{
-					StringCchCopy(szSubBlock, std::size(szSubBlock),
-						_T("\\VarFileInfo\\Translation"));
-					pBuffer = reinterpret_cast<LPVOID *>(&plcp);
-					uStructureSize = sizeof(LangAndCodePage);
-				}
+	LangAndCodePage *plcp = nullptr;
+	VS_FIXEDFILEINFO *pvsffi = nullptr;
 
-				UINT uLen;
-				bRet = VerQueryValue(pBlock, szSubBlock, pBuffer, &uLen);
+	if (subBlockType == VersionSubBlockType::Root)
+	{
+		StringCchCopy(szSubBlock, std::size(szSubBlock), _T("\\"));
+		pBuffer = reinterpret_cast<LPVOID *>(&pvsffi);
+		uStructureSize = sizeof(VS_FIXEDFILEINFO);
+	}
+	else if (subBlockType == VersionSubBlockType::Translation
+		|| subBlockType == VersionSubBlockType::StringTableValue)
+	{
+		StringCchCopy(szSubBlock, std::size(szSubBlock), _T("\\VarFileInfo\\Translation"));
+		pBuffer = reinterpret_cast<LPVOID *>(&plcp);
+		uStructureSize = sizeof(LangAndCodePage);
+	}
 
-				if (bRet && (uLen >= uStructureSize))
-				{
-					bSuccess = TRUE;
+	UINT uLen;
+	BOOL bRet = VerQueryValue(pBlock, szSubBlock, pBuffer, &uLen);
 
-					if (subBlockType == VersionSubBlockType::Root)
-					{
-						*pdwProductVersionLS = pvsffi->dwProductVersionLS;
-						*pdwProductVersionMS = pvsffi->dwProductVersionMS;
-					}
-					else if (subBlockType == VersionSubBlockType::Translation)
-					{
-						*pwLanguage = plcp[0].wLanguage;
-					}
-					else if (subBlockType == VersionSubBlockType::StringTableValue)
-					{
-						bSuccess = GetStringTableValue(pBlock, plcp, uLen / sizeof(LangAndCodePage),
-							szVersionInfo, szVersionBuffer, cchMax);
-					}
-				}
-			}
+	if (bRet && (uLen >= uStructureSize))
+	{
+		bSuccess = TRUE;
 
-			free(pBlock);
+		if (subBlockType == VersionSubBlockType::Root)
+		{
+			*pdwProductVersionLS = pvsffi->dwProductVersionLS;
+			*pdwProductVersionMS = pvsffi->dwProductVersionMS;
+		}
+		else if (subBlockType == VersionSubBlockType::Translation)
+		{
+			*pwLanguage = plcp[0].wLanguage;
+		}
+		else if (subBlockType == VersionSubBlockType::StringTableValue)
+		{
+			bSuccess = GetStringTableValue(pBlock, plcp, uLen / sizeof(LangAndCodePage),
+				szVersionInfo, szVersionBuffer, cchMax);
 		}
 	}
 
 	return bSuccess;
 }
 
-BOOL GetStringTableValue(void *pBlock, LangAndCodePage *plcp, UINT nItems,
+BOOL GetStringTableValue(const void *pBlock, LangAndCodePage *plcp, UINT nItems,
 	const TCHAR *szVersionInfo, TCHAR *szVersionBuffer, UINT cchMax)
 {
 	BOOL bSuccess = FALSE;
@@ -569,67 +606,102 @@ HRESULT GetCPUBrandString(std::wstring &cpuBrand)
 
 HRESULT GetMediaMetadata(const TCHAR *szFileName, const TCHAR *szAttribute, BYTE **pszOutput)
 {
-	typedef HRESULT(WINAPI * WMCREATEEDITOR_PROC)(IWMMetadataEditor **);
-	WMCREATEEDITOR_PROC pWMCreateEditor = nullptr;
-	HMODULE hWMVCore;
-	IWMMetadataEditor *pEditor = nullptr;
-	IWMHeaderInfo *pWMHeaderInfo = nullptr;
-	HRESULT hr = E_FAIL;
+	wil::unique_hmodule wmvCore;
+	wil::com_ptr_nothrow<IWMHeaderInfo> headerInfo;
+	HRESULT hr = OpenMediaMetadata(szFileName, wmvCore, headerInfo);
+
+	if (FAILED(hr))
+	{
+		return hr;
+	}
 
-	hWMVCore = LoadLibrary(_T("wmvcore.dll"));
+	return GetMediaMetadata(headerInfo.get(), szAttribute, pszOutput);
+}
+
+HRESULT GetMediaMetadata(IWMHeaderInfo *headerInfo, const TCHAR *szAttribute, BYTE **pszOutput)
+{
+	WMT_ATTR_DATATYPE type;
+	WORD cbLength;
 
-	if (hWMVCore != nullptr)
+	/* Any stream. Should be zero for MP3 files. */
+	WORD wStreamNum = 0;
+
+	HRESULT hr =
+		headerInfo->GetAttributeByName(&wStreamNum, szAttribute, &type, nullptr, &cbLength);
+
+	if (FAILED(hr))
 	{
-		pWMCreateEditor =
-			std::bit_cast<WMCREATEEDITOR_PROC>(GetProcAddress(hWMVCore, "WMCreateEditor"));
+		return hr;
+	}
 
-		if (pWMCreateEditor != nullptr)
-		{
-			hr = pWMCreateEditor(&pEditor);
+	*pszOutput = (BYTE *) malloc(cbLength);
 
-			if (SUCCEEDED(hr))
-			{
-				hr = pEditor->Open(szFileName);
+	if (*pszOutput == nullptr)
+	{
+		return E_OUTOFMEMORY;
+	}
 
-				if (SUCCEEDED(hr))
-				{
-					hr = pEditor->QueryInterface(IID_PPV_ARGS(&pWMHeaderInfo));
+	hr = headerInfo->GetAttributeByName(&wStreamNum, szAttribute, &type, *pszOutput, &cbLength);
 
-					if (SUCCEEDED(hr))
-					{
-						WORD wStreamNum;
-						WMT_ATTR_DATATYPE type;
-						WORD cbLength;
+	if (FAILED(hr))
+	{
+		free(*pszOutput);
+		*pszOutput = nullptr;
+	}
 
-						/* Any stream. Should be zero for MP3 files. */
-						wStreamNum = 0;
+	return hr;
+}
 
-						hr = pWMHeaderInfo->GetAttributeByName(&wStreamNum, szAttribute, &type,
-							nullptr, &cbLength);
+HRESULT OpenMediaMetadata(const TCHAR *szFileName, wil::unique_hmodule &wmvCore,
+	wil::com_ptr_nothrow<IWMHeaderInfo> &headerInfo)
+{
+	typedef HRESULT(WINAPI * WMCREATEEDITOR_PROC)(IWMMetadataEditor **);
 
-						if (SUCCEEDED(hr))
-						{
-							*pszOutput = (BYTE *) malloc(cbLength);
+	wil::unique_hmodule module(LoadLibrary(_T("wmvcore.dll")));
 
-							if (*pszOutput != nullptr)
-							{
-								hr = pWMHeaderInfo->GetAttributeByName(&wStreamNum, szAttribute,
-									&type, *pszOutput, &cbLength);
-							}
-						}
+	if (!module)
+	{
+		return E_FAIL;
+	}
 
-						pWMHeaderInfo->Release();
-					}
-				}
+	auto pWMCreateEditor =
+		std::bit_cast<WMCREATEEDITOR_PROC>(GetProcAddress(module.get(), "WMCreateEditor"));
 
-				pEditor->Release();
-			}
-		}
+	if (pWMCreateEditor == nullptr)
+	{
+		return E_FAIL;
+	}
 
-		FreeLibrary(hWMVCore);
+	wil::com_ptr_nothrow<IWMMetadataEditor> editor;
+	HRESULT hr = pWMCreateEditor(&editor);
+
+	if (FAILED(hr))
+	{
+		return hr;
 	}
 
-	return hr;
+	hr = editor->Open(szFileName);
+
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	wil::com_ptr_nothrow<IWMHeaderInfo> openedHeaderInfo;
+	hr = editor->QueryInterface(IID_PPV_ARGS(&openedHeaderInfo));
+
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	// The header needs to be released before the module, so any header the caller was previously
+	// holding is released first.
+	headerInfo.reset();
+	wmvCore = std::move(module);
+	headerInfo = std::move(openedHeaderInfo);
+
+	return S_OK;
 }
 
 void SetFORMATETC(FORMATETC *pftc, CLIPFORMAT cfFormat, DVTARGETDEVICE *ptd, DWORD dwAspect,
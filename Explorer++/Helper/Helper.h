@@ -6,10 +6,19 @@
 
 #include <boost/bimap.hpp>
 #include <boost/numeric/conversion/cast.hpp>
+#include <wil/com.h>
 #include <wil/resource.h>
 #include <windows.h>
 #include <optional>
 #include <string>
+#include <vector>
+
+namespace Gdiplus
+{
+class Image;
+}
+
+struct IWMHeaderInfo;
 
 struct LangAndCodePage
 {
@@ -38,13 +47,23 @@ std::wstring BuildFileAttributesString(DWORD fileAttributes);
 BOOL GetFileOwner(const TCHAR *szFile, TCHAR *szOwner, size_t cchMax);
 std::optional<DWORD> GetNumFileHardLinks(const TCHAR *lpszFileName);
 BOOL ReadImageProperty(const TCHAR *lpszImage, PROPID propId, TCHAR *szProperty, int cchMax);
+BOOL ReadImageProperty(Gdiplus::Image *image, PROPID propId, TCHAR *szProperty, int cchMax);
 HRESULT GetMediaMetadata(const TCHAR *szFileName, const TCHAR *szAttribute, BYTE **pszOutput);
+HRESULT GetMediaMetadata(IWMHeaderInfo *headerInfo, const TCHAR *szAttribute, BYTE **pszOutput);
+
+// wmvcore.dll needs to remain loaded for as long as the returned header is in use, so wmvCore
+// should outlive headerInfo.
+HRESULT OpenMediaMetadata(const TCHAR *szFileName, wil::unique_hmodule &wmvCore,
+	wil::com_ptr_nothrow<IWMHeaderInfo> &headerInfo);
 BOOL IsImage(const TCHAR *fileName);
 BOOL GetFileProductVersion(const TCHAR *szFullFileName, DWORD *pdwProductVersionLS,
 	DWORD *pdwProductVersionMS);
 BOOL GetFileLanguage(const TCHAR *szFullFileName, WORD *pwLanguage);
 BOOL GetVersionInfoString(const TCHAR *szFullFileName, const TCHAR *szVersionInfo,
 	TCHAR *szVersionBuffer, UINT cchMax);
+BOOL GetVersionInfoString(const std::vector<BYTE> &versionInfo, const TCHAR *szVersionInfo,
+	TCHAR *szVersionBuffer, UINT cchMax);
+bool LoadFileVersionInfo(const TCHAR *szFullFileName, std::vector<BYTE> &versionInfo);
 
 /* Ownership and access. */
 BOOL CheckGroupMembership(GroupType groupType);
@@ -0,0 +1,229 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "ParallelDirectoryWalker.h"
+#include <algorithm>
+#include <iterator>
+#include <thread>
+
+namespace
+{
+
+// The threads that are used to help with each walk. The threads are created on first use and
+// shared between all walks.
+class HelperThreadPool : private boost::noncopyable
+{
+public:
+	static HelperThreadPool &GetInstance()
+	{
+		static HelperThreadPool pool;
+		return pool;
+	}
+
+	size_t GetNumThreads() const
+	{
+		return m_threads.size();
+	}
+
+	void Submit(std::function<void()> task)
+	{
+		std::unique_lock lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+		lock.unlock();
+
+		m_taskQueuedCondition.notify_one();
+	}
+
+private:
+	HelperThreadPool()
+	{
+		// The thread that starts a walk also takes part in it, so one fewer thread is needed here.
+		auto numThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		for (unsigned int i = 0; i < numThreads; i++)
+		{
+			m_threads.emplace_back(std::bind_front(&HelperThreadPool::RunThread, this));
+		}
+	}
+
+	void RunThread(std::stop_token stopToken)
+	{
+		while (true)
+		{
+			std::unique_lock lock(m_mutex);
+
+			if (!m_taskQueuedCondition.wait(lock, stopToken, [this] { return !m_tasks.empty(); }))
+			{
+				return;
+			}
+
+			auto task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+			lock.unlock();
+
+			task();
+		}
+	}
+
+	std::mutex m_mutex;
+	std::condition_variable_any m_taskQueuedCondition;
+	std::deque<std::function<void()>> m_tasks;
+
+	// This is declared last, so that the threads are stopped and joined before any of the other
+	// members are destroyed.
+	std::vector<std::jthread> m_threads;
+};
+
+}
+
+ParallelDirectoryWalker::ParallelDirectoryWalker(std::stop_token stopToken,
+	DirectoryCallback directoryCallback) :
+	m_stopToken(stopToken),
+	m_directoryCallback(directoryCallback)
+{
+}
+
+void ParallelDirectoryWalker::Walk(const std::wstring &root)
+{
+	auto &threadPool = HelperThreadPool::GetInstance();
+	size_t numWorkers = threadPool.GetNumThreads() + 1;
+
+	auto state = std::make_shared<WalkState>();
+	state->workerQueues.resize(numWorkers);
+	state->numPendingDirectories = 1;
+	ProcessDirectory(*state, 0, root);
+
+	// Most folders don't contain any subfolders, in which case there's no need for any help.
+	if (state->numPendingDirectories == 0)
+	{
+		return;
+	}
+
+	for (size_t i = 1; i < numWorkers; i++)
+	{
+		threadPool.Submit([this, state, i] { RunHelper(*state, i); });
+	}
+
+	RunWorker(*state, 0);
+
+	// Any helpers that haven't started yet won't run at all, while any that are still running
+	// (e.g. because a stop was requested while they were processing a directory) need to finish
+	// before this object can be destroyed.
+	std::unique_lock lock(state->mutex);
+	state->finished = true;
+	state->condition.wait(lock, [&state] { return state->numActiveHelpers == 0; });
+}
+
+void ParallelDirectoryWalker::RunHelper(WalkState &state, size_t workerIndex)
+{
+	std::unique_lock lock(state.mutex);
+
+	// Note that if the walk has finished, this object may already have been destroyed, so it's
+	// important that no members are accessed in that case.
+	if (state.finished)
+	{
+		return;
+	}
+
+	state.numActiveHelpers++;
+	lock.unlock();
+
+	RunWorker(state, workerIndex);
+
+	lock.lock();
+	state.numActiveHelpers--;
+	lock.unlock();
+
+	state.condition.notify_all();
+}
+
+void ParallelDirectoryWalker::RunWorker(WalkState &state, size_t workerIndex)
+{
+	std::unique_lock lock(state.mutex);
+
+	while (true)
+	{
+		// The pending count includes directories that are still being processed, so any
+		// subdirectories they contain will be queued before it reaches 0.
+		bool workAvailable = state.condition.wait(lock, m_stopToken, [&state]
+			{ return state.numQueuedDirectories > 0 || state.numPendingDirectories == 0; });
+
+		if (!workAvailable || m_stopToken.stop_requested() || state.numQueuedDirectories == 0)
+		{
+			break;
+		}
+
+		auto directory = TakeNextDirectory(state, workerIndex);
+		lock.unlock();
+
+		ProcessDirectory(state, workerIndex, directory);
+
+		lock.lock();
+	}
+}
+
+std::wstring ParallelDirectoryWalker::TakeNextDirectory(WalkState &state, size_t workerIndex)
+{
+	for (size_t i = 0; i < state.workerQueues.size(); i++)
+	{
+		auto &workerQueue = state.workerQueues[(workerIndex + i) % state.workerQueues.size()];
+
+		if (workerQueue.empty())
+		{
+			continue;
+		}
+
+		std::wstring directory;
+
+		if (i == 0)
+		{
+			directory = std::move(workerQueue.back());
+			workerQueue.pop_back();
+		}
+		else
+		{
+			directory = std::move(workerQueue.front());
+			workerQueue.pop_front();
+		}
+
+		state.numQueuedDirectories--;
+
+		return directory;
+	}
+
+	// This should only be called when there's at least one queued directory.
+	DCHECK(false);
+
+	return {};
+}
+
+void ParallelDirectoryWalker::ProcessDirectory(WalkState &state, size_t workerIndex,
+	const std::wstring &path)
+{
+	std::vector<std::wstring> subdirectories;
+	m_directoryCallback(path, subdirectories);
+
+	std::unique_lock lock(state.mutex);
+
+	auto &workerQueue = state.workerQueues[workerIndex];
+	std::move(subdirectories.begin(), subdirectories.end(), std::back_inserter(workerQueue));
+	state.numQueuedDirectories += subdirectories.size();
+	state.numPendingDirectories += subdirectories.size();
+	state.numPendingDirectories--;
+
+	bool walkComplete = state.numPendingDirectories == 0;
+	lock.unlock();
+
+	// Idle workers are only woken when there's something for them to do: either new directories
+	// to process, or the walk has completed.
+	if (walkComplete || subdirectories.size() > 1)
+	{
+		state.condition.notify_all();
+	}
+	else if (subdirectories.size() == 1)
+	{
+		state.condition.notify_one();
+	}
+}
@@ -0,0 +1,66 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <boost/core/noncopyable.hpp>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+// Visits each directory in a tree using a set of workers. The calling thread is always one of the
+// workers. The others run on a pool of threads that's shared between all walks, so the number of
+// threads used stays bounded, regardless of how many walks are running at once. If the pool is
+// busy, the walk simply proceeds with fewer workers.
+//
+// Each worker has its own queue of directories. Any subdirectories a worker finds are added to the
+// back of its own queue and the worker takes its next directory from the back of that queue, so
+// that each worker moves depth-first through its part of the tree. Once a worker's queue is empty,
+// it takes directories from the front of the other queues. Those directories are nearer to the
+// root, so are likely to represent a larger amount of work.
+class ParallelDirectoryWalker : private boost::noncopyable
+{
+public:
+	// Called once for each directory that's visited. Any subdirectories that should also be
+	// visited should be added to the vector that's passed in. This will be called concurrently
+	// from each of the worker threads.
+	using DirectoryCallback =
+		std::function<void(const std::wstring &path, std::vector<std::wstring> &subdirectories)>;
+
+	ParallelDirectoryWalker(std::stop_token stopToken, DirectoryCallback directoryCallback);
+
+	// Returns once every directory has been visited, or a stop has been requested.
+	void Walk(const std::wstring &root);
+
+private:
+	// This is shared with the tasks submitted to the thread pool, since those tasks may only start
+	// once the walk has finished.
+	struct WalkState
+	{
+		std::mutex mutex;
+		std::condition_variable_any condition;
+		std::vector<std::deque<std::wstring>> workerQueues;
+		size_t numQueuedDirectories = 0;
+
+		// The number of directories that have been queued, but haven't finished being processed.
+		size_t numPendingDirectories = 0;
+
+		int numActiveHelpers = 0;
+		bool finished = false;
+	};
+
+	void RunHelper(WalkState &state, size_t workerIndex);
+	void RunWorker(WalkState &state, size_t workerIndex);
+	static std::wstring TakeNextDirectory(WalkState &state, size_t workerIndex);
+	void ProcessDirectory(WalkState &state, size_t workerIndex, const std::wstring &path);
+
+	const std::stop_token m_stopToken;
+	const DirectoryCallback m_directoryCallback;
+};
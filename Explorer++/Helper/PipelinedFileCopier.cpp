@@ -0,0 +1,199 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "PipelinedFileCopier.h"
+#include <algorithm>
+#include <deque>
+#include <utility>
+
+namespace
+{
+
+// The minimum amount of time between progress updates.
+constexpr auto PROGRESS_INTERVAL = std::chrono::milliseconds(100);
+
+}
+
+PipelinedFileCopier::PipelinedFileCopier(std::stop_token stopToken,
+	ProgressCallback progressCallback, size_t bufferSize, size_t numBuffers) :
+	m_stopToken(stopToken),
+	m_progressCallback(progressCallback),
+	m_bufferSize(bufferSize),
+	m_buffers(numBuffers),
+	m_startTime(std::chrono::steady_clock::now()),
+	m_lastProgressTime(m_startTime)
+{
+	CHECK_GT(bufferSize, 0u);
+	CHECK_LE(bufferSize, static_cast<size_t>(MAXDWORD));
+	CHECK_GT(numBuffers, 0u);
+
+	for (auto &buffer : m_buffers)
+	{
+		buffer.data = std::make_unique<char[]>(bufferSize);
+		buffer.event.create(wil::EventOptions::ManualReset);
+	}
+}
+
+bool PipelinedFileCopier::CopyRange(HANDLE source, std::uint64_t sourceOffset, HANDLE destination,
+	std::uint64_t destinationOffset, std::uint64_t length)
+{
+	// Buffers are processed in the order in which their operations were started. That ensures
+	// that each completed read is written out before any later reads are waited on.
+	std::deque<Buffer *> pendingBuffers;
+	std::uint64_t nextReadOffset = 0;
+	std::uint64_t bytesWritten = 0;
+	bool failed = false;
+
+	auto startNextRead = [&](Buffer &buffer)
+	{
+		if (nextReadOffset == length || m_stopToken.stop_requested())
+		{
+			return true;
+		}
+
+		buffer.rangeOffset = nextReadOffset;
+		buffer.size = static_cast<DWORD>(std::min<std::uint64_t>(m_bufferSize,
+			length - nextReadOffset));
+
+		if (!StartIo(buffer, BufferState::Reading, source, sourceOffset + nextReadOffset))
+		{
+			return false;
+		}
+
+		pendingBuffers.push_back(&buffer);
+		nextReadOffset += buffer.size;
+
+		return true;
+	};
+
+	for (auto &buffer : m_buffers)
+	{
+		if (!startNextRead(buffer))
+		{
+			failed = true;
+			break;
+		}
+	}
+
+	while (!failed && !pendingBuffers.empty())
+	{
+		auto *buffer = pendingBuffers.front();
+		pendingBuffers.pop_front();
+
+		HANDLE file = (buffer->state == BufferState::Reading) ? source : destination;
+		DWORD numBytesTransferred;
+		BOOL res = GetOverlappedResult(file, &buffer->overlapped, &numBytesTransferred, TRUE);
+		auto completedState = std::exchange(buffer->state, BufferState::Idle);
+
+		// A short read would indicate that the source file was truncated while being copied.
+		if (!res || numBytesTransferred != buffer->size)
+		{
+			failed = true;
+			break;
+		}
+
+		if (completedState == BufferState::Reading)
+		{
+			if (!StartIo(*buffer, BufferState::Writing, destination,
+					destinationOffset + buffer->rangeOffset))
+			{
+				failed = true;
+				break;
+			}
+
+			pendingBuffers.push_back(buffer);
+		}
+		else
+		{
+			bytesWritten += buffer->size;
+			OnBlockCopied(buffer->size);
+
+			if (!startNextRead(*buffer))
+			{
+				failed = true;
+				break;
+			}
+		}
+	}
+
+	// The buffers can't be reused until any operations still in progress have finished.
+	for (auto *buffer : pendingBuffers)
+	{
+		HANDLE file = (buffer->state == BufferState::Reading) ? source : destination;
+		CancelIoEx(file, &buffer->overlapped);
+
+		DWORD numBytesTransferred;
+		GetOverlappedResult(file, &buffer->overlapped, &numBytesTransferred, TRUE);
+
+		buffer->state = BufferState::Idle;
+	}
+
+	ReportProgress();
+
+	return !failed && bytesWritten == length;
+}
+
+bool PipelinedFileCopier::StartIo(Buffer &buffer, BufferState state, HANDLE file,
+	std::uint64_t fileOffset)
+{
+	DCHECK(state != BufferState::Idle);
+
+	ULARGE_INTEGER offset;
+	offset.QuadPart = fileOffset;
+
+	buffer.overlapped = {};
+	buffer.overlapped.Offset = offset.LowPart;
+	buffer.overlapped.OffsetHigh = offset.HighPart;
+	buffer.overlapped.hEvent = buffer.event.get();
+	buffer.state = state;
+
+	BOOL res;
+
+	if (state == BufferState::Reading)
+	{
+		res = ReadFile(file, buffer.data.get(), buffer.size, nullptr, &buffer.overlapped);
+	}
+	else
+	{
+		res = WriteFile(file, buffer.data.get(), buffer.size, nullptr, &buffer.overlapped);
+	}
+
+	if (!res && GetLastError() != ERROR_IO_PENDING)
+	{
+		buffer.state = BufferState::Idle;
+		return false;
+	}
+
+	return true;
+}
+
+void PipelinedFileCopier::OnBlockCopied(DWORD size)
+{
+	m_bytesCopied += size;
+
+	if (std::chrono::steady_clock::now() - m_lastProgressTime >= PROGRESS_INTERVAL)
+	{
+		ReportProgress();
+	}
+}
+
+void PipelinedFileCopier::ReportProgress()
+{
+	m_lastProgressTime = std::chrono::steady_clock::now();
+
+	if (m_progressCallback)
+	{
+		m_progressCallback(GetProgress());
+	}
+}
+
+PipelinedFileCopier::Progress PipelinedFileCopier::GetProgress() const
+{
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - m_startTime);
+	auto elapsedMs = std::max<std::uint64_t>(elapsed.count(), 1);
+
+	return { m_bytesCopied, m_bytesCopied * 1000 / elapsedMs };
+}
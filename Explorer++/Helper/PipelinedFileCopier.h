@@ -0,0 +1,85 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <boost/core/noncopyable.hpp>
+#include <wil/resource.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stop_token>
+#include <vector>
+
+// Copies data between files using a fixed pool of buffers, so the amount of memory used doesn't
+// depend on the amount of data being copied. Reads and writes are overlapped: while one buffer is
+// being written, the following blocks are read into the other buffers.
+class PipelinedFileCopier : private boost::noncopyable
+{
+public:
+	struct Progress
+	{
+		// The total number of bytes copied, across all calls to CopyRange().
+		std::uint64_t bytesCopied;
+
+		// The average rate since the copier was constructed.
+		std::uint64_t bytesPerSecond;
+	};
+
+	// Called periodically while data is being copied, as well as at the end of each call to
+	// CopyRange(). This is always called on the thread that's performing the copy.
+	using ProgressCallback = std::function<void(const Progress &progress)>;
+
+	static constexpr size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+	static constexpr size_t DEFAULT_NUM_BUFFERS = 3;
+
+	PipelinedFileCopier(std::stop_token stopToken = {}, ProgressCallback progressCallback = nullptr,
+		size_t bufferSize = DEFAULT_BUFFER_SIZE, size_t numBuffers = DEFAULT_NUM_BUFFERS);
+
+	// Copies the specified number of bytes from the source file (starting at sourceOffset) to the
+	// destination file (starting at destinationOffset). For reads and writes to proceed
+	// concurrently, both handles should be opened with FILE_FLAG_OVERLAPPED, though handles opened
+	// for synchronous I/O will also work. Returns false if an error occurs, or a stop is requested,
+	// before all of the data has been copied.
+	bool CopyRange(HANDLE source, std::uint64_t sourceOffset, HANDLE destination,
+		std::uint64_t destinationOffset, std::uint64_t length);
+
+	Progress GetProgress() const;
+
+private:
+	enum class BufferState
+	{
+		Idle,
+		Reading,
+		Writing
+	};
+
+	struct Buffer
+	{
+		std::unique_ptr<char[]> data;
+		wil::unique_event_failfast event;
+		OVERLAPPED overlapped = {};
+		BufferState state = BufferState::Idle;
+
+		// The offset of the block held in this buffer, relative to the start of the range being
+		// copied.
+		std::uint64_t rangeOffset = 0;
+
+		DWORD size = 0;
+	};
+
+	static bool StartIo(Buffer &buffer, BufferState state, HANDLE file, std::uint64_t fileOffset);
+	void OnBlockCopied(DWORD size);
+	void ReportProgress();
+
+	const std::stop_token m_stopToken;
+	const ProgressCallback m_progressCallback;
+	const size_t m_bufferSize;
+	std::vector<Buffer> m_buffers;
+
+	std::uint64_t m_bytesCopied = 0;
+	const std::chrono::steady_clock::time_point m_startTime;
+	std::chrono::steady_clock::time_point m_lastProgressTime;
+};
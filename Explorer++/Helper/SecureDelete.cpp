@@ -0,0 +1,411 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "SecureDelete.h"
+#include "DriveInfo.h"
+#include "Helper.h"
+#include <boost/core/noncopyable.hpp>
+#include <wil/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+
+namespace
+{
+
+// The amount of data written in each call to WriteFile(). This is a multiple of any sector size,
+// as required when writing to a file opened with FILE_FLAG_NO_BUFFERING.
+constexpr DWORD BLOCK_SIZE = 1024 * 1024;
+
+// Used to round up the size of a file when its cluster size can't be determined. Sector sizes
+// are no larger than this in practice.
+constexpr std::uint64_t FALLBACK_ALIGNMENT = 4096;
+
+constexpr unsigned int MAX_THREADS = 4;
+
+// The minimum amount of time between progress updates.
+constexpr auto PROGRESS_INTERVAL = std::chrono::milliseconds(100);
+
+struct VirtualFreeDeleter
+{
+	void operator()(char *data) const
+	{
+		VirtualFree(data, 0, MEM_RELEASE);
+	}
+};
+
+// Memory returned by VirtualAlloc() is page aligned, which satisfies the alignment requirements
+// for unbuffered I/O.
+using AlignedBuffer = std::unique_ptr<char, VirtualFreeDeleter>;
+
+AlignedBuffer AllocateAlignedBuffer(size_t size)
+{
+	auto *data = static_cast<char *>(
+		VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+	CHECK(data);
+	return AlignedBuffer(data);
+}
+
+// Returns the size of the file, rounded up to the end of its last cluster, or std::nullopt if the
+// file can't be overwritten (for example, because it's a folder).
+std::optional<std::uint64_t> GetOverwriteSize(const std::wstring &path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributeData;
+
+	if (!GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &attributeData)
+		|| WI_IsFlagSet(attributeData.dwFileAttributes, FILE_ATTRIBUTE_DIRECTORY))
+	{
+		return std::nullopt;
+	}
+
+	ULARGE_INTEGER fileSize = { { attributeData.nFileSizeLow, attributeData.nFileSizeHigh } };
+	std::uint64_t alignment = FALLBACK_ALIGNMENT;
+
+	TCHAR root[MAX_PATH];
+	DWORD clusterSize;
+
+	if (SUCCEEDED(StringCchCopy(root, std::size(root), path.c_str())) && PathStripToRoot(root)
+		&& GetClusterSize(root, &clusterSize))
+	{
+		alignment = clusterSize;
+	}
+
+	return (fileSize.QuadPart + alignment - 1) / alignment * alignment;
+}
+
+std::mt19937_64 CreateRandomGenerator()
+{
+	std::random_device randomDevice;
+	std::seed_seq seedSequence{ randomDevice(), randomDevice(), randomDevice(), randomDevice() };
+	return std::mt19937_64(seedSequence);
+}
+
+class SecureDeleter : private boost::noncopyable
+{
+public:
+	SecureDeleter(const std::vector<SecureDeletePass> &passes, std::stop_token stopToken,
+		SecureDeleteProgressCallback progressCallback) :
+		m_passes(passes),
+		m_stopToken(stopToken),
+		m_progressCallback(progressCallback),
+		m_startTime(std::chrono::steady_clock::now()),
+		m_lastProgressTime(m_startTime)
+	{
+	}
+
+	SecureDeleteResult DeleteFiles(const std::vector<std::wstring> &paths)
+	{
+		SecureDeleteResult result;
+
+		for (const auto &path : paths)
+		{
+			auto overwriteSize = GetOverwriteSize(path);
+
+			if (!overwriteSize)
+			{
+				// Folders are skipped, but a file that can't be queried can't be deleted either.
+				DWORD attributes = GetFileAttributes(path.c_str());
+
+				if (attributes == INVALID_FILE_ATTRIBUTES
+					|| WI_IsFlagClear(attributes, FILE_ATTRIBUTE_DIRECTORY))
+				{
+					result.failedPaths.push_back(path);
+				}
+
+				continue;
+			}
+
+			m_files.emplace_back(path, *overwriteSize);
+			m_totalBytes += *overwriteSize * m_passes.size();
+		}
+
+		auto numThreads = std::min({ MAX_THREADS,
+			std::max(std::thread::hardware_concurrency(), 1u),
+			static_cast<unsigned int>(m_files.size()) });
+
+		{
+			std::vector<std::jthread> threads;
+
+			for (unsigned int i = 0; i < numThreads; i++)
+			{
+				threads.emplace_back(&SecureDeleter::ProcessFiles, this);
+			}
+		}
+
+		ReportProgress();
+
+		result.numFilesDeleted = m_numFilesDeleted;
+
+		for (const auto &fileEntry : m_files)
+		{
+			if (fileEntry.failed)
+			{
+				result.failedPaths.push_back(fileEntry.path);
+			}
+		}
+
+		return result;
+	}
+
+	bool OverwriteFile(const std::wstring &path)
+	{
+		if (m_stopToken.stop_requested())
+		{
+			return false;
+		}
+
+		auto overwriteSize = GetOverwriteSize(path);
+
+		if (!overwriteSize)
+		{
+			return false;
+		}
+
+		auto buffer = AllocateAlignedBuffer(BLOCK_SIZE);
+		auto generator = CreateRandomGenerator();
+
+		return OverwriteFileWithBuffer({ path, *overwriteSize }, buffer.get(), generator);
+	}
+
+private:
+	struct FileEntry
+	{
+		std::wstring path;
+		std::uint64_t overwriteSize;
+
+		// Each entry is only processed by a single thread, so this doesn't need to be atomic.
+		bool failed = false;
+	};
+
+	void ProcessFiles()
+	{
+		auto buffer = AllocateAlignedBuffer(BLOCK_SIZE);
+		auto generator = CreateRandomGenerator();
+
+		// The stop token is only checked between files. Stopping part way through a file would
+		// leave it extended and partially overwritten, which is neither the original file nor a
+		// deleted one.
+		while (!m_stopToken.stop_requested())
+		{
+			size_t index = m_nextFileIndex++;
+
+			if (index >= m_files.size())
+			{
+				break;
+			}
+
+			auto &fileEntry = m_files[index];
+
+			if (OverwriteAndDeleteFile(fileEntry, buffer.get(), generator))
+			{
+				m_numFilesDeleted++;
+			}
+			else
+			{
+				fileEntry.failed = true;
+			}
+		}
+	}
+
+	bool OverwriteAndDeleteFile(const FileEntry &fileEntry, char *buffer,
+		std::mt19937_64 &generator)
+	{
+		if (!OverwriteFileWithBuffer(fileEntry, buffer, generator))
+		{
+			return false;
+		}
+
+		return DeleteFile(fileEntry.path.c_str());
+	}
+
+	bool OverwriteFileWithBuffer(const FileEntry &fileEntry, char *buffer,
+		std::mt19937_64 &generator)
+	{
+		// No sharing is allowed, so that the file can't be opened while it's being overwritten.
+		wil::unique_hfile file(CreateFile(fileEntry.path.c_str(), GENERIC_WRITE, 0, nullptr,
+			OPEN_EXISTING, FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH, nullptr));
+
+		if (!file)
+		{
+			return false;
+		}
+
+		// Extend the file out to the end of its last cluster, so that any data in the slack space
+		// is also overwritten.
+		FILE_END_OF_FILE_INFO endOfFileInfo;
+		endOfFileInfo.EndOfFile.QuadPart = fileEntry.overwriteSize;
+
+		if (!SetFileInformationByHandle(file.get(), FileEndOfFileInfo, &endOfFileInfo,
+				sizeof(endOfFileInfo)))
+		{
+			return false;
+		}
+
+		for (auto pass : m_passes)
+		{
+			if (!WritePass(file.get(), fileEntry.overwriteSize, pass, buffer, generator))
+			{
+				return false;
+			}
+		}
+
+		FlushFileBuffers(file.get());
+
+		return true;
+	}
+
+	bool WritePass(HANDLE file, std::uint64_t size, SecureDeletePass pass, char *buffer,
+		std::mt19937_64 &generator)
+	{
+		if (pass != SecureDeletePass::Random)
+		{
+			std::memset(buffer, (pass == SecureDeletePass::Zeros) ? 0x00 : 0xFF, BLOCK_SIZE);
+		}
+
+		LARGE_INTEGER start = {};
+
+		if (!SetFilePointerEx(file, start, nullptr, FILE_BEGIN))
+		{
+			return false;
+		}
+
+		for (std::uint64_t offset = 0; offset < size; offset += BLOCK_SIZE)
+		{
+			// Since the size is a multiple of the cluster size, the final block will still be a
+			// multiple of the sector size.
+			auto blockSize = static_cast<DWORD>(std::min<std::uint64_t>(BLOCK_SIZE, size - offset));
+
+			if (pass == SecureDeletePass::Random)
+			{
+				FillRandom(buffer, blockSize, generator);
+			}
+
+			DWORD numBytesWritten;
+
+			if (!WriteFile(file, buffer, blockSize, &numBytesWritten, nullptr)
+				|| numBytesWritten != blockSize)
+			{
+				return false;
+			}
+
+			OnBytesWritten(blockSize);
+		}
+
+		return true;
+	}
+
+	static void FillRandom(char *buffer, DWORD size, std::mt19937_64 &generator)
+	{
+		DCHECK_EQ(size % sizeof(std::uint64_t), 0u);
+
+		for (DWORD i = 0; i < size; i += sizeof(std::uint64_t))
+		{
+			auto value = generator();
+			std::memcpy(buffer + i, &value, sizeof(value));
+		}
+	}
+
+	void OnBytesWritten(DWORD size)
+	{
+		m_bytesWritten += size;
+
+		if (!m_progressCallback)
+		{
+			return;
+		}
+
+		std::unique_lock lock(m_progressMutex, std::try_to_lock);
+
+		if (!lock.owns_lock())
+		{
+			// Another worker is reporting progress.
+			return;
+		}
+
+		if (std::chrono::steady_clock::now() - m_lastProgressTime < PROGRESS_INTERVAL)
+		{
+			return;
+		}
+
+		ReportProgressLocked();
+	}
+
+	void ReportProgress()
+	{
+		if (!m_progressCallback)
+		{
+			return;
+		}
+
+		std::lock_guard lock(m_progressMutex);
+		ReportProgressLocked();
+	}
+
+	void ReportProgressLocked()
+	{
+		auto now = std::chrono::steady_clock::now();
+		m_lastProgressTime = now;
+
+		auto elapsed =
+			std::chrono::duration_cast<std::chrono::milliseconds>(now - m_startTime).count();
+		std::uint64_t bytesWritten = m_bytesWritten;
+
+		m_progressCallback({ bytesWritten, m_totalBytes,
+			bytesWritten * 1000 / std::max<std::uint64_t>(elapsed, 1) });
+	}
+
+	const std::vector<SecureDeletePass> m_passes;
+	const std::stop_token m_stopToken;
+	const SecureDeleteProgressCallback m_progressCallback;
+
+	std::vector<FileEntry> m_files;
+	std::uint64_t m_totalBytes = 0;
+	std::atomic<size_t> m_nextFileIndex = 0;
+	std::atomic<int> m_numFilesDeleted = 0;
+	std::atomic<std::uint64_t> m_bytesWritten = 0;
+
+	std::mutex m_progressMutex;
+	const std::chrono::steady_clock::time_point m_startTime;
+	std::chrono::steady_clock::time_point m_lastProgressTime;
+};
+
+}
+
+SecureDeleteResult DeleteFilesSecurely(const std::vector<std::wstring> &paths,
+	FileOperations::OverwriteMethod overwriteMethod, std::stop_token stopToken,
+	SecureDeleteProgressCallback progressCallback)
+{
+	SecureDeleter deleter(GetSecureDeletePasses(overwriteMethod), stopToken, progressCallback);
+	return deleter.DeleteFiles(paths);
+}
+
+std::vector<SecureDeletePass> GetSecureDeletePasses(
+	FileOperations::OverwriteMethod overwriteMethod)
+{
+	switch (overwriteMethod)
+	{
+	case FileOperations::OverwriteMethod::OnePass:
+		return { SecureDeletePass::Zeros };
+
+	case FileOperations::OverwriteMethod::ThreePass:
+		return { SecureDeletePass::Zeros, SecureDeletePass::Ones, SecureDeletePass::Random };
+	}
+
+	DCHECK(false);
+	return { SecureDeletePass::Zeros };
+}
+
+bool OverwriteFileSecurely(const std::wstring &path, const std::vector<SecureDeletePass> &passes,
+	std::stop_token stopToken)
+{
+	SecureDeleter deleter(passes, stopToken, nullptr);
+	return deleter.OverwriteFile(path);
+}
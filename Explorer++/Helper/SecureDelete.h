@@ -0,0 +1,65 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include "FileOperations.h"
+#include <cstdint>
+#include <functional>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+enum class SecureDeletePass
+{
+	Zeros,
+	Ones,
+	Random
+};
+
+struct SecureDeleteProgress
+{
+	// The number of bytes written so far, across all files and passes.
+	std::uint64_t bytesWritten;
+
+	// The total number of bytes that will be written, across all files and passes.
+	std::uint64_t totalBytes;
+
+	// The average rate since the operation started.
+	std::uint64_t bytesPerSecond;
+};
+
+struct SecureDeleteResult
+{
+	int numFilesDeleted = 0;
+
+	// The files that couldn't be overwritten or deleted (for example, because they're read-only or
+	// in use). Files that were skipped because a stop was requested aren't included.
+	std::vector<std::wstring> failedPaths;
+};
+
+// Called periodically while files are being overwritten, as well as once all of the files have
+// been processed. This may be called from any of the threads that are used to process the files,
+// though it will never be called concurrently.
+using SecureDeleteProgressCallback = std::function<void(const SecureDeleteProgress &progress)>;
+
+// Overwrites each of the specified files, using the specified method, then deletes it. Each file
+// is overwritten up to the end of its last cluster, in large blocks, with caching disabled, so
+// that every pass is written through to the disk. Multiple files are processed in parallel.
+// Folders are skipped. If a stop is requested, any file that's already being overwritten is
+// finished and deleted, so that a file is never left partially overwritten. No further files are
+// started.
+SecureDeleteResult DeleteFilesSecurely(const std::vector<std::wstring> &paths,
+	FileOperations::OverwriteMethod overwriteMethod, std::stop_token stopToken = {},
+	SecureDeleteProgressCallback progressCallback = nullptr);
+
+// Returns the passes, in order, that are used for the specified method.
+std::vector<SecureDeletePass> GetSecureDeletePasses(
+	FileOperations::OverwriteMethod overwriteMethod);
+
+// Performs the overwrite step of DeleteFilesSecurely() for a single file, without deleting it
+// afterwards. This allows the data that's written to be verified. Returns true if every pass was
+// written successfully. The stop token is only checked before the file is opened.
+bool OverwriteFileSecurely(const std::wstring &path, const std::vector<SecureDeletePass> &passes,
+	std::stop_token stopToken = {});
@@ -17,6 +17,7 @@
 #include <wil/com.h>
 #include <propkey.h>
 #include <wininet.h>
+#include <algorithm>
 #include <filesystem>
 
 namespace
@@ -51,6 +52,9 @@ HRESULT AddJumpListTaskInternal(IObjectCollection *objectCollection, const TCHAR
 HRESULT MaybeGetLinkTarget(HWND hwnd, PCIDLIST_ABSOLUTE pidl, LinkTargetRetrievalType retrievalType,
 	unique_pidl_absolute &targetPidl);
 
+HRESULT GetNextEnumeratedItemsIndividually(IEnumIDList *enumerator, ULONG maxItems,
+	std::vector<PidlChild> &outputItems);
+
 HRESULT GetDisplayName(const std::wstring &parsingPath, DWORD flags, std::wstring &output)
 {
 	unique_pidl_absolute pidl;
@@ -1405,3 +1409,58 @@ bool DoesItemExist(PCIDLIST_ABSOLUTE pidl)
 	// succeeded, the item exists.
 	return true;
 }
+
+HRESULT GetNextEnumeratedItems(IEnumIDList *enumerator, ULONG maxItems,
+	std::vector<PidlChild> &outputItems)
+{
+	std::vector<PITEMID_CHILD> items(maxItems);
+	ULONG numFetched = 0;
+	HRESULT hr = enumerator->Next(maxItems, items.data(), &numFetched);
+
+	// Some enumerators only support retrieving a single item at a time. Those enumerators will
+	// either fail with E_INVALIDARG, or indicate that no items were returned, when asked for more
+	// than one item. In that case, the items are retrieved one by one instead.
+	if (maxItems > 1 && (hr == E_INVALIDARG || (hr == S_FALSE && numFetched == 0)))
+	{
+		return GetNextEnumeratedItemsIndividually(enumerator, maxItems, outputItems);
+	}
+
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+
+	// Some enumerators don't reliably return S_FALSE when fewer items than requested are returned,
+	// so the number of items is checked as well.
+	for (ULONG i = 0; i < std::min(numFetched, maxItems); i++)
+	{
+		outputItems.emplace_back(items[i], Pidl::takeOwnership);
+	}
+
+	return (hr == S_OK && numFetched == maxItems) ? S_OK : S_FALSE;
+}
+
+HRESULT GetNextEnumeratedItemsIndividually(IEnumIDList *enumerator, ULONG maxItems,
+	std::vector<PidlChild> &outputItems)
+{
+	for (ULONG i = 0; i < maxItems; i++)
+	{
+		PITEMID_CHILD item = nullptr;
+		ULONG numFetched = 0;
+		HRESULT hr = enumerator->Next(1, &item, &numFetched);
+
+		if (FAILED(hr))
+		{
+			return hr;
+		}
+
+		if (hr != S_OK || numFetched != 1 || !item)
+		{
+			return S_FALSE;
+		}
+
+		outputItems.emplace_back(item, Pidl::takeOwnership);
+	}
+
+	return S_OK;
+}
@@ -156,3 +156,11 @@ ShellIconInfo ExtractShellIconParts(int iconIndexAndOverlay);
 PidlAbsolute GetClosestExistingItem(PCIDLIST_ABSOLUTE pidl);
 
 bool DoesItemExist(PCIDLIST_ABSOLUTE pidl);
+
+// Retrieves up to `maxItems` items from the enumerator and appends them to `outputItems`.
+// Retrieving items in batches, rather than one at a time, reduces the number of calls made to the
+// enumerator, which matters when the enumerator is slow to respond (e.g. for a folder on a network
+// share). Returns S_OK if there may be more items to retrieve and S_FALSE once the enumeration is
+// complete.
+HRESULT GetNextEnumeratedItems(IEnumIDList *enumerator, ULONG maxItems,
+	std::vector<PidlChild> &outputItems);
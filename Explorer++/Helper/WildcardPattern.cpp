@@ -0,0 +1,188 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "stdafx.h"
+#include "WildcardPattern.h"
+#include <algorithm>
+
+WildcardPattern::WildcardPattern(const std::wstring &pattern, bool caseSensitive) :
+	m_pattern(pattern),
+	m_caseSensitive(caseSensitive)
+{
+	std::wstring foldedPattern = m_caseSensitive ? m_pattern : ToLowerCase(m_pattern);
+
+	if (foldedPattern.find(L':') == std::wstring::npos)
+	{
+		m_alternatives.push_back(ParseAlternative(foldedPattern));
+		return;
+	}
+
+	std::wstring_view remainingPattern = foldedPattern;
+
+	while (!remainingPattern.empty())
+	{
+		auto separatorPosition = remainingPattern.find(L':');
+		auto alternative = remainingPattern.substr(0, separatorPosition);
+
+		auto firstNonSpace = alternative.find_first_not_of(L' ');
+		auto lastNonSpace = alternative.find_last_not_of(L' ');
+		alternative = (firstNonSpace == std::wstring_view::npos)
+			? std::wstring_view()
+			: alternative.substr(firstNonSpace, lastNonSpace - firstNonSpace + 1);
+
+		// An empty pattern could only match an empty string, which will never be matched against
+		// in practice.
+		if (!alternative.empty())
+		{
+			m_alternatives.push_back(ParseAlternative(alternative));
+		}
+
+		if (separatorPosition == std::wstring_view::npos)
+		{
+			break;
+		}
+
+		remainingPattern.remove_prefix(separatorPosition + 1);
+	}
+}
+
+bool WildcardPattern::Matches(std::wstring_view str) const
+{
+	std::wstring foldedStr;
+
+	if (!m_caseSensitive)
+	{
+		foldedStr = ToLowerCase(str);
+		str = foldedStr;
+	}
+
+	return std::ranges::any_of(m_alternatives, [str](const Alternative &alternative)
+		{ return MatchesAlternative(alternative, str); });
+}
+
+const std::wstring &WildcardPattern::GetPattern() const
+{
+	return m_pattern;
+}
+
+bool WildcardPattern::IsCaseSensitive() const
+{
+	return m_caseSensitive;
+}
+
+WildcardPattern::Alternative WildcardPattern::ParseAlternative(std::wstring_view pattern)
+{
+	if (pattern.find(L'?') == std::wstring_view::npos)
+	{
+		auto numStars = std::ranges::count(pattern, L'*');
+
+		if (numStars == 0)
+		{
+			return { MatchType::Exact, std::wstring(pattern) };
+		}
+		else if (numStars == 1 && pattern.back() == L'*')
+		{
+			return { MatchType::Prefix, std::wstring(pattern.substr(0, pattern.size() - 1)) };
+		}
+		else if (numStars == 1 && pattern.front() == L'*')
+		{
+			return { MatchType::Suffix, std::wstring(pattern.substr(1)) };
+		}
+		else if (numStars == 2 && pattern.size() >= 2 && pattern.front() == L'*'
+			&& pattern.back() == L'*')
+		{
+			return { MatchType::Contains, std::wstring(pattern.substr(1, pattern.size() - 2)) };
+		}
+	}
+
+	return { MatchType::General, std::wstring(pattern) };
+}
+
+bool WildcardPattern::MatchesAlternative(const Alternative &alternative, std::wstring_view str)
+{
+	switch (alternative.matchType)
+	{
+	case MatchType::Exact:
+		return str == alternative.text;
+
+	case MatchType::Prefix:
+		return str.starts_with(alternative.text);
+
+	case MatchType::Suffix:
+		return str.ends_with(alternative.text);
+
+	case MatchType::Contains:
+		return str.find(alternative.text) != std::wstring_view::npos;
+
+	case MatchType::General:
+		return MatchesGeneral(alternative.text, str);
+	}
+
+	return false;
+}
+
+bool WildcardPattern::MatchesGeneral(std::wstring_view pattern, std::wstring_view str)
+{
+	// When a mismatch occurs, matching resumes from the most recent '*', with that '*' consuming
+	// one more character. Only the most recent '*' needs to be retried, which means the match can
+	// be performed without recursion.
+	size_t patternIndex = 0;
+	size_t strIndex = 0;
+	size_t starPatternIndex = std::wstring_view::npos;
+	size_t starStrIndex = 0;
+
+	while (strIndex < str.size())
+	{
+		if (patternIndex < pattern.size()
+			&& (pattern[patternIndex] == L'?' || pattern[patternIndex] == str[strIndex]))
+		{
+			patternIndex++;
+			strIndex++;
+		}
+		else if (patternIndex < pattern.size() && pattern[patternIndex] == L'*')
+		{
+			starPatternIndex = patternIndex++;
+			starStrIndex = strIndex;
+		}
+		else if (starPatternIndex != std::wstring_view::npos)
+		{
+			patternIndex = starPatternIndex + 1;
+			strIndex = ++starStrIndex;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	while (patternIndex < pattern.size() && pattern[patternIndex] == L'*')
+	{
+		patternIndex++;
+	}
+
+	return patternIndex == pattern.size();
+}
+
+std::wstring WildcardPattern::ToLowerCase(std::wstring_view str)
+{
+	if (str.empty())
+	{
+		return {};
+	}
+
+	// This uses the same mapping as CheckWildcardMatch(), so that the two functions match the same
+	// set of strings.
+	std::wstring lowerCaseStr(str.size(), '\0');
+	int res = LCMapString(LOCALE_USER_DEFAULT, LCMAP_LOWERCASE, str.data(),
+		static_cast<int>(str.size()), lowerCaseStr.data(), static_cast<int>(lowerCaseStr.size()));
+
+	if (res == 0)
+	{
+		return std::wstring(str);
+	}
+
+	lowerCaseStr.resize(res);
+
+	return lowerCaseStr;
+}
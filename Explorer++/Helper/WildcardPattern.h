@@ -0,0 +1,64 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A wildcard pattern that's parsed once, so that it can be efficiently matched against a large
+// number of strings. The syntax is the same as that supported by CheckWildcardMatch():
+//
+// - '*' matches any sequence of characters (including an empty sequence).
+// - '?' matches any single character.
+// - Multiple patterns can be separated by ':' (e.g. "*.h: *.cpp"), in which case a string matches
+//   if it matches any of the patterns. Spaces around each pattern are ignored.
+class WildcardPattern
+{
+public:
+	WildcardPattern(const std::wstring &pattern, bool caseSensitive);
+
+	bool Matches(std::wstring_view str) const;
+
+	const std::wstring &GetPattern() const;
+	bool IsCaseSensitive() const;
+
+private:
+	// Most patterns are of a simple form (e.g. "*.txt"), which can be matched without having to
+	// perform a general wildcard match.
+	enum class MatchType
+	{
+		// The pattern contains no wildcards.
+		Exact,
+
+		// The pattern is of the form "text*".
+		Prefix,
+
+		// The pattern is of the form "*text".
+		Suffix,
+
+		// The pattern is of the form "*text*".
+		Contains,
+
+		General
+	};
+
+	struct Alternative
+	{
+		MatchType matchType;
+
+		// For every match type apart from General, this is the text with the wildcards removed.
+		std::wstring text;
+	};
+
+	static Alternative ParseAlternative(std::wstring_view pattern);
+	static bool MatchesAlternative(const Alternative &alternative, std::wstring_view str);
+	static bool MatchesGeneral(std::wstring_view pattern, std::wstring_view str);
+	static std::wstring ToLowerCase(std::wstring_view str);
+
+	std::wstring m_pattern;
+	bool m_caseSensitive;
+	std::vector<Alternative> m_alternatives;
+};
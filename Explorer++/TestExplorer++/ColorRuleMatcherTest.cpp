@@ -0,0 +1,75 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "ColorRuleMatcher.h"
+#include "ColorRuleModel.h"
+#include <gtest/gtest.h>
+
+class ColorRuleMatcherTest : public testing::Test
+{
+protected:
+	void AddRule(const std::wstring &pattern, bool caseInsensitive, DWORD attributes,
+		COLORREF color)
+	{
+		m_model.AddItem(
+			std::make_unique<ColorRule>(L"Description", pattern, caseInsensitive, attributes, color));
+	}
+
+	ColorRuleModel m_model;
+};
+
+TEST_F(ColorRuleMatcherTest, NoRules)
+{
+	ColorRuleMatcher matcher(&m_model);
+	EXPECT_EQ(matcher.GetColor(L"file.txt", FILE_ATTRIBUTE_NORMAL), std::nullopt);
+}
+
+TEST_F(ColorRuleMatcherTest, MatchByName)
+{
+	AddRule(L"*.cpp", true, 0, RGB(0, 0, 128));
+	AddRule(L"*.H", true, 0, RGB(0, 128, 0));
+	AddRule(L"*.TXT", false, 0, RGB(128, 0, 0));
+
+	ColorRuleMatcher matcher(&m_model);
+	EXPECT_EQ(matcher.GetColor(L"file.CPP", std::nullopt), RGB(0, 0, 128));
+	EXPECT_EQ(matcher.GetColor(L"file.h", std::nullopt), RGB(0, 128, 0));
+	EXPECT_EQ(matcher.GetColor(L"file.txt", std::nullopt), std::nullopt);
+	EXPECT_EQ(matcher.GetColor(L"file.TXT", std::nullopt), RGB(128, 0, 0));
+}
+
+TEST_F(ColorRuleMatcherTest, MatchByAttributes)
+{
+	AddRule(L"", true, FILE_ATTRIBUTE_HIDDEN, RGB(0, 0, 128));
+	AddRule(L"*.txt", true, FILE_ATTRIBUTE_READONLY, RGB(0, 128, 0));
+
+	ColorRuleMatcher matcher(&m_model);
+	EXPECT_EQ(matcher.GetColor(L"file.doc", FILE_ATTRIBUTE_HIDDEN), RGB(0, 0, 128));
+	EXPECT_EQ(matcher.GetColor(L"file.txt", FILE_ATTRIBUTE_READONLY), RGB(0, 128, 0));
+	EXPECT_EQ(matcher.GetColor(L"file.doc", FILE_ATTRIBUTE_READONLY), std::nullopt);
+
+	// Rules that filter on attributes can't match if the attributes aren't known.
+	EXPECT_EQ(matcher.GetColor(L"file.txt", std::nullopt), std::nullopt);
+}
+
+TEST_F(ColorRuleMatcherTest, FirstMatchingRuleWins)
+{
+	AddRule(L"*.txt", true, 0, RGB(0, 0, 128));
+	AddRule(L"file*", true, 0, RGB(0, 128, 0));
+
+	ColorRuleMatcher matcher(&m_model);
+	EXPECT_EQ(matcher.GetColor(L"file.txt", std::nullopt), RGB(0, 0, 128));
+	EXPECT_EQ(matcher.GetColor(L"file.doc", std::nullopt), RGB(0, 128, 0));
+}
+
+TEST_F(ColorRuleMatcherTest, RulesCopiedOnConstruction)
+{
+	AddRule(L"*.txt", true, 0, RGB(0, 0, 128));
+
+	ColorRuleMatcher matcher(&m_model);
+	m_model.GetItems()[0]->SetColor(RGB(0, 128, 0));
+
+	// The matcher should continue to use the rules as they were when it was built.
+	EXPECT_EQ(matcher.GetColor(L"file.txt", std::nullopt), RGB(0, 0, 128));
+}
@@ -0,0 +1,95 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "ShellBrowser/ColumnTextCache.h"
+#include <gtest/gtest.h>
+
+using namespace testing;
+
+TEST(ColumnTextCacheTest, SetGet)
+{
+	ColumnTextCache cache(100, 100);
+	cache.SetText(1, ColumnType::Owner, L"owner1");
+	cache.SetText(1, ColumnType::Company, L"company1");
+	cache.SetText(2, ColumnType::Owner, L"owner2");
+
+	EXPECT_EQ(cache.MaybeGetText(1, ColumnType::Owner), L"owner1");
+	EXPECT_EQ(cache.MaybeGetText(1, ColumnType::Company), L"company1");
+	EXPECT_EQ(cache.MaybeGetText(2, ColumnType::Owner), L"owner2");
+	EXPECT_EQ(cache.MaybeGetText(2, ColumnType::Company), std::nullopt);
+	EXPECT_EQ(cache.MaybeGetText(3, ColumnType::Owner), std::nullopt);
+
+	EXPECT_EQ(cache.GetNumEntries(), 3u);
+	EXPECT_EQ(cache.GetSize(), 20u);
+}
+
+TEST(ColumnTextCacheTest, ReplaceText)
+{
+	ColumnTextCache cache(100, 100);
+	cache.SetText(1, ColumnType::Owner, L"owner");
+	cache.SetText(1, ColumnType::Owner, L"updated owner");
+
+	EXPECT_EQ(cache.MaybeGetText(1, ColumnType::Owner), L"updated owner");
+	EXPECT_EQ(cache.GetNumEntries(), 1u);
+	EXPECT_EQ(cache.GetSize(), 13u);
+}
+
+TEST(ColumnTextCacheTest, InvalidateItem)
+{
+	ColumnTextCache cache(100, 100);
+	cache.SetText(1, ColumnType::Owner, L"owner1");
+	cache.SetText(1, ColumnType::Company, L"company1");
+	cache.SetText(2, ColumnType::Owner, L"owner2");
+
+	cache.InvalidateItem(1);
+
+	EXPECT_EQ(cache.MaybeGetText(1, ColumnType::Owner), std::nullopt);
+	EXPECT_EQ(cache.MaybeGetText(1, ColumnType::Company), std::nullopt);
+	EXPECT_EQ(cache.MaybeGetText(2, ColumnType::Owner), L"owner2");
+	EXPECT_EQ(cache.GetNumEntries(), 1u);
+	EXPECT_EQ(cache.GetSize(), 6u);
+
+	cache.Clear();
+	EXPECT_EQ(cache.GetNumEntries(), 0u);
+	EXPECT_EQ(cache.GetSize(), 0u);
+}
+
+TEST(ColumnTextCacheTest, SizeLimit)
+{
+	ColumnTextCache cache(10, 100);
+	cache.SetText(1, ColumnType::Owner, L"aaaa");
+	cache.SetText(2, ColumnType::Owner, L"bbbb");
+
+	// Accessing the first entry makes it the most recently used entry, so the second entry should
+	// be removed when the limit is exceeded below.
+	EXPECT_EQ(cache.MaybeGetText(1, ColumnType::Owner), L"aaaa");
+
+	cache.SetText(3, ColumnType::Owner, L"cccc");
+
+	EXPECT_EQ(cache.MaybeGetText(1, ColumnType::Owner), L"aaaa");
+	EXPECT_EQ(cache.MaybeGetText(2, ColumnType::Owner), std::nullopt);
+	EXPECT_EQ(cache.MaybeGetText(3, ColumnType::Owner), L"cccc");
+	EXPECT_EQ(cache.GetSize(), 8u);
+
+	// Text that's longer than the limit is never stored.
+	cache.SetText(4, ColumnType::Owner, L"ddddddddddd");
+	EXPECT_EQ(cache.MaybeGetText(4, ColumnType::Owner), std::nullopt);
+	EXPECT_EQ(cache.GetNumEntries(), 2u);
+}
+
+TEST(ColumnTextCacheTest, EntryLimit)
+{
+	ColumnTextCache cache(100, 2);
+	cache.SetText(1, ColumnType::Owner, L"");
+	cache.SetText(2, ColumnType::Owner, L"");
+	cache.SetText(3, ColumnType::Owner, L"");
+
+	// Empty text doesn't count towards the size limit, but each entry still counts towards the
+	// entry limit, so the least recently used entry should have been removed.
+	EXPECT_EQ(cache.MaybeGetText(1, ColumnType::Owner), std::nullopt);
+	EXPECT_EQ(cache.MaybeGetText(2, ColumnType::Owner), L"");
+	EXPECT_EQ(cache.MaybeGetText(3, ColumnType::Owner), L"");
+	EXPECT_EQ(cache.GetNumEntries(), 2u);
+}
@@ -22,6 +22,7 @@ Config BuildReference()
 	config.globalFolderSettings.forceSize = true;
 	config.globalFolderSettings.oneClickActivate = true;
 	config.globalFolderSettings.oneClickActivateHoverTime = 40;
+	config.thumbnailMemoryLimitMB = 32;
 	config.defaultFolderSettings.viewMode = ViewMode::Details;
 	config.defaultFolderSettings.showInGroups = true;
 	return config;
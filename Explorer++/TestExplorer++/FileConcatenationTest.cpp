@@ -0,0 +1,196 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Helper/FileConcatenation.h"
+#include "../Helper/PipelinedFileCopier.h"
+#include "FileTestHelper.h"
+#include "ScopedTestDir.h"
+#include <gtest/gtest.h>
+#include <wil/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stop_token>
+#include <vector>
+
+using namespace testing;
+
+class FileConcatenationTest : public Test
+{
+protected:
+	static constexpr size_t TEST_BUFFER_SIZE = 4 * 1024;
+
+	std::wstring CreateInputFile(const std::wstring &name, size_t size, char value)
+	{
+		auto path = m_scopedTestDir.GetPath() / name;
+		CreateFileWithSize(path, size, value);
+		return path.wstring();
+	}
+
+	static wil::unique_hfile CreateOutputFile(const std::filesystem::path &path,
+		DWORD flags = FILE_FLAG_OVERLAPPED)
+	{
+		return wil::unique_hfile(
+			CreateFile(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, flags, nullptr));
+	}
+
+	ScopedTestDir m_scopedTestDir;
+};
+
+TEST_F(FileConcatenationTest, Concatenate)
+{
+	std::vector<std::wstring> inputPaths = { CreateInputFile(L"file.part1", 10000, 'a'),
+		CreateInputFile(L"file.part2", 0, 'b'), CreateInputFile(L"file.part3", 5000, 'c'),
+		CreateInputFile(L"file.part4", TEST_BUFFER_SIZE, 'd') };
+
+	auto outputPath = m_scopedTestDir.GetPath() / L"file";
+	std::uint64_t reportedTotalSize = 0;
+
+	{
+		auto outputFile = CreateOutputFile(outputPath);
+		ASSERT_TRUE(outputFile);
+
+		PipelinedFileCopier copier({}, nullptr, TEST_BUFFER_SIZE);
+		EXPECT_TRUE(ConcatenateFiles(inputPaths, outputFile.get(), copier,
+			[&reportedTotalSize](std::uint64_t totalSize) { reportedTotalSize = totalSize; }));
+	}
+
+	auto expectedData = std::string(10000, 'a') + std::string(5000, 'c')
+		+ std::string(TEST_BUFFER_SIZE, 'd');
+	EXPECT_EQ(ReadFileData(outputPath),
+		std::vector<char>(expectedData.begin(), expectedData.end()));
+	EXPECT_EQ(reportedTotalSize, expectedData.size());
+}
+
+TEST_F(FileConcatenationTest, MissingInputFile)
+{
+	std::vector<std::wstring> inputPaths = { CreateInputFile(L"file.part1", 100, 'a'),
+		(m_scopedTestDir.GetPath() / L"missing").wstring(),
+		CreateInputFile(L"file.part3", 200, 'c') };
+
+	auto outputPath = m_scopedTestDir.GetPath() / L"file";
+
+	{
+		auto outputFile = CreateOutputFile(outputPath);
+		ASSERT_TRUE(outputFile);
+
+		PipelinedFileCopier copier({}, nullptr, TEST_BUFFER_SIZE);
+		EXPECT_FALSE(ConcatenateFiles(inputPaths, outputFile.get(), copier));
+	}
+
+	// Since one of the input files can't be opened, nothing should have been written.
+	EXPECT_EQ(std::filesystem::file_size(outputPath), 0u);
+}
+
+TEST_F(FileConcatenationTest, Stop)
+{
+	std::vector<std::wstring> inputPaths = { CreateInputFile(L"file.part1", 10000, 'a'),
+		CreateInputFile(L"file.part2", 10000, 'b') };
+
+	auto outputPath = m_scopedTestDir.GetPath() / L"file";
+
+	{
+		auto outputFile = CreateOutputFile(outputPath);
+		ASSERT_TRUE(outputFile);
+
+		std::stop_source stopSource;
+		stopSource.request_stop();
+
+		PipelinedFileCopier copier(stopSource.get_token(), nullptr, TEST_BUFFER_SIZE);
+		EXPECT_FALSE(ConcatenateFiles(inputPaths, outputFile.get(), copier));
+	}
+
+	// The output file is set to the combined size of the inputs upfront. Since nothing was
+	// copied, it should have been truncated back to an empty file.
+	EXPECT_EQ(std::filesystem::file_size(outputPath), 0u);
+}
+
+// This test is disabled by default, since it's only intended to be used to measure performance. It
+// can be run by passing --gtest_also_run_disabled_tests.
+TEST_F(FileConcatenationTest, DISABLED_Benchmark)
+{
+	// The first part is larger than 4 GB, which is a case the previous implementation didn't
+	// support.
+	const std::vector<std::uint64_t> partSizes = { 4608ull * 1024 * 1024, 1024ull * 1024 * 1024,
+		1024ull * 1024 * 1024 };
+
+	std::vector<std::wstring> inputPaths;
+	std::uint64_t totalSize = 0;
+	std::string block(PipelinedFileCopier::DEFAULT_BUFFER_SIZE, 'a');
+
+	for (size_t i = 0; i < partSizes.size(); i++)
+	{
+		auto path = m_scopedTestDir.GetPath() / std::format(L"file.part{}", i + 1);
+		std::ofstream file(path, std::ios::binary);
+
+		for (std::uint64_t written = 0; written < partSizes[i]; written += block.size())
+		{
+			file.write(block.data(), block.size());
+		}
+
+		inputPaths.push_back(path.wstring());
+		totalSize += partSizes[i];
+	}
+
+	auto outputPath = m_scopedTestDir.GetPath() / L"file";
+	auto start = std::chrono::steady_clock::now();
+
+	{
+		auto outputFile = CreateOutputFile(outputPath);
+		ASSERT_TRUE(outputFile);
+
+		PipelinedFileCopier copier;
+		ASSERT_TRUE(ConcatenateFiles(inputPaths, outputFile.get(), copier));
+	}
+
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start);
+
+	EXPECT_EQ(std::filesystem::file_size(outputPath), totalSize);
+	std::filesystem::remove(outputPath);
+
+	// Synchronous reads and writes, with a single buffer of the same size, provide a baseline.
+	start = std::chrono::steady_clock::now();
+
+	{
+		auto outputFile = CreateOutputFile(outputPath, 0);
+		ASSERT_TRUE(outputFile);
+
+		std::vector<char> buffer(PipelinedFileCopier::DEFAULT_BUFFER_SIZE);
+
+		for (const auto &inputPath : inputPaths)
+		{
+			wil::unique_hfile inputFile(CreateFile(inputPath.c_str(), GENERIC_READ,
+				FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+			ASSERT_TRUE(inputFile);
+
+			DWORD numBytesRead;
+
+			while (ReadFile(inputFile.get(), buffer.data(), static_cast<DWORD>(buffer.size()),
+					   &numBytesRead, nullptr)
+				&& numBytesRead > 0)
+			{
+				DWORD numBytesWritten;
+				ASSERT_TRUE(WriteFile(outputFile.get(), buffer.data(), numBytesRead,
+					&numBytesWritten, nullptr));
+			}
+		}
+	}
+
+	auto baselineDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start);
+
+	EXPECT_EQ(std::filesystem::file_size(outputPath), totalSize);
+
+	auto toMBPerSecond = [totalSize](std::chrono::milliseconds duration)
+	{ return (totalSize / (1024 * 1024)) * 1000 / std::max<std::uint64_t>(duration.count(), 1); };
+
+	std::cout << std::format("{} parts ({} MB) merged in {} ({} MB/s, baseline: {}, {} MB/s)\n",
+		partSizes.size(), totalSize / (1024 * 1024), duration, toMBPerSecond(duration),
+		baselineDuration, toMBPerSecond(baselineDuration));
+}
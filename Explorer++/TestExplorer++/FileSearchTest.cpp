@@ -0,0 +1,179 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Helper/FileSearch.h"
+#include "FileTestHelper.h"
+#include "ScopedTestDir.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <regex>
+#include <stop_token>
+
+using namespace testing;
+
+class FileSearchTest : public Test
+{
+protected:
+	std::vector<std::wstring> Search(const FileSearchOptions &options,
+		std::stop_token stopToken = {})
+	{
+		std::vector<std::wstring> paths;
+
+		SearchFiles(m_scopedTestDir.GetPath(), options, stopToken,
+			[&paths](FileSearchProgress &&progress)
+			{
+				for (const auto &result : progress.results)
+				{
+					paths.push_back(result.path);
+				}
+			});
+
+		std::ranges::sort(paths);
+		return paths;
+	}
+
+	ScopedTestDir m_scopedTestDir;
+};
+
+TEST_F(FileSearchTest, Wildcard)
+{
+	CreateTestTree(m_scopedTestDir.GetPath(), 1, 2, 2);
+
+	FileSearchOptions options;
+	options.pattern = L"*1.TXT";
+
+	auto paths = Search(options);
+
+	auto root = m_scopedTestDir.GetPath();
+	std::vector<std::wstring> expectedPaths = { root / L"file1.txt",
+		root / L"folder0" / L"file1.txt", root / L"folder1" / L"file1.txt" };
+	EXPECT_EQ(paths, expectedPaths);
+}
+
+TEST_F(FileSearchTest, CaseSensitive)
+{
+	CreateTestTree(m_scopedTestDir.GetPath(), 1, 2, 2);
+
+	FileSearchOptions options;
+	options.pattern = L"*1.TXT";
+	options.caseInsensitive = false;
+
+	EXPECT_TRUE(Search(options).empty());
+}
+
+TEST_F(FileSearchTest, RegularExpression)
+{
+	CreateTestTree(m_scopedTestDir.GetPath(), 1, 2, 2);
+
+	FileSearchOptions options;
+	options.pattern = L"folder\\d";
+	options.useRegularExpressions = true;
+
+	auto root = m_scopedTestDir.GetPath();
+	std::vector<std::wstring> expectedPaths = { root / L"folder0", root / L"folder1" };
+	EXPECT_EQ(Search(options), expectedPaths);
+}
+
+TEST_F(FileSearchTest, InvalidRegularExpression)
+{
+	FileSearchOptions options;
+	options.pattern = L"[";
+	options.useRegularExpressions = true;
+
+	EXPECT_THROW(Search(options), std::regex_error);
+}
+
+TEST_F(FileSearchTest, RegularExpressionTooComplex)
+{
+	CreateFileWithSize(m_scopedTestDir.GetPath() / std::wstring(100, L'a'), 0);
+	CreateFileWithSize(m_scopedTestDir.GetPath() / L"b", 0);
+
+	// Evaluating this expression against the first file requires catastrophic backtracking, which
+	// the regex implementation will abandon by throwing. That item should simply be treated as not
+	// matching, rather than the exception escaping from the search thread.
+	FileSearchOptions options;
+	options.pattern = L"(a*)*b";
+	options.useRegularExpressions = true;
+
+	std::vector<std::wstring> paths;
+	auto summary = SearchFiles(m_scopedTestDir.GetPath(), options, {},
+		[&paths](FileSearchProgress &&progress)
+		{
+			for (const auto &result : progress.results)
+			{
+				paths.push_back(result.path);
+			}
+		});
+
+	std::vector<std::wstring> expectedPaths = { m_scopedTestDir.GetPath() / L"b" };
+	EXPECT_EQ(paths, expectedPaths);
+	EXPECT_TRUE(summary.regexMatchFailed);
+}
+
+TEST_F(FileSearchTest, NoSubfolders)
+{
+	CreateTestTree(m_scopedTestDir.GetPath(), 2, 2, 1);
+
+	FileSearchOptions options;
+	options.pattern = L"file*";
+	options.searchSubfolders = false;
+
+	std::vector<std::wstring> expectedPaths = { m_scopedTestDir.GetPath() / L"file0.txt" };
+	EXPECT_EQ(Search(options), expectedPaths);
+}
+
+TEST_F(FileSearchTest, Summary)
+{
+	auto treeInfo = CreateTestTree(m_scopedTestDir.GetPath(), 2, 3, 4);
+
+	auto summary = SearchFiles(m_scopedTestDir.GetPath(), {}, {}, nullptr);
+	EXPECT_EQ(summary.numFilesFound, treeInfo.numFiles);
+	EXPECT_EQ(summary.numFoldersFound, 3 + (3 * 3));
+}
+
+TEST_F(FileSearchTest, Stop)
+{
+	CreateTestTree(m_scopedTestDir.GetPath(), 2, 2, 2);
+
+	std::stop_source stopSource;
+	stopSource.request_stop();
+
+	// Since the stop was requested upfront, none of the subfolders should be searched.
+	FileSearchOptions options;
+	options.pattern = L"file*";
+
+	auto paths = Search(options, stopSource.get_token());
+	EXPECT_LE(paths.size(), 2u);
+}
+
+// This test is disabled by default, since it's only intended to be used to measure performance. It
+// can be run by passing --gtest_also_run_disabled_tests.
+TEST_F(FileSearchTest, DISABLED_Benchmark)
+{
+	auto treeInfo = CreateTestTree(m_scopedTestDir.GetPath(), 3, 10, 50);
+
+	FileSearchOptions options;
+	options.pattern = L"*5*";
+
+	size_t numResults = 0;
+	auto start = std::chrono::steady_clock::now();
+	auto summary = SearchFiles(m_scopedTestDir.GetPath(), options, {},
+		[&numResults](FileSearchProgress &&progress) { numResults += progress.results.size(); });
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start);
+
+	EXPECT_EQ(numResults,
+		static_cast<size_t>(summary.numFilesFound) + static_cast<size_t>(summary.numFoldersFound));
+
+	auto filesPerSecond =
+		duration.count() > 0 ? (treeInfo.numFiles * 1000LL) / duration.count() : 0;
+
+	std::cout << std::format("{} files searched in {} ({} files/second, {} results)\n",
+		treeInfo.numFiles, duration, filesPerSecond, numResults);
+}
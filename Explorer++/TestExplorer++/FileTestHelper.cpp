@@ -0,0 +1,70 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "FileTestHelper.h"
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace
+{
+
+void CreateTestTreeRecursive(const std::filesystem::path &root, int depth, int foldersPerFolder,
+	int filesPerFolder, TestTreeInfo &treeInfo)
+{
+	for (int i = 0; i < filesPerFolder; i++)
+	{
+		// The file sizes vary, so that files being counted multiple times or skipped would be
+		// more likely to result in an incorrect total.
+		auto size = static_cast<size_t>(i + 1) * 10;
+		CreateFileWithSize(root / std::format(L"file{}.txt", i), size);
+
+		treeInfo.size += size;
+		treeInfo.numFiles++;
+	}
+
+	if (depth == 0)
+	{
+		return;
+	}
+
+	for (int i = 0; i < foldersPerFolder; i++)
+	{
+		auto folder = root / std::format(L"folder{}", i);
+		std::filesystem::create_directory(folder);
+		treeInfo.numFolders++;
+
+		CreateTestTreeRecursive(folder, depth - 1, foldersPerFolder, filesPerFolder, treeInfo);
+	}
+}
+
+}
+
+void CreateFileWithSize(const std::filesystem::path &path, size_t size, char value)
+{
+	std::ofstream file(path, std::ios::binary);
+	file << std::string(size, value);
+}
+
+void WriteFileData(const std::filesystem::path &path, const std::vector<char> &data)
+{
+	std::ofstream file(path, std::ios::binary);
+	file.write(data.data(), data.size());
+}
+
+std::vector<char> ReadFileData(const std::filesystem::path &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+TestTreeInfo CreateTestTree(const std::filesystem::path &root, int depth, int foldersPerFolder,
+	int filesPerFolder)
+{
+	TestTreeInfo treeInfo;
+	CreateTestTreeRecursive(root, depth, foldersPerFolder, filesPerFolder, treeInfo);
+	return treeInfo;
+}
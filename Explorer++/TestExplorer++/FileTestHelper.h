@@ -0,0 +1,28 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+struct TestTreeInfo
+{
+	std::uintmax_t size = 0;
+	int numFolders = 0;
+	int numFiles = 0;
+};
+
+// Creates a file that consists of the specified character, repeated size times.
+void CreateFileWithSize(const std::filesystem::path &path, size_t size, char value = 'a');
+
+void WriteFileData(const std::filesystem::path &path, const std::vector<char> &data);
+std::vector<char> ReadFileData(const std::filesystem::path &path);
+
+// Creates a tree with the specified number of levels below the root. Each folder in the tree
+// contains the specified number of subfolders (apart from the folders on the last level) and
+// files. The files are named file0.txt, file1.txt, etc.
+TestTreeInfo CreateTestTree(const std::filesystem::path &root, int depth, int foldersPerFolder,
+	int filesPerFolder);
@@ -0,0 +1,212 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "FolderSizeCache.h"
+#include "FileTestHelper.h"
+#include "ScopedTestDir.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+
+using namespace testing;
+
+namespace
+{
+
+constexpr FILETIME TEST_WRITE_TIME = { 1, 2 };
+constexpr FILETIME UPDATED_WRITE_TIME = { 3, 4 };
+
+FILETIME GetLastWriteTime(const std::filesystem::path &path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributeData;
+	BOOL res = GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &attributeData);
+	EXPECT_TRUE(res);
+	return attributeData.ftLastWriteTime;
+}
+
+}
+
+TEST(FolderSizeCacheTest, SetGet)
+{
+	FolderSizeCache cache(100);
+	auto watchedTree = cache.RegisterWatchedTree(L"C:\\");
+	cache.Set(L"C:\\Folder", TEST_WRITE_TIME, { 100, 2, 3 });
+
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder", TEST_WRITE_TIME), FolderInfo(100, 2, 3));
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Other", TEST_WRITE_TIME), std::nullopt);
+}
+
+TEST(FolderSizeCacheTest, PathNormalization)
+{
+	FolderSizeCache cache(100);
+	auto watchedTree = cache.RegisterWatchedTree(L"C:\\Folder");
+	cache.Set(L"C:\\Folder", TEST_WRITE_TIME, { 100, 2, 3 });
+
+	EXPECT_EQ(cache.MaybeGet(L"c:\\FOLDER", TEST_WRITE_TIME), FolderInfo(100, 2, 3));
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder\\", TEST_WRITE_TIME), FolderInfo(100, 2, 3));
+}
+
+TEST(FolderSizeCacheTest, WriteTimeMismatch)
+{
+	FolderSizeCache cache(100);
+	auto watchedTree = cache.RegisterWatchedTree(L"C:\\Folder");
+	cache.Set(L"C:\\Folder", TEST_WRITE_TIME, { 100, 2, 3 });
+
+	// The folder has been modified since the entry was added, so the entry shouldn't be used.
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder", UPDATED_WRITE_TIME), std::nullopt);
+}
+
+TEST(FolderSizeCacheTest, InvalidatePath)
+{
+	FolderSizeCache cache(100);
+	auto watchedTree = cache.RegisterWatchedTree(L"C:\\Folder");
+	cache.Set(L"C:\\Folder", TEST_WRITE_TIME, { 100, 2, 3 });
+	cache.Set(L"C:\\Folder\\Subfolder", TEST_WRITE_TIME, { 50, 1, 1 });
+	cache.Set(L"C:\\Folder\\Subfolder\\Nested", TEST_WRITE_TIME, { 10, 0, 1 });
+	cache.Set(L"C:\\Folder\\Sibling", TEST_WRITE_TIME, { 20, 0, 1 });
+
+	cache.InvalidatePath(L"C:\\Folder\\Subfolder\\file.txt", false);
+
+	// The folders containing the file should have been invalidated, while other folders should be
+	// unaffected.
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder", TEST_WRITE_TIME), std::nullopt);
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder\\Subfolder", TEST_WRITE_TIME), std::nullopt);
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder\\Subfolder\\Nested", TEST_WRITE_TIME),
+		FolderInfo(10, 0, 1));
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder\\Sibling", TEST_WRITE_TIME), FolderInfo(20, 0, 1));
+}
+
+TEST(FolderSizeCacheTest, InvalidateSubtree)
+{
+	FolderSizeCache cache(100);
+	auto watchedTree = cache.RegisterWatchedTree(L"C:\\Folder");
+	cache.Set(L"C:\\Folder", TEST_WRITE_TIME, { 100, 2, 3 });
+	cache.Set(L"C:\\Folder\\Subfolder", TEST_WRITE_TIME, { 50, 1, 1 });
+	cache.Set(L"C:\\Folder\\Subfolder\\Nested", TEST_WRITE_TIME, { 10, 0, 1 });
+	cache.Set(L"C:\\Folder\\Subfolder2", TEST_WRITE_TIME, { 20, 0, 1 });
+
+	cache.InvalidatePath(L"C:\\Folder\\Subfolder", true);
+
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder", TEST_WRITE_TIME), std::nullopt);
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder\\Subfolder", TEST_WRITE_TIME), std::nullopt);
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder\\Subfolder\\Nested", TEST_WRITE_TIME), std::nullopt);
+
+	// This folder has a name that starts with the name of the invalidated folder, but isn't
+	// contained within it.
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder\\Subfolder2", TEST_WRITE_TIME), FolderInfo(20, 0, 1));
+}
+
+TEST(FolderSizeCacheTest, MaxEntries)
+{
+	FolderSizeCache cache(2);
+	auto watchedTree = cache.RegisterWatchedTree(L"C:\\");
+	cache.Set(L"C:\\Folder1", TEST_WRITE_TIME, { 1, 0, 1 });
+	cache.Set(L"C:\\Folder2", TEST_WRITE_TIME, { 2, 0, 1 });
+	cache.Set(L"C:\\Folder3", TEST_WRITE_TIME, { 3, 0, 1 });
+
+	EXPECT_EQ(cache.GetNumEntries(), 2u);
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder3", TEST_WRITE_TIME), FolderInfo(3, 0, 1));
+}
+
+TEST(FolderSizeCacheTest, UnwatchedFolder)
+{
+	FolderSizeCache cache(100);
+	auto watchedTree = cache.RegisterWatchedTree(L"C:\\Folder");
+
+	// Changes to this folder won't be reported, so the entry shouldn't be stored.
+	cache.Set(L"C:\\Other", TEST_WRITE_TIME, { 100, 2, 3 });
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Other", TEST_WRITE_TIME), std::nullopt);
+	EXPECT_EQ(cache.GetNumEntries(), 0u);
+}
+
+TEST(FolderSizeCacheTest, WatchedTreeReleased)
+{
+	FolderSizeCache cache(100);
+	auto watchedTree = cache.RegisterWatchedTree(L"C:\\Folder");
+	auto otherWatchedTree = cache.RegisterWatchedTree(L"C:\\Other");
+	cache.Set(L"C:\\Folder", TEST_WRITE_TIME, { 100, 2, 3 });
+	cache.Set(L"C:\\Folder\\Subfolder", TEST_WRITE_TIME, { 50, 1, 1 });
+	cache.Set(L"C:\\Other", TEST_WRITE_TIME, { 20, 0, 1 });
+
+	watchedTree.reset();
+
+	// Entries within a tree that's no longer watched may go out of date, so they should have been
+	// removed.
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder", TEST_WRITE_TIME), std::nullopt);
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder\\Subfolder", TEST_WRITE_TIME), std::nullopt);
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Other", TEST_WRITE_TIME), FolderInfo(20, 0, 1));
+}
+
+TEST(FolderSizeCacheTest, WatchedTreeRegisteredMultipleTimes)
+{
+	FolderSizeCache cache(100);
+	auto watchedTree1 = cache.RegisterWatchedTree(L"C:\\Folder");
+	auto watchedTree2 = cache.RegisterWatchedTree(L"c:\\folder\\");
+	auto nestedWatchedTree = cache.RegisterWatchedTree(L"C:\\Folder\\Subfolder");
+	cache.Set(L"C:\\Folder", TEST_WRITE_TIME, { 100, 2, 3 });
+	cache.Set(L"C:\\Folder\\Subfolder", TEST_WRITE_TIME, { 50, 1, 1 });
+
+	// The tree is still being watched, so the entries should be retained.
+	watchedTree1.reset();
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder", TEST_WRITE_TIME), FolderInfo(100, 2, 3));
+
+	// The subfolder is still being watched via the nested registration.
+	watchedTree2.reset();
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder", TEST_WRITE_TIME), std::nullopt);
+	EXPECT_EQ(cache.MaybeGet(L"C:\\Folder\\Subfolder", TEST_WRITE_TIME), FolderInfo(50, 1, 1));
+}
+
+TEST(FolderSizeCacheTest, GetOrCalculateReusesSubfolders)
+{
+	ScopedTestDir scopedTestDir;
+	auto subfolder = scopedTestDir.GetPath() / L"subfolder";
+	std::filesystem::create_directory(subfolder);
+
+	CreateFileWithSize(scopedTestDir.GetPath() / L"file", 10);
+
+	// The cached size for the subfolder doesn't reflect its actual (empty) contents, so the total
+	// will only include that size if the cached value is used.
+	FolderSizeCache cache(100);
+	auto watchedTree = cache.RegisterWatchedTree(scopedTestDir.GetPath());
+	cache.Set(subfolder, GetLastWriteTime(subfolder), { 1000, 5, 6 });
+
+	auto rootWriteTime = GetLastWriteTime(scopedTestDir.GetPath());
+	auto folderInfo = cache.GetOrCalculate(scopedTestDir.GetPath(), rootWriteTime);
+	EXPECT_EQ(folderInfo, FolderInfo(1010, 6, 7));
+
+	// The result should now be cached.
+	EXPECT_EQ(cache.MaybeGet(scopedTestDir.GetPath(), rootWriteTime), FolderInfo(1010, 6, 7));
+}
+
+TEST(FolderSizeCacheTest, GetOrCalculateCachesSubfolders)
+{
+	ScopedTestDir scopedTestDir;
+	auto subfolder = scopedTestDir.GetPath() / L"subfolder";
+	auto nestedFolder = subfolder / L"nested";
+	std::filesystem::create_directories(nestedFolder);
+
+	CreateFileWithSize(nestedFolder / L"file", 10);
+
+	FolderSizeCache cache(100);
+	auto watchedTree = cache.RegisterWatchedTree(scopedTestDir.GetPath());
+
+	auto folderInfo =
+		cache.GetOrCalculate(scopedTestDir.GetPath(), GetLastWriteTime(scopedTestDir.GetPath()));
+	EXPECT_EQ(folderInfo, FolderInfo(10, 2, 1));
+
+	// The totals for each subfolder should have been cached as part of the scan.
+	EXPECT_EQ(cache.MaybeGet(subfolder, GetLastWriteTime(subfolder)), FolderInfo(10, 1, 1));
+	EXPECT_EQ(cache.MaybeGet(nestedFolder, GetLastWriteTime(nestedFolder)), FolderInfo(10, 0, 1));
+}
+
+TEST(FolderSizeCacheTest, GetOrCalculateUnwatched)
+{
+	ScopedTestDir scopedTestDir;
+	FolderSizeCache cache(100);
+
+	auto rootWriteTime = GetLastWriteTime(scopedTestDir.GetPath());
+	cache.GetOrCalculate(scopedTestDir.GetPath(), rootWriteTime);
+
+	EXPECT_EQ(cache.MaybeGet(scopedTestDir.GetPath(), rootWriteTime), std::nullopt);
+}
@@ -0,0 +1,134 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Helper/FolderSize.h"
+#include "FileTestHelper.h"
+#include "ScopedTestDir.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stop_token>
+
+using namespace testing;
+
+class FolderSizeTest : public Test
+{
+protected:
+	ScopedTestDir m_scopedTestDir;
+};
+
+TEST_F(FolderSizeTest, Empty)
+{
+	auto folderInfo = GetFolderInfo(m_scopedTestDir.GetPath());
+	EXPECT_EQ(folderInfo.size, 0u);
+	EXPECT_EQ(folderInfo.numFolders, 0);
+	EXPECT_EQ(folderInfo.numFiles, 0);
+}
+
+TEST_F(FolderSizeTest, FilesAndFolders)
+{
+	auto treeInfo = CreateTestTree(m_scopedTestDir.GetPath(), 3, 4, 5);
+
+	auto folderInfo = GetFolderInfo(m_scopedTestDir.GetPath());
+	EXPECT_EQ(folderInfo.size, treeInfo.size);
+	EXPECT_EQ(folderInfo.numFolders, treeInfo.numFolders);
+	EXPECT_EQ(folderInfo.numFiles, treeInfo.numFiles);
+}
+
+TEST_F(FolderSizeTest, PathWithTrailingSeparator)
+{
+	auto treeInfo = CreateTestTree(m_scopedTestDir.GetPath(), 1, 2, 2);
+
+	auto folderInfo = GetFolderInfo(m_scopedTestDir.GetPath().wstring() + L"\\");
+	EXPECT_EQ(folderInfo.size, treeInfo.size);
+	EXPECT_EQ(folderInfo.numFolders, treeInfo.numFolders);
+	EXPECT_EQ(folderInfo.numFiles, treeInfo.numFiles);
+}
+
+TEST_F(FolderSizeTest, Stop)
+{
+	CreateTestTree(m_scopedTestDir.GetPath(), 2, 3, 0);
+
+	auto folder = m_scopedTestDir.GetPath() / L"folder0" / L"folder0";
+	CreateFileWithSize(folder / L"file", 100);
+
+	std::stop_source stopSource;
+	stopSource.request_stop();
+
+	// The files are only contained within subfolders and those subfolders should never be
+	// scanned, since the stop was requested upfront.
+	auto folderInfo = GetFolderInfo(m_scopedTestDir.GetPath(), stopSource.get_token());
+	EXPECT_EQ(folderInfo.size, 0u);
+	EXPECT_EQ(folderInfo.numFiles, 0);
+}
+
+TEST_F(FolderSizeTest, SubfolderTotals)
+{
+	auto treeInfo = CreateTestTree(m_scopedTestDir.GetPath(), 2, 2, 3);
+
+	std::mutex mutex;
+	std::map<std::wstring, FolderInfo> subfolderInfos;
+
+	auto folderInfo = GetFolderInfo(m_scopedTestDir.GetPath(), {}, nullptr, nullptr,
+		[&mutex, &subfolderInfos](const std::wstring &path, const FILETIME &lastWriteTime,
+			const FolderInfo &subfolderInfo)
+		{
+			UNREFERENCED_PARAMETER(lastWriteTime);
+
+			std::scoped_lock lock(mutex);
+			auto [itr, inserted] = subfolderInfos.emplace(path, subfolderInfo);
+			EXPECT_TRUE(inserted);
+		});
+	EXPECT_EQ(folderInfo.numFolders, treeInfo.numFolders);
+
+	// The totals for each subfolder should be reported, with the root itself excluded.
+	EXPECT_EQ(subfolderInfos.size(), static_cast<size_t>(treeInfo.numFolders));
+
+	for (const auto &[path, subfolderInfo] : subfolderInfos)
+	{
+		EXPECT_EQ(subfolderInfo, GetFolderInfo(path));
+	}
+}
+
+// This test is disabled by default, since it's only intended to be used to measure performance. It
+// can be run by passing --gtest_also_run_disabled_tests.
+TEST_F(FolderSizeTest, DISABLED_Benchmark)
+{
+	auto treeInfo = CreateTestTree(m_scopedTestDir.GetPath(), 3, 10, 20);
+
+	auto start = std::chrono::steady_clock::now();
+	auto folderInfo = GetFolderInfo(m_scopedTestDir.GetPath());
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start);
+
+	EXPECT_EQ(folderInfo.size, treeInfo.size);
+	EXPECT_EQ(folderInfo.numFolders, treeInfo.numFolders);
+	EXPECT_EQ(folderInfo.numFiles, treeInfo.numFiles);
+
+	// A single-threaded walk, querying the size of each file separately, provides a baseline.
+	start = std::chrono::steady_clock::now();
+	std::uintmax_t baselineSize = 0;
+
+	for (const auto &entry : std::filesystem::recursive_directory_iterator(
+			 m_scopedTestDir.GetPath()))
+	{
+		if (!entry.is_directory())
+		{
+			baselineSize += std::filesystem::file_size(entry.path());
+		}
+	}
+
+	auto baselineDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start);
+
+	EXPECT_EQ(baselineSize, treeInfo.size);
+
+	std::cout << std::format("{} folders and {} files scanned in {} (baseline: {})\n",
+		treeInfo.numFolders, treeInfo.numFiles, duration, baselineDuration);
+}
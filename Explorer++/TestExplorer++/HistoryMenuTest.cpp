@@ -12,17 +12,27 @@
 #include "MenuViewFakeTestHelper.h"
 #include "ShellIconLoaderFake.h"
 #include <gtest/gtest.h>
+#include <format>
 
 class HistoryMenuTest : public BrowserTestBase
 {
 protected:
 	HistoryMenuTest() :
+		m_historyModel(MAX_HISTORY_ITEMS),
 		m_historyTracker(&m_historyModel, &m_navigationEvents),
 		m_browser(AddBrowser()),
 		m_menu(&m_menuView, &m_acceleratorManager, &m_historyModel, m_browser, &m_shellIconLoader)
 	{
 	}
 
+	void ShowMenu()
+	{
+		m_menuView.OnMenuWillShowForDpi(USER_DEFAULT_SCREEN_DPI);
+		m_menuView.OnMenuClosed();
+	}
+
+	static constexpr size_t MAX_HISTORY_ITEMS = 5;
+
 	HistoryModel m_historyModel;
 	HistoryTracker m_historyTracker;
 	ShellIconLoaderFake m_shellIconLoader;
@@ -46,6 +56,7 @@ TEST_F(HistoryMenuTest, CheckItems)
 
 	// Items should appear in the reverse order that they were added to the history (i.e. with the
 	// most recent item first).
+	ShowMenu();
 	MenuViewFakeTestHelper::CheckItemDetails(&m_menuView, { pidl3, pidl2, pidl1 });
 
 	// The menu should automatically update when the global history changes.
@@ -55,5 +66,69 @@ TEST_F(HistoryMenuTest, CheckItems)
 	PidlAbsolute pidl5;
 	m_browser->AddTab(L"e:\\", {}, &pidl5);
 
+	ShowMenu();
 	MenuViewFakeTestHelper::CheckItemDetails(&m_menuView, { pidl5, pidl4, pidl3, pidl2, pidl1 });
 }
+
+TEST_F(HistoryMenuTest, ItemsAddedWhenShown)
+{
+	PidlAbsolute pidl1;
+	m_browser->AddTab(L"c:\\windows", {}, &pidl1);
+	ShowMenu();
+
+	PidlAbsolute pidl2;
+	m_browser->AddTab(L"d:\\project\\documents", {}, &pidl2);
+
+	// New history items should only be added to the menu once it's about to be shown.
+	MenuViewFakeTestHelper::CheckItemDetails(&m_menuView, { pidl1 });
+
+	ShowMenu();
+	MenuViewFakeTestHelper::CheckItemDetails(&m_menuView, { pidl2, pidl1 });
+}
+
+TEST_F(HistoryMenuTest, RepeatedNavigation)
+{
+	PidlAbsolute pidl1;
+	m_browser->AddTab(L"c:\\windows", {}, &pidl1);
+
+	PidlAbsolute pidl2;
+	m_browser->AddTab(L"d:\\project\\documents", {}, &pidl2);
+	ShowMenu();
+
+	PidlAbsolute pidl3;
+	m_browser->AddTab(L"c:\\users", {}, &pidl3);
+
+	// The existing item should be moved to the top of the menu, while the new item is still
+	// pending.
+	m_browser->AddTab(L"c:\\windows");
+	MenuViewFakeTestHelper::CheckItemDetails(&m_menuView, { pidl1, pidl2 });
+
+	ShowMenu();
+	MenuViewFakeTestHelper::CheckItemDetails(&m_menuView, { pidl1, pidl3, pidl2 });
+}
+
+TEST_F(HistoryMenuTest, Eviction)
+{
+	std::vector<PidlAbsolute> pidls;
+
+	for (size_t i = 0; i < MAX_HISTORY_ITEMS; i++)
+	{
+		PidlAbsolute pidl;
+		m_browser->AddTab(std::format(L"c:\\path{}", i), {}, &pidl);
+		pidls.insert(pidls.begin(), pidl);
+	}
+
+	ShowMenu();
+	MenuViewFakeTestHelper::CheckItemDetails(&m_menuView, pidls);
+
+	PidlAbsolute newPidl;
+	m_browser->AddTab(L"c:\\new-path", {}, &newPidl);
+
+	// The oldest item should be removed from the menu straight away.
+	pidls.pop_back();
+	MenuViewFakeTestHelper::CheckItemDetails(&m_menuView, pidls);
+
+	ShowMenu();
+	pidls.insert(pidls.begin(), newPidl);
+	MenuViewFakeTestHelper::CheckItemDetails(&m_menuView, pidls);
+}
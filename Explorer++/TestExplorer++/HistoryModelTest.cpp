@@ -19,11 +19,61 @@ TEST(HistoryModelTest, RepeatedNavigation)
 	historyModel.AddHistoryItem(pidl);
 	EXPECT_EQ(history.size(), 1U);
 
-	MockFunction<void()> callback;
-	historyModel.AddHistoryChangedObserver(callback.AsStdFunction());
-	EXPECT_CALL(callback, Call()).Times(0);
+	MockFunction<void(const PidlAbsolute &pidl)> addedCallback;
+	historyModel.AddHistoryItemAddedObserver(addedCallback.AsStdFunction());
+	EXPECT_CALL(addedCallback, Call(_)).Times(0);
+
+	MockFunction<void(const PidlAbsolute &pidl)> movedCallback;
+	historyModel.AddHistoryItemMovedObserver(movedCallback.AsStdFunction());
+	EXPECT_CALL(movedCallback, Call(_)).Times(0);
 
 	// A repeated navigation to the most recent entry should be ignored.
 	historyModel.AddHistoryItem(pidl);
 	EXPECT_EQ(history.size(), 1U);
 }
+
+TEST(HistoryModelTest, RepeatedNavigationToOlderItem)
+{
+	HistoryModel historyModel;
+	const auto &history = historyModel.GetHistoryItems();
+
+	PidlAbsolute pidl1 = CreateSimplePidlForTest(L"C:\\Fake1");
+	historyModel.AddHistoryItem(pidl1);
+
+	PidlAbsolute pidl2 = CreateSimplePidlForTest(L"C:\\Fake2");
+	historyModel.AddHistoryItem(pidl2);
+
+	MockFunction<void(const PidlAbsolute &pidl)> addedCallback;
+	historyModel.AddHistoryItemAddedObserver(addedCallback.AsStdFunction());
+	EXPECT_CALL(addedCallback, Call(_)).Times(0);
+
+	MockFunction<void(const PidlAbsolute &pidl)> movedCallback;
+	historyModel.AddHistoryItemMovedObserver(movedCallback.AsStdFunction());
+	EXPECT_CALL(movedCallback, Call(pidl1));
+
+	// The existing item should be moved to the front, rather than a duplicate item being added.
+	historyModel.AddHistoryItem(pidl1);
+	EXPECT_THAT(history, ElementsAre(pidl1, pidl2));
+}
+
+TEST(HistoryModelTest, Eviction)
+{
+	HistoryModel historyModel(2);
+	const auto &history = historyModel.GetHistoryItems();
+
+	PidlAbsolute pidl1 = CreateSimplePidlForTest(L"C:\\Fake1");
+	historyModel.AddHistoryItem(pidl1);
+
+	PidlAbsolute pidl2 = CreateSimplePidlForTest(L"C:\\Fake2");
+	historyModel.AddHistoryItem(pidl2);
+
+	MockFunction<void(const PidlAbsolute &pidl)> evictedCallback;
+	historyModel.AddHistoryItemEvictedObserver(evictedCallback.AsStdFunction());
+	EXPECT_CALL(evictedCallback, Call(pidl1));
+
+	// The history is full, so adding a new item should result in the least recently visited item
+	// being removed.
+	PidlAbsolute pidl3 = CreateSimplePidlForTest(L"C:\\Fake3");
+	historyModel.AddHistoryItem(pidl3);
+	EXPECT_THAT(history, ElementsAre(pidl3, pidl2));
+}
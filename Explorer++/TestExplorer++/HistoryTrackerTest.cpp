@@ -27,26 +27,26 @@ TEST_F(HistoryTrackerTest, CheckNavigationsAdded)
 	const auto &history = m_historyModel.GetHistoryItems();
 	EXPECT_EQ(history.size(), 0U);
 
-	MockFunction<void()> callback;
-	m_historyModel.AddHistoryChangedObserver(callback.AsStdFunction());
-	EXPECT_CALL(callback, Call()).Times(3);
+	MockFunction<void(const PidlAbsolute &pidl)> callback;
+	m_historyModel.AddHistoryItemAddedObserver(callback.AsStdFunction());
+	EXPECT_CALL(callback, Call(_)).Times(3);
 
 	auto *browser1 = AddBrowser();
 
 	PidlAbsolute pidl1;
 	browser1->AddTab(L"c:\\fake1", {}, &pidl1);
 	ASSERT_EQ(history.size(), 1U);
-	EXPECT_EQ(history[0], pidl1);
+	EXPECT_EQ(history.front(), pidl1);
 
 	PidlAbsolute pidl2;
 	browser1->AddTab(L"c:\\path2", {}, &pidl2);
 	ASSERT_EQ(history.size(), 2U);
-	EXPECT_EQ(history[0], pidl2);
+	EXPECT_EQ(history.front(), pidl2);
 
 	auto *browser2 = AddBrowser();
 
 	PidlAbsolute pidl3;
 	browser2->AddTab(L"c:\\path3", {}, &pidl3);
 	ASSERT_EQ(history.size(), 3U);
-	EXPECT_EQ(history[0], pidl3);
+	EXPECT_EQ(history.front(), pidl3);
 }
@@ -47,6 +47,61 @@ TEST_F(MenuViewTest, AppendItem)
 	CheckAppendItem(idCounter++, L"Item 3", L"Help text for item 3");
 }
 
+TEST_F(MenuViewTest, InsertItem)
+{
+	m_menuView.AppendItem(1, L"Item 1");
+	m_menuView.AppendItem(2, L"Item 2");
+	m_menuView.InsertItem(0, 3, L"Item 3", {}, L"Help text for item 3");
+	m_menuView.InsertItem(2, 4, L"Item 4");
+
+	ASSERT_EQ(m_menuView.GetItemCount(), 4);
+	EXPECT_EQ(m_menuView.GetItemId(0), 3U);
+	EXPECT_EQ(m_menuView.GetItemId(1), 1U);
+	EXPECT_EQ(m_menuView.GetItemId(2), 4U);
+	EXPECT_EQ(m_menuView.GetItemId(3), 2U);
+	EXPECT_EQ(m_menuView.GetItemText(3), L"Item 3");
+	EXPECT_EQ(m_menuView.GetItemHelpText(3), L"Help text for item 3");
+}
+
+TEST_F(MenuViewTest, MoveItem)
+{
+	m_menuView.AppendItem(1, L"Item 1");
+	m_menuView.AppendItem(2, L"Item 2", {}, L"Help text for item 2", L"Ctrl+B");
+	m_menuView.AppendItem(3, L"Item 3");
+
+	m_menuView.MoveItem(2, 0);
+
+	ASSERT_EQ(m_menuView.GetItemCount(), 3);
+	EXPECT_EQ(m_menuView.GetItemId(0), 2U);
+	EXPECT_EQ(m_menuView.GetItemId(1), 1U);
+	EXPECT_EQ(m_menuView.GetItemId(2), 3U);
+
+	// The details of the item should be retained.
+	EXPECT_EQ(m_menuView.GetItemText(2), L"Item 2\tCtrl+B");
+	EXPECT_EQ(m_menuView.GetItemHelpText(2), L"Help text for item 2");
+}
+
+TEST_F(MenuViewTest, RemoveItem)
+{
+	m_menuView.AppendItem(1, L"Item 1");
+	m_menuView.AppendItem(2, L"Item 2");
+
+	m_menuView.RemoveItem(1);
+
+	ASSERT_EQ(m_menuView.GetItemCount(), 1);
+	EXPECT_EQ(m_menuView.GetItemId(0), 2U);
+}
+
+TEST_F(MenuViewTest, MenuWillShowSignal)
+{
+	MockFunction<void()> callback;
+	m_menuView.AddMenuWillShowObserver(callback.AsStdFunction());
+
+	EXPECT_CALL(callback, Call());
+	m_menuView.OnMenuWillShowForDpi(USER_DEFAULT_SCREEN_DPI);
+	m_menuView.OnMenuClosed();
+}
+
 TEST_F(MenuViewTest, ClearEmptyMenu)
 {
 	// Clearing an empty menu should have no effect, but also shouldn't cause any issues.
@@ -165,6 +220,29 @@ TEST_F(MenuViewIconTest, MenuBeingShown)
 	EXPECT_EQ(bitmap, generatedBitmap);
 }
 
+TEST_F(MenuViewIconTest, ItemAddedAfterShow)
+{
+	MenuViewFake menuView;
+
+	menuView.OnMenuWillShowForDpi(USER_DEFAULT_SCREEN_DPI);
+	AddItemsToMenu(&menuView, 1);
+	menuView.OnMenuClosed();
+
+	AddItemsToMenu(&menuView, 1);
+
+	HBITMAP generatedBitmap = nullptr;
+	m_shellIconLoader.SetBitmapGeneratedCallback(
+		[&generatedBitmap](HBITMAP bitmap) { generatedBitmap = bitmap; });
+
+	// The menu is being shown again at the same DPI. The image for the item that was added while
+	// the menu was closed should still be set.
+	menuView.OnMenuWillShowForDpi(USER_DEFAULT_SCREEN_DPI);
+	EXPECT_NE(generatedBitmap, nullptr);
+
+	auto bitmap = menuView.GetItemBitmap(menuView.GetItemId(1));
+	EXPECT_EQ(bitmap, generatedBitmap);
+}
+
 TEST_F(MenuViewIconTest, ShowAfterDpiChange)
 {
 	MenuViewFake menuView;
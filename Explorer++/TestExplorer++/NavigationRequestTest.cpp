@@ -8,9 +8,11 @@
 #include "PidlTestHelper.h"
 #include "ShellBrowser/NavigationEvents.h"
 #include "ShellBrowser/NavigationRequestDelegate.h"
+#include "ShellBrowser/RemainingNavigationItems.h"
 #include "ShellEnumeratorFake.h"
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <format>
 
 using namespace testing;
 
@@ -126,6 +128,106 @@ TEST_F(NavigationRequestTest, Stopped)
 	EXPECT_TRUE(request->Stopped());
 }
 
+TEST_F(NavigationRequestTest, EnumeratedItems)
+{
+	PidlAbsolute pidl = CreateSimplePidlForTest(L"c:\\");
+
+	std::vector<PidlAbsolute> expectedItems;
+	std::vector<PidlChild> items;
+
+	// Item information is retrieved in chunks, so the number of items here should be large enough
+	// to span multiple chunks.
+	for (int i = 0; i < 1000; i++)
+	{
+		auto itemPidl = CreateSimplePidlForTest(std::format(L"c:\\file{}", i), nullptr,
+			ShellItemType::File);
+		items.push_back(itemPidl.GetLastItem());
+		expectedItems.push_back(itemPidl);
+	}
+
+	m_shellEnumerator->SetItems(items);
+
+	auto request = MakeNavigationRequest(NavigateParams::Normal(pidl.Raw()));
+	request->Start();
+	RunExecutors();
+
+	const auto &enumeratedItems = request->GetItems();
+	ASSERT_EQ(enumeratedItems.size(), expectedItems.size());
+
+	for (size_t i = 0; i < enumeratedItems.size(); i++)
+	{
+		EXPECT_EQ(enumeratedItems[i].pidlComplete, expectedItems[i]);
+	}
+}
+
+TEST_F(NavigationRequestTest, RemainingItems)
+{
+	PidlAbsolute pidl = CreateSimplePidlForTest(L"c:\\");
+
+	std::vector<PidlAbsolute> expectedItems;
+	std::vector<PidlChild> items;
+
+	// The number of items here should be large enough that the items are passed on in several
+	// chunks.
+	for (size_t i = 0; i < NavigationRequest::ITEMS_CHUNK_SIZE * 3; i++)
+	{
+		auto itemPidl = CreateSimplePidlForTest(std::format(L"c:\\file{}", i), nullptr,
+			ShellItemType::File);
+		items.push_back(itemPidl.GetLastItem());
+		expectedItems.push_back(itemPidl);
+	}
+
+	m_shellEnumerator->SetItems(items);
+
+	auto request = MakeNavigationRequest(NavigateParams::Normal(pidl.Raw()));
+	request->Start();
+	RunExecutors();
+
+	// The navigation should be able to commit once the first chunk of items is available, so only
+	// that chunk should be returned here.
+	const auto &initialItems = request->GetItems();
+	EXPECT_GE(initialItems.size(), NavigationRequest::ITEMS_CHUNK_SIZE);
+	EXPECT_LT(initialItems.size(), expectedItems.size());
+
+	std::vector<PidlAbsolute> enumeratedItems;
+
+	for (const auto &item : initialItems)
+	{
+		enumeratedItems.push_back(item.pidlComplete);
+	}
+
+	bool finished = false;
+	request->GetRemainingItems()->SetCallbacks(
+		[&enumeratedItems](std::vector<ItemInfo_t> remainingItems)
+		{
+			for (const auto &item : remainingItems)
+			{
+				enumeratedItems.push_back(item.pidlComplete);
+			}
+		},
+		[&finished] { finished = true; });
+
+	EXPECT_TRUE(finished);
+	EXPECT_EQ(enumeratedItems, expectedItems);
+}
+
+TEST_F(NavigationRequestTest, EnumerationStopped)
+{
+	PidlAbsolute pidl = CreateSimplePidlForTest(L"c:\\");
+	auto itemPidl = CreateSimplePidlForTest(L"c:\\file", nullptr, ShellItemType::File);
+	m_shellEnumerator->SetItems({ itemPidl.GetLastItem() });
+
+	auto request = MakeNavigationRequest(NavigateParams::Normal(pidl.Raw()));
+	request->Start();
+
+	// Stopping the navigation should stop the enumeration, rather than the enumeration running to
+	// completion.
+	m_stopSource.request_stop();
+	RunExecutors();
+
+	EXPECT_TRUE(request->GetItems().empty());
+}
+
 class NavigationRequestSignalTest : public NavigationRequestTest
 {
 protected:
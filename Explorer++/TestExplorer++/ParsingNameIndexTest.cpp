@@ -0,0 +1,95 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "ShellBrowser/ParsingNameIndex.h"
+#include <gtest/gtest.h>
+#include <format>
+
+using namespace testing;
+
+TEST(ParsingNameIndexTest, AddRemove)
+{
+	ParsingNameIndex index;
+	index.AddItem(L"c:\\folder\\file.txt", 1);
+	index.AddItem(L"c:\\folder\\image.png", 2);
+	EXPECT_EQ(index.GetSize(), 2u);
+
+	EXPECT_THAT(index.GetItemsForParsingName(L"c:\\folder\\file.txt"), ElementsAre(1));
+	EXPECT_THAT(index.GetItemsForParsingName(L"c:\\folder\\image.png"), ElementsAre(2));
+	EXPECT_THAT(index.GetItemsForParsingName(L"c:\\folder\\other.txt"), IsEmpty());
+
+	index.RemoveItem(L"c:\\folder\\file.txt", 1);
+	EXPECT_THAT(index.GetItemsForParsingName(L"c:\\folder\\file.txt"), IsEmpty());
+	EXPECT_THAT(index.GetItemsForParsingName(L"c:\\folder\\image.png"), ElementsAre(2));
+	EXPECT_EQ(index.GetSize(), 1u);
+
+	index.Clear();
+	EXPECT_EQ(index.GetSize(), 0u);
+}
+
+TEST(ParsingNameIndexTest, CaseInsensitive)
+{
+	ParsingNameIndex index;
+	index.AddItem(L"C:\\Folder\\File.txt", 1);
+
+	EXPECT_THAT(index.GetItemsForParsingName(L"c:\\folder\\file.txt"), ElementsAre(1));
+	EXPECT_THAT(index.GetItemsForParsingName(L"C:\\FOLDER\\FILE.TXT"), ElementsAre(1));
+
+	// Items whose names only differ by case can exist in a case-sensitive directory. Both items
+	// should be returned in that case.
+	index.AddItem(L"C:\\Folder\\FILE.txt", 2);
+	EXPECT_THAT(index.GetItemsForParsingName(L"c:\\folder\\file.txt"), UnorderedElementsAre(1, 2));
+
+	index.RemoveItem(L"C:\\Folder\\File.txt", 1);
+	EXPECT_THAT(index.GetItemsForParsingName(L"c:\\folder\\file.txt"), ElementsAre(2));
+}
+
+TEST(ParsingNameIndexTest, NotificationBurst)
+{
+	ParsingNameIndex index;
+	const int numItems = 10000;
+
+	for (int i = 0; i < numItems; i++)
+	{
+		index.AddItem(std::format(L"c:\\build\\output{}.obj", i), i);
+	}
+
+	EXPECT_EQ(index.GetSize(), static_cast<size_t>(numItems));
+
+	// Simulate a burst of notifications, where every item is renamed and then every second item is
+	// removed.
+	for (int i = 0; i < numItems; i++)
+	{
+		auto oldName = std::format(L"c:\\build\\output{}.obj", i);
+		ASSERT_THAT(index.GetItemsForParsingName(oldName), ElementsAre(i));
+
+		index.RemoveItem(oldName, i);
+		index.AddItem(std::format(L"c:\\build\\renamed{}.obj", i), i);
+	}
+
+	for (int i = 0; i < numItems; i += 2)
+	{
+		index.RemoveItem(std::format(L"c:\\build\\renamed{}.obj", i), i);
+	}
+
+	EXPECT_EQ(index.GetSize(), static_cast<size_t>(numItems / 2));
+
+	for (int i = 0; i < numItems; i++)
+	{
+		auto items = index.GetItemsForParsingName(std::format(L"c:\\build\\renamed{}.obj", i));
+
+		if (i % 2 == 0)
+		{
+			EXPECT_THAT(items, IsEmpty());
+		}
+		else
+		{
+			EXPECT_THAT(items, ElementsAre(i));
+		}
+
+		EXPECT_THAT(index.GetItemsForParsingName(std::format(L"c:\\build\\output{}.obj", i)),
+			IsEmpty());
+	}
+}
@@ -5,9 +5,23 @@
 #include "pch.h"
 #include "PasteSymLinksClient.h"
 #include "PasteSymLinksServer.h"
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <format>
+#include <thread>
 
 using namespace std::chrono_literals;
+using namespace testing;
+
+namespace
+{
+
+std::wstring GetLongPath()
+{
+	return L"C:\\" + std::wstring(PasteSymLinksServerClientBase::SHARED_MEMORY_SIZE, '0');
+}
+
+}
 
 TEST(PasteSymLinksServerClientTest, ClientSendsResultsNormally)
 {
@@ -33,11 +47,11 @@ TEST(PasteSymLinksServerClientTest, ClientSendsResultsNormally)
 		return true;
 	};
 
-	auto receivedItems = server.LaunchClientAndWaitForResponse(clientLauncher, 1s);
+	auto receivedItems = server.LaunchClientAndWaitForResponse(clientLauncher, 1s, 1s);
 	EXPECT_EQ(receivedItems, pastedItems);
 }
 
-TEST(PasteSymLinksServerClientTest, DataGreaterThanMaxSize)
+TEST(PasteSymLinksServerClientTest, DataGreaterThanSharedMemorySize)
 {
 	PasteSymLinksServer server;
 
@@ -45,16 +59,12 @@ TEST(PasteSymLinksServerClientTest, DataGreaterThanMaxSize)
 
 	auto clientThreadBody = []
 	{
-		// It's not realistic for an individual file path to be this long in practice. But if there
-		// are a large number of files on the clipboard and symlinks to those files are pasted, the
-		// memory limit could be reached. So, this is a simple way of simulating a situation where
-		// the serialized data is larger than the shared memory segment.
+		// It's not realistic for an individual file path to be this long in practice. However,
+		// it's a simple way of testing that a single result that's larger than the shared memory
+		// segment can be split across multiple chunks.
 		// Note that SHARED_MEMORY_SIZE is in bytes and the path here is a std::wstring, so the
-		// string will take twice that number of bytes. It's therefore guaranteed to not fit in the
-		// shared memory segment.
-		auto filePath =
-			L"C:\\" + std::wstring(PasteSymLinksServerClientBase::SHARED_MEMORY_SIZE, '0');
-		ClipboardOperations::PastedItems pastedItems = { { filePath, {} } };
+		// string will take twice that number of bytes.
+		ClipboardOperations::PastedItems pastedItems = { { GetLongPath(), {} } };
 
 		PasteSymLinksClient client;
 		client.NotifyServerOfResult(pastedItems);
@@ -66,29 +76,204 @@ TEST(PasteSymLinksServerClientTest, DataGreaterThanMaxSize)
 		return true;
 	};
 
-	// The data the client is attempting to send is larger than the shared memory size. In that
-	// case, no data should be received.
-	auto receivedItems = server.LaunchClientAndWaitForResponse(clientLauncher, 1s);
-	EXPECT_TRUE(receivedItems.empty());
+	auto receivedItems = server.LaunchClientAndWaitForResponse(clientLauncher, 1s, 1s);
+	ClipboardOperations::PastedItems expectedItems = { { GetLongPath(), {} } };
+	EXPECT_EQ(receivedItems, expectedItems);
+}
+
+TEST(PasteSymLinksServerClientTest, ResultsReceivedIncrementally)
+{
+	PasteSymLinksServer server;
+
+	ClipboardOperations::PastedItems pastedItems;
+
+	for (size_t i = 0; i < PasteSymLinksServerClientBase::RESULTS_PER_MESSAGE * 3; i++)
+	{
+		pastedItems.emplace_back(std::format(L"C:\\file{}", i), std::error_code());
+	}
+
+	std::jthread thread;
+
+	auto clientThreadBody = [&pastedItems]
+	{
+		PasteSymLinksClient client;
+		client.NotifyServerOfResult(pastedItems);
+	};
+
+	auto clientLauncher = [&thread, clientThreadBody]
+	{
+		thread = std::jthread(clientThreadBody);
+		return true;
+	};
+
+	std::vector<size_t> batchSizes;
+	auto receivedItems = server.LaunchClientAndWaitForResponse(clientLauncher, 1s, 1s,
+		[&batchSizes](const ClipboardOperations::PastedItems &results)
+		{ batchSizes.push_back(results.size()); });
+	EXPECT_EQ(receivedItems, pastedItems);
+
+	size_t batchSize = PasteSymLinksServerClientBase::RESULTS_PER_MESSAGE;
+	EXPECT_THAT(batchSizes, ElementsAre(batchSize, batchSize, batchSize));
+}
+
+TEST(PasteSymLinksServerClientTest, Throughput)
+{
+	PasteSymLinksServer server;
+
+	ClipboardOperations::PastedItems pastedItems;
+
+	for (int i = 0; i < 100'000; i++)
+	{
+		std::error_code error;
+
+		if (i % 10 == 0)
+		{
+			error = { ERROR_ACCESS_DENIED, std::system_category() };
+		}
+
+		pastedItems.emplace_back(std::format(L"C:\\Users\\Test\\Folder\\file{}.txt", i),
+			error);
+	}
+
+	std::jthread thread;
+
+	auto clientThreadBody = [&pastedItems]
+	{
+		PasteSymLinksClient client;
+		client.NotifyServerOfResult(pastedItems);
+	};
+
+	auto clientLauncher = [&thread, clientThreadBody]
+	{
+		thread = std::jthread(clientThreadBody);
+		return true;
+	};
+
+	size_t numItemsReceivedViaCallback = 0;
+	auto receivedItems = server.LaunchClientAndWaitForResponse(clientLauncher, 1s, 5s,
+		[&numItemsReceivedViaCallback](const ClipboardOperations::PastedItems &results)
+		{ numItemsReceivedViaCallback += results.size(); });
+	EXPECT_EQ(receivedItems, pastedItems);
+	EXPECT_EQ(numItemsReceivedViaCallback, pastedItems.size());
 }
 
 TEST(PasteSymLinksServerClientTest, ClientLaunchFails)
 {
 	// If the client fails to launch, an empty result should be returned.
 	PasteSymLinksServer server;
-	auto receivedItems = server.LaunchClientAndWaitForResponse([] { return false; }, 1s);
+	auto receivedItems = server.LaunchClientAndWaitForResponse([] { return false; }, 1s, 1s);
 	EXPECT_TRUE(receivedItems.empty());
 }
 
-TEST(PasteSymLinksServerClientTest, ClientFailsToSendResults)
+TEST(PasteSymLinksServerClientTest, ClientFailsToStart)
 {
-	// If the client doesn't send back any results, an empty result should be returned after the
-	// timeout.
+	// If the client never connects, an empty result should be returned after the start timeout.
 	PasteSymLinksServer server;
-	auto receivedItems = server.LaunchClientAndWaitForResponse([] { return true; }, 1s);
+	auto receivedItems = server.LaunchClientAndWaitForResponse([] { return true; }, 100ms, 1s);
 	EXPECT_TRUE(receivedItems.empty());
 }
 
+TEST(PasteSymLinksServerClientTest, ClientStartsSlowly)
+{
+	PasteSymLinksServer server;
+
+	ClipboardOperations::PastedItems pastedItems = { { L"C:\file1", {} } };
+
+	std::jthread thread;
+
+	auto clientThreadBody = [&pastedItems]
+	{
+		// The client takes longer than the response timeout to start. That shouldn't matter,
+		// since the response timeout only applies once the client is running.
+		std::this_thread::sleep_for(500ms);
+
+		PasteSymLinksClient client;
+		client.NotifyServerOfResult(pastedItems);
+	};
+
+	auto clientLauncher = [&thread, clientThreadBody]
+	{
+		thread = std::jthread(clientThreadBody);
+		return true;
+	};
+
+	auto receivedItems = server.LaunchClientAndWaitForResponse(clientLauncher, 5s, 100ms);
+	EXPECT_EQ(receivedItems, pastedItems);
+}
+
+TEST(PasteSymLinksServerClientTest, ClientSendsResultsAsAvailable)
+{
+	PasteSymLinksServer server;
+
+	std::vector<ClipboardOperations::PastedItems> batches;
+	ClipboardOperations::PastedItems allItems;
+
+	for (int i = 0; i < 5; i++)
+	{
+		ClipboardOperations::PastedItems batch = { { std::format(L"C:\\file{}", i), {} } };
+		batches.push_back(batch);
+		allItems.insert(allItems.end(), batch.begin(), batch.end());
+	}
+
+	std::jthread thread;
+
+	auto clientThreadBody = [&batches]
+	{
+		PasteSymLinksClient client;
+
+		// The total time taken by the client is longer than the response timeout, but the gap
+		// between each set of results isn't.
+		for (const auto &batch : batches)
+		{
+			std::this_thread::sleep_for(100ms);
+			client.NotifyServerOfResult(batch);
+		}
+
+		client.FinishStream();
+	};
+
+	auto clientLauncher = [&thread, clientThreadBody]
+	{
+		thread = std::jthread(clientThreadBody);
+		return true;
+	};
+
+	std::vector<ClipboardOperations::PastedItems> receivedBatches;
+	auto receivedItems = server.LaunchClientAndWaitForResponse(clientLauncher, 1s, 300ms,
+		[&receivedBatches](const ClipboardOperations::PastedItems &results)
+		{ receivedBatches.push_back(results); });
+	EXPECT_EQ(receivedBatches, batches);
+	EXPECT_EQ(receivedItems, allItems);
+}
+
+TEST(PasteSymLinksServerClientTest, ClientStopsSendingResults)
+{
+	PasteSymLinksServer server;
+
+	ClipboardOperations::PastedItems pastedItems = { { L"C:\file1", {} } };
+
+	std::jthread thread;
+
+	auto clientThreadBody = [&pastedItems]
+	{
+		PasteSymLinksClient client;
+		client.NotifyServerOfResult(pastedItems);
+
+		// The client stalls, without finishing the stream.
+		std::this_thread::sleep_for(500ms);
+	};
+
+	auto clientLauncher = [&thread, clientThreadBody]
+	{
+		thread = std::jthread(clientThreadBody);
+		return true;
+	};
+
+	// The results received before the client stalled should be returned.
+	auto receivedItems = server.LaunchClientAndWaitForResponse(clientLauncher, 1s, 100ms);
+	EXPECT_EQ(receivedItems, pastedItems);
+}
+
 TEST(PasteSymLinksServerClientTest, NoServer)
 {
 	ClipboardOperations::PastedItems pastedItems = {
@@ -0,0 +1,309 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Helper/PipelinedFileCopier.h"
+#include "FileTestHelper.h"
+#include "ScopedTestDir.h"
+#include <gtest/gtest.h>
+#include <wil/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stop_token>
+#include <vector>
+
+using namespace testing;
+
+class PipelinedFileCopierTest : public Test
+{
+protected:
+	// Small buffers are used, so that the data is split across a large number of blocks.
+	static constexpr size_t TEST_BUFFER_SIZE = 4 * 1024;
+
+	static std::vector<char> GenerateData(size_t size)
+	{
+		// The data is random, so that a block being written to the wrong offset would result in
+		// the output being different.
+		std::mt19937 generator(static_cast<unsigned int>(size));
+		std::uniform_int_distribution<int> distribution(0, 255);
+
+		std::vector<char> data(size);
+
+		for (auto &byte : data)
+		{
+			byte = static_cast<char>(distribution(generator));
+		}
+
+		return data;
+	}
+
+	static wil::unique_hfile OpenForReading(const std::filesystem::path &path,
+		DWORD flags = FILE_FLAG_OVERLAPPED)
+	{
+		return wil::unique_hfile(CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, flags, nullptr));
+	}
+
+	static wil::unique_hfile OpenForWriting(const std::filesystem::path &path,
+		DWORD flags = FILE_FLAG_OVERLAPPED)
+	{
+		return wil::unique_hfile(
+			CreateFile(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, flags, nullptr));
+	}
+
+	ScopedTestDir m_scopedTestDir;
+};
+
+TEST_F(PipelinedFileCopierTest, CopyWholeFile)
+{
+	// The size isn't a multiple of the buffer size, so the last block will be partially filled.
+	auto data = GenerateData(TEST_BUFFER_SIZE * 10 + 123);
+
+	auto sourcePath = m_scopedTestDir.GetPath() / L"source";
+	auto destinationPath = m_scopedTestDir.GetPath() / L"destination";
+	WriteFileData(sourcePath, data);
+
+	{
+		auto source = OpenForReading(sourcePath);
+		ASSERT_TRUE(source);
+
+		auto destination = OpenForWriting(destinationPath);
+		ASSERT_TRUE(destination);
+
+		PipelinedFileCopier copier({}, nullptr, TEST_BUFFER_SIZE);
+		EXPECT_TRUE(copier.CopyRange(source.get(), 0, destination.get(), 0, data.size()));
+		EXPECT_EQ(copier.GetProgress().bytesCopied, data.size());
+	}
+
+	EXPECT_EQ(ReadFileData(destinationPath), data);
+}
+
+TEST_F(PipelinedFileCopierTest, CopyRanges)
+{
+	auto data = GenerateData(TEST_BUFFER_SIZE * 7 + 10);
+
+	auto sourcePath = m_scopedTestDir.GetPath() / L"source";
+	WriteFileData(sourcePath, data);
+
+	auto source = OpenForReading(sourcePath);
+	ASSERT_TRUE(source);
+
+	// Splits the source file into several parts, as is done when splitting a file.
+	const size_t partSize = TEST_BUFFER_SIZE * 2 + 500;
+	PipelinedFileCopier copier({}, nullptr, TEST_BUFFER_SIZE);
+
+	for (size_t offset = 0, part = 0; offset < data.size(); offset += partSize, part++)
+	{
+		auto partPath = m_scopedTestDir.GetPath() / std::format(L"part{}", part);
+		auto size = std::min(partSize, data.size() - offset);
+
+		{
+			auto destination = OpenForWriting(partPath);
+			ASSERT_TRUE(destination);
+
+			EXPECT_TRUE(copier.CopyRange(source.get(), offset, destination.get(), 0, size));
+		}
+
+		std::vector<char> expectedData(data.begin() + offset, data.begin() + offset + size);
+		EXPECT_EQ(ReadFileData(partPath), expectedData);
+	}
+
+	EXPECT_EQ(copier.GetProgress().bytesCopied, data.size());
+}
+
+TEST_F(PipelinedFileCopierTest, DestinationOffset)
+{
+	auto data = GenerateData(TEST_BUFFER_SIZE * 3);
+
+	auto sourcePath = m_scopedTestDir.GetPath() / L"source";
+	auto destinationPath = m_scopedTestDir.GetPath() / L"destination";
+	WriteFileData(sourcePath, data);
+
+	{
+		auto source = OpenForReading(sourcePath);
+		ASSERT_TRUE(source);
+
+		auto destination = OpenForWriting(destinationPath);
+		ASSERT_TRUE(destination);
+
+		// Copying the file twice, one copy after the other, should result in the data being
+		// concatenated.
+		PipelinedFileCopier copier({}, nullptr, TEST_BUFFER_SIZE);
+		EXPECT_TRUE(copier.CopyRange(source.get(), 0, destination.get(), 0, data.size()));
+		EXPECT_TRUE(
+			copier.CopyRange(source.get(), 0, destination.get(), data.size(), data.size()));
+	}
+
+	auto expectedData = data;
+	expectedData.insert(expectedData.end(), data.begin(), data.end());
+	EXPECT_EQ(ReadFileData(destinationPath), expectedData);
+}
+
+TEST_F(PipelinedFileCopierTest, SynchronousHandles)
+{
+	auto data = GenerateData(TEST_BUFFER_SIZE * 5 + 1);
+
+	auto sourcePath = m_scopedTestDir.GetPath() / L"source";
+	auto destinationPath = m_scopedTestDir.GetPath() / L"destination";
+	WriteFileData(sourcePath, data);
+
+	{
+		auto source = OpenForReading(sourcePath, 0);
+		ASSERT_TRUE(source);
+
+		auto destination = OpenForWriting(destinationPath, 0);
+		ASSERT_TRUE(destination);
+
+		PipelinedFileCopier copier({}, nullptr, TEST_BUFFER_SIZE);
+		EXPECT_TRUE(copier.CopyRange(source.get(), 0, destination.get(), 0, data.size()));
+	}
+
+	EXPECT_EQ(ReadFileData(destinationPath), data);
+}
+
+TEST_F(PipelinedFileCopierTest, SourceTooShort)
+{
+	auto data = GenerateData(TEST_BUFFER_SIZE * 2);
+
+	auto sourcePath = m_scopedTestDir.GetPath() / L"source";
+	auto destinationPath = m_scopedTestDir.GetPath() / L"destination";
+	WriteFileData(sourcePath, data);
+
+	auto source = OpenForReading(sourcePath);
+	ASSERT_TRUE(source);
+
+	auto destination = OpenForWriting(destinationPath);
+	ASSERT_TRUE(destination);
+
+	// The range extends past the end of the source file, so the copy should fail.
+	PipelinedFileCopier copier({}, nullptr, TEST_BUFFER_SIZE);
+	EXPECT_FALSE(copier.CopyRange(source.get(), 0, destination.get(), 0, data.size() + 1));
+}
+
+TEST_F(PipelinedFileCopierTest, Stop)
+{
+	auto data = GenerateData(TEST_BUFFER_SIZE * 4);
+
+	auto sourcePath = m_scopedTestDir.GetPath() / L"source";
+	auto destinationPath = m_scopedTestDir.GetPath() / L"destination";
+	WriteFileData(sourcePath, data);
+
+	auto source = OpenForReading(sourcePath);
+	ASSERT_TRUE(source);
+
+	auto destination = OpenForWriting(destinationPath);
+	ASSERT_TRUE(destination);
+
+	std::stop_source stopSource;
+	stopSource.request_stop();
+
+	PipelinedFileCopier copier(stopSource.get_token(), nullptr, TEST_BUFFER_SIZE);
+	EXPECT_FALSE(copier.CopyRange(source.get(), 0, destination.get(), 0, data.size()));
+	EXPECT_EQ(copier.GetProgress().bytesCopied, 0u);
+}
+
+TEST_F(PipelinedFileCopierTest, Progress)
+{
+	auto data = GenerateData(TEST_BUFFER_SIZE * 4);
+
+	auto sourcePath = m_scopedTestDir.GetPath() / L"source";
+	auto destinationPath = m_scopedTestDir.GetPath() / L"destination";
+	WriteFileData(sourcePath, data);
+
+	auto source = OpenForReading(sourcePath);
+	ASSERT_TRUE(source);
+
+	auto destination = OpenForWriting(destinationPath);
+	ASSERT_TRUE(destination);
+
+	std::vector<std::uint64_t> reportedBytes;
+	PipelinedFileCopier copier({},
+		[&reportedBytes](const PipelinedFileCopier::Progress &progress)
+		{ reportedBytes.push_back(progress.bytesCopied); },
+		TEST_BUFFER_SIZE);
+	EXPECT_TRUE(copier.CopyRange(source.get(), 0, destination.get(), 0, data.size()));
+
+	// Progress is always reported once the copy has finished.
+	ASSERT_FALSE(reportedBytes.empty());
+	EXPECT_EQ(reportedBytes.back(), data.size());
+}
+
+// This test is disabled by default, since it's only intended to be used to measure performance. It
+// can be run by passing --gtest_also_run_disabled_tests.
+TEST_F(PipelinedFileCopierTest, DISABLED_Benchmark)
+{
+	const std::uint64_t fileSize = 4ull * 1024 * 1024 * 1024;
+	const std::uint64_t partSize = 512ull * 1024 * 1024;
+
+	auto sourcePath = m_scopedTestDir.GetPath() / L"source";
+
+	{
+		auto block = GenerateData(PipelinedFileCopier::DEFAULT_BUFFER_SIZE);
+		std::ofstream file(sourcePath, std::ios::binary);
+
+		for (std::uint64_t written = 0; written < fileSize; written += block.size())
+		{
+			file.write(block.data(), block.size());
+		}
+	}
+
+	auto source = OpenForReading(sourcePath, FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN);
+	ASSERT_TRUE(source);
+
+	// Splits the file into parts using the copier.
+	auto start = std::chrono::steady_clock::now();
+	PipelinedFileCopier copier;
+
+	for (std::uint64_t offset = 0, part = 0; offset < fileSize; offset += partSize, part++)
+	{
+		auto destination =
+			OpenForWriting(m_scopedTestDir.GetPath() / std::format(L"part{}", part));
+		ASSERT_TRUE(destination);
+
+		ASSERT_TRUE(copier.CopyRange(source.get(), offset, destination.get(), 0, partSize));
+	}
+
+	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start);
+
+	// Synchronous reads and writes, with a single buffer of the same size, provide a baseline.
+	auto baselineSource = OpenForReading(sourcePath, FILE_FLAG_SEQUENTIAL_SCAN);
+	ASSERT_TRUE(baselineSource);
+
+	start = std::chrono::steady_clock::now();
+	std::vector<char> buffer(PipelinedFileCopier::DEFAULT_BUFFER_SIZE);
+
+	for (std::uint64_t offset = 0, part = 0; offset < fileSize; offset += partSize, part++)
+	{
+		auto destination =
+			OpenForWriting(m_scopedTestDir.GetPath() / std::format(L"baseline{}", part), 0);
+		ASSERT_TRUE(destination);
+
+		for (std::uint64_t copied = 0; copied < partSize; copied += buffer.size())
+		{
+			DWORD numBytesRead;
+			ASSERT_TRUE(ReadFile(baselineSource.get(), buffer.data(),
+				static_cast<DWORD>(buffer.size()), &numBytesRead, nullptr));
+
+			DWORD numBytesWritten;
+			ASSERT_TRUE(WriteFile(destination.get(), buffer.data(), numBytesRead,
+				&numBytesWritten, nullptr));
+		}
+	}
+
+	auto baselineDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start);
+
+	auto toMBPerSecond = [fileSize](std::chrono::milliseconds duration)
+	{ return (fileSize / (1024 * 1024)) * 1000 / std::max<std::uint64_t>(duration.count(), 1); };
+
+	std::cout << std::format("{} MB split in {} ({} MB/s, baseline: {}, {} MB/s)\n",
+		fileSize / (1024 * 1024), duration, toMBPerSecond(duration), baselineDuration,
+		toMBPerSecond(baselineDuration));
+}
@@ -0,0 +1,305 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Helper/DriveInfo.h"
+#include "../Helper/SecureDelete.h"
+#include "FileTestHelper.h"
+#include "ScopedTestDir.h"
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <set>
+#include <stop_token>
+#include <vector>
+
+using namespace testing;
+
+class SecureDeleteTest : public Test
+{
+protected:
+	std::wstring CreateTestFile(const std::wstring &name, size_t size)
+	{
+		auto path = m_scopedTestDir.GetPath() / name;
+		CreateFileWithSize(path, size);
+		return path.wstring();
+	}
+
+	DWORD GetTestDirClusterSize()
+	{
+		DWORD clusterSize = 0;
+		auto root = m_scopedTestDir.GetPath().root_path();
+		EXPECT_TRUE(GetClusterSize(root.c_str(), &clusterSize));
+		return clusterSize;
+	}
+
+	static bool ContainsOnly(const std::vector<char> &data, unsigned char value)
+	{
+		return std::ranges::all_of(data,
+			[value](char byte) { return static_cast<unsigned char>(byte) == value; });
+	}
+
+	ScopedTestDir m_scopedTestDir;
+};
+
+TEST_F(SecureDeleteTest, OnePass)
+{
+	auto path = CreateTestFile(L"file", 10000);
+
+	auto result = DeleteFilesSecurely({ path }, FileOperations::OverwriteMethod::OnePass);
+	EXPECT_EQ(result.numFilesDeleted, 1);
+	EXPECT_THAT(result.failedPaths, IsEmpty());
+	EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST_F(SecureDeleteTest, ThreePass)
+{
+	auto path = CreateTestFile(L"file", 10000);
+
+	auto result = DeleteFilesSecurely({ path }, FileOperations::OverwriteMethod::ThreePass);
+	EXPECT_EQ(result.numFilesDeleted, 1);
+	EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST_F(SecureDeleteTest, EmptyFile)
+{
+	auto path = CreateTestFile(L"file", 0);
+
+	auto result = DeleteFilesSecurely({ path }, FileOperations::OverwriteMethod::OnePass);
+	EXPECT_EQ(result.numFilesDeleted, 1);
+	EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST_F(SecureDeleteTest, MultipleFiles)
+{
+	std::vector<std::wstring> paths;
+
+	for (int i = 0; i < 10; i++)
+	{
+		// The files vary in size, so that some span multiple blocks.
+		paths.push_back(CreateTestFile(std::format(L"file{}", i), i * 300'000));
+	}
+
+	auto result = DeleteFilesSecurely(paths, FileOperations::OverwriteMethod::ThreePass);
+	EXPECT_EQ(result.numFilesDeleted, 10);
+	EXPECT_THAT(result.failedPaths, IsEmpty());
+
+	for (const auto &path : paths)
+	{
+		EXPECT_FALSE(std::filesystem::exists(path));
+	}
+}
+
+TEST_F(SecureDeleteTest, FoldersSkipped)
+{
+	auto folder = m_scopedTestDir.GetPath() / L"folder";
+	std::filesystem::create_directory(folder);
+
+	auto path = CreateTestFile(L"file", 100);
+
+	auto result =
+		DeleteFilesSecurely({ folder.wstring(), path }, FileOperations::OverwriteMethod::OnePass);
+	EXPECT_EQ(result.numFilesDeleted, 1);
+	EXPECT_THAT(result.failedPaths, IsEmpty());
+	EXPECT_TRUE(std::filesystem::exists(folder));
+	EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST_F(SecureDeleteTest, Stop)
+{
+	auto path = CreateTestFile(L"file", 10000);
+
+	std::stop_source stopSource;
+	stopSource.request_stop();
+
+	auto result = DeleteFilesSecurely({ path }, FileOperations::OverwriteMethod::OnePass,
+		stopSource.get_token());
+	EXPECT_EQ(result.numFilesDeleted, 0);
+
+	// Files that weren't started because of the stop request aren't failures.
+	EXPECT_THAT(result.failedPaths, IsEmpty());
+	EXPECT_TRUE(std::filesystem::exists(path));
+}
+
+TEST_F(SecureDeleteTest, StopDuringFile)
+{
+	// The file is large enough that progress will be reported before it's been fully
+	// overwritten.
+	auto path = CreateTestFile(L"file", 32 * 1024 * 1024);
+
+	std::stop_source stopSource;
+	bool stopRequested = false;
+
+	// A stop requested while a file is being overwritten shouldn't leave that file partially
+	// overwritten. Instead, the file should be finished and deleted.
+	auto result = DeleteFilesSecurely({ path }, FileOperations::OverwriteMethod::ThreePass,
+		stopSource.get_token(),
+		[&stopSource, &stopRequested](const SecureDeleteProgress &progress)
+		{
+			if (progress.bytesWritten > 0 && !stopRequested)
+			{
+				stopSource.request_stop();
+				stopRequested = true;
+			}
+		});
+	EXPECT_EQ(result.numFilesDeleted, 1);
+	EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST_F(SecureDeleteTest, FailedPaths)
+{
+	auto readOnlyPath = CreateTestFile(L"read-only", 100);
+	ASSERT_TRUE(SetFileAttributes(readOnlyPath.c_str(), FILE_ATTRIBUTE_READONLY));
+
+	auto missingPath = (m_scopedTestDir.GetPath() / L"missing").wstring();
+	auto path = CreateTestFile(L"file", 100);
+
+	auto result = DeleteFilesSecurely({ readOnlyPath, missingPath, path },
+		FileOperations::OverwriteMethod::OnePass);
+	EXPECT_EQ(result.numFilesDeleted, 1);
+	EXPECT_THAT(result.failedPaths, UnorderedElementsAre(readOnlyPath, missingPath));
+	EXPECT_TRUE(std::filesystem::exists(readOnlyPath));
+	EXPECT_FALSE(std::filesystem::exists(path));
+
+	// Allows the test directory to be removed.
+	SetFileAttributes(readOnlyPath.c_str(), FILE_ATTRIBUTE_NORMAL);
+}
+
+TEST_F(SecureDeleteTest, Progress)
+{
+	const size_t fileSize = 3'000'000;
+	std::vector<std::wstring> paths = { CreateTestFile(L"file1", fileSize),
+		CreateTestFile(L"file2", fileSize) };
+
+	SecureDeleteProgress finalProgress = {};
+	DeleteFilesSecurely(paths, FileOperations::OverwriteMethod::ThreePass, {},
+		[&finalProgress](const SecureDeleteProgress &progress) { finalProgress = progress; });
+
+	// Each file is overwritten up to the end of its last cluster, three times.
+	EXPECT_GE(finalProgress.totalBytes, fileSize * paths.size() * 3);
+	EXPECT_EQ(finalProgress.bytesWritten, finalProgress.totalBytes);
+}
+
+TEST_F(SecureDeleteTest, Passes)
+{
+	EXPECT_THAT(GetSecureDeletePasses(FileOperations::OverwriteMethod::OnePass),
+		ElementsAre(SecureDeletePass::Zeros));
+	EXPECT_THAT(GetSecureDeletePasses(FileOperations::OverwriteMethod::ThreePass),
+		ElementsAre(SecureDeletePass::Zeros, SecureDeletePass::Ones, SecureDeletePass::Random));
+}
+
+TEST_F(SecureDeleteTest, ZerosPass)
+{
+	// The file spans multiple blocks and its size isn't a multiple of the cluster size.
+	const size_t fileSize = 3'000'001;
+	auto path = CreateTestFile(L"file", fileSize);
+	auto clusterSize = GetTestDirClusterSize();
+
+	ASSERT_TRUE(OverwriteFileSecurely(path, { SecureDeletePass::Zeros }));
+
+	auto data = ReadFileData(path);
+	EXPECT_EQ(data.size(), (fileSize + clusterSize - 1) / clusterSize * clusterSize);
+	EXPECT_TRUE(ContainsOnly(data, 0x00));
+}
+
+TEST_F(SecureDeleteTest, OnesPass)
+{
+	auto path = CreateTestFile(L"file", 3'000'001);
+
+	ASSERT_TRUE(OverwriteFileSecurely(path, { SecureDeletePass::Ones }));
+	EXPECT_TRUE(ContainsOnly(ReadFileData(path), 0xFF));
+}
+
+TEST_F(SecureDeleteTest, RandomPass)
+{
+	auto path = CreateTestFile(L"file", 100'000);
+
+	ASSERT_TRUE(OverwriteFileSecurely(path, { SecureDeletePass::Random }));
+
+	// With this much random data, almost every possible byte value should appear.
+	auto data = ReadFileData(path);
+	std::set<char> values(data.begin(), data.end());
+	EXPECT_GT(values.size(), 200u);
+
+	// A second pass should write different data.
+	ASSERT_TRUE(OverwriteFileSecurely(path, { SecureDeletePass::Random }));
+	EXPECT_NE(ReadFileData(path), data);
+}
+
+TEST_F(SecureDeleteTest, PassesWrittenInOrder)
+{
+	auto path = CreateTestFile(L"file", 10000);
+
+	// If the passes were written in the wrong order, the file would end up full of zeros or
+	// 0xFF bytes.
+	ASSERT_TRUE(OverwriteFileSecurely(path,
+		GetSecureDeletePasses(FileOperations::OverwriteMethod::ThreePass)));
+
+	auto data = ReadFileData(path);
+	EXPECT_FALSE(ContainsOnly(data, 0x00));
+	EXPECT_FALSE(ContainsOnly(data, 0xFF));
+}
+
+TEST_F(SecureDeleteTest, SlackSpaceOverwritten)
+{
+	auto path = CreateTestFile(L"file", 100);
+	auto clusterSize = GetTestDirClusterSize();
+	ASSERT_GT(clusterSize, 100u);
+
+	ASSERT_TRUE(OverwriteFileSecurely(path, { SecureDeletePass::Ones }));
+
+	// The file should have been extended out to the end of its cluster, with the slack space
+	// overwritten along with the original data.
+	auto data = ReadFileData(path);
+	EXPECT_EQ(data.size(), clusterSize);
+	EXPECT_TRUE(ContainsOnly(data, 0xFF));
+}
+
+TEST_F(SecureDeleteTest, OverwriteStop)
+{
+	auto path = CreateTestFile(L"file", 10000);
+
+	std::stop_source stopSource;
+	stopSource.request_stop();
+
+	EXPECT_FALSE(OverwriteFileSecurely(path, { SecureDeletePass::Ones }, stopSource.get_token()));
+	EXPECT_FALSE(ContainsOnly(ReadFileData(path), 0xFF));
+}
+
+// This test is disabled by default, since it's only intended to be used to measure performance. It
+// can be run by passing --gtest_also_run_disabled_tests.
+TEST_F(SecureDeleteTest, DISABLED_Benchmark)
+{
+	const int numFiles = 4;
+	const size_t fileSize = 256 * 1024 * 1024;
+
+	for (auto overwriteMethod :
+		{ FileOperations::OverwriteMethod::OnePass, FileOperations::OverwriteMethod::ThreePass })
+	{
+		std::vector<std::wstring> paths;
+
+		for (int i = 0; i < numFiles; i++)
+		{
+			paths.push_back(CreateTestFile(std::format(L"file{}", i), fileSize));
+		}
+
+		SecureDeleteProgress finalProgress = {};
+		auto start = std::chrono::steady_clock::now();
+
+		auto result = DeleteFilesSecurely(paths, overwriteMethod, {},
+			[&finalProgress](const SecureDeleteProgress &progress) { finalProgress = progress; });
+		EXPECT_EQ(result.numFilesDeleted, numFiles);
+
+		auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start);
+
+		std::cout << std::format("Method {}: {} MB written in {} ({} MB/s)\n",
+			static_cast<int>(overwriteMethod), finalProgress.totalBytes / (1024 * 1024), duration,
+			finalProgress.bytesPerSecond / (1024 * 1024));
+	}
+}
@@ -4,21 +4,52 @@
 
 #include "pch.h"
 #include "ShellEnumeratorFake.h"
+#include <algorithm>
+#include <iterator>
 
 HRESULT ShellEnumeratorFake::EnumerateDirectory(PCIDLIST_ABSOLUTE pidlDirectory,
 	ShellItemFilter::ItemType itemType, ShellItemFilter::HiddenItemPolicy hiddenItemPolicy,
 	std::vector<PidlChild> &outputItems, std::stop_token stopToken) const
+{
+	return EnumerateDirectoryInBatches(pidlDirectory, itemType, hiddenItemPolicy,
+		[&outputItems](std::vector<PidlChild> items)
+		{ std::ranges::move(items, std::back_inserter(outputItems)); },
+		stopToken);
+}
+
+HRESULT ShellEnumeratorFake::EnumerateDirectoryInBatches(PCIDLIST_ABSOLUTE pidlDirectory,
+	ShellItemFilter::ItemType itemType, ShellItemFilter::HiddenItemPolicy hiddenItemPolicy,
+	const BatchCallback &batchCallback, std::stop_token stopToken) const
 {
 	UNREFERENCED_PARAMETER(pidlDirectory);
 	UNREFERENCED_PARAMETER(itemType);
 	UNREFERENCED_PARAMETER(hiddenItemPolicy);
-	UNREFERENCED_PARAMETER(outputItems);
-	UNREFERENCED_PARAMETER(stopToken);
 
-	return m_shouldSucceed ? S_OK : E_FAIL;
+	if (!m_shouldSucceed)
+	{
+		return E_FAIL;
+	}
+
+	for (size_t start = 0; start < m_items.size(); start += BATCH_SIZE)
+	{
+		if (stopToken.stop_requested())
+		{
+			break;
+		}
+
+		size_t end = std::min(start + BATCH_SIZE, m_items.size());
+		batchCallback(std::vector<PidlChild>(m_items.begin() + start, m_items.begin() + end));
+	}
+
+	return S_OK;
 }
 
 void ShellEnumeratorFake::SetShouldSucceed(bool shouldSucceed)
 {
 	m_shouldSucceed = shouldSucceed;
 }
+
+void ShellEnumeratorFake::SetItems(const std::vector<PidlChild> &items)
+{
+	m_items = items;
+}
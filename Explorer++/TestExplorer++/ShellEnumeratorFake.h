@@ -12,9 +12,19 @@ public:
 	HRESULT EnumerateDirectory(PCIDLIST_ABSOLUTE pidlDirectory, ShellItemFilter::ItemType itemType,
 		ShellItemFilter::HiddenItemPolicy hiddenItemPolicy, std::vector<PidlChild> &outputItems,
 		std::stop_token stopToken) const override;
+	HRESULT EnumerateDirectoryInBatches(PCIDLIST_ABSOLUTE pidlDirectory,
+		ShellItemFilter::ItemType itemType, ShellItemFilter::HiddenItemPolicy hiddenItemPolicy,
+		const BatchCallback &batchCallback, std::stop_token stopToken) const override;
 
 	void SetShouldSucceed(bool shouldSucceed);
 
+	// Sets the items that will be returned when a directory is enumerated.
+	void SetItems(const std::vector<PidlChild> &items);
+
 private:
+	// Matches the number of items the real enumerator requests at once.
+	static constexpr size_t BATCH_SIZE = 256;
+
 	bool m_shouldSucceed = true;
+	std::vector<PidlChild> m_items;
 };
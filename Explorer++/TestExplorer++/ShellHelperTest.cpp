@@ -9,6 +9,7 @@
 #include <gtest/gtest.h>
 #include <wil/com.h>
 #include <ShlObj.h>
+#include <format>
 
 using namespace testing;
 
@@ -284,6 +285,143 @@ TEST(GetDisplayName, ParsingName)
 	EXPECT_THAT(parsingName, StrCaseEq(pidlPath));
 }
 
+namespace
+{
+
+enum class BatchSupport
+{
+	Supported,
+	RejectedWithError,
+	RejectedWithNoItems
+};
+
+class EnumIDListFake : public winrt::implements<EnumIDListFake, IEnumIDList, winrt::non_agile>
+{
+public:
+	EnumIDListFake(const std::vector<PidlChild> &items, BatchSupport batchSupport) :
+		m_items(items),
+		m_batchSupport(batchSupport)
+	{
+	}
+
+	IFACEMETHODIMP Next(ULONG celt, PITEMID_CHILD *rgelt, ULONG *pceltFetched)
+	{
+		if (celt > 1 && m_batchSupport == BatchSupport::RejectedWithError)
+		{
+			return E_INVALIDARG;
+		}
+
+		ULONG numFetched = 0;
+
+		if (celt == 1 || m_batchSupport == BatchSupport::Supported)
+		{
+			for (; numFetched < celt && m_currentIndex < m_items.size(); numFetched++)
+			{
+				rgelt[numFetched] = ILCloneChild(m_items[m_currentIndex++].Raw());
+			}
+		}
+
+		if (pceltFetched)
+		{
+			*pceltFetched = numFetched;
+		}
+
+		m_numCalls++;
+
+		return (numFetched == celt) ? S_OK : S_FALSE;
+	}
+
+	IFACEMETHODIMP Skip(ULONG celt)
+	{
+		m_currentIndex = std::min(m_currentIndex + celt, m_items.size());
+		return S_OK;
+	}
+
+	IFACEMETHODIMP Reset()
+	{
+		m_currentIndex = 0;
+		return S_OK;
+	}
+
+	IFACEMETHODIMP Clone(IEnumIDList **ppenum)
+	{
+		*ppenum = nullptr;
+		return E_NOTIMPL;
+	}
+
+	int GetNumCalls() const
+	{
+		return m_numCalls;
+	}
+
+private:
+	const std::vector<PidlChild> m_items;
+	const BatchSupport m_batchSupport;
+	size_t m_currentIndex = 0;
+	int m_numCalls = 0;
+};
+
+}
+
+class GetNextEnumeratedItemsTest : public TestWithParam<BatchSupport>
+{
+protected:
+	static constexpr ULONG BATCH_SIZE = 10;
+
+	GetNextEnumeratedItemsTest() : m_parentPidl(CreateSimplePidlForTest(L"c:\\"))
+	{
+		for (int i = 0; i < 25; i++)
+		{
+			auto pidl = CreateSimplePidlForTest(std::format(L"c:\\file{}", i), nullptr,
+				ShellItemType::File);
+			m_items.push_back(pidl.GetLastItem());
+			m_expectedItems.push_back(pidl);
+		}
+	}
+
+	const PidlAbsolute m_parentPidl;
+	std::vector<PidlChild> m_items;
+	std::vector<PidlAbsolute> m_expectedItems;
+};
+
+TEST_P(GetNextEnumeratedItemsTest, RetrieveAll)
+{
+	auto enumerator = winrt::make_self<EnumIDListFake>(m_items, GetParam());
+
+	std::vector<PidlChild> enumeratedItems;
+	HRESULT hr;
+
+	do
+	{
+		hr = GetNextEnumeratedItems(enumerator.get(), BATCH_SIZE, enumeratedItems);
+		ASSERT_HRESULT_SUCCEEDED(hr);
+	} while (hr == S_OK);
+
+	ASSERT_EQ(enumeratedItems.size(), m_expectedItems.size());
+
+	for (size_t i = 0; i < enumeratedItems.size(); i++)
+	{
+		EXPECT_EQ(m_parentPidl + enumeratedItems[i], m_expectedItems[i]);
+	}
+}
+
+TEST_F(GetNextEnumeratedItemsTest, ItemsRetrievedInBatches)
+{
+	auto enumerator = winrt::make_self<EnumIDListFake>(m_items, BatchSupport::Supported);
+
+	std::vector<PidlChild> enumeratedItems;
+	HRESULT hr = GetNextEnumeratedItems(enumerator.get(), BATCH_SIZE, enumeratedItems);
+	EXPECT_EQ(hr, S_OK);
+	EXPECT_EQ(enumeratedItems.size(), BATCH_SIZE);
+
+	// All the items in the batch should have been retrieved in a single call.
+	EXPECT_EQ(enumerator->GetNumCalls(), 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(BatchSupportVariants, GetNextEnumeratedItemsTest,
+	Values(BatchSupport::Supported, BatchSupport::RejectedWithError,
+		BatchSupport::RejectedWithNoItems));
+
 class ExtractShellIconPartsTest : public Test
 {
 protected:
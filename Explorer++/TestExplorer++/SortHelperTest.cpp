@@ -0,0 +1,84 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "ShellBrowser/SortHelper.h"
+#include "ShellBrowser/ColumnDataRetrieval.h"
+#include <gtest/gtest.h>
+
+TEST(SortHelperTest, MissingValuesSortFirst)
+{
+	SortKey missingKey = { 0, std::monostate() };
+	SortKey numericKey = { 1, 0ULL };
+	SortKey stringKey = { 1, std::wstring(L"") };
+
+	EXPECT_LT(CompareSortKeys(missingKey, numericKey, StringComparison::Logical), 0);
+	EXPECT_GT(CompareSortKeys(numericKey, missingKey, StringComparison::Logical), 0);
+	EXPECT_LT(CompareSortKeys(missingKey, stringKey, StringComparison::Logical), 0);
+	EXPECT_EQ(CompareSortKeys(missingKey, missingKey, StringComparison::Logical), 0);
+}
+
+TEST(SortHelperTest, NumericKeys)
+{
+	SortKey smallKey = { 1, 100ULL };
+	SortKey largeKey = { 1, 5000000000ULL };
+
+	EXPECT_LT(CompareSortKeys(smallKey, largeKey, StringComparison::Logical), 0);
+	EXPECT_GT(CompareSortKeys(largeKey, smallKey, StringComparison::Logical), 0);
+	EXPECT_EQ(CompareSortKeys(largeKey, largeKey, StringComparison::Logical), 0);
+}
+
+TEST(SortHelperTest, StringKeys)
+{
+	SortKey key1 = { 1, std::wstring(L"file2") };
+	SortKey key2 = { 1, std::wstring(L"FILE10") };
+
+	// Numbers are compared by value when using a logical comparison.
+	EXPECT_LT(CompareSortKeys(key1, key2, StringComparison::Logical), 0);
+	EXPECT_GT(CompareSortKeys(key1, key2, StringComparison::CaseInsensitive), 0);
+
+	SortKey key3 = { 1, std::wstring(L"File2") };
+	EXPECT_EQ(CompareSortKeys(key1, key3, StringComparison::Logical), 0);
+	EXPECT_EQ(CompareSortKeys(key1, key3, StringComparison::CaseInsensitive), 0);
+}
+
+TEST(SortHelperTest, VariantKeys)
+{
+	wil::unique_variant value1;
+	value1.vt = VT_I4;
+	value1.lVal = 1;
+
+	wil::unique_variant value2;
+	value2.vt = VT_I4;
+	value2.lVal = 2;
+
+	SortKey key1 = { 1, std::move(value1) };
+	SortKey key2 = { 1, std::move(value2) };
+
+	EXPECT_LT(CompareSortKeys(key1, key2, StringComparison::Logical), 0);
+	EXPECT_GT(CompareSortKeys(key2, key1, StringComparison::Logical), 0);
+}
+
+TEST(SortHelperTest, SortKeyTextColumns)
+{
+	EXPECT_EQ(GetSortKeyTextColumn(SortMode::Owner), +ColumnType::Owner);
+	EXPECT_EQ(GetSortKeyTextColumn(SortMode::MediaAlbum), +ColumnType::MediaAlbum);
+	EXPECT_EQ(GetSortKeyTextColumn(SortMode::Name), std::nullopt);
+	EXPECT_EQ(GetSortKeyTextColumn(SortMode::Size), std::nullopt);
+
+	// Keys are only built from the column text if that text can be cached.
+	for (auto sortMode : SortMode::_values())
+	{
+		auto textColumn = GetSortKeyTextColumn(sortMode);
+
+		if (textColumn)
+		{
+			EXPECT_TRUE(CanCacheColumnText(*textColumn));
+		}
+	}
+
+	SortKey key1 = BuildSortKeyFromColumnText(L"file2");
+	SortKey key2 = BuildSortKeyFromColumnText(L"file10");
+	EXPECT_LT(CompareSortKeys(key1, key2, StringComparison::Logical), 0);
+}
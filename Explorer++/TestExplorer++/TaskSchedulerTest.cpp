@@ -0,0 +1,410 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "TaskScheduler.h"
+#include "ComStaThreadPoolExecutor.h"
+#include <gtest/gtest.h>
+#include <concurrencpp/concurrencpp.h>
+#include <psapi.h>
+#include <tlhelp32.h>
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <future>
+#include <iostream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+
+namespace
+{
+
+size_t GetProcessThreadCount()
+{
+	wil::unique_hfile snapshot(CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0));
+
+	if (!snapshot)
+	{
+		return 0;
+	}
+
+	THREADENTRY32 threadEntry;
+	threadEntry.dwSize = sizeof(threadEntry);
+	size_t numThreads = 0;
+	DWORD processId = GetCurrentProcessId();
+
+	for (BOOL res = Thread32First(snapshot.get(), &threadEntry); res;
+		res = Thread32Next(snapshot.get(), &threadEntry))
+	{
+		if (threadEntry.th32OwnerProcessID == processId)
+		{
+			numThreads++;
+		}
+	}
+
+	return numThreads;
+}
+
+size_t GetProcessPrivateBytes()
+{
+	PROCESS_MEMORY_COUNTERS_EX counters = {};
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(),
+			reinterpret_cast<PROCESS_MEMORY_COUNTERS *>(&counters), sizeof(counters)))
+	{
+		return 0;
+	}
+
+	return counters.PrivateUsage;
+}
+
+}
+
+class TaskSchedulerTest : public Test
+{
+protected:
+	TaskSchedulerTest() :
+		m_executor(std::make_shared<concurrencpp::manual_executor>()),
+		m_scheduler(m_executor)
+	{
+	}
+
+	void RunAllTasks()
+	{
+		while (m_executor->loop_once())
+		{
+		}
+	}
+
+	const std::shared_ptr<concurrencpp::manual_executor> m_executor;
+	TaskScheduler m_scheduler;
+};
+
+TEST_F(TaskSchedulerTest, TaskResult)
+{
+	auto queue = m_scheduler.CreateQueue();
+
+	auto future = queue->Push([] { return 42; });
+	RunAllTasks();
+
+	EXPECT_EQ(future.get(), 42);
+}
+
+TEST_F(TaskSchedulerTest, TasksRunInOrder)
+{
+	auto queue1 = m_scheduler.CreateQueue();
+	auto queue2 = m_scheduler.CreateQueue();
+
+	std::vector<int> order;
+	queue1->Push([&order] { order.push_back(1); });
+	queue2->Push([&order] { order.push_back(2); });
+	queue1->Push([&order] { order.push_back(3); });
+	RunAllTasks();
+
+	EXPECT_EQ(order, (std::vector<int>{ 1, 2, 3 }));
+}
+
+TEST_F(TaskSchedulerTest, HigherPriorityTasksRunFirst)
+{
+	auto lowPriorityQueue = m_scheduler.CreateQueue(TaskPriority::Low);
+	auto normalPriorityQueue = m_scheduler.CreateQueue(TaskPriority::Normal);
+	auto highPriorityQueue = m_scheduler.CreateQueue(TaskPriority::High);
+
+	std::vector<TaskPriority> order;
+	lowPriorityQueue->Push([&order] { order.push_back(TaskPriority::Low); });
+	normalPriorityQueue->Push([&order] { order.push_back(TaskPriority::Normal); });
+	highPriorityQueue->Push([&order] { order.push_back(TaskPriority::High); });
+	RunAllTasks();
+
+	EXPECT_EQ(order,
+		(std::vector<TaskPriority>{ TaskPriority::High, TaskPriority::Normal, TaskPriority::Low }));
+}
+
+TEST_F(TaskSchedulerTest, SetPriority)
+{
+	auto queue1 = m_scheduler.CreateQueue();
+	auto queue2 = m_scheduler.CreateQueue();
+
+	std::vector<int> order;
+	queue1->Push([&order] { order.push_back(1); });
+	queue2->Push([&order] { order.push_back(2); });
+
+	// The tasks in the second queue should now run before any of the tasks in the first queue,
+	// even though they were queued later.
+	queue2->SetPriority(TaskPriority::High);
+	EXPECT_EQ(queue2->GetPriority(), TaskPriority::High);
+
+	RunAllTasks();
+
+	EXPECT_EQ(order, (std::vector<int>{ 2, 1 }));
+}
+
+TEST_F(TaskSchedulerTest, Prioritize)
+{
+	auto queue1 = m_scheduler.CreateQueue();
+	auto queue2 = m_scheduler.CreateQueue();
+
+	std::vector<int> order;
+	queue1->Push([&order] { order.push_back(1); }, 1);
+	queue1->Push([&order] { order.push_back(2); }, 2);
+	queue2->Push([&order] { order.push_back(3); });
+	queue1->Push([&order] { order.push_back(4); }, 4);
+	queue1->Push([&order] { order.push_back(5); }, 2);
+
+	queue1->Prioritize({ 2, 4 });
+	RunAllTasks();
+
+	// The prioritized tasks should take the place of the earliest tasks in the first queue, without
+	// affecting the order of tasks relative to the second queue.
+	EXPECT_EQ(order, (std::vector<int>{ 2, 4, 3, 5, 1 }));
+}
+
+TEST(TaskSchedulerRunnerTest, NumberOfSubmittedTasksIsBounded)
+{
+	auto executor = std::make_shared<concurrencpp::manual_executor>();
+	TaskScheduler scheduler(executor, 2);
+	auto queue = scheduler.CreateQueue();
+
+	int numTasksRun = 0;
+
+	for (int i = 0; i < 10; i++)
+	{
+		queue->Push([&numTasksRun] { numTasksRun++; });
+	}
+
+	// Only a fixed number of runners should be submitted to the executor, regardless of how many
+	// tasks are queued.
+	EXPECT_EQ(executor->size(), 2u);
+
+	while (executor->loop_once())
+	{
+	}
+
+	EXPECT_EQ(numTasksRun, 10);
+	EXPECT_EQ(executor->size(), 0u);
+}
+
+TEST(TaskSchedulerRunnerTest, PriorityAppliesToPreviouslyQueuedTasks)
+{
+	auto executor = std::make_shared<concurrencpp::manual_executor>();
+	TaskScheduler scheduler(executor, 1);
+	auto normalPriorityQueue = scheduler.CreateQueue(TaskPriority::Normal);
+	auto highPriorityQueue = scheduler.CreateQueue(TaskPriority::High);
+
+	std::vector<int> order;
+
+	for (int i = 0; i < 5; i++)
+	{
+		normalPriorityQueue->Push([&order, i] { order.push_back(i); });
+	}
+
+	executor->loop_once();
+
+	// The high priority task is queued after all the normal priority tasks, but should still run
+	// as soon as the current runner finishes, rather than waiting for the remaining normal
+	// priority tasks.
+	highPriorityQueue->Push([&order] { order.push_back(100); });
+
+	while (executor->loop_once())
+	{
+	}
+
+	EXPECT_EQ(order, (std::vector<int>{ 0, 100, 1, 2, 3, 4 }));
+}
+
+TEST_F(TaskSchedulerTest, Counters)
+{
+	auto queue1 = m_scheduler.CreateQueue();
+	auto queue2 = m_scheduler.CreateQueue();
+
+	queue1->Push([] {});
+	queue1->Push([] {});
+	queue2->Push([] {});
+	m_executor->loop_once();
+
+	queue1->Clear();
+	queue2->Push([] {});
+	RunAllTasks();
+
+	auto counters1 = queue1->GetCounters();
+	EXPECT_EQ(counters1.numTasksQueued, 2u);
+	EXPECT_EQ(counters1.numTasksExecuted, 1u);
+	EXPECT_EQ(counters1.numTasksDiscarded, 1u);
+
+	auto counters2 = queue2->GetCounters();
+	EXPECT_EQ(counters2.numTasksQueued, 2u);
+	EXPECT_EQ(counters2.numTasksExecuted, 2u);
+	EXPECT_EQ(counters2.numTasksDiscarded, 0u);
+
+	queue2->Push([] {});
+	queue2.reset();
+
+	auto schedulerCounters = m_scheduler.GetCounters();
+	EXPECT_EQ(schedulerCounters.numTasksQueued, 5u);
+	EXPECT_EQ(schedulerCounters.numTasksExecuted, 3u);
+	EXPECT_EQ(schedulerCounters.numTasksDiscarded, 2u);
+}
+
+TEST_F(TaskSchedulerTest, Clear)
+{
+	auto queue1 = m_scheduler.CreateQueue();
+	auto queue2 = m_scheduler.CreateQueue();
+
+	bool queue1TaskRun = false;
+	bool queue2TaskRun = false;
+	auto future1 = queue1->Push([&queue1TaskRun] { queue1TaskRun = true; });
+	auto future2 = queue2->Push([&queue2TaskRun] { queue2TaskRun = true; });
+
+	queue1->Clear();
+	RunAllTasks();
+
+	EXPECT_FALSE(queue1TaskRun);
+	EXPECT_THROW(future1.get(), std::future_error);
+
+	// Clearing one queue shouldn't affect the tasks in another queue.
+	EXPECT_TRUE(queue2TaskRun);
+	EXPECT_NO_THROW(future2.get());
+}
+
+TEST_F(TaskSchedulerTest, DestroyQueue)
+{
+	auto queue = m_scheduler.CreateQueue();
+
+	bool taskRun = false;
+	auto future = queue->Push([&taskRun] { taskRun = true; });
+
+	queue.reset();
+	RunAllTasks();
+
+	EXPECT_FALSE(taskRun);
+	EXPECT_THROW(future.get(), std::future_error);
+}
+
+// This test is disabled by default, since it's only intended to be used to measure performance. It
+// can be run by passing --gtest_also_run_disabled_tests.
+//
+// Each simulated tab has the same set of queues that a real tab has (columns, thumbnails, info tips
+// and icons), and one of the tabs is selected. The shared scheduler is compared against the
+// previous model, where each of those queues had its own thread.
+TEST(TaskSchedulerBenchmarkTest, DISABLED_Benchmark)
+{
+	const int numTabs = 60;
+	const int numQueuesPerTab = 4;
+	const int numTasksPerQueue = 100;
+
+	// The selected tab is the last one to be filled, so that it has to compete with the work that
+	// was queued for every other tab.
+	const int selectedTab = numTabs - 1;
+
+	// Simulates retrieving the data for a single row.
+	auto task = [] { std::this_thread::sleep_for(std::chrono::microseconds(200)); };
+
+	auto printResults = [](const std::string &name, size_t numThreads, size_t privateBytes,
+							std::chrono::milliseconds selectedTabDuration,
+							std::chrono::milliseconds totalDuration)
+	{
+		std::cout << std::format(
+			"{}: {} threads, {} KB, selected tab filled in {}, all tabs filled in {}\n", name,
+			numThreads, privateBytes / 1024, selectedTabDuration, totalDuration);
+	};
+
+	{
+		size_t initialNumThreads = GetProcessThreadCount();
+		size_t initialPrivateBytes = GetProcessPrivateBytes();
+
+		auto executor = std::make_shared<ComStaThreadPoolExecutor>(
+			std::max(std::thread::hardware_concurrency(), 1u));
+		TaskScheduler scheduler(executor);
+		std::vector<std::unique_ptr<TaskQueue>> queues;
+
+		for (int i = 0; i < numTabs; i++)
+		{
+			for (int j = 0; j < numQueuesPerTab; j++)
+			{
+				queues.push_back(scheduler.CreateQueue(
+					(i == selectedTab) ? TaskPriority::High : TaskPriority::Normal));
+			}
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::future<void>> futures;
+
+		for (auto &queue : queues)
+		{
+			for (int i = 0; i < numTasksPerQueue; i++)
+			{
+				futures.push_back(queue->Push(task));
+			}
+		}
+
+		size_t numThreads = GetProcessThreadCount() - initialNumThreads;
+		size_t privateBytes = GetProcessPrivateBytes() - initialPrivateBytes;
+
+		auto selectedTabFutures =
+			std::span(futures).subspan(selectedTab * numQueuesPerTab * numTasksPerQueue,
+				numQueuesPerTab * numTasksPerQueue);
+		std::ranges::for_each(selectedTabFutures, [](auto &future) { future.get(); });
+		auto selectedTabDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start);
+
+		std::ranges::for_each(futures, [](auto &future) { future.wait(); });
+		auto totalDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start);
+
+		printResults("Shared scheduler", numThreads, privateBytes, selectedTabDuration,
+			totalDuration);
+
+		queues.clear();
+		executor->shutdown();
+	}
+
+	{
+		size_t initialNumThreads = GetProcessThreadCount();
+		size_t initialPrivateBytes = GetProcessPrivateBytes();
+
+		std::vector<std::shared_ptr<ComStaThreadPoolExecutor>> executors;
+
+		for (int i = 0; i < numTabs * numQueuesPerTab; i++)
+		{
+			executors.push_back(std::make_shared<ComStaThreadPoolExecutor>(1));
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<concurrencpp::result<void>> results;
+
+		for (auto &executor : executors)
+		{
+			for (int i = 0; i < numTasksPerQueue; i++)
+			{
+				results.push_back(executor->submit(task));
+			}
+		}
+
+		size_t numThreads = GetProcessThreadCount() - initialNumThreads;
+		size_t privateBytes = GetProcessPrivateBytes() - initialPrivateBytes;
+
+		auto selectedTabResults =
+			std::span(results).subspan(selectedTab * numQueuesPerTab * numTasksPerQueue,
+				numQueuesPerTab * numTasksPerQueue);
+		std::ranges::for_each(selectedTabResults, [](auto &result) { result.get(); });
+		auto selectedTabDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start);
+
+		std::ranges::for_each(results, [](auto &result) { result.wait(); });
+		auto totalDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start);
+
+		printResults("Thread per queue", numThreads, privateBytes, selectedTabDuration,
+			totalDuration);
+
+		for (auto &executor : executors)
+		{
+			executor->shutdown();
+		}
+	}
+}
@@ -0,0 +1,118 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "ShellBrowser/ThumbnailBitmapCache.h"
+#include <gtest/gtest.h>
+
+using namespace testing;
+
+namespace
+{
+
+// Each bitmap created here is 32bpp, so it will use 4 * width * height bytes.
+wil::unique_hbitmap CreateTestBitmap(int width, int height)
+{
+	wil::unique_hbitmap bitmap(CreateBitmap(width, height, 1, 32, nullptr));
+	EXPECT_TRUE(bitmap);
+	return bitmap;
+}
+
+}
+
+TEST(ThumbnailBitmapCacheTest, SetGet)
+{
+	ThumbnailBitmapCache cache(1000, 100);
+
+	auto bitmap1 = CreateTestBitmap(4, 4);
+	HBITMAP rawBitmap1 = bitmap1.get();
+	cache.SetThumbnail(1, 64, std::move(bitmap1));
+
+	auto bitmap2 = CreateTestBitmap(2, 2);
+	HBITMAP rawBitmap2 = bitmap2.get();
+	cache.SetThumbnail(1, 128, std::move(bitmap2));
+
+	EXPECT_EQ(cache.MaybeGetThumbnail(1, 64), rawBitmap1);
+	EXPECT_EQ(cache.MaybeGetThumbnail(1, 128), rawBitmap2);
+	EXPECT_EQ(cache.MaybeGetThumbnail(1, 256), nullptr);
+	EXPECT_EQ(cache.MaybeGetThumbnail(2, 64), nullptr);
+
+	EXPECT_EQ(cache.GetNumEntries(), 2u);
+	EXPECT_EQ(cache.GetSize(), 80u);
+}
+
+TEST(ThumbnailBitmapCacheTest, ReplaceThumbnail)
+{
+	ThumbnailBitmapCache cache(1000, 100);
+	cache.SetThumbnail(1, 64, CreateTestBitmap(4, 4));
+
+	auto updatedBitmap = CreateTestBitmap(2, 2);
+	HBITMAP rawUpdatedBitmap = updatedBitmap.get();
+	cache.SetThumbnail(1, 64, std::move(updatedBitmap));
+
+	EXPECT_EQ(cache.MaybeGetThumbnail(1, 64), rawUpdatedBitmap);
+	EXPECT_EQ(cache.GetNumEntries(), 1u);
+	EXPECT_EQ(cache.GetSize(), 16u);
+}
+
+TEST(ThumbnailBitmapCacheTest, InvalidateItem)
+{
+	ThumbnailBitmapCache cache(1000, 100);
+	cache.SetThumbnail(1, 64, CreateTestBitmap(4, 4));
+	cache.SetThumbnail(1, 128, CreateTestBitmap(4, 4));
+	cache.SetThumbnail(2, 64, CreateTestBitmap(2, 2));
+
+	cache.InvalidateItem(1);
+
+	EXPECT_EQ(cache.MaybeGetThumbnail(1, 64), nullptr);
+	EXPECT_EQ(cache.MaybeGetThumbnail(1, 128), nullptr);
+	EXPECT_NE(cache.MaybeGetThumbnail(2, 64), nullptr);
+	EXPECT_EQ(cache.GetNumEntries(), 1u);
+	EXPECT_EQ(cache.GetSize(), 16u);
+
+	cache.Clear();
+	EXPECT_EQ(cache.GetNumEntries(), 0u);
+	EXPECT_EQ(cache.GetSize(), 0u);
+}
+
+TEST(ThumbnailBitmapCacheTest, SizeLimit)
+{
+	ThumbnailBitmapCache cache(150, 100);
+	cache.SetThumbnail(1, 64, CreateTestBitmap(4, 4));
+	cache.SetThumbnail(2, 64, CreateTestBitmap(4, 4));
+
+	// Accessing the first entry makes it the most recently used entry, so the second entry should
+	// be removed when the limit is exceeded below.
+	EXPECT_NE(cache.MaybeGetThumbnail(1, 64), nullptr);
+
+	cache.SetThumbnail(3, 64, CreateTestBitmap(4, 4));
+
+	EXPECT_NE(cache.MaybeGetThumbnail(1, 64), nullptr);
+	EXPECT_EQ(cache.MaybeGetThumbnail(2, 64), nullptr);
+	EXPECT_NE(cache.MaybeGetThumbnail(3, 64), nullptr);
+	EXPECT_EQ(cache.GetSize(), 128u);
+
+	// Bitmaps that are larger than the limit are never stored.
+	cache.SetThumbnail(4, 64, CreateTestBitmap(8, 8));
+	EXPECT_EQ(cache.MaybeGetThumbnail(4, 64), nullptr);
+	EXPECT_EQ(cache.GetNumEntries(), 2u);
+}
+
+TEST(ThumbnailBitmapCacheTest, EntryLimit)
+{
+	ThumbnailBitmapCache cache(1000, 2);
+	cache.SetThumbnail(1, 64, CreateTestBitmap(2, 2));
+	cache.SetThumbnail(2, 64, CreateTestBitmap(2, 2));
+
+	EXPECT_NE(cache.MaybeGetThumbnail(1, 64), nullptr);
+
+	// The bitmaps are well within the size limit, but the least recently used entry should still
+	// be removed, since there can only be two entries.
+	cache.SetThumbnail(3, 64, CreateTestBitmap(2, 2));
+
+	EXPECT_NE(cache.MaybeGetThumbnail(1, 64), nullptr);
+	EXPECT_EQ(cache.MaybeGetThumbnail(2, 64), nullptr);
+	EXPECT_NE(cache.MaybeGetThumbnail(3, 64), nullptr);
+	EXPECT_EQ(cache.GetNumEntries(), 2u);
+}
@@ -0,0 +1,161 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "ShellBrowser/ThumbnailSlotAllocator.h"
+#include <gtest/gtest.h>
+
+using namespace testing;
+
+TEST(ThumbnailSlotAllocatorTest, NewSlots)
+{
+	ThumbnailSlotAllocator allocator(3);
+
+	auto allocation1 = allocator.GetSlot(10);
+	EXPECT_EQ(allocation1.slot, 0);
+	EXPECT_TRUE(allocation1.newSlot);
+	EXPECT_EQ(allocation1.evictedItem, std::nullopt);
+
+	auto allocation2 = allocator.GetSlot(20);
+	EXPECT_EQ(allocation2.slot, 1);
+	EXPECT_TRUE(allocation2.newSlot);
+	EXPECT_EQ(allocation2.evictedItem, std::nullopt);
+
+	EXPECT_EQ(allocator.GetNumSlots(), 2);
+	EXPECT_EQ(allocator.GetNumAssignedItems(), 2);
+	EXPECT_EQ(allocator.GetNumMisses(), 2u);
+	EXPECT_EQ(allocator.GetNumHits(), 0u);
+}
+
+TEST(ThumbnailSlotAllocatorTest, ExistingSlot)
+{
+	ThumbnailSlotAllocator allocator(3);
+
+	allocator.GetSlot(10);
+	allocator.GetSlot(20);
+
+	auto allocation = allocator.GetSlot(10);
+	EXPECT_EQ(allocation.slot, 0);
+	EXPECT_FALSE(allocation.newSlot);
+	EXPECT_EQ(allocation.evictedItem, std::nullopt);
+
+	EXPECT_EQ(allocator.GetNumSlots(), 2);
+	EXPECT_EQ(allocator.GetNumHits(), 1u);
+	EXPECT_EQ(allocator.GetNumMisses(), 2u);
+}
+
+TEST(ThumbnailSlotAllocatorTest, Eviction)
+{
+	ThumbnailSlotAllocator allocator(2);
+
+	allocator.GetSlot(10);
+	allocator.GetSlot(20);
+
+	// Item 10 is now the most recently used, so item 20 should be the one evicted.
+	allocator.GetSlot(10);
+
+	auto allocation = allocator.GetSlot(30);
+	EXPECT_EQ(allocation.slot, 1);
+	EXPECT_FALSE(allocation.newSlot);
+	EXPECT_EQ(allocation.evictedItem, 20);
+
+	EXPECT_EQ(allocator.GetNumSlots(), 2);
+	EXPECT_EQ(allocator.GetNumAssignedItems(), 2);
+	EXPECT_EQ(allocator.GetNumEvictions(), 1u);
+
+	// Item 20 no longer has a slot, so it will need a new one.
+	allocation = allocator.GetSlot(20);
+	EXPECT_EQ(allocation.slot, 0);
+	EXPECT_EQ(allocation.evictedItem, 10);
+	EXPECT_EQ(allocator.GetNumEvictions(), 2u);
+}
+
+TEST(ThumbnailSlotAllocatorTest, MarkItemUsed)
+{
+	ThumbnailSlotAllocator allocator(2);
+
+	allocator.GetSlot(10);
+	allocator.GetSlot(20);
+	allocator.MarkItemUsed(10);
+
+	auto allocation = allocator.GetSlot(30);
+	EXPECT_EQ(allocation.evictedItem, 20);
+
+	// Marking an item as used shouldn't affect the counters.
+	EXPECT_EQ(allocator.GetNumHits(), 0u);
+	EXPECT_EQ(allocator.GetNumMisses(), 3u);
+}
+
+TEST(ThumbnailSlotAllocatorTest, ReleaseItem)
+{
+	ThumbnailSlotAllocator allocator(2);
+
+	allocator.GetSlot(10);
+	allocator.GetSlot(20);
+	allocator.ReleaseItem(10);
+
+	EXPECT_EQ(allocator.GetNumAssignedItems(), 1);
+
+	// The released slot should be reused, without anything being evicted.
+	auto allocation = allocator.GetSlot(30);
+	EXPECT_EQ(allocation.slot, 0);
+	EXPECT_FALSE(allocation.newSlot);
+	EXPECT_EQ(allocation.evictedItem, std::nullopt);
+	EXPECT_EQ(allocator.GetNumEvictions(), 0u);
+}
+
+TEST(ThumbnailSlotAllocatorTest, VisibleItemsNotEvicted)
+{
+	ThumbnailSlotAllocator allocator(2);
+
+	allocator.SetVisibleItems({ 10 });
+	allocator.GetSlot(10);
+	allocator.GetSlot(20);
+	allocator.GetSlot(20);
+
+	// Item 10 is the least recently used item, but it's visible, so item 20 should be evicted
+	// instead.
+	auto allocation = allocator.GetSlot(30);
+	EXPECT_EQ(allocation.evictedItem, 20);
+	EXPECT_EQ(allocator.GetNumSlots(), 2);
+}
+
+TEST(ThumbnailSlotAllocatorTest, MoreVisibleItemsThanSlots)
+{
+	ThumbnailSlotAllocator allocator(2);
+
+	std::unordered_set<int> visibleItems = { 10, 20, 30, 40, 50 };
+	allocator.SetVisibleItems(visibleItems);
+
+	// Each visible item should be assigned its own slot, without any of the other visible items
+	// being evicted.
+	for (int internalIndex : visibleItems)
+	{
+		auto allocation = allocator.GetSlot(internalIndex);
+		EXPECT_EQ(allocation.evictedItem, std::nullopt);
+	}
+
+	EXPECT_EQ(allocator.GetNumSlots(), 5);
+	EXPECT_EQ(allocator.GetNumAssignedItems(), 5);
+	EXPECT_EQ(allocator.GetNumEvictions(), 0u);
+
+	// Redrawing the visible items should then result in hits only.
+	for (int internalIndex : visibleItems)
+	{
+		auto allocation = allocator.GetSlot(internalIndex);
+		EXPECT_FALSE(allocation.newSlot);
+		EXPECT_EQ(allocation.evictedItem, std::nullopt);
+	}
+
+	EXPECT_EQ(allocator.GetNumHits(), 5u);
+	EXPECT_EQ(allocator.GetNumEvictions(), 0u);
+
+	// Once fewer items are visible, the items that are no longer visible can be evicted again.
+	allocator.SetVisibleItems({ 10 });
+
+	auto allocation = allocator.GetSlot(60);
+	EXPECT_NE(allocation.evictedItem, std::nullopt);
+	EXPECT_NE(allocation.evictedItem, 10);
+	EXPECT_EQ(allocator.GetNumSlots(), 5);
+}
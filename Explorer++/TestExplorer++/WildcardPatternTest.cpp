@@ -0,0 +1,163 @@
+// Copyright (C) Explorer++ Project
+// SPDX-License-Identifier: GPL-3.0-only
+// See LICENSE in the top level directory
+
+#include "pch.h"
+#include "../Helper/WildcardPattern.h"
+#include "../Helper/StringHelper.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <format>
+#include <iostream>
+
+TEST(WildcardPatternTest, SimpleMatches)
+{
+	EXPECT_TRUE(WildcardPattern(L"*.txt", true).Matches(L"Test.txt"));
+	EXPECT_TRUE(WildcardPattern(L"?.txt", true).Matches(L"1.txt"));
+	EXPECT_TRUE(WildcardPattern(L"?ab*cd.tx?", true).Matches(L"1abefghcd.txt"));
+	EXPECT_TRUE(WildcardPattern(L"Test?1*txt", true).Matches(L"Test11test.txt"));
+
+	EXPECT_FALSE(WildcardPattern(L"*.txt", true).Matches(L"Test.txt.bak"));
+	EXPECT_FALSE(WildcardPattern(L"?.txt", true).Matches(L"12.txt"));
+	EXPECT_FALSE(WildcardPattern(L"a*b*c", true).Matches(L"abcd"));
+}
+
+TEST(WildcardPatternTest, SimplePatternForms)
+{
+	// Exact
+	EXPECT_TRUE(WildcardPattern(L"file.txt", true).Matches(L"file.txt"));
+	EXPECT_FALSE(WildcardPattern(L"file.txt", true).Matches(L"file.txt2"));
+
+	// Prefix
+	EXPECT_TRUE(WildcardPattern(L"file*", true).Matches(L"file.txt"));
+	EXPECT_TRUE(WildcardPattern(L"file*", true).Matches(L"file"));
+	EXPECT_FALSE(WildcardPattern(L"file*", true).Matches(L"afile"));
+
+	// Suffix
+	EXPECT_TRUE(WildcardPattern(L"*.txt", true).Matches(L".txt"));
+	EXPECT_FALSE(WildcardPattern(L"*.txt", true).Matches(L"file.tx"));
+
+	// Contains
+	EXPECT_TRUE(WildcardPattern(L"*name*", true).Matches(L"filename.txt"));
+	EXPECT_TRUE(WildcardPattern(L"*name*", true).Matches(L"name"));
+	EXPECT_FALSE(WildcardPattern(L"*name*", true).Matches(L"nam.txt"));
+
+	// Star only
+	EXPECT_TRUE(WildcardPattern(L"*", true).Matches(L"anything"));
+	EXPECT_TRUE(WildcardPattern(L"**", true).Matches(L"anything"));
+}
+
+TEST(WildcardPatternTest, CaseSensitivity)
+{
+	EXPECT_TRUE(WildcardPattern(L"*.TXT", false).Matches(L"file.txt"));
+	EXPECT_FALSE(WildcardPattern(L"*.TXT", true).Matches(L"file.txt"));
+
+	EXPECT_TRUE(WildcardPattern(L"привет", false).Matches(L"Привет"));
+	EXPECT_TRUE(WildcardPattern(L"тестовую строку", false).Matches(L"ТЕСТОВУЮ СТРОКУ"));
+	EXPECT_FALSE(WildcardPattern(L"тестовую строку 2", true).Matches(L"ТЕСТОВУЮ СТРОКУ 2"));
+	EXPECT_TRUE(WildcardPattern(L"Тест?1*txt", true).Matches(L"Тест11Тест.txt"));
+}
+
+TEST(WildcardPatternTest, MultiplePatterns)
+{
+	WildcardPattern pattern(L"*.h: *.cpp :readme", true);
+
+	EXPECT_TRUE(pattern.Matches(L"file.h"));
+	EXPECT_TRUE(pattern.Matches(L"file.cpp"));
+	EXPECT_TRUE(pattern.Matches(L"readme"));
+	EXPECT_FALSE(pattern.Matches(L"file.txt"));
+	EXPECT_FALSE(pattern.Matches(L" readme"));
+
+	// Empty patterns between separators are ignored.
+	WildcardPattern emptyAlternatives(L"::*.txt:", true);
+	EXPECT_TRUE(emptyAlternatives.Matches(L"file.txt"));
+	EXPECT_FALSE(emptyAlternatives.Matches(L"file.doc"));
+}
+
+TEST(WildcardPatternTest, GetProperties)
+{
+	WildcardPattern pattern(L"*.TXT", false);
+	EXPECT_EQ(pattern.GetPattern(), L"*.TXT");
+	EXPECT_FALSE(pattern.IsCaseSensitive());
+}
+
+TEST(WildcardPatternTest, ConsistentWithCheckWildcardMatch)
+{
+	const wchar_t *patterns[] = { L"*", L"*.txt", L"file*", L"*name*", L"f?le.*", L"*a*b?c*",
+		L"*.h: *.cpp", L"exact.txt", L"*.TXT" };
+	const wchar_t *names[] = { L"file.txt", L"FILE.TXT", L"filename.cpp", L"fale.h", L"xaybzc",
+		L"aabbcc", L"exact.txt", L"name", L"" };
+
+	for (auto *pattern : patterns)
+	{
+		for (bool caseSensitive : { true, false })
+		{
+			WildcardPattern compiledPattern(pattern, caseSensitive);
+
+			for (auto *name : names)
+			{
+				EXPECT_EQ(compiledPattern.Matches(name),
+					CheckWildcardMatch(pattern, name, caseSensitive) == TRUE)
+					<< "Pattern: " << pattern << ", name: " << name;
+			}
+		}
+	}
+}
+
+// This test is disabled by default, since it's only intended to be used to measure performance. It
+// can be run by passing --gtest_also_run_disabled_tests.
+TEST(WildcardPatternTest, DISABLED_Benchmark)
+{
+	constexpr int NUM_NAMES = 1'000'000;
+
+	std::vector<std::wstring> names;
+	names.reserve(NUM_NAMES);
+
+	for (int i = 0; i < NUM_NAMES; i++)
+	{
+		names.push_back(
+			std::format(L"Document {} - final version.{}", i, i % 2 == 0 ? L"txt" : L"docx"));
+	}
+
+	for (const auto *pattern :
+		{ L"*.txt", L"Document 1*", L"*final*", L"*.txt: *.docx", L"D?c*5*.txt" })
+	{
+		for (bool caseSensitive : { true, false })
+		{
+			auto start = std::chrono::steady_clock::now();
+			int numMatchesOriginal = 0;
+
+			for (const auto &name : names)
+			{
+				if (CheckWildcardMatch(pattern, name.c_str(), caseSensitive))
+				{
+					numMatchesOriginal++;
+				}
+			}
+
+			auto originalDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - start);
+
+			start = std::chrono::steady_clock::now();
+			WildcardPattern compiledPattern(pattern, caseSensitive);
+			int numMatchesCompiled = 0;
+
+			for (const auto &name : names)
+			{
+				if (compiledPattern.Matches(name))
+				{
+					numMatchesCompiled++;
+				}
+			}
+
+			auto compiledDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - start);
+
+			EXPECT_EQ(numMatchesCompiled, numMatchesOriginal);
+
+			std::wcout << std::format(
+				L"{} (case sensitive: {}): CheckWildcardMatch {}, WildcardPattern {}\n", pattern,
+				caseSensitive, originalDuration, compiledDuration);
+		}
+	}
+}
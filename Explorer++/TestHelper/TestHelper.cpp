@@ -78,6 +78,26 @@ TEST(GetVersionInfoString, Simple)
 	TestVersionInfoString(szDLL, L"ProductVersion", L"1.18.23.4728");
 }
 
+TEST(GetVersionInfoString, LoadedVersionInfo)
+{
+	TCHAR szDLL[MAX_PATH];
+	GetTestResourceFilePath(L"VersionInfo.dll", szDLL, SIZEOF_ARRAY(szDLL));
+
+	std::vector<BYTE> versionInfo;
+	ASSERT_TRUE(LoadFileVersionInfo(szDLL, versionInfo));
+
+	/* The same block can be used to
+	retrieve multiple values. */
+	TCHAR szOutput[512];
+	BOOL bRet = GetVersionInfoString(versionInfo, L"CompanyName", szOutput, SIZEOF_ARRAY(szOutput));
+	ASSERT_EQ(TRUE, bRet);
+	EXPECT_STREQ(L"Test company", szOutput);
+
+	bRet = GetVersionInfoString(versionInfo, L"ProductName", szOutput, SIZEOF_ARRAY(szOutput));
+	ASSERT_EQ(TRUE, bRet);
+	EXPECT_STREQ(L"Test product name", szOutput);
+}
+
 class HardLinkTest : public ::testing::Test
 {
 public: